@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "config.h"
+
+#include "benchmarks.h"
+
+#include "nfa/multishufti.h"
+#include "nfa/multitruffle.h"
+#include "nfa/multivermicelli.h"
+#include "nfa/shufti.h"
+#include "nfa/shufticompile.h"
+#include "nfa/truffle.h"
+#include "nfa/trufflecompile.h"
+#include "nfa/vermicelli.h"
+#include "util/simd_utils.h"
+#include "util/ue2_containers.h"
+
+#include <cassert>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace ue2;
+
+/** \brief Run length used by the multibyte acceleration benchmarks. */
+static const u8 MULTI_RUN_LEN = 4;
+
+/** \brief Class sizes swept for the single-byte class primitives. */
+static const vector<u32> CLASS_SIZES = {1, 3, 8, 16, 64, 128};
+
+/** \brief A class of \a cls contiguous characters, starting at 'a'. */
+static
+CharReach makeClass(u32 cls) {
+    assert(cls && cls <= 128);
+    CharReach cr;
+    cr.setRange('a', 'a' + cls - 1);
+    return cr;
+}
+
+static
+vector<string> singleChars(const CharReach &cr) {
+    vector<string> out;
+    for (size_t c = cr.find_first(); c != cr.npos; c = cr.find_next(c)) {
+        out.push_back(string(1, (char)c));
+    }
+    return out;
+}
+
+/** \brief Count stops of a forward scanner that returns buf_end when there
+ * are none. Scanning ends once fewer than \a min_len bytes remain, as the
+ * accel framework does not call some primitives on short buffers. */
+template<class Scan>
+static
+u64a scanForward(const u8 *buf, size_t len, const Scan &scan,
+                 size_t min_len = 1) {
+    const u8 *end = buf + len;
+    u64a stops = 0;
+    for (const u8 *p = buf; (size_t)(end - p) >= min_len; p++) {
+        p = scan(p, end);
+        if (p >= end) {
+            break;
+        }
+        stops++;
+    }
+    return stops;
+}
+
+/** \brief Count stops of a reverse scanner that returns (buf - 1) when there
+ * are none. */
+template<class Scan>
+static
+u64a scanReverse(const u8 *buf, size_t len, const Scan &scan) {
+    u64a stops = 0;
+    for (const u8 *e = buf + len; e > buf;) {
+        const u8 *p = scan(buf, e);
+        if (p < buf) {
+            break;
+        }
+        stops++;
+        e = p;
+    }
+    return stops;
+}
+
+static
+void addShufti(vector<Benchmark> &out) {
+    out.push_back({"shufti", "chars", CLASS_SIZES, [](u32 cls, Kernel &k) {
+        CharReach cr = makeClass(cls);
+        m128 lo, hi;
+        if (shuftiBuildMasks(cr, &lo, &hi) == -1) {
+            return false;
+        }
+        k.plants = singleChars(cr);
+        k.background = ~cr;
+        k.run = [lo, hi](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [&](const u8 *b, const u8 *e) {
+                return shuftiExec(lo, hi, b, e);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"rshufti", "chars", CLASS_SIZES, [](u32 cls, Kernel &k) {
+        CharReach cr = makeClass(cls);
+        m128 lo, hi;
+        if (shuftiBuildMasks(cr, &lo, &hi) == -1) {
+            return false;
+        }
+        k.plants = singleChars(cr);
+        k.background = ~cr;
+        k.run = [lo, hi](const u8 *buf, size_t len) {
+            return scanReverse(buf, len, [&](const u8 *b, const u8 *e) {
+                return rshuftiExec(lo, hi, b, e);
+            });
+        };
+        return true;
+    }});
+
+    // Class size is the number of two-byte strings.
+    out.push_back({"shufti-double", "pairs", {1, 4, 8},
+                   [](u32 cls, Kernel &k) {
+        CharReach cr = makeClass(cls + 1);
+        flat_set<pair<u8, u8>> pairs;
+        k.plants.clear();
+        for (u32 i = 0; i < cls; i++) {
+            u8 c1 = 'a' + i, c2 = 'a' + i + 1;
+            pairs.insert(make_pair(c1, c2));
+            k.plants.push_back(string{(char)c1, (char)c2});
+        }
+        m128 lo1, hi1, lo2, hi2;
+        if (!shuftiBuildDoubleMasks(CharReach(), pairs, &lo1, &hi1, &lo2,
+                                    &hi2)) {
+            return false;
+        }
+        k.background = ~cr;
+        k.run = [lo1, hi1, lo2, hi2](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [&](const u8 *b, const u8 *e) {
+                return shuftiDoubleExec(lo1, hi1, lo2, hi2, b, e);
+            });
+        };
+        return true;
+    }});
+}
+
+static
+void addTruffle(vector<Benchmark> &out) {
+    out.push_back({"truffle", "chars", CLASS_SIZES, [](u32 cls, Kernel &k) {
+        CharReach cr = makeClass(cls);
+        m128 m1, m2;
+        truffleBuildMasks(cr, &m1, &m2);
+        k.plants = singleChars(cr);
+        k.background = ~cr;
+        k.run = [m1, m2](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [&](const u8 *b, const u8 *e) {
+                return truffleExec(m1, m2, b, e);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"rtruffle", "chars", CLASS_SIZES, [](u32 cls, Kernel &k) {
+        CharReach cr = makeClass(cls);
+        m128 m1, m2;
+        truffleBuildMasks(cr, &m1, &m2);
+        k.plants = singleChars(cr);
+        k.background = ~cr;
+        k.run = [m1, m2](const u8 *buf, size_t len) {
+            return scanReverse(buf, len, [&](const u8 *b, const u8 *e) {
+                return rtruffleExec(m1, m2, b, e);
+            });
+        };
+        return true;
+    }});
+}
+
+static
+void addVermicelli(vector<Benchmark> &out) {
+    out.push_back({"vermicelli", "", {0}, [](u32, Kernel &k) {
+        k.plants = {"a"};
+        k.background = ~CharReach('a');
+        k.run = [](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [](const u8 *b, const u8 *e) {
+                return vermicelliExec('a', 0, b, e);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"vermicelli-nocase", "", {0}, [](u32, Kernel &k) {
+        k.plants = {"a", "A"};
+        k.background = ~CharReach(string("aA"));
+        k.run = [](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [](const u8 *b, const u8 *e) {
+                return vermicelliExec('A', 1, b, e);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"nvermicelli", "", {0}, [](u32, Kernel &k) {
+        k.plants = {"b"};
+        k.background = CharReach('a');
+        k.run = [](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [](const u8 *b, const u8 *e) {
+                return nvermicelliExec('a', 0, b, e);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"rvermicelli", "", {0}, [](u32, Kernel &k) {
+        k.plants = {"a"};
+        k.background = ~CharReach('a');
+        k.run = [](const u8 *buf, size_t len) {
+            return scanReverse(buf, len, [](const u8 *b, const u8 *e) {
+                return rvermicelliExec('a', 0, b, e);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"vermicelli-double", "", {0}, [](u32, Kernel &k) {
+        k.plants = {"ab"};
+        k.background = ~CharReach(string("ab"));
+        k.run = [](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [](const u8 *b, const u8 *e) {
+                return vermicelliDoubleExec('a', 'b', 0, b, e);
+            }, VERM_BOUNDARY);
+        };
+        return true;
+    }});
+}
+
+/** \brief Multibyte acceleration: each plant is a run of the stop character
+ * long enough to satisfy every variant. */
+static
+void addMultiaccel(vector<Benchmark> &out) {
+    const string run(2 * MULTI_RUN_LEN, 'a');
+    const CharReach cr('a');
+
+    out.push_back({"long-shufti", "", {0}, [=](u32, Kernel &k) {
+        m128 lo, hi;
+        if (shuftiBuildMasks(cr, &lo, &hi) == -1) {
+            return false;
+        }
+        k.plants = {run};
+        k.background = ~cr;
+        k.run = [lo, hi](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [&](const u8 *b, const u8 *e) {
+                return long_shuftiExec(lo, hi, b, e, MULTI_RUN_LEN);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"shift-shufti", "", {0}, [=](u32, Kernel &k) {
+        m128 lo, hi;
+        if (shuftiBuildMasks(cr, &lo, &hi) == -1) {
+            return false;
+        }
+        k.plants = {run};
+        k.background = ~cr;
+        k.run = [lo, hi](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [&](const u8 *b, const u8 *e) {
+                return shift_shuftiExec(lo, hi, b, e, MULTI_RUN_LEN);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"long-truffle", "", {0}, [=](u32, Kernel &k) {
+        m128 m1, m2;
+        truffleBuildMasks(cr, &m1, &m2);
+        k.plants = {run};
+        k.background = ~cr;
+        k.run = [m1, m2](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [&](const u8 *b, const u8 *e) {
+                return long_truffleExec(m1, m2, b, e, MULTI_RUN_LEN);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"shift-truffle", "", {0}, [=](u32, Kernel &k) {
+        m128 m1, m2;
+        truffleBuildMasks(cr, &m1, &m2);
+        k.plants = {run};
+        k.background = ~cr;
+        k.run = [m1, m2](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [&](const u8 *b, const u8 *e) {
+                return shift_truffleExec(m1, m2, b, e, MULTI_RUN_LEN);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"long-vermicelli", "", {0}, [=](u32, Kernel &k) {
+        k.plants = {run};
+        k.background = ~cr;
+        k.run = [](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [](const u8 *b, const u8 *e) {
+                return long_vermicelliExec('a', 0, b, e, MULTI_RUN_LEN);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"shift-vermicelli", "", {0}, [=](u32, Kernel &k) {
+        k.plants = {run};
+        k.background = ~cr;
+        k.run = [](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [](const u8 *b, const u8 *e) {
+                return shift_vermicelliExec('a', 0, b, e, MULTI_RUN_LEN);
+            });
+        };
+        return true;
+    }});
+
+    out.push_back({"doubleshift-vermicelli", "", {0}, [=](u32, Kernel &k) {
+        k.plants = {run};
+        k.background = ~cr;
+        k.run = [](const u8 *buf, size_t len) {
+            return scanForward(buf, len, [](const u8 *b, const u8 *e) {
+                return doubleshift_vermicelliExec('a', 0, b, e, 1,
+                                                  MULTI_RUN_LEN - 1);
+            });
+        };
+        return true;
+    }});
+}
+
+void addAccelBenchmarks(vector<Benchmark> &out) {
+    addShufti(out);
+    addTruffle(out);
+    addVermicelli(out);
+    addMultiaccel(out);
+}
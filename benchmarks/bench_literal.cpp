@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "config.h"
+
+#include "benchmarks.h"
+
+#include "grey.h"
+#include "fdr/fdr.h"
+#include "fdr/fdr_compile.h"
+#include "fdr/fdr_compile_internal.h"
+#include "fdr/fdr_engine_description.h"
+#include "fdr/teddy_engine_description.h"
+#include "hwlm/hwlm.h"
+#include "hwlm/hwlm_literal.h"
+#include "hwlm/noodle_build.h"
+#include "hwlm/noodle_engine.h"
+#include "util/target_info.h"
+
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace ue2;
+
+/** \brief Literals are drawn from this alphabet; the background never is. */
+static const CharReach LITERAL_CHARS('a', 'z');
+
+static
+hwlmcb_rv_t countMatch(size_t, size_t, u32, void *ctxt) {
+    u64a *matches = (u64a *)ctxt;
+    (*matches)++;
+    return HWLM_CONTINUE_MATCHING;
+}
+
+/** \brief \a count distinct random literals of 3 to 8 characters. */
+static
+vector<string> makeLiterals(u32 count) {
+    mt19937 rng(count);
+    uniform_int_distribution<u32> len_dist(3, 8);
+    uniform_int_distribution<int> char_dist('a', 'z');
+    set<string> lits;
+    while (lits.size() < count) {
+        string s(len_dist(rng), 'a');
+        for (auto &c : s) {
+            c = (char)char_dist(rng);
+        }
+        lits.insert(s);
+    }
+    return vector<string>(lits.begin(), lits.end());
+}
+
+static
+void addNoodle(vector<Benchmark> &out, bool nocase) {
+    string name = nocase ? "noodle-nocase" : "noodle";
+    out.push_back({name, "length", {1, 2, 4, 8}, [nocase](u32 cls, Kernel &k) {
+        const string lit = string("qzxjkvbw").substr(0, cls);
+        shared_ptr<noodTable> table =
+            noodBuildTable(hwlmLiteral(lit, nocase, 0));
+        if (!table) {
+            return false;
+        }
+        k.plants = {lit};
+        k.background = ~LITERAL_CHARS;
+        if (nocase) {
+            k.background &= ~CharReach('A', 'Z');
+        }
+        k.run = [table](const u8 *buf, size_t len) {
+            u64a matches = 0;
+            noodExec(table.get(), buf, len, 0, countMatch, &matches);
+            return matches;
+        };
+        return true;
+    }});
+}
+
+/** \brief Build an FDR or Teddy engine; in release builds the engine can't
+ * be chosen by hint, so the compiler picks one. */
+static
+shared_ptr<FDR> buildFdr(const vector<hwlmLiteral> &lits, UNUSED u32 hint) {
+#if !defined(RELEASE_BUILD)
+    if (hint != HINT_INVALID) {
+        return fdrBuildTableHinted(lits, false, hint, get_current_target(),
+                                   Grey());
+    }
+#endif
+    return fdrBuildTable(lits, false, get_current_target(), Grey());
+}
+
+/** \brief One FDR or Teddy benchmark, with the engine selected by hint. */
+static
+Benchmark makeFdrBenchmark(const string &name, u32 hint,
+                           const vector<u32> &classes) {
+    return {name, "literals", classes, [hint](u32 cls, Kernel &k) {
+        vector<hwlmLiteral> lits;
+        k.plants = makeLiterals(cls);
+        for (u32 i = 0; i < k.plants.size(); i++) {
+            lits.push_back(hwlmLiteral(k.plants[i], false, i));
+        }
+        shared_ptr<FDR> fdr = buildFdr(lits, hint);
+        if (!fdr) {
+            return false;
+        }
+        k.background = ~LITERAL_CHARS;
+        k.run = [fdr](const u8 *buf, size_t len) {
+            u64a matches = 0;
+            fdrExec(fdr.get(), buf, len, 0, countMatch, &matches,
+                    HWLM_ALL_GROUPS);
+            return matches;
+        };
+        return true;
+    }};
+}
+
+static
+void addFdr(vector<Benchmark> &out) {
+    out.push_back(makeFdrBenchmark("fdr-auto", HINT_INVALID,
+                                   {1, 8, 32, 128, 512, 4096}));
+
+#if !defined(RELEASE_BUILD)
+    const auto target = get_current_target();
+
+    vector<FDREngineDescription> fdr_descriptions;
+    getFdrDescriptions(&fdr_descriptions);
+    for (const auto &d : fdr_descriptions) {
+        if (!d.isValidOnTarget(target)) {
+            continue;
+        }
+        string name = "fdr-" + to_string(d.getID()) + "-s" +
+                      to_string(d.stateWidth);
+        out.push_back(makeFdrBenchmark(name, d.getID(), {8, 64, 512, 4096}));
+    }
+
+    vector<TeddyEngineDescription> teddy_descriptions;
+    getTeddyDescriptions(&teddy_descriptions);
+    for (const auto &d : teddy_descriptions) {
+        if (!d.isValidOnTarget(target)) {
+            continue;
+        }
+        string name = "teddy-" + to_string(d.getID()) + "-m" +
+                      to_string(d.numMasks) + "b" +
+                      to_string(d.getNumBuckets()) + (d.packed ? "p" : "");
+        out.push_back(makeFdrBenchmark(name, d.getID(), {1, 8, 32, 128}));
+    }
+#endif
+}
+
+void addLiteralBenchmarks(vector<Benchmark> &out) {
+    addNoodle(out, false);
+    addNoodle(out, true);
+    addFdr(out);
+}
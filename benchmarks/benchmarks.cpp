@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file
+ * \brief Microbenchmarks for the acceleration primitives and literal
+ * matchers.
+ *
+ * Each benchmark is swept over buffer sizes, match densities, buffer
+ * alignments and (where it applies) character class or literal set sizes.
+ * For every combination the minimum and mean cycle counts over a number of
+ * samples are measured with rdtsc and reported, along with bytes per cycle,
+ * as CSV or JSON on stdout.
+ */
+
+#include "config.h"
+
+#include "benchmarks.h"
+#include "util/alloc.h"
+#include "util/simd_types.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+
+using namespace std;
+using namespace ue2;
+
+namespace {
+
+/** \brief Largest alignment offset that may be requested. */
+static const size_t MAX_ALIGN = 64;
+
+/** \brief Each sample runs a kernel enough times to cover at least this many
+ * bytes, so that short buffers are not dominated by timer overhead. */
+static const size_t MIN_SAMPLE_BYTES = 64 * 1024;
+
+enum class OutputFormat { CSV, JSON };
+
+struct Config {
+    vector<size_t> sizes = {16, 64, 256, 1024, 4096, 16384, 65536};
+    vector<double> densities = {0.0, 0.001, 0.01, 0.1};
+    vector<size_t> aligns = {0, 1, 31};
+    vector<string> filters;
+    u32 samples = 10;
+    OutputFormat format = OutputFormat::CSV;
+    bool list = false;
+};
+
+struct Result {
+    string benchmark;
+    string class_kind;
+    u32 cls;
+    size_t size;
+    double density;
+    size_t align;
+    u64a matches;
+    u64a min_cycles;
+    double mean_cycles;
+};
+
+} // namespace
+
+static
+void usage(const char *name, const char *error) {
+    cerr << "Usage: " << name << " [OPTIONS...]" << endl << endl;
+    cerr << "  -f NAME        Only run benchmarks whose name contains NAME "
+            "(may be repeated)." << endl;
+    cerr << "  -s SIZE,...    Buffer sizes in bytes." << endl;
+    cerr << "  -d DENSITY,... Planted match densities, in matches per byte."
+         << endl;
+    cerr << "  -a ALIGN,...   Buffer offsets from a 64-byte boundary." << endl;
+    cerr << "  -n SAMPLES     Samples per measurement (default 10)." << endl;
+    cerr << "  -o csv|json    Output format (default csv)." << endl;
+    cerr << "  -l             List benchmarks and exit." << endl;
+    cerr << "  -h             Display help and exit." << endl;
+    cerr << endl;
+
+    if (error) {
+        cerr << "Error: " << error << endl;
+    }
+}
+
+template<class T>
+static
+bool parseList(const char *str, vector<T> &out) {
+    out.clear();
+    stringstream ss(str);
+    string item;
+    while (getline(ss, item, ',')) {
+        stringstream is(item);
+        T val;
+        if (!(is >> val) || !is.eof()) {
+            return false;
+        }
+        out.push_back(val);
+    }
+    return !out.empty();
+}
+
+static
+void processArgs(int argc, char *argv[], Config &cfg) {
+    const char options[] = "f:s:d:a:n:o:lh";
+    int in;
+    while ((in = getopt(argc, argv, options)) != -1) {
+        switch (in) {
+        case 'f':
+            cfg.filters.push_back(optarg);
+            break;
+        case 's':
+            if (!parseList(optarg, cfg.sizes) ||
+                find(cfg.sizes.begin(), cfg.sizes.end(), 0) !=
+                    cfg.sizes.end()) {
+                usage(argv[0], "Couldn't parse argument to -s flag.");
+                exit(1);
+            }
+            break;
+        case 'd':
+            if (!parseList(optarg, cfg.densities) ||
+                any_of(cfg.densities.begin(), cfg.densities.end(),
+                       [](double d) { return d < 0 || d > 1; })) {
+                usage(argv[0], "Couldn't parse argument to -d flag.");
+                exit(1);
+            }
+            break;
+        case 'a':
+            if (!parseList(optarg, cfg.aligns) ||
+                any_of(cfg.aligns.begin(), cfg.aligns.end(),
+                       [](size_t a) { return a >= MAX_ALIGN; })) {
+                usage(argv[0], "Couldn't parse argument to -a flag.");
+                exit(1);
+            }
+            break;
+        case 'n': {
+            vector<u32> n;
+            if (!parseList(optarg, n) || n.size() != 1 || !n[0]) {
+                usage(argv[0], "Couldn't parse argument to -n flag.");
+                exit(1);
+            }
+            cfg.samples = n[0];
+            break;
+        }
+        case 'o':
+            if (!strcmp(optarg, "csv")) {
+                cfg.format = OutputFormat::CSV;
+            } else if (!strcmp(optarg, "json")) {
+                cfg.format = OutputFormat::JSON;
+            } else {
+                usage(argv[0], "Output format must be csv or json.");
+                exit(1);
+            }
+            break;
+        case 'l':
+            cfg.list = true;
+            break;
+        case 'h':
+            usage(argv[0], nullptr);
+            exit(0);
+        default:
+            usage(argv[0], "Unrecognised command line argument.");
+            exit(1);
+        }
+    }
+
+    if (optind < argc) {
+        usage(argv[0], "Unrecognised argument.");
+        exit(1);
+    }
+}
+
+static
+bool selected(const Config &cfg, const string &name) {
+    if (cfg.filters.empty()) {
+        return true;
+    }
+    for (const auto &f : cfg.filters) {
+        if (name.find(f) != string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** \brief Fill \a buf with background characters and plant matches at the
+ * given density. The same parameters always produce the same data. */
+static
+void fillBuffer(u8 *buf, size_t len, const Kernel &k, double density) {
+    mt19937 rng(len);
+
+    vector<u8> bg;
+    for (size_t c = k.background.find_first(); c != k.background.npos;
+         c = k.background.find_next(c)) {
+        bg.push_back((u8)c);
+    }
+    assert(!bg.empty());
+    uniform_int_distribution<size_t> bg_dist(0, bg.size() - 1);
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = bg[bg_dist(rng)];
+    }
+
+    size_t count = (size_t)(len * density + 0.5);
+    if (!count || k.plants.empty()) {
+        return;
+    }
+    uniform_int_distribution<size_t> plant_dist(0, k.plants.size() - 1);
+    for (size_t i = 0; i < count; i++) {
+        const string &p = k.plants[plant_dist(rng)];
+        if (p.size() > len) {
+            continue;
+        }
+        uniform_int_distribution<size_t> pos_dist(0, len - p.size());
+        memcpy(buf + pos_dist(rng), p.data(), p.size());
+    }
+}
+
+static
+void measure(const Kernel &k, const u8 *buf, size_t len, u32 samples,
+             Result &r) {
+    const size_t iters = max<size_t>(1, MIN_SAMPLE_BYTES / len);
+
+    // Warm up, and record the match count.
+    r.matches = k.run(buf, len);
+
+    u64a total = 0;
+    r.min_cycles = ~0ULL;
+    for (u32 s = 0; s < samples; s++) {
+        u64a start = __rdtsc();
+        for (size_t i = 0; i < iters; i++) {
+            k.run(buf, len);
+        }
+        u64a cycles = (__rdtsc() - start) / iters;
+        r.min_cycles = min(r.min_cycles, cycles);
+        total += cycles;
+    }
+    r.mean_cycles = (double)total / samples;
+}
+
+static
+double bytesPerCycle(const Result &r) {
+    return r.min_cycles ? (double)r.size / r.min_cycles : 0.0;
+}
+
+static
+void printHeader(const Config &cfg) {
+    if (cfg.format == OutputFormat::CSV) {
+        cout << "benchmark,class_kind,class,size,density,align,matches,"
+                "min_cycles,mean_cycles,bytes_per_cycle" << endl;
+    } else {
+        cout << "[";
+    }
+}
+
+static
+void printResult(const Config &cfg, const Result &r, bool first) {
+    if (cfg.format == OutputFormat::CSV) {
+        cout << r.benchmark << "," << r.class_kind << "," << r.cls << ","
+             << r.size << "," << r.density << "," << r.align << ","
+             << r.matches << "," << r.min_cycles << "," << fixed
+             << setprecision(1) << r.mean_cycles << "," << setprecision(4)
+             << bytesPerCycle(r) << defaultfloat << endl;
+    } else {
+        cout << (first ? "\n" : ",\n") << "  {\"benchmark\": \""
+             << r.benchmark << "\", \"class_kind\": \"" << r.class_kind
+             << "\", \"class\": " << r.cls << ", \"size\": " << r.size
+             << ", \"density\": " << r.density << ", \"align\": " << r.align
+             << ", \"matches\": " << r.matches << ", \"min_cycles\": "
+             << r.min_cycles << ", \"mean_cycles\": " << fixed
+             << setprecision(1) << r.mean_cycles
+             << ", \"bytes_per_cycle\": " << setprecision(4)
+             << bytesPerCycle(r) << defaultfloat << "}";
+    }
+}
+
+static
+void printFooter(const Config &cfg) {
+    if (cfg.format == OutputFormat::JSON) {
+        cout << "\n]" << endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Config cfg;
+    processArgs(argc, argv, cfg);
+
+    vector<Benchmark> benchmarks;
+    addAccelBenchmarks(benchmarks);
+    addLiteralBenchmarks(benchmarks);
+
+    if (cfg.list) {
+        for (const auto &b : benchmarks) {
+            cout << b.name << endl;
+        }
+        return 0;
+    }
+
+    const size_t max_size = *max_element(cfg.sizes.begin(), cfg.sizes.end());
+    auto storage = aligned_zmalloc_unique<u8>(max_size + MAX_ALIGN);
+
+    printHeader(cfg);
+    bool first = true;
+    for (const auto &b : benchmarks) {
+        if (!selected(cfg, b.name)) {
+            continue;
+        }
+        for (u32 cls : b.classes) {
+            Kernel k;
+            if (!b.setup(cls, k)) {
+                cerr << "Skipping " << b.name << " with " << cls << " "
+                     << b.class_kind << ": unable to build." << endl;
+                continue;
+            }
+            for (size_t size : cfg.sizes) {
+                for (double density : cfg.densities) {
+                    for (size_t align : cfg.aligns) {
+                        u8 *buf = storage.get() + align;
+                        fillBuffer(buf, size, k, density);
+
+                        Result r{b.name, b.class_kind, cls, size, density,
+                                 align, 0, 0, 0.0};
+                        measure(k, buf, size, cfg.samples, r);
+                        printResult(cfg, r, first);
+                        first = false;
+                    }
+                }
+            }
+        }
+    }
+    printFooter(cfg);
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file
+ * \brief Microbenchmarks for the acceleration primitives and literal
+ * matchers: shared declarations.
+ */
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include "ue2common.h"
+#include "util/charreach.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * \brief A primitive prepared for one class size, ready to be timed.
+ *
+ * The input buffer is filled with random bytes drawn from \a background, with
+ * strings from \a plants written over it at the requested match density.
+ */
+struct Kernel {
+    std::vector<std::string> plants;
+    ue2::CharReach background;
+
+    /** \brief Scan the whole buffer, returning the number of matches (or
+     * stops, for the acceleration primitives). */
+    std::function<size_t(const u8 *buf, size_t len)> run;
+};
+
+/** \brief A family of kernels, swept over a list of class sizes. */
+struct Benchmark {
+    std::string name;
+
+    /** \brief What the class dimension means for this benchmark, e.g.
+     * "chars" or "literals". */
+    std::string class_kind;
+
+    /** \brief Class sizes to sweep; a single zero if there is no class. */
+    std::vector<u32> classes;
+
+    /** \brief Prepare a kernel for the given class size. Returns false if
+     * the primitive cannot be built for it. */
+    std::function<bool(u32 cls, Kernel &k)> setup;
+};
+
+void addAccelBenchmarks(std::vector<Benchmark> &out);
+void addLiteralBenchmarks(std::vector<Benchmark> &out);
+
+#endif // BENCHMARKS_H
@@ -23,6 +23,12 @@ if (NOT HAVE_SSSE3)
     message(FATAL_ERROR "A minimum of SSSE3 compiler support is required")
 endif ()
 
+if (FAT_RUNTIME)
+    # for the fat runtime, check that the compiler can build each of the
+    # higher microarchitecture variants rather than the host one
+    set (CMAKE_REQUIRED_FLAGS "${CMAKE_C_FLAGS} ${EXTRA_C_FLAGS} ${AVX2_ARCH_FLAGS}")
+endif ()
+
 # now look for AVX2
 CHECK_C_SOURCE_COMPILES("#include <${INTRIN_INC_H}>
 #if !defined(__AVX2__)
@@ -34,8 +40,34 @@ int main(){
     (void)_mm256_xor_si256(z, z);
 }" HAVE_AVX2)
 
-if (NOT HAVE_AVX2)
-    message(STATUS "Building without AVX2 support")
+if (FAT_RUNTIME)
+    set (CMAKE_REQUIRED_FLAGS "${CMAKE_C_FLAGS} ${EXTRA_C_FLAGS} ${AVX512_ARCH_FLAGS}")
+endif ()
+
+# and AVX-512 (we need the byte/word instructions)
+CHECK_C_SOURCE_COMPILES("#include <${INTRIN_INC_H}>
+#if !defined(__AVX512BW__)
+#error no avx512bw
+#endif
+
+int main(){
+    __m512i z = _mm512_setzero_si512();
+    (void)_mm512_abs_epi8(z);
+}" HAVE_AVX512)
+
+if (FAT_RUNTIME)
+    if (NOT HAVE_AVX2)
+        message(FATAL_ERROR "AVX2 compiler support is required for the fat runtime")
+    endif ()
+    if (HAVE_AVX512)
+        set (BUILD_AVX512 TRUE)
+    else ()
+        message(STATUS "Building fat runtime without AVX-512 support")
+    endif ()
+else ()
+    if (NOT HAVE_AVX2)
+        message(STATUS "Building without AVX2 support")
+    endif ()
 endif ()
 
 unset (CMAKE_REQUIRED_FLAGS)
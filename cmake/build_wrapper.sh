@@ -0,0 +1,33 @@
+#!/bin/sh -e
+# This is used for renaming symbols for the fat runtime, don't call directly
+# usage: build_wrapper.sh <prefix> <keep-syms-file> <compiler> <args...>
+#
+# All global symbols in the object being built, defined or referenced, are
+# given the prefix, except for those matched by the keep-syms file and the
+# symbols exported by the C library.
+
+cleanup () {
+    rm -f ${SYMSFILE} ${KEEPSYMS}
+}
+
+PREFIX=$1
+KEEPSYMS_IN=$2
+shift 2
+# $@ contains the actual build command
+OUT=$(echo "$@" | sed 's/.* -o \([^ ]*\.o\).*/\1/')
+trap cleanup INT QUIT EXIT
+SYMSFILE=$(mktemp --tmpdir ${PREFIX}_rename.syms.XXXXX)
+KEEPSYMS=$(mktemp --tmpdir keep.syms.XXXXX)
+# find the libc used by the compiler
+LIBC_SO=$("$1" --print-file-name=libc.so.6)
+cp ${KEEPSYMS_IN} ${KEEPSYMS}
+# get all symbols from libc and turn them into patterns, dropping versions
+nm -f p -g -D ${LIBC_SO} | sed -e 's/\([^ @]*\).*/^\1$/' >> ${KEEPSYMS}
+# build the object
+"$@"
+# rename the symbols in the object
+nm -f p -g ${OUT} | cut -f1 -d' ' | grep -v -f ${KEEPSYMS} | sed -e "s/\(.*\)/\1\ ${PREFIX}_\1/" >> ${SYMSFILE}
+if test -s ${SYMSFILE}
+then
+    objcopy --redefine-syms=${SYMSFILE} ${OUT}
+fi
@@ -36,6 +36,7 @@
 #include "hs_internal.h"
 #include "hs_runtime.h"
 #include "ue2common.h"
+#include "nfa/nfa_internal.h"
 #include "nfagraph/ng_builder.h"
 #include "nfagraph/ng_dump.h"
 #include "nfagraph/ng.h"
@@ -55,9 +56,12 @@
 #include "smallwrite/smallwrite_build.h"
 #include "rose/rose_build.h"
 #include "rose/rose_build_dump.h"
+#include "rose/rose_internal.h"
 #include "som/slot_manager_dump.h"
 #include "util/alloc.h"
 #include "util/compile_error.h"
+#include "util/compile_report.h"
+#include "util/make_unique.h"
 #include "util/target_info.h"
 #include "util/verify_types.h"
 
@@ -219,6 +223,28 @@ void optimise(ParsedExpression &expr) {
     expr.component->optimise(true /* root is connected to sds */);
 }
 
+static
+void addCombination(NG &ng, unsigned index, const char *expression,
+                    unsigned flags, const hs_expr_ext *ext, ReportID id) {
+    if (flags & ~(HS_FLAG_ALL | HS_FLAG_COMBINATION)) {
+        DEBUG_PRINTF("Unrecognised flag, flags=%u.\n", flags);
+        throw CompileError("Unrecognised flag.");
+    }
+
+    if (flags & ~(HS_FLAG_COMBINATION | HS_FLAG_SINGLEMATCH)) {
+        throw CompileError("Only HS_FLAG_SINGLEMATCH may be used in "
+                           "combination with HS_FLAG_COMBINATION.");
+    }
+
+    if (ext && ext->flags) {
+        throw CompileError("Extended parameters are not supported for "
+                           "logical combinations.");
+    }
+
+    ng.rm.pl.addCombination(id, expression, flags & HS_FLAG_SINGLEMATCH,
+                            index);
+}
+
 void addExpression(NG &ng, unsigned index, const char *expression,
                    unsigned flags, const hs_expr_ext *ext, ReportID id) {
     assert(expression);
@@ -231,11 +257,21 @@ void addExpression(NG &ng, unsigned index, const char *expression,
         throw CompileError("Pattern length exceeds limit.");
     }
 
+    // Logical combinations are evaluated over the matches of other
+    // expressions and have no graph of their own.
+    if (flags & HS_FLAG_COMBINATION) {
+        addCombination(ng, index, expression, flags, ext, id);
+        return;
+    }
+
     // Do per-expression processing: errors here will result in an exception
     // being thrown up to our caller
+    CompilePhase parse_phase("parse");
     ParsedExpression expr(index, expression, flags, id, ext);
     dumpExpression(expr, "orig", cc.grey);
 
+    ng.rm.registerQuiet(id, flags & HS_FLAG_QUIET, index);
+
     // Apply prefiltering transformations if desired.
     if (expr.prefilter) {
         prefilterTree(expr.component, ParseMode(flags));
@@ -254,6 +290,7 @@ void addExpression(NG &ng, unsigned index, const char *expression,
         optimise(expr);
         dumpExpression(expr, "opt", cc.grey);
     }
+    parse_phase.end();
 
     DEBUG_PRINTF("component=%p, nfaId=%u, reportId=%u\n",
                  expr.component.get(), expr.index, expr.id);
@@ -292,6 +329,92 @@ void addExpression(NG &ng, unsigned index, const char *expression,
     }
 }
 
+/** \brief Builds the graph for a literal that Rose could not take directly:
+ * a simple chain of vertices, reachable from both start vertices. */
+static
+unique_ptr<NGWrapper> buildLiteralWrapper(ReportManager &rm,
+                                          const ue2_literal &lit,
+                                          unsigned index, ReportID id,
+                                          bool highlander, som_type som) {
+    auto w = ue2::make_unique<NGWrapper>(index, highlander, false, false, som,
+                                         id, 0, MAX_OFFSET, 0);
+    NGHolder &g = *w;
+
+    NFAVertex u = NGHolder::null_vertex();
+    for (const auto &c : lit) {
+        NFAVertex v = add_vertex(g);
+        g[v].char_reach = c;
+        if (u == NGHolder::null_vertex()) {
+            add_edge(g.start, v, g);
+            add_edge(g.startDs, v, g);
+        } else {
+            add_edge(u, v, g);
+        }
+        u = v;
+    }
+
+    assert(u != NGHolder::null_vertex());
+    g[u].reports.insert(rm.getInternalId(rm.getBasicInternalReport(*w, 0)));
+    add_edge(u, g.accept, g);
+
+    return w;
+}
+
+void addLitExpression(NG &ng, unsigned index, const char *expression,
+                      unsigned flags, ReportID id, size_t length) {
+    assert(expression);
+    const CompileContext &cc = ng.cc;
+    DEBUG_PRINTF("index=%u, id=%u, flags=%u, length=%zu\n", index, id, flags,
+                 length);
+
+    if (flags & ~HS_FLAG_LIT_ALL) {
+        DEBUG_PRINTF("Unrecognised flag, flags=%u.\n", flags);
+        throw CompileError("Unrecognised flag: only HS_FLAG_CASELESS, "
+                           "HS_FLAG_SINGLEMATCH and HS_FLAG_SOM_LEFTMOST are "
+                           "supported for literals.");
+    }
+
+    if (!length) {
+        throw CompileError("Literal must not be empty.");
+    }
+
+    if (length > cc.grey.limitPatternLength) {
+        throw CompileError("Pattern length exceeds limit.");
+    }
+
+    // FIXME: we disallow highlander + SOM, see UE-1850.
+    if ((flags & HS_FLAG_SINGLEMATCH) && (flags & HS_FLAG_SOM_LEFTMOST)) {
+        throw CompileError("HS_FLAG_SINGLEMATCH is not supported in "
+                           "combination with HS_FLAG_SOM_LEFTMOST.");
+    }
+
+    const bool highlander = flags & HS_FLAG_SINGLEMATCH;
+    const som_type som = (flags & HS_FLAG_SOM_LEFTMOST) ? SOM_LEFT : SOM_NONE;
+
+    if (som != SOM_NONE && cc.streaming && !ng.ssm.somPrecision()) {
+        throw CompileError("To use a SOM expression flag in streaming mode, "
+                           "an SOM precision mode (e.g. "
+                           "HS_MODE_SOM_HORIZON_LARGE) must be specified.");
+    }
+
+    const ue2_literal lit(string(expression, length),
+                          flags & HS_FLAG_CASELESS);
+
+    // Literals go straight to Rose where possible, subject to the same
+    // restrictions as the literal short cut taken by addExpression.
+    if (cc.grey.allowRose && !(highlander && lit.length() <= 1)
+        && ng.addLiteral(lit, index, id, highlander, som)) {
+        DEBUG_PRINTF("added literal directly\n");
+        return;
+    }
+
+    auto g = buildLiteralWrapper(ng.rm, lit, index, id, highlander, som);
+    if (!ng.addGraph(*g)) {
+        DEBUG_PRINTF("NFA addGraph failed on ID %u.\n", id);
+        throw CompileError("Error compiling expression.");
+    }
+}
+
 static
 aligned_unique_ptr<RoseEngine> generateRoseEngine(NG &ng) {
     const u32 minWidth =
@@ -306,6 +429,7 @@ aligned_unique_ptr<RoseEngine> generateRoseEngine(NG &ng) {
 
     /* avoid building a smwr if just a pure floating case. */
     if (!roseIsPureLiteral(rose.get())) {
+        CompilePhase phase("small_write");
         u32 qual = roseQuality(rose.get());
         auto smwr = ng.smwr->build(qual);
         if (smwr) {
@@ -328,16 +452,83 @@ platform_t target_to_platform(const target_t &target_info) {
     if (!target_info.has_avx2()) {
         p |= HS_PLATFORM_NOAVX2;
     }
+    if (!target_info.has_avx512()) {
+        p |= HS_PLATFORM_NOAVX512;
+    }
     return p;
 }
 
-struct hs_database *build(NG &ng, unsigned int *length) {
+/** \brief Check that every match ID used by a logical combination belongs
+ * to an expression in the pattern set. */
+static
+void checkLogicalCombinations(const ReportManager &rm) {
+    for (const auto &m : rm.pl.subExpressionRefs()) {
+        if (!rm.hasExtReport(m.first)) {
+            ostringstream oss;
+            oss << "Logical combination refers to match ID " << m.first
+                << ", which is not used by any other expression.";
+            throw CompileError(m.second, oss.str());
+        }
+    }
+}
+
+/** \brief Counts the engines in the final bytecode, by type and by role. */
+static
+void countEngines(const RoseEngine &t, EngineCounts &ec) {
+    for (u32 qi = 0; qi < t.queueCount; qi++) {
+        const NFA *nfa = getNfaByQueue(&t, qi);
+        const u8 type = nfa->type;
+        if (isNfaType(type)) {
+            ec.limex++;
+        } else if (isMcClellanType(type)) {
+            ec.mcclellan++;
+        } else if (isShengType(type)) {
+            ec.sheng++;
+        } else if (isMcShengType(type)) {
+            ec.mcsheng++;
+        } else if (isGoughType(type)) {
+            ec.gough++;
+        } else if (isLbrType(type)) {
+            ec.lbr++;
+        } else if (type == CASTLE_NFA_0) {
+            ec.castle++;
+        } else if (type == MPV_NFA_0) {
+            ec.mpv++;
+        } else {
+            ec.other++;
+        }
+
+        // The MPV, if present, sits on the queues before the outfixes.
+        if (qi < t.outfixEndQueue) {
+            ec.outfixes++;
+        } else if (qi < t.leftfixBeginQueue) {
+            ec.suffixes++;
+        } else {
+            ec.leftfixes++;
+        }
+    }
+
+    ec.literal_matchers = (t.amatcherOffset ? 1 : 0) +
+                          (t.fmatcherOffset ? 1 : 0) +
+                          (t.ematcherOffset ? 1 : 0) +
+                          (t.sbmatcherOffset ? 1 : 0);
+    ec.small_write = t.smallWriteOffset != 0;
+}
+
+struct hs_database *build(NG &ng, unsigned int *length,
+                          CompileReport *report) {
     assert(length);
+    CompilePhase phase(report, "build");
+
+    checkLogicalCombinations(ng.rm);
 
     auto rose = generateRoseEngine(ng);
     if (!rose) {
         throw CompileError("Unable to generate bytecode.");
     }
+    if (report) {
+        countEngines(*rose, report->engines);
+    }
     *length = roseSize(rose.get());
     if (!*length) {
         DEBUG_PRINTF("RoseEngine has zero length\n");
@@ -421,6 +612,7 @@ bool isSupported(const Component &c) {
 
 unique_ptr<NGWrapper> buildWrapper(ReportManager &rm, const CompileContext &cc,
                                    const ParsedExpression &expr) {
+    CompilePhase phase("glushkov");
     assert(isSupported(*expr.component));
 
     const unique_ptr<NFABuilder> builder = makeNFABuilder(rm, cc, expr);
@@ -46,6 +46,7 @@ struct hs_expr_ext;
 
 namespace ue2 {
 
+class CompileReport;
 struct CompileContext;
 struct Grey;
 struct target_t;
@@ -101,6 +102,28 @@ public:
 void addExpression(NG &ng, unsigned index, const char *expression,
                    unsigned flags, const hs_expr_ext *ext, ReportID actionId);
 
+/**
+ * Add a pure literal to the compiler, bypassing the parser.
+ *
+ * @param ng
+ *      The global NG object.
+ * @param index
+ *      The index of the literal (used for errors)
+ * @param expression
+ *      The literal bytes, which may include NUL.
+ * @param flags
+ *      The Hyperscan flags associated with this literal; only
+ *      HS_FLAG_CASELESS, HS_FLAG_SINGLEMATCH and HS_FLAG_SOM_LEFTMOST are
+ *      permitted.
+ * @param actionId
+ *      The identifier to associate with the literal; returned by engine on
+ *      match.
+ * @param length
+ *      The length of the literal in bytes.
+ */
+void addLitExpression(NG &ng, unsigned index, const char *expression,
+                      unsigned flags, ReportID actionId, size_t length);
+
 /**
  * Build a Hyperscan database out of the expressions we've been given. A
  * fatal error will result in an exception being thrown.
@@ -109,11 +132,15 @@ void addExpression(NG &ng, unsigned index, const char *expression,
  *      The global NG object.
  * @param[out] length
  *      The number of bytes occupied by the compiled structure.
+ * @param report
+ *      If not nullptr, the build phases and the engines built are recorded
+ *      here.
  * @return
  *      The compiled structure. Should be deallocated with the
  *      hs_database_free() function.
  */
-struct hs_database *build(NG &ng, unsigned int *length);
+struct hs_database *build(NG &ng, unsigned int *length,
+                          CompileReport *report = nullptr);
 
 /**
  * Constructs an NFA graph from the given expression tree.
@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Partitioning of an expression set into shards, each of which is
+ * compiled into its own database.
+ */
+
+#include "shard.h"
+
+#include "compiler.h"
+#include "grey.h"
+#include "hs_compile.h"
+#include "nfagraph/ng.h"
+#include "nfagraph/ng_holder.h"
+#include "parser/logical_combination.h"
+#include "parser/Parser.h"
+#include "parser/prefilter.h"
+#include "util/charreach.h"
+#include "util/compare.h"
+#include "util/compile_context.h"
+#include "util/compile_error.h"
+#include "util/graph_range.h"
+#include "util/report_manager.h"
+#include "util/ue2_containers.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+namespace ue2 {
+
+/** \brief Cost of an expression that the literal matcher handles alone. */
+static const u64a LITERAL_COST = 1;
+
+/** \brief Fixed cost of an expression that needs an engine, to which its
+ * state count is added. */
+static const u64a ENGINE_COST = 16;
+
+/** \brief Upper bound on the literal keys kept for one expression. */
+static const size_t MAX_KEYS_PER_EXPR = 64;
+
+static
+bool isLiteralReach(const CharReach &cr) {
+    return cr.count() == 1 || cr.isCaselessChar();
+}
+
+static
+char foldedChar(const CharReach &cr) {
+    return mytoupper((char)cr.find_first());
+}
+
+/**
+ * \brief Returns the maximal runs of single-character vertices in \a g as
+ * case-folded strings. Sets \a pure if the graph is nothing but one run.
+ */
+static
+vector<string> literalRuns(const NGHolder &g, bool *pure) {
+    vector<string> runs;
+    size_t total = 0;
+    size_t in_runs = 0;
+
+    for (auto v : vertices_range(g)) {
+        if (is_special(v, g)) {
+            continue;
+        }
+        total++;
+        if (!isLiteralReach(g[v].char_reach)) {
+            continue;
+        }
+
+        // Vertices continuing a run are handled from the run's head.
+        if (in_degree(v, g) == 1) {
+            NFAVertex u = *inv_adjacent_vertices(v, g).first;
+            if (!is_special(u, g) && out_degree(u, g) == 1 &&
+                isLiteralReach(g[u].char_reach)) {
+                continue;
+            }
+        }
+
+        string s;
+        NFAVertex u = v;
+        for (;;) {
+            s.push_back(foldedChar(g[u].char_reach));
+            if (out_degree(u, g) != 1) {
+                break;
+            }
+            NFAVertex w = *adjacent_vertices(u, g).first;
+            if (is_special(w, g) || in_degree(w, g) != 1 ||
+                !isLiteralReach(g[w].char_reach)) {
+                break;
+            }
+            u = w;
+        }
+
+        in_runs += s.size();
+        runs.push_back(move(s));
+    }
+
+    *pure = runs.size() == 1 && in_runs == total;
+    return runs;
+}
+
+/** \brief Keys for a set of literal runs: their trigrams, or the whole run
+ * if it is shorter than that. */
+static
+vector<u32> literalKeys(const vector<string> &runs) {
+    vector<u32> keys;
+    for (const auto &s : runs) {
+        if (s.size() < 3) {
+            u32 key = (u32)s.size() << 24;
+            for (size_t i = 0; i < s.size(); i++) {
+                key |= (u32)(u8)s[i] << (8 * i);
+            }
+            keys.push_back(key);
+            continue;
+        }
+        for (size_t i = 0; i + 3 <= s.size(); i++) {
+            keys.push_back(3U << 24 | (u32)(u8)s[i] << 16 |
+                           (u32)(u8)s[i + 1] << 8 | (u32)(u8)s[i + 2]);
+        }
+    }
+
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    if (keys.size() > MAX_KEYS_PER_EXPR) {
+        keys.resize(MAX_KEYS_PER_EXPR);
+    }
+    return keys;
+}
+
+static
+u32 findRoot(vector<u32> &parent, u32 i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+vector<vector<u32>> assignShards(vector<ShardItem> items, u32 shards) {
+    assert(shards);
+
+    // Place the heaviest items first, so that they decide the balance.
+    stable_sort(items.begin(), items.end(),
+                [](const ShardItem &a, const ShardItem &b) {
+                    return a.cost > b.cost;
+                });
+
+    u64a total = 0;
+    for (const auto &item : items) {
+        total += item.cost;
+    }
+
+    // An item may join a shard carrying up to this much more than the
+    // lightest one, if they share literal keys.
+    const u64a slack = total / shards / 4;
+
+    vector<u64a> load(shards, 0);
+    vector<unordered_set<u32>> shard_keys(shards);
+    vector<vector<u32>> out(shards);
+
+    for (const auto &item : items) {
+        if (item.members.empty()) {
+            continue;
+        }
+
+        const u64a min_load = *min_element(load.begin(), load.end());
+        u32 best = shards;
+        size_t best_shared = 0;
+        for (u32 s = 0; s < shards; s++) {
+            if (load[s] > min_load + slack) {
+                continue;
+            }
+            size_t shared = 0;
+            for (u32 key : item.keys) {
+                shared += shard_keys[s].count(key);
+            }
+            if (best == shards || shared > best_shared ||
+                (shared == best_shared && load[s] < load[best])) {
+                best = s;
+                best_shared = shared;
+            }
+        }
+        assert(best < shards);
+
+        DEBUG_PRINTF("item of cost %llu -> shard %u (%zu shared keys)\n",
+                     item.cost, best, best_shared);
+        load[best] += item.cost;
+        shard_keys[best].insert(item.keys.begin(), item.keys.end());
+        out[best].insert(out[best].end(), item.members.begin(),
+                         item.members.end());
+    }
+
+    out.erase(remove_if(out.begin(), out.end(),
+                        [](const vector<u32> &v) { return v.empty(); }),
+              out.end());
+    for (auto &members : out) {
+        sort(members.begin(), members.end());
+    }
+    return out;
+}
+
+vector<vector<u32>>
+partitionExpressions(const CompileContext &cc, const char *const *expressions,
+                     const unsigned *flags, const unsigned *ids,
+                     const hs_expr_ext *const *ext, u32 elements, u32 shards) {
+    assert(expressions);
+    ReportManager rm(cc.grey);
+
+    vector<u64a> cost(elements, 0);
+    vector<vector<u32>> keys(elements);
+    vector<u32> parent(elements);
+    vector<u32> combinations;
+
+    for (u32 i = 0; i < elements; i++) {
+        parent[i] = i;
+        const unsigned fl = flags ? flags[i] : 0;
+        const unsigned id = ids ? ids[i] : 0;
+
+        if (!expressions[i]) {
+            throw CompileError(i, "Invalid parameter: expression is NULL.");
+        }
+
+        if (fl & HS_FLAG_COMBINATION) {
+            cost[i] = LITERAL_COST;
+            combinations.push_back(i);
+            continue;
+        }
+
+        try {
+            if (strlen(expressions[i]) > cc.grey.limitPatternLength) {
+                throw CompileError("Pattern length exceeds limit.");
+            }
+
+            ParsedExpression pe(i, expressions[i], fl, id,
+                                ext ? ext[i] : nullptr);
+            if (pe.prefilter) {
+                prefilterTree(pe.component, ParseMode(fl));
+            }
+
+            unique_ptr<NGWrapper> g = buildWrapper(rm, cc, pe);
+            if (!g) {
+                throw CompileError("Internal error.");
+            }
+
+            bool pure = false;
+            vector<string> runs = literalRuns(*g, &pure);
+            keys[i] = literalKeys(runs);
+
+            u64a states = num_vertices(*g) - N_SPECIALS;
+            cost[i] = pure ? LITERAL_COST
+                           : ENGINE_COST + states * (cc.streaming ? 2 : 1);
+            DEBUG_PRINTF("expr %u: cost %llu, %zu keys\n", i, cost[i],
+                         keys[i].size());
+        } catch (CompileError &e) {
+            e.setExpressionIndex(i);
+            throw;
+        }
+    }
+
+    unordered_map<unsigned, vector<u32>> by_id;
+    for (u32 i = 0; i < elements; i++) {
+        by_id[ids ? ids[i] : 0].push_back(i);
+    }
+
+    // Expressions that share a match ID must be compiled together, so that
+    // HS_FLAG_SINGLEMATCH and match dedupe still see all of them.
+    for (const auto &m : by_id) {
+        const vector<u32> &members = m.second;
+        for (size_t j = 1; j < members.size(); j++) {
+            parent[findRoot(parent, members[j])] =
+                findRoot(parent, members[0]);
+        }
+    }
+
+    // Combinations must live with every expression they refer to.
+    for (u32 c : combinations) {
+        ParsedLogical pl;
+        pl.addCombination(ids ? ids[c] : 0, expressions[c],
+                          flags[c] & HS_FLAG_SINGLEMATCH, c);
+        for (const auto &m : pl.subExpressionRefs()) {
+            auto it = by_id.find(m.first);
+            if (it == by_id.end()) {
+                continue; // reported by the compile proper
+            }
+            for (u32 j : it->second) {
+                parent[findRoot(parent, j)] = findRoot(parent, c);
+            }
+        }
+    }
+
+    vector<ShardItem> items;
+    unordered_map<u32, size_t> item_of_root;
+    for (u32 i = 0; i < elements; i++) {
+        u32 root = findRoot(parent, i);
+        auto it = item_of_root.find(root);
+        if (it == item_of_root.end()) {
+            it = item_of_root.emplace(root, items.size()).first;
+            items.push_back(ShardItem());
+        }
+        ShardItem &item = items[it->second];
+        item.members.push_back(i);
+        item.cost += cost[i];
+        item.keys.insert(item.keys.end(), keys[i].begin(), keys[i].end());
+    }
+    for (auto &item : items) {
+        sort(item.keys.begin(), item.keys.end());
+        item.keys.erase(unique(item.keys.begin(), item.keys.end()),
+                        item.keys.end());
+    }
+
+    return assignShards(move(items), shards);
+}
+
+} // namespace ue2
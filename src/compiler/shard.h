@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Partitioning of an expression set into shards, each of which is
+ * compiled into its own database.
+ */
+
+#ifndef COMPILER_SHARD_H
+#define COMPILER_SHARD_H
+
+#include "ue2common.h"
+
+#include <vector>
+
+struct hs_expr_ext;
+
+namespace ue2 {
+
+struct CompileContext;
+
+/** \brief A unit of work that must be placed in a single shard. */
+struct ShardItem {
+    /** \brief Indices of the expressions in this item. */
+    std::vector<u32> members;
+
+    /** \brief Estimated cost of the item's expressions in a database. */
+    u64a cost = 0;
+
+    /** \brief Sorted literal factor keys; items sharing keys are best kept
+     * together so that the literal matcher work is not repeated. */
+    std::vector<u32> keys;
+};
+
+/**
+ * \brief Assigns items to at most \a shards shards, balancing the total cost
+ * of each shard while grouping items with common literal keys.
+ *
+ * Returns the expression indices of each non-empty shard, in ascending order.
+ */
+std::vector<std::vector<u32>> assignShards(std::vector<ShardItem> items,
+                                           u32 shards);
+
+/**
+ * \brief Partitions the given expressions into at most \a shards sets.
+ *
+ * Each expression is parsed and analysed by a simple cost model: literal
+ * expressions are cheap, others cost an engine plus their state count (which
+ * weighs double in streaming mode, where it becomes stream state). Logical
+ * combinations are always placed with their sub-expressions.
+ *
+ * Throws a CompileError, carrying the index of the offending expression, if
+ * an expression cannot be parsed.
+ */
+std::vector<std::vector<u32>>
+partitionExpressions(const CompileContext &cc, const char *const *expressions,
+                     const unsigned *flags, const unsigned *ids,
+                     const hs_expr_ext *const *ext, u32 elements, u32 shards);
+
+} // namespace ue2
+
+#endif // COMPILER_SHARD_H
@@ -53,6 +53,10 @@ hs_error_t hs_free_database(hs_database_t *db) {
     if (db && db->magic != HS_DB_MAGIC) {
         return HS_INVALID;
     }
+    if (db && (db->flags & HS_DB_FLAG_IMAGE)) {
+        // Images are owned by the caller, not by our allocator.
+        return HS_INVALID;
+    }
     hs_database_free(db);
 
     return HS_SUCCESS;
@@ -96,7 +100,7 @@ hs_error_t hs_serialize_database(const hs_database_t *db, char **bytes,
     buf += 2;
     *buf = db->crc32;
     buf++;
-    *buf = db->reserved0;
+    *buf = 0; // flags are not serialized
     buf++;
     *buf = db->reserved1;
     buf++;
@@ -114,7 +118,8 @@ hs_error_t hs_serialize_database(const hs_database_t *db, char **bytes,
 static
 hs_error_t db_check_platform(const u64a p) {
     if (p != hs_current_platform
-        && p != hs_current_platform_no_avx2) {
+        && p != (hs_current_platform | hs_current_platform_no_avx2)
+        && p != (hs_current_platform | hs_current_platform_no_avx512)) {
         return HS_DB_PLATFORM_ERROR;
     }
     // passed all checks
@@ -163,7 +168,7 @@ hs_error_t db_decode_header(const char **bytes, const size_t length,
     header->platform = unaligned_load_u64a(buf);
     buf += 2;
     header->crc32 = unaligned_load_u32(buf++);
-    header->reserved0 = unaligned_load_u32(buf++);
+    buf++; // flags are not serialized; header->flags remains zero
     header->reserved1 = unaligned_load_u32(buf++);
 
     *bytes = (const char *)buf;
@@ -285,6 +290,103 @@ hs_error_t hs_deserialize_database(const char *bytes, const size_t length,
     return HS_SUCCESS;
 }
 
+HS_PUBLIC_API
+hs_error_t hs_serialize_database_image(const hs_database_t *db, char **bytes,
+                                       size_t *length) {
+    if (!db || !bytes || !length) {
+        return HS_INVALID;
+    }
+
+    if (!db_correctly_aligned(db)) {
+        return HS_BAD_ALIGN;
+    }
+
+    hs_error_t ret = validDatabase(db);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    size_t image_len = HS_DB_IMAGE_BYTECODE_OFFSET + db->length;
+
+    char *out = hs_misc_alloc(image_len);
+    ret = hs_check_alloc(out);
+    if (ret != HS_SUCCESS) {
+        hs_misc_free(out);
+        return ret;
+    }
+
+    memset(out, 0, image_len);
+
+    // The header fields all precede the bytecode offset; only the padding at
+    // the end of struct hs_database overlaps the bytecode.
+    assert(offsetof(struct hs_database, padding) <=
+           HS_DB_IMAGE_BYTECODE_OFFSET);
+
+    struct hs_database header;
+    memset(&header, 0, sizeof(header));
+    header.magic = db->magic;
+    header.version = db->version;
+    header.length = db->length;
+    header.platform = db->platform;
+    header.crc32 = db->crc32;
+    header.flags = HS_DB_FLAG_IMAGE;
+    header.bytecode = HS_DB_IMAGE_BYTECODE_OFFSET;
+    memcpy(out, &header, offsetof(struct hs_database, padding));
+
+    memcpy(out + HS_DB_IMAGE_BYTECODE_OFFSET, hs_get_bytecode(db), db->length);
+
+    *bytes = out;
+    *length = image_len;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_load_database_image(const char *bytes, const size_t length,
+                                  const hs_database_t **db) {
+    if (!bytes || !db) {
+        return HS_INVALID;
+    }
+
+    *db = NULL;
+
+    // The image is used in place, so it must provide the bytecode's cacheline
+    // alignment itself.
+    if (!ISALIGNED_CL(bytes)) {
+        return HS_BAD_ALIGN;
+    }
+
+    if (length < HS_DB_IMAGE_BYTECODE_OFFSET) {
+        return HS_INVALID;
+    }
+
+    const struct hs_database *image = (const struct hs_database *)bytes;
+    if (image->magic != HS_DB_MAGIC) {
+        return HS_INVALID;
+    }
+    if (image->version != HS_DB_VERSION) {
+        return HS_DB_VERSION_ERROR;
+    }
+    if (!(image->flags & HS_DB_FLAG_IMAGE) ||
+        image->bytecode != HS_DB_IMAGE_BYTECODE_OFFSET ||
+        length != (size_t)HS_DB_IMAGE_BYTECODE_OFFSET + image->length) {
+        DEBUG_PRINTF("bad image header\n");
+        return HS_INVALID;
+    }
+
+    hs_error_t ret = db_check_platform(image->platform);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    ret = db_check_crc(image);
+    if (ret != HS_SUCCESS) {
+        return ret;
+    }
+
+    *db = image;
+    return HS_SUCCESS;
+}
+
 HS_PUBLIC_API
 hs_error_t hs_database_size(const hs_database_t *db, size_t *size) {
     if (!size) {
@@ -296,7 +398,11 @@ hs_error_t hs_database_size(const hs_database_t *db, size_t *size) {
         return ret;
     }
 
-    *size = sizeof(struct hs_database) + db->length;
+    if (db->flags & HS_DB_FLAG_IMAGE) {
+        *size = HS_DB_IMAGE_BYTECODE_OFFSET + db->length;
+    } else {
+        *size = sizeof(struct hs_database) + db->length;
+    }
     return HS_SUCCESS;
 }
 
@@ -403,7 +509,9 @@ hs_error_t print_database_string(char **s, u32 version, const platform_t plat,
     u8 minor = (version >> 16) & 0xff;
     u8 major = (version >> 24) & 0xff;
 
-    const char *avx2 = (plat & HS_PLATFORM_NOAVX2)  ? "NOAVX2" : " AVX2";
+    const char *features = (plat & HS_PLATFORM_NOAVX512)
+                               ? (plat & HS_PLATFORM_NOAVX2) ? "" : "AVX2"
+                               : "AVX512";
 
     const char *mode = NULL;
 
@@ -432,7 +540,7 @@ hs_error_t print_database_string(char **s, u32 version, const platform_t plat,
         // that don't have snprintf but have a workalike.
         int p_len = SNPRINTF_COMPAT(
             buf, len, "Version: %u.%u.%u Features: %s Mode: %s",
-            major, minor, release, avx2, mode);
+            major, minor, release, features, mode);
         if (p_len < 0) {
             DEBUG_PRINTF("snprintf output error, returned %d\n", p_len);
             hs_misc_free(buf);
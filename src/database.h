@@ -53,6 +53,16 @@ extern "C"
 #define HS_PLATFORM_CPU_MASK        0x3F
 
 #define HS_PLATFORM_NOAVX2          (4<<13)
+#define HS_PLATFORM_NOAVX512        (8<<13)
+
+/** \brief Database header flag: this database is a loaded image, referring
+ * to caller-owned (and possibly read-only) memory, see
+ * hs_load_database_image(). */
+#define HS_DB_FLAG_IMAGE            1
+
+/** \brief Offset of the bytecode within a database image. Images are loaded
+ * from 64-byte aligned memory, so this keeps the bytecode cacheline aligned. */
+#define HS_DB_IMAGE_BYTECODE_OFFSET 64
 
 /** \brief Platform features bitmask. */
 typedef u64a platform_t;
@@ -61,6 +71,9 @@ static UNUSED
 const platform_t hs_current_platform = {
 #if !defined(__AVX2__)
     HS_PLATFORM_NOAVX2 |
+#endif
+#if !defined(__AVX512BW__)
+    HS_PLATFORM_NOAVX512 |
 #endif
     0,
 };
@@ -68,6 +81,13 @@ const platform_t hs_current_platform = {
 static UNUSED
 const platform_t hs_current_platform_no_avx2 = {
     HS_PLATFORM_NOAVX2 |
+    HS_PLATFORM_NOAVX512 |
+    0,
+};
+
+static UNUSED
+const platform_t hs_current_platform_no_avx512 = {
+    HS_PLATFORM_NOAVX512 |
     0,
 };
 
@@ -81,7 +101,7 @@ struct hs_database {
     u32 length;
     u64a platform;
     u32 crc32;
-    u32 reserved0;
+    u32 flags;       // HS_DB_FLAG_* values
     u32 reserved1;
     u32 bytecode;    // offset relative to db start
     u32 padding[16];
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Fat runtime dispatcher: selects a microarchitecture-specific build of
+ * the runtime when the library is loaded.
+ *
+ * Each variant of the runtime is built with its symbols renamed with a
+ * prefix (see cmake/build_wrapper.sh); the public API entry points defined
+ * here are ifuncs whose resolvers pick the best variant for the host.
+ */
+
+#include "config.h"
+#include "hs_common.h"
+#include "hs_runtime.h"
+#include "ue2common.h"
+#include "util/cpuid_flags.h"
+#include "util/join.h"
+
+#if defined(BUILD_AVX512)
+#define DECLARE_AVX512(RTYPE, NAME, ...) RTYPE JOIN(avx512_, NAME)(__VA_ARGS__);
+#define CHECK_AVX512(NAME)                                                     \
+    if (check_avx512()) {                                                      \
+        return JOIN(avx512_, NAME);                                            \
+    }
+#else
+#define DECLARE_AVX512(RTYPE, NAME, ...)
+#define CHECK_AVX512(NAME)
+#endif
+
+#define CREATE_DISPATCH_IMPL(RTYPE, ERR_RV, NAME, ...)                         \
+    /* create defns */                                                         \
+    DECLARE_AVX512(RTYPE, NAME, __VA_ARGS__)                                   \
+    RTYPE JOIN(avx2_, NAME)(__VA_ARGS__);                                      \
+    RTYPE JOIN(core2_, NAME)(__VA_ARGS__);                                     \
+                                                                               \
+    /* error func */                                                           \
+    static RTYPE JOIN(error_, NAME)(__VA_ARGS__) {                             \
+        return ERR_RV;                                                         \
+    }                                                                          \
+                                                                               \
+    /* resolver */                                                             \
+    static RTYPE (*JOIN(resolve_, NAME)(void))(__VA_ARGS__) {                  \
+        CHECK_AVX512(NAME)                                                     \
+        if (check_avx2()) {                                                    \
+            return JOIN(avx2_, NAME);                                          \
+        }                                                                      \
+        if (check_ssse3()) {                                                   \
+            return JOIN(core2_, NAME);                                         \
+        }                                                                      \
+        /* anything else is fail */                                            \
+        return JOIN(error_, NAME);                                             \
+    }
+
+/** \brief Dispatch a public runtime API function returning hs_error_t. */
+#define CREATE_DISPATCH(RTYPE, NAME, ...)                                      \
+    CREATE_DISPATCH_IMPL(RTYPE, HS_ARCH_ERROR, NAME, __VA_ARGS__)              \
+                                                                               \
+    /* function */                                                             \
+    HS_PUBLIC_API                                                              \
+    RTYPE NAME(__VA_ARGS__) __attribute__((ifunc("resolve_" #NAME)))
+
+CREATE_DISPATCH(hs_error_t, hs_scan, const hs_database_t *db, const char *data,
+                unsigned length, unsigned flags, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *userCtx);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_batch, const hs_database_t *db,
+                const char *const *data, const unsigned int *length,
+                unsigned int count, unsigned int flags, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *const *context);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_bitmap, const hs_database_t *db,
+                const char *data, unsigned int length, unsigned int flags,
+                hs_scratch_t *scratch, unsigned char *bitmap,
+                unsigned int num_ids);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_count, const hs_database_t *db,
+                const char *data, unsigned int length, unsigned int flags,
+                hs_scratch_t *scratch, unsigned long long *counts,
+                unsigned int num_ids);
+
+CREATE_DISPATCH(hs_error_t, hs_stream_size, const hs_database_t *database,
+                size_t *stream_size);
+
+CREATE_DISPATCH(hs_error_t, hs_database_size, const hs_database_t *db,
+                size_t *size);
+
+CREATE_DISPATCH(hs_error_t, hs_free_database, hs_database_t *db);
+
+CREATE_DISPATCH(hs_error_t, hs_open_stream, const hs_database_t *db,
+                unsigned flags, hs_stream_t **stream);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_stream, hs_stream_t *id, const char *data,
+                unsigned int length, unsigned int flags, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *ctxt);
+
+CREATE_DISPATCH(hs_error_t, hs_close_stream, hs_stream_t *id,
+                hs_scratch_t *scratch, match_event_handler onEvent, void *ctxt);
+
+CREATE_DISPATCH(hs_error_t, hs_scan_vector, const hs_database_t *db,
+                const char *const *data, const unsigned int *length,
+                unsigned int count, unsigned int flags, hs_scratch_t *scratch,
+                match_event_handler onevent, void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_database_info, const hs_database_t *db,
+                char **info);
+
+CREATE_DISPATCH(hs_error_t, hs_copy_stream, hs_stream_t **to_id,
+                const hs_stream_t *from_id);
+
+CREATE_DISPATCH(hs_error_t, hs_reset_stream, hs_stream_t *id,
+                unsigned int flags, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_reset_and_copy_stream, hs_stream_t *to_id,
+                const hs_stream_t *from_id, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_compress_stream, const hs_stream_t *stream,
+                char *buf, size_t buf_space, size_t *used_space);
+
+CREATE_DISPATCH(hs_error_t, hs_expand_stream, const hs_database_t *db,
+                hs_stream_t **stream, const char *buf, size_t buf_size);
+
+CREATE_DISPATCH(hs_error_t, hs_reset_and_expand_stream, hs_stream_t *to_stream,
+                const char *buf, size_t buf_size, hs_scratch_t *scratch,
+                match_event_handler onEvent, void *context);
+
+CREATE_DISPATCH(hs_error_t, hs_serialize_database, const hs_database_t *db,
+                char **bytes, size_t *length);
+
+CREATE_DISPATCH(hs_error_t, hs_deserialize_database, const char *bytes,
+                const size_t length, hs_database_t **db);
+
+CREATE_DISPATCH(hs_error_t, hs_deserialize_database_at, const char *bytes,
+                const size_t length, hs_database_t *db);
+
+CREATE_DISPATCH(hs_error_t, hs_serialize_database_image,
+                const hs_database_t *db, char **bytes, size_t *length);
+
+CREATE_DISPATCH(hs_error_t, hs_load_database_image, const char *bytes,
+                const size_t length, const hs_database_t **db);
+
+CREATE_DISPATCH(hs_error_t, hs_serialized_database_info, const char *bytes,
+                size_t length, char **info);
+
+CREATE_DISPATCH(hs_error_t, hs_serialized_database_size, const char *bytes,
+                const size_t length, size_t *deserialized_size);
+
+CREATE_DISPATCH(hs_error_t, hs_alloc_scratch, const hs_database_t *db,
+                hs_scratch_t **scratch);
+
+CREATE_DISPATCH(hs_error_t, hs_clone_scratch, const hs_scratch_t *src,
+                hs_scratch_t **dest);
+
+CREATE_DISPATCH(hs_error_t, hs_free_scratch, hs_scratch_t *scratch);
+
+CREATE_DISPATCH(hs_error_t, hs_scratch_size, const hs_scratch_t *scratch,
+                size_t *scratch_size);
+
+CREATE_DISPATCH(hs_error_t, hs_alloc_scratch_pool, const hs_database_t *db,
+                unsigned int size, hs_scratch_pool_t **pool);
+
+CREATE_DISPATCH(hs_error_t, hs_scratch_pool_add_database,
+                hs_scratch_pool_t *pool, const hs_database_t *db);
+
+CREATE_DISPATCH(hs_error_t, hs_scratch_pool_acquire, hs_scratch_pool_t *pool,
+                hs_scratch_t **scratch);
+
+CREATE_DISPATCH(hs_error_t, hs_scratch_pool_release, hs_scratch_pool_t *pool,
+                hs_scratch_t *scratch);
+
+CREATE_DISPATCH(hs_error_t, hs_free_scratch_pool, hs_scratch_pool_t *pool);
+
+CREATE_DISPATCH(hs_error_t, hs_scratch_profile, const hs_database_t *db,
+                const hs_scratch_t *scratch, hs_profile_t *profile);
+
+CREATE_DISPATCH(hs_error_t, hs_scratch_profile_engine,
+                const hs_database_t *db, const hs_scratch_t *scratch,
+                unsigned int engine, hs_profile_engine_t *info);
+
+CREATE_DISPATCH(hs_error_t, hs_scratch_profile_pattern,
+                const hs_database_t *db, const hs_scratch_t *scratch,
+                unsigned int pattern, hs_profile_pattern_t *info);
+
+CREATE_DISPATCH(hs_error_t, hs_reset_scratch_profile, hs_scratch_t *scratch);
+
+/* Internal entry points used by the compiler. */
+
+struct hs_database;
+
+CREATE_DISPATCH_IMPL(struct hs_database *, NULL, dbCreate,
+                     const char *in_bytecode, size_t len, u64a platform)
+
+struct hs_database *dbCreate(const char *in_bytecode, size_t len,
+                             u64a platform)
+    __attribute__((ifunc("resolve_dbCreate")));
@@ -312,6 +312,174 @@ void get_conf_stride_4(const u8 *itPtr, const u8 *start_ptr, const u8 *end_ptr,
     *conf8 ^= ~0ULL;
 }
 
+/* Wide state variants of the main loop. These use the same table layout as
+ * get_conf_stride_*(), but compute the state for 32 (AVX2) or 64 (AVX-512)
+ * positions per iteration. Each 16-byte lane of the wide state covers 16
+ * positions: the table entries for the first eight positions of every lane
+ * are combined in one vector ("even") and those for the second eight in
+ * another ("odd"), using per-lane byte shifts. The overhang from each lane's
+ * odd half is then carried into the next lane, and the overhang from the last
+ * lane becomes the incoming 128-bit state for the next iteration, so the
+ * state passed between iterations has the same meaning as it does for the
+ * 128-bit loop. */
+
+/** \brief Load the data words used to hash each group of eight positions.
+ *
+ * d[g] holds the eight bytes of group g; d7[g] the two bytes used to hash its
+ * last position, which takes in the first byte of the following group. */
+static really_inline
+void load_wide_data(const u8 *itPtr, const u8 *start_ptr, const u8 *end_ptr,
+                    u64a domain_mask_adjusted, const u32 stride,
+                    const u32 groups, u64a *d, u64a *d7) {
+    for (u32 g = 0; g < groups; g++) {
+        d[g] = lv_u64a(itPtr + g * 8, start_ptr, end_ptr);
+        if (stride == 1) {
+            /* +1: the zones ensure that we can read the byte at z->end */
+            d7[g] = (lv_u16(itPtr + g * 8 + 7, start_ptr, end_ptr + 1) << 1) &
+                    domain_mask_adjusted;
+        }
+    }
+}
+
+/* hash (pre-scaled table offset) for position k of group g */
+#define WIDE_HASH(g, k)                                                     \
+    ((k) == 7 ? d7[g]                                                       \
+              : (k) ? (d[g] >> (8 * (k) - 1)) & domain_mask_adjusted        \
+                    : (d[g] << 1) & domain_mask_adjusted)
+
+#if defined(__AVX2__)
+
+#define WIDE_ITER_BYTES_256 32
+
+/* table entries for position k of groups g0 and g1 */
+#define LOAD_PAIR_256(g0, g1, k)                                            \
+    insert128to256(cast128to256(load128(ft + WIDE_HASH(g0, k) * 8)),       \
+                   load128(ft + WIDE_HASH(g1, k) * 8), 1)
+
+/* ... shifted into place */
+#define LOAD_LANES_256(g0, g1, k) byteShiftLeft256(LOAD_PAIR_256(g0, g1, k), k)
+
+#define OR_POSITION_256(k)                                                  \
+    do {                                                                    \
+        even = or256(even, LOAD_LANES_256(0, 2, k));                        \
+        odd = or256(odd, LOAD_LANES_256(1, 3, k));                          \
+    } while (0)
+
+static really_inline
+u32 get_conf_wide_256(const u8 *itPtr, const u8 *start_ptr, const u8 *end_ptr,
+                      u64a domain_mask_adjusted, const u8 *ft, const u32 stride,
+                      u64a *conf, m128 *s) {
+    u64a d[4];
+    u64a d7[4];
+    load_wide_data(itPtr, start_ptr, end_ptr, domain_mask_adjusted, stride, 4,
+                   d, d7);
+
+    m256 even = LOAD_PAIR_256(0, 2, 0);
+    m256 odd = LOAD_PAIR_256(1, 3, 0);
+    OR_POSITION_256(4);
+    if (stride <= 2) {
+        OR_POSITION_256(2);
+        OR_POSITION_256(6);
+    }
+    if (stride == 1) {
+        OR_POSITION_256(1);
+        OR_POSITION_256(3);
+        OR_POSITION_256(5);
+        OR_POSITION_256(7);
+    }
+
+    m256 carry = byteShiftRight256(odd, 8);
+    m256 st = or256(even, byteShiftLeft256(odd, 8));
+    /* lane 0 takes the incoming state, lane 1 the overhang from lane 0 */
+    st = or256(st, _mm256_permute2x128_si256(carry, cast128to256(*s), 0x02));
+    *s = _mm256_extracti128_si256(carry, 1);
+
+    if (likely(!diff256(st, ones256()))) {
+        return 0;
+    }
+
+    union {
+        m256 val256;
+        u64a val64[WIDE_ITER_BYTES_256 / 8];
+    } c;
+    c.val256 = not256(st);
+    for (u32 i = 0; i < WIDE_ITER_BYTES_256 / 8; i++) {
+        conf[i] = c.val64[i];
+    }
+    return 1;
+}
+
+#endif // __AVX2__
+
+#if defined(__AVX512BW__)
+
+#define WIDE_ITER_BYTES_512 64
+
+/* table entries for position k of groups g0 to g3 */
+#define LOAD_QUAD_512(g0, g1, g2, g3, k)                                    \
+    _mm512_inserti64x4(_mm512_castsi256_si512(LOAD_PAIR_256(g0, g1, k)),    \
+                       LOAD_PAIR_256(g2, g3, k), 1)
+
+/* ... shifted into place */
+#define LOAD_LANES_512(g0, g1, g2, g3, k)                                   \
+    _mm512_bslli_epi128(LOAD_QUAD_512(g0, g1, g2, g3, k), k)
+
+#define OR_POSITION_512(k)                                                  \
+    do {                                                                    \
+        even = _mm512_or_si512(even, LOAD_LANES_512(0, 2, 4, 6, k));        \
+        odd = _mm512_or_si512(odd, LOAD_LANES_512(1, 3, 5, 7, k));          \
+    } while (0)
+
+static really_inline
+u32 get_conf_wide_512(const u8 *itPtr, const u8 *start_ptr, const u8 *end_ptr,
+                      u64a domain_mask_adjusted, const u8 *ft, const u32 stride,
+                      u64a *conf, m128 *s) {
+    u64a d[8];
+    u64a d7[8];
+    load_wide_data(itPtr, start_ptr, end_ptr, domain_mask_adjusted, stride, 8,
+                   d, d7);
+
+    __m512i even = LOAD_QUAD_512(0, 2, 4, 6, 0);
+    __m512i odd = LOAD_QUAD_512(1, 3, 5, 7, 0);
+    OR_POSITION_512(4);
+    if (stride <= 2) {
+        OR_POSITION_512(2);
+        OR_POSITION_512(6);
+    }
+    if (stride == 1) {
+        OR_POSITION_512(1);
+        OR_POSITION_512(3);
+        OR_POSITION_512(5);
+        OR_POSITION_512(7);
+    }
+
+    __m512i carry = _mm512_bsrli_epi128(odd, 8);
+    __m512i st = _mm512_or_si512(even, _mm512_bslli_epi128(odd, 8));
+    /* lane 0 takes the incoming state (broadcast, so that it is available in
+     * lane 3 for the alignr), lanes 1-3 the overhang from lanes 0-2 */
+    st = _mm512_or_si512(st, _mm512_alignr_epi64(carry,
+                                                 _mm512_broadcast_i32x4(*s),
+                                                 6));
+    *s = _mm512_extracti32x4_epi32(carry, 3);
+
+    const __m512i ones = _mm512_set1_epi8(0xff);
+    if (likely(!_mm512_cmpneq_epi64_mask(st, ones))) {
+        return 0;
+    }
+
+    union {
+        __m512i val512;
+        u64a val64[WIDE_ITER_BYTES_512 / 8];
+    } c;
+    c.val512 = _mm512_xor_si512(st, ones);
+    for (u32 i = 0; i < WIDE_ITER_BYTES_512 / 8; i++) {
+        conf[i] = c.val64[i];
+    }
+    return 1;
+}
+
+#endif // __AVX512BW__
+
 static really_inline
 void do_confirm_fdr(u64a *conf, u8 offset, hwlmcb_rv_t *controlVal,
                     const u32 *confBase, const struct FDR_Runtime_Args *a,
@@ -702,9 +870,70 @@ size_t prepareZones(const u8 *buf, size_t len, const u8 *hend,
         } /* end for loop */                                                \
     } while (0)                                                             \
 
-static never_inline
-hwlm_error_t fdr_engine_exec(const struct FDR *fdr,
-                             const struct FDR_Runtime_Args *a) {
+/* Runs the wide state loop over as much of the zone as it can, leaving the
+ * remainder (less than iter_bytes) to FDR_MAIN_LOOP(). Only the main zone is
+ * ever long enough for this to scan anything. */
+#define FDR_WIDE_LOOP(zz, s, get_conf_fn, iter_bytes, stride)               \
+    do {                                                                    \
+        const u8 *tryFloodDetect = zz->floodPtr;                            \
+        const u8 *start_ptr = zz->start;                                    \
+        const u8 *end_ptr = zz->end;                                        \
+        const u8 *itPtr = start_ptr;                                        \
+                                                                            \
+        for (; itPtr + iter_bytes <= end_ptr; itPtr += iter_bytes) {        \
+            if (unlikely(itPtr > tryFloodDetect)) {                         \
+                tryFloodDetect = floodDetect(fdr, a, &itPtr, tryFloodDetect,\
+                                             &floodBackoff, &controlVal,    \
+                                             iter_bytes);                   \
+                if (unlikely(controlVal == HWLM_TERMINATE_MATCHING)) {      \
+                    return HWLM_TERMINATED;                                 \
+                }                                                           \
+            }                                                               \
+            __builtin_prefetch(itPtr + (iter_bytes*4));                     \
+            u64a conf[iter_bytes / 8];                                      \
+            if (!get_conf_fn(itPtr, start_ptr, end_ptr,                     \
+                             domain_mask_adjusted, ft, stride, conf, &s)) { \
+                continue;                                                   \
+            }                                                               \
+            for (u32 i = 0; i < iter_bytes / 8; i++) {                      \
+                do_confirm_fdr(&conf[i], i * 8, &controlVal, confBase, a,   \
+                               itPtr, control, &last_match_id, zz);         \
+            }                                                               \
+            if (unlikely(controlVal == HWLM_TERMINATE_MATCHING)) {          \
+                return HWLM_TERMINATED;                                     \
+            }                                                               \
+        } /* end for loop */                                                \
+        zz->start = itPtr;                                                  \
+        zz->floodPtr = tryFloodDetect;                                      \
+    } while (0)
+
+#if defined(__AVX2__)
+#define FDR_WIDE_LOOP_256(zz, s, stride)                                    \
+    FDR_WIDE_LOOP(zz, s, get_conf_wide_256, WIDE_ITER_BYTES_256, stride)
+#else
+#define FDR_WIDE_LOOP_256(zz, s, stride) do {} while (0)
+#endif
+
+#if defined(__AVX512BW__)
+#define FDR_WIDE_LOOP_512(zz, s, stride)                                    \
+    FDR_WIDE_LOOP(zz, s, get_conf_wide_512, WIDE_ITER_BYTES_512, stride)
+#else
+#define FDR_WIDE_LOOP_512(zz, s, stride) do {} while (0)
+#endif
+
+#define FDR_WIDE_LOOPS(zz, s, state_width, stride)                          \
+    do {                                                                    \
+        if (state_width == 512) {                                           \
+            FDR_WIDE_LOOP_512(zz, s, stride);                               \
+        } else if (state_width == 256) {                                    \
+            FDR_WIDE_LOOP_256(zz, s, stride);                               \
+        }                                                                   \
+    } while (0)
+
+static really_inline
+hwlm_error_t fdr_engine_exec_i(const struct FDR *fdr,
+                               const struct FDR_Runtime_Args *a,
+                               const u32 state_width) {
     hwlmcb_rv_t controlVal = *a->groups;
     hwlmcb_rv_t *control = &controlVal;
     u32 floodBackoff = FLOOD_BACKOFF_START;
@@ -749,12 +978,15 @@ hwlm_error_t fdr_engine_exec(const struct FDR *fdr,
 
         switch (stride) {
         case 1:
+            FDR_WIDE_LOOPS(z, state, state_width, 1);
             FDR_MAIN_LOOP(z, state, get_conf_stride_1);
             break;
         case 2:
+            FDR_WIDE_LOOPS(z, state, state_width, 2);
             FDR_MAIN_LOOP(z, state, get_conf_stride_2);
             break;
         case 4:
+            FDR_WIDE_LOOPS(z, state, state_width, 4);
             FDR_MAIN_LOOP(z, state, get_conf_stride_4);
             break;
         default:
@@ -765,12 +997,40 @@ hwlm_error_t fdr_engine_exec(const struct FDR *fdr,
     return HWLM_SUCCESS;
 }
 
+static never_inline
+hwlm_error_t fdr_engine_exec(const struct FDR *fdr,
+                             const struct FDR_Runtime_Args *a) {
+    return fdr_engine_exec_i(fdr, a, 128);
+}
+
+#if defined(__AVX2__)
+static never_inline
+hwlm_error_t fdr_engine_exec_avx2(const struct FDR *fdr,
+                                  const struct FDR_Runtime_Args *a) {
+    return fdr_engine_exec_i(fdr, a, 256);
+}
+#endif
+
+#if defined(__AVX512BW__)
+static never_inline
+hwlm_error_t fdr_engine_exec_avx512(const struct FDR *fdr,
+                                    const struct FDR_Runtime_Args *a) {
+    return fdr_engine_exec_i(fdr, a, 512);
+}
+#endif
+
 #if defined(__AVX2__)
 #define ONLY_AVX2(func) func
 #else
 #define ONLY_AVX2(func) NULL
 #endif
 
+#if defined(__AVX512BW__)
+#define ONLY_AVX512(func) func
+#else
+#define ONLY_AVX512(func) NULL
+#endif
+
 typedef hwlm_error_t (*FDRFUNCTYPE)(const struct FDR *fdr, const struct FDR_Runtime_Args *a);
 static const FDRFUNCTYPE funcs[] = {
     fdr_engine_exec,
@@ -792,8 +1052,53 @@ static const FDRFUNCTYPE funcs[] = {
     fdr_exec_teddy_msks3_pck,
     fdr_exec_teddy_msks4,
     fdr_exec_teddy_msks4_pck,
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks1),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks1_pck),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks2),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks2_pck),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks3),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks3_pck),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks4),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks4_pck),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks1_fat),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks1_pck_fat),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks2_fat),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks2_pck_fat),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks3_fat),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks3_pck_fat),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks4_fat),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks4_pck_fat),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks1_wide),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks1_pck_wide),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks2_wide),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks2_pck_wide),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks3_wide),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks3_pck_wide),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks4_wide),
+    ONLY_AVX512(fdr_exec_teddy_avx512_msks4_pck_wide),
+    ONLY_AVX2(fdr_engine_exec_avx2),
+    ONLY_AVX512(fdr_engine_exec_avx512),
 };
 
+char fdrEngineIsTeddy(const struct FDR *fdr) {
+    assert(fdr->engineID < ARRAY_LENGTH(funcs));
+    const FDRFUNCTYPE f = funcs[fdr->engineID];
+    if (f == fdr_engine_exec) {
+        return 0;
+    }
+#if defined(__AVX2__)
+    if (f == fdr_engine_exec_avx2) {
+        return 0;
+    }
+#endif
+#if defined(__AVX512BW__)
+    if (f == fdr_engine_exec_avx512) {
+        return 0;
+    }
+#endif
+    return 1;
+}
+
 #define FAKE_HISTORY_SIZE 16
 static const u8 fake_history[FAKE_HISTORY_SIZE];
 
@@ -47,6 +47,10 @@ struct FDR;
  * there is active FDR history beyond the regularly used history. */
 u32 fdrStreamStateActive(const struct FDR *fdr, const u8 *stream_state);
 
+/** \brief Returns non-zero if the given matcher uses one of the Teddy
+ * engines rather than FDR proper. */
+char fdrEngineIsTeddy(const struct FDR *fdr);
+
 /**
  * \brief Block-mode scan.
  *
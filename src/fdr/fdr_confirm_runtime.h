@@ -35,6 +35,7 @@
 #include "ue2common.h"
 #include "util/bitutils.h"
 #include "util/compare.h"
+#include "util/profile.h"
 
 // this is ordinary confirmation function which runs through
 // the whole confirmation procedure
@@ -59,6 +60,7 @@ void confWithBit(const struct FDRConfirm *fdrc, const struct FDR_Runtime_Args *a
     u8 oldNext; // initialized in loop
     do {
         assert(ISALIGNED(li));
+        PROFILE_EVENT(confirms, 1);
 
         if (unlikely((conf_key & li->msk) != li->v)) {
             goto out;
@@ -155,6 +157,7 @@ void confWithBit1(const struct FDRConfirm *fdrc,
     } else {
         u32 id = fdrc->nBitsOrSoleID;
 
+        PROFILE_EVENT(confirms, 1);
         if ((*last_match == id) && (fdrc->flags & NoRepeat)) {
             return;
         }
@@ -184,6 +187,7 @@ void confWithBitMany(const struct FDRConfirm *fdrc,
         const u32 id = fdrc->nBitsOrSoleID;
         const u32 len = fdrc->soleLitSize;
 
+        PROFILE_EVENT(confirms, 1);
         if ((*last_match == id) && (fdrc->flags & NoRepeat)) {
             return;
         }
@@ -46,7 +46,8 @@ FDREngineDescription::FDREngineDescription(const FDREngineDef &def)
     : EngineDescription(def.id, targetByArchFeatures(def.cpu_features),
                         def.numBuckets, def.confirmPullBackDistance,
                         def.confirmTopLevelSplit),
-      schemeWidth(def.schemeWidth), stride(0), bits(0) {}
+      schemeWidth(def.schemeWidth), stateWidth(def.stateWidth), stride(0),
+      bits(0) {}
 
 u32 FDREngineDescription::getDefaultFloodSuffixLength() const {
     // rounding up, so that scheme width 32 and 6 buckets is 6 not 5!
@@ -55,9 +56,18 @@ u32 FDREngineDescription::getDefaultFloodSuffixLength() const {
 }
 
 void getFdrDescriptions(vector<FDREngineDescription> *out) {
-    static const FDREngineDef def = {0, 128, 8, 0, 1, 256};
+    // All models share the same table layout; the wider models consume 32 or
+    // 64 bytes of input per iteration in the main loop. Engine IDs must not
+    // collide with those used by Teddy.
+    static const FDREngineDef defns[] = {
+        {0, 128, 8, 0, 1, 256, 128},
+        {43, 128, 8, HS_CPU_FEATURES_AVX2, 1, 256, 256},
+        {44, 128, 8, HS_CPU_FEATURES_AVX512, 1, 256, 512},
+    };
     out->clear();
-    out->emplace_back(def);
+    for (const auto &def : defns) {
+        out->emplace_back(def);
+    }
 }
 
 static
@@ -112,81 +122,90 @@ unique_ptr<FDREngineDescription> chooseEngine(const target_t &target,
     FDREngineDescription *best = nullptr;
     u32 best_score = 0;
 
-    FDREngineDescription &eng = allDescs[0];
+    for (FDREngineDescription &eng : allDescs) {
+        if (!eng.isValidOnTarget(target)) {
+            continue;
+        }
 
-    for (u32 domain = 9; domain <= 15; domain++) {
-        for (size_t stride = 1; stride <= 4; stride *= 2) {
-            // to make sure that domains >=14 have stride 1 according to origin
-            if (domain > 13 && stride > 1) {
-                continue;
-            }
-            if (!eng.isValidOnTarget(target)) {
-                continue;
-            }
-            if (msl < stride) {
-                continue;
-            }
+        for (u32 domain = 9; domain <= 15; domain++) {
+            for (size_t stride = 1; stride <= 4; stride *= 2) {
+                // to make sure that domains >=14 have stride 1 according to
+                // origin
+                if (domain > 13 && stride > 1) {
+                    continue;
+                }
+                if (msl < stride) {
+                    continue;
+                }
 
-            u32 score = 100;
+                u32 score = 100;
 
-            score -= absdiff(desiredStride, stride);
+                score -= absdiff(desiredStride, stride);
 
-            if (stride <= desiredStride) {
-                score += stride;
-            }
+                if (stride <= desiredStride) {
+                    score += stride;
+                }
 
-            u32 effLits = vl.size(); /* * desiredStride;*/
-            u32 ideal;
-            if (effLits < eng.getNumBuckets()) {
-                if (stride == 1) {
-                    ideal = 8;
-                } else {
+                u32 effLits = vl.size(); /* * desiredStride;*/
+                u32 ideal;
+                if (effLits < eng.getNumBuckets()) {
+                    if (stride == 1) {
+                        ideal = 8;
+                    } else {
+                        ideal = 10;
+                    }
+                } else if (effLits < 20) {
                     ideal = 10;
+                } else if (effLits < 100) {
+                    ideal = 11;
+                } else if (effLits < 1000) {
+                    ideal = 12;
+                } else if (effLits < 10000) {
+                    ideal = 13;
+                } else {
+                    ideal = 15;
                 }
-            } else if (effLits < 20) {
-                ideal = 10;
-            } else if (effLits < 100) {
-                ideal = 11;
-            } else if (effLits < 1000) {
-                ideal = 12;
-            } else if (effLits < 10000) {
-                ideal = 13;
-            } else {
-                ideal = 15;
-            }
 
-            if (ideal != 8 && eng.schemeWidth == 32) {
-                ideal += 1;
-            }
+                if (ideal != 8 && eng.schemeWidth == 32) {
+                    ideal += 1;
+                }
 
-            if (make_small) {
-                ideal -= 2;
-            }
+                if (make_small) {
+                    ideal -= 2;
+                }
 
-            if (stride > 1) {
-                ideal++;
-            }
+                if (stride > 1) {
+                    ideal++;
+                }
 
-            DEBUG_PRINTF("effLits %u\n", effLits);
+                DEBUG_PRINTF("effLits %u\n", effLits);
 
-            if (target.is_atom_class() && !make_small && effLits < 4000) {
-                /* Unless it is a very heavy case, we want to build smaller
-                 * tables on lightweight machines due to their small caches. */
-                ideal -= 2;
-            }
+                if (target.is_atom_class() && !make_small &&
+                    effLits < 4000) {
+                    /* Unless it is a very heavy case, we want to build smaller
+                     * tables on lightweight machines due to their small
+                     * caches. */
+                    ideal -= 2;
+                }
+
+                score -= absdiff(ideal, domain);
 
-            score -= absdiff(ideal, domain);
+                /* The wider models share the table layout (and hence the
+                 * domain and stride trade-offs above) but cover more input
+                 * positions per iteration; prefer the widest available. */
+                score += eng.stateWidth / 128;
 
-            DEBUG_PRINTF("fdr %u: width=%u, domain=%u, buckets=%u, stride=%zu "
-                         "-> score=%u\n",
-                         eng.getID(), eng.schemeWidth, domain,
-                         eng.getNumBuckets(), stride, score);
+                DEBUG_PRINTF("fdr %u: width=%u, state=%u, domain=%u, "
+                             "buckets=%u, stride=%zu -> score=%u\n",
+                             eng.getID(), eng.schemeWidth, eng.stateWidth,
+                             domain, eng.getNumBuckets(), stride, score);
 
-            if (!best || score > best_score) {
-                eng.bits = domain;
-                eng.stride = stride;
-                best = &eng;
-                best_score = score;
+                if (!best || score > best_score) {
+                    eng.bits = domain;
+                    eng.stride = stride;
+                    best = &eng;
+                    best_score = score;
+                }
             }
         }
     }
@@ -219,11 +238,13 @@ unique_ptr<FDREngineDescription> getFdrDescription(u32 engineID) {
     vector<FDREngineDescription> allDescs;
     getFdrDescriptions(&allDescs);
 
-    if (engineID >= allDescs.size()) {
-        return nullptr;
+    for (const auto &desc : allDescs) {
+        if (desc.getID() == engineID) {
+            return ue2::make_unique<FDREngineDescription>(desc);
+        }
     }
 
-    return ue2::make_unique<FDREngineDescription>(allDescs[engineID]);
+    return nullptr;
 }
 
 } // namespace ue2
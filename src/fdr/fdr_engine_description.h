@@ -45,11 +45,13 @@ struct FDREngineDef {
     u64a cpu_features;
     u32 confirmPullBackDistance;
     u32 confirmTopLevelSplit;
+    u32 stateWidth;
 };
 
 class FDREngineDescription : public EngineDescription {
 public:
     u32 schemeWidth;
+    u32 stateWidth; // width in bits of the runtime state, 128, 256 or 512
     u32 stride;
     u32 bits;
 
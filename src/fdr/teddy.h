@@ -94,4 +94,80 @@ hwlm_error_t fdr_exec_teddy_avx2_msks1_pck_fast(const struct FDR *fdr,
 
 #endif /* __AVX2__ */
 
+#if defined(__AVX512BW__)
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1(const struct FDR *fdr,
+                                         const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1_pck(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2(const struct FDR *fdr,
+                                         const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2_pck(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3(const struct FDR *fdr,
+                                         const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3_pck(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4(const struct FDR *fdr,
+                                         const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4_pck(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1_fat(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1_pck_fat(const struct FDR *fdr,
+                                                 const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2_fat(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2_pck_fat(const struct FDR *fdr,
+                                                 const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3_fat(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3_pck_fat(const struct FDR *fdr,
+                                                 const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4_fat(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4_pck_fat(const struct FDR *fdr,
+                                                 const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1_wide(const struct FDR *fdr,
+                                              const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1_pck_wide(const struct FDR *fdr,
+                                                  const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2_wide(const struct FDR *fdr,
+                                              const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2_pck_wide(const struct FDR *fdr,
+                                                  const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3_wide(const struct FDR *fdr,
+                                              const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3_pck_wide(const struct FDR *fdr,
+                                                  const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4_wide(const struct FDR *fdr,
+                                              const struct FDR_Runtime_Args *a);
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4_pck_wide(const struct FDR *fdr,
+                                                  const struct FDR_Runtime_Args *a);
+
+#endif /* __AVX512BW__ */
+
 #endif /* TEDDY_H_ */
@@ -0,0 +1,446 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Teddy literal matcher: AVX-512 engine runtime.
+ *
+ * All AVX-512 Teddy models use the same pshufb-based bucket test as the
+ * SSSE3 and AVX2 models, but each 512-bit vector is split into four 128-bit
+ * lanes that are arranged according to the bucket count:
+ *
+ *  -  8 buckets: four consecutive 16-byte blocks, 64 bytes per vector;
+ *  - 16 buckets: two 16-byte blocks, each tested against buckets 0-7 and
+ *                8-15 (32 bytes per vector);
+ *  - 32 buckets: one 16-byte block tested against four groups of 8 buckets
+ *                (16 bytes per vector).
+ *
+ * The nibble masks are laid out by the compiler exactly as for the other
+ * Teddy models: for each mask, a low nibble table and a high nibble table,
+ * each holding 16 bytes per group of 8 buckets.
+ */
+
+#include "fdr_internal.h"
+#include "flood_runtime.h"
+#include "teddy.h"
+#include "teddy_internal.h"
+#include "teddy_runtime_common.h"
+#include "util/simd_utils.h"
+
+#if defined(__AVX512BW__)
+
+/** \brief Number of input bytes covered by one vector for a bucket count. */
+#define TEDDY_512_BLOCK(bucket) (64 * 8 / (bucket))
+
+/** \brief Number of confirm words in a 512-bit result. */
+#define TEDDY_512_PARTS (64 / sizeof(TEDDY_CONF_TYPE))
+
+/** \brief Number of input positions covered by one confirm word. */
+#define TEDDY_512_PART_POS(bucket) (sizeof(TEDDY_CONF_TYPE) * 8 / (bucket))
+
+#define CONFIRM_TEDDY_512(var, bucket, offset, reason, conf_fn)             \
+do {                                                                        \
+    if (unlikely(_mm512_test_epi64_mask(var, var))) {                       \
+        union {                                                             \
+            __m512i val512;                                                 \
+            TEDDY_CONF_TYPE part[TEDDY_512_PARTS];                          \
+        } u;                                                                \
+        u.val512 = transposeBlock512(var, bucket);                          \
+        for (u32 i = 0; i < TEDDY_512_PARTS; i++) {                         \
+            if (unlikely(u.part[i])) {                                      \
+                conf_fn(&u.part[i], bucket,                                 \
+                        (offset) + i * TEDDY_512_PART_POS(bucket),          \
+                        confBase, reason, a, ptr, control, &last_match);    \
+                CHECK_HWLM_TERMINATE_MATCHING;                              \
+            }                                                               \
+        }                                                                   \
+    }                                                                       \
+} while (0);
+
+/**
+ * \brief Rearrange the lanes of a block of input so that each lane is lined
+ * up with the group of buckets that its masks test for.
+ */
+static really_inline
+__m512i spreadBlock512(__m512i v, const u32 bucket) {
+    if (bucket == 16) {
+        return _mm512_permutexvar_epi64(_mm512_set_epi64(3, 2, 3, 2,
+                                                         1, 0, 1, 0), v);
+    } else if (bucket == 32) {
+        return _mm512_broadcast_i32x4(_mm512_castsi512_si128(v));
+    }
+    return v;
+}
+
+static really_inline
+__m512i loadBlock512(const u8 *ptr, const u32 bucket) {
+    if (bucket == 8) {
+        return _mm512_loadu_si512((const void *)ptr);
+    } else if (bucket == 16) {
+        return spreadBlock512(_mm512_castsi256_si512(loadu256(ptr)), bucket);
+    }
+    return _mm512_broadcast_i32x4(loadu128(ptr));
+}
+
+static really_inline
+__m512i loadMask512(const u8 *msk, const u32 bucket) {
+    if (bucket == 8) {
+        return _mm512_broadcast_i32x4(loadu128(msk));
+    } else if (bucket == 16) {
+        return _mm512_broadcast_i64x4(loadu256(msk));
+    }
+    return _mm512_loadu_si512((const void *)msk);
+}
+
+// Note: p_mask is an output param that initialises a poison mask.
+static really_inline
+__m512i vectoredLoad512(__m512i *p_mask, const u8 *ptr, const u8 *lo,
+                        const u8 *hi, const u8 *buf_history,
+                        size_t len_history, const u32 nMasks,
+                        const u32 bucket) {
+    const uintptr_t width = TEDDY_512_BLOCK(bucket);
+    uintptr_t start = ptr < lo ? (uintptr_t)(lo - ptr) : 0;
+    uintptr_t end = MIN(width, (uintptr_t)(hi - ptr));
+    assert(start <= end && end <= 64);
+
+    // Only the bytes inside [lo, hi) are read; masked loads never fault on
+    // the suppressed bytes.
+    u64a valid = end - start == 64 ? ~0ULL
+                                   : ((1ULL << (end - start)) - 1) << start;
+    __m512i val = _mm512_maskz_loadu_epi8(valid, (const void *)ptr);
+
+    if (start) {
+        union {
+            u8 val8[64];
+            __m512i val512;
+        } u;
+        u.val512 = val;
+        uintptr_t need = MIN(start, MIN(len_history, nMasks - 1));
+        for (uintptr_t i = start - need; i < start; i++) {
+            u.val8[i] = buf_history[len_history - (start - i)];
+        }
+        val = u.val512;
+    }
+
+    *p_mask = spreadBlock512(_mm512_movm_epi8(valid), bucket);
+    return spreadBlock512(val, bucket);
+}
+
+/**
+ * \brief Returns the lanes of the previous result that immediately precede
+ * each lane of the current one in the input.
+ */
+static really_inline
+__m512i prevBlock512(__m512i cur, __m512i old, const u32 bucket) {
+    if (bucket == 8) {
+        return _mm512_alignr_epi64(cur, old, 6);
+    } else if (bucket == 16) {
+        return _mm512_alignr_epi64(cur, old, 4);
+    }
+    return old;
+}
+
+#define SHIFT_TEDDY_512(res, old, bucket, n)                                \
+    _mm512_alignr_epi8(res, prevBlock512(res, old, bucket), 16 - (n))
+
+static really_inline
+__m512i shuftiTeddy512(__m512i lo, __m512i hi, __m512i lo_msk,
+                       __m512i hi_msk) {
+    return _mm512_and_si512(_mm512_shuffle_epi8(lo_msk, lo),
+                            _mm512_shuffle_epi8(hi_msk, hi));
+}
+
+static really_inline
+__m512i prep_conf_teddy_512(const __m512i *lo_msk, const __m512i *hi_msk,
+                            __m512i *old, const u32 nMasks, const u32 bucket,
+                            __m512i p_mask, __m512i val) {
+    const __m512i mask = _mm512_set1_epi8(0xf);
+    __m512i lo = _mm512_and_si512(val, mask);
+    __m512i hi = _mm512_and_si512(_mm512_srli_epi64(val, 4), mask);
+
+    __m512i r = _mm512_and_si512(shuftiTeddy512(lo, hi, lo_msk[0], hi_msk[0]),
+                                 p_mask);
+    if (nMasks > 1) {
+        __m512i res_1 = shuftiTeddy512(lo, hi, lo_msk[1], hi_msk[1]);
+        r = _mm512_and_si512(r, SHIFT_TEDDY_512(res_1, old[0], bucket, 1));
+        old[0] = res_1;
+    }
+    if (nMasks > 2) {
+        __m512i res_2 = shuftiTeddy512(lo, hi, lo_msk[2], hi_msk[2]);
+        r = _mm512_and_si512(r, SHIFT_TEDDY_512(res_2, old[1], bucket, 2));
+        old[1] = res_2;
+    }
+    if (nMasks > 3) {
+        __m512i res_3 = shuftiTeddy512(lo, hi, lo_msk[3], hi_msk[3]);
+        r = _mm512_and_si512(r, SHIFT_TEDDY_512(res_3, old[2], bucket, 3));
+        old[2] = res_3;
+    }
+    return r;
+}
+
+/**
+ * \brief Reorder a result vector so that every confirm word holds the bucket
+ * bits of consecutive input positions, lowest position first.
+ */
+static really_inline
+__m512i transposeBlock512(__m512i r, const u32 bucket) {
+    if (bucket == 8) {
+        return r;
+    }
+
+    // Interleave the bytes of neighbouring bucket groups.
+    __m512i swap = _mm512_shuffle_i64x2(r, r, _MM_SHUFFLE(2, 3, 0, 1));
+    __m512i lo = _mm512_unpacklo_epi8(r, swap);
+    __m512i hi = _mm512_unpackhi_epi8(r, swap);
+    __m512i p = _mm512_permutex2var_epi64(lo, _mm512_set_epi64(13, 12, 5, 4,
+                                                               9, 8, 1, 0),
+                                          hi);
+    if (bucket == 16) {
+        return p;
+    }
+
+    // With 32 buckets, p holds buckets 0-15 in its low half and buckets
+    // 16-31 in its high half; interleave those 16-bit halves.
+    __m512i q = _mm512_shuffle_i64x2(p, p, _MM_SHUFFLE(1, 0, 3, 2));
+    __m512i lo16 = _mm512_unpacklo_epi16(p, q);
+    __m512i hi16 = _mm512_unpackhi_epi16(p, q);
+    return _mm512_permutex2var_epi64(lo16, _mm512_set_epi64(11, 10, 3, 2,
+                                                            9, 8, 1, 0),
+                                     hi16);
+}
+
+static really_inline
+const u8 *getMaskBase_avx512(const struct Teddy *teddy) {
+    return (const u8 *)teddy + sizeof(struct Teddy);
+}
+
+static really_inline
+const u32 *getConfBase_avx512(const struct Teddy *teddy, u8 numMask,
+                              const u32 bucket) {
+    return (const u32 *)((const u8 *)teddy + sizeof(struct Teddy) +
+                         (numMask * 32 * (bucket / 8)));
+}
+
+#define FDR_EXEC_TEDDY_512(fdr, a, n_msk, bucket, conf_fn)                  \
+do {                                                                        \
+    const u8 *buf_end = a->buf + a->len;                                    \
+    const u8 *ptr = a->buf + a->start_offset;                               \
+    hwlmcb_rv_t controlVal = *a->groups;                                    \
+    hwlmcb_rv_t *control = &controlVal;                                     \
+    u32 floodBackoff = FLOOD_BACKOFF_START;                                 \
+    const u8 *tryFloodDetect = a->firstFloodDetect;                         \
+    u32 last_match = (u32)-1;                                               \
+    const struct Teddy *teddy = (const struct Teddy *)fdr;                  \
+    const size_t blockBytes = TEDDY_512_BLOCK(bucket);                      \
+    const size_t iterBytes = 2 * blockBytes;                                \
+    DEBUG_PRINTF("params: buf %p len %zu start_offset %zu\n",              \
+                 a->buf, a->len, a->start_offset);                          \
+                                                                            \
+    const u8 *maskBase = getMaskBase_avx512(teddy);                         \
+    const u32 *confBase = getConfBase_avx512(teddy, n_msk, bucket);         \
+                                                                            \
+    __m512i lo_msk[n_msk];                                                  \
+    __m512i hi_msk[n_msk];                                                  \
+    __m512i res_old[n_msk];                                                 \
+    for (u32 i = 0; i < n_msk; i++) {                                       \
+        lo_msk[i] = loadMask512(maskBase + (i * 2) * 2 * bucket, bucket);   \
+        hi_msk[i] = loadMask512(maskBase + (i * 2 + 1) * 2 * bucket,        \
+                                bucket);                                    \
+        res_old[i] = _mm512_set1_epi32(-1);                                 \
+    }                                                                       \
+    const __m512i ones = _mm512_set1_epi32(-1);                             \
+                                                                            \
+    const u8 *mainStart = ROUNDUP_PTR(ptr, blockBytes);                     \
+    DEBUG_PRINTF("derive: ptr: %p mainstart %p\n", ptr, mainStart);        \
+    if (ptr < mainStart) {                                                  \
+        ptr = mainStart - blockBytes;                                       \
+        __m512i p_mask;                                                     \
+        __m512i val_0 = vectoredLoad512(&p_mask, ptr, a->buf, buf_end,      \
+                                        a->buf_history, a->len_history,     \
+                                        n_msk, bucket);                     \
+        __m512i r_0 = prep_conf_teddy_512(lo_msk, hi_msk, res_old, n_msk,   \
+                                          bucket, p_mask, val_0);           \
+        CONFIRM_TEDDY_512(r_0, bucket, 0, VECTORING, conf_fn);              \
+        ptr += blockBytes;                                                  \
+    }                                                                       \
+                                                                            \
+    if (ptr + blockBytes < buf_end) {                                       \
+        __m512i r_0 = prep_conf_teddy_512(lo_msk, hi_msk, res_old, n_msk,   \
+                                          bucket, ones,                     \
+                                          loadBlock512(ptr, bucket));       \
+        CONFIRM_TEDDY_512(r_0, bucket, 0, VECTORING, conf_fn);              \
+        ptr += blockBytes;                                                  \
+    }                                                                       \
+                                                                            \
+    for (; ptr + iterBytes <= buf_end; ptr += iterBytes) {                  \
+        __builtin_prefetch(ptr + (iterBytes * 4));                          \
+        CHECK_FLOOD;                                                        \
+        __m512i r_0 = prep_conf_teddy_512(lo_msk, hi_msk, res_old, n_msk,   \
+                                          bucket, ones,                     \
+                                          loadBlock512(ptr, bucket));       \
+        CONFIRM_TEDDY_512(r_0, bucket, 0, NOT_CAUTIOUS, conf_fn);           \
+        __m512i r_1 = prep_conf_teddy_512(lo_msk, hi_msk, res_old, n_msk,   \
+                                          bucket, ones,                     \
+                                          loadBlock512(ptr + blockBytes,    \
+                                                       bucket));            \
+        CONFIRM_TEDDY_512(r_1, bucket, blockBytes, NOT_CAUTIOUS, conf_fn);  \
+    }                                                                       \
+                                                                            \
+    for (; ptr < buf_end; ptr += blockBytes) {                              \
+        __m512i p_mask;                                                     \
+        __m512i val_0 = vectoredLoad512(&p_mask, ptr, a->buf, buf_end,      \
+                                        a->buf_history, a->len_history,     \
+                                        n_msk, bucket);                     \
+        __m512i r_0 = prep_conf_teddy_512(lo_msk, hi_msk, res_old, n_msk,   \
+                                          bucket, p_mask, val_0);           \
+        CONFIRM_TEDDY_512(r_0, bucket, 0, VECTORING, conf_fn);              \
+    }                                                                       \
+    *a->groups = controlVal;                                                \
+    return HWLM_SUCCESS;                                                    \
+} while (0)
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1(const struct FDR *fdr,
+                                         const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 1, 8, do_confWithBit1_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1_pck(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 1, 8, do_confWithBit_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2(const struct FDR *fdr,
+                                         const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 2, 8, do_confWithBitMany_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2_pck(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 2, 8, do_confWithBit_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3(const struct FDR *fdr,
+                                         const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 3, 8, do_confWithBitMany_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3_pck(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 3, 8, do_confWithBit_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4(const struct FDR *fdr,
+                                         const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 4, 8, do_confWithBitMany_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4_pck(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 4, 8, do_confWithBit_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1_fat(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 1, 16, do_confWithBit1_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1_pck_fat(const struct FDR *fdr,
+                                                 const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 1, 16, do_confWithBit_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2_fat(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 2, 16, do_confWithBitMany_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2_pck_fat(const struct FDR *fdr,
+                                                 const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 2, 16, do_confWithBit_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3_fat(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 3, 16, do_confWithBitMany_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3_pck_fat(const struct FDR *fdr,
+                                                 const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 3, 16, do_confWithBit_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4_fat(const struct FDR *fdr,
+                                             const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 4, 16, do_confWithBitMany_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4_pck_fat(const struct FDR *fdr,
+                                                 const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 4, 16, do_confWithBit_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1_wide(const struct FDR *fdr,
+                                              const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 1, 32, do_confWithBit1_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks1_pck_wide(const struct FDR *fdr,
+                                                  const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 1, 32, do_confWithBit_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2_wide(const struct FDR *fdr,
+                                              const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 2, 32, do_confWithBitMany_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks2_pck_wide(const struct FDR *fdr,
+                                                  const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 2, 32, do_confWithBit_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3_wide(const struct FDR *fdr,
+                                              const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 3, 32, do_confWithBitMany_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks3_pck_wide(const struct FDR *fdr,
+                                                  const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 3, 32, do_confWithBit_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4_wide(const struct FDR *fdr,
+                                              const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 4, 32, do_confWithBitMany_teddy);
+}
+
+hwlm_error_t fdr_exec_teddy_avx512_msks4_pck_wide(const struct FDR *fdr,
+                                                  const struct FDR_Runtime_Args *a) {
+    FDR_EXEC_TEDDY_512(fdr, a, 4, 32, do_confWithBit_teddy);
+}
+
+#endif // __AVX512BW__
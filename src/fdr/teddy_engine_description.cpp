@@ -65,7 +65,33 @@ bool TeddyEngineDescription::needConfirm(const vector<hwlmLiteral> &lits) const
 }
 
 void getTeddyDescriptions(vector<TeddyEngineDescription> *out) {
+    // Note: chooseTeddyEngine() keeps the first of several equally-scored
+    // engines, so wider models are listed ahead of narrower ones.
     static const TeddyEngineDef defns[] = {
+        { 19, 0 | HS_CPU_FEATURES_AVX512, 1, 8, false, 0, 1 },
+        { 20, 0 | HS_CPU_FEATURES_AVX512, 1, 8, true, 0, 32 },
+        { 21, 0 | HS_CPU_FEATURES_AVX512, 2, 8, false, 0, 1 },
+        { 22, 0 | HS_CPU_FEATURES_AVX512, 2, 8, true, 0, 32 },
+        { 23, 0 | HS_CPU_FEATURES_AVX512, 3, 8, false, 0, 1 },
+        { 24, 0 | HS_CPU_FEATURES_AVX512, 3, 8, true, 0, 32 },
+        { 25, 0 | HS_CPU_FEATURES_AVX512, 4, 8, false, 0, 1 },
+        { 26, 0 | HS_CPU_FEATURES_AVX512, 4, 8, true, 0, 32 },
+        { 27, 0 | HS_CPU_FEATURES_AVX512, 1, 16, false, 0, 1 },
+        { 28, 0 | HS_CPU_FEATURES_AVX512, 1, 16, true, 0, 32 },
+        { 29, 0 | HS_CPU_FEATURES_AVX512, 2, 16, false, 0, 1 },
+        { 30, 0 | HS_CPU_FEATURES_AVX512, 2, 16, true, 0, 32 },
+        { 31, 0 | HS_CPU_FEATURES_AVX512, 3, 16, false, 0, 1 },
+        { 32, 0 | HS_CPU_FEATURES_AVX512, 3, 16, true, 0, 32 },
+        { 33, 0 | HS_CPU_FEATURES_AVX512, 4, 16, false, 0, 1 },
+        { 34, 0 | HS_CPU_FEATURES_AVX512, 4, 16, true, 0, 32 },
+        { 35, 0 | HS_CPU_FEATURES_AVX512, 1, 32, false, 0, 1 },
+        { 36, 0 | HS_CPU_FEATURES_AVX512, 1, 32, true, 0, 32 },
+        { 37, 0 | HS_CPU_FEATURES_AVX512, 2, 32, false, 0, 1 },
+        { 38, 0 | HS_CPU_FEATURES_AVX512, 2, 32, true, 0, 32 },
+        { 39, 0 | HS_CPU_FEATURES_AVX512, 3, 32, false, 0, 1 },
+        { 40, 0 | HS_CPU_FEATURES_AVX512, 3, 32, true, 0, 32 },
+        { 41, 0 | HS_CPU_FEATURES_AVX512, 4, 32, false, 0, 1 },
+        { 42, 0 | HS_CPU_FEATURES_AVX512, 4, 32, true, 0, 32 },
         { 1, 0 | HS_CPU_FEATURES_AVX2, 1, 8, false, 0, 1 },
         { 2, 0 | HS_CPU_FEATURES_AVX2, 1, 8, true, 0, 32 },
         { 3, 0 | HS_CPU_FEATURES_AVX2, 1, 16, false, 0, 1 },
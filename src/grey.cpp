@@ -69,6 +69,8 @@ Grey::Grey(void) :
                    onlyOneOutfix(false),
                    allowShermanStates(true),
                    allowMcClellan8(true),
+                   allowSheng(true),
+                   allowMcSheng(true),
                    highlanderPruneDFA(true),
                    minimizeDFA(true),
                    accelerateDFA(true),
@@ -77,6 +79,7 @@ Grey::Grey(void) :
                    squashNFA(true),
                    compressNFAState(true),
                    numberNFAStatesWrong(false), /* debugging only */
+                   reorderNFAStates(true),
                    highlanderSquash(true),
                    allowZombies(true),
                    floodAsPuffette(false),
@@ -126,6 +129,7 @@ Grey::Grey(void) :
                                                 // are given to rose &co
                    smallWriteLargestBufferBad(35),
                    limitSmallWriteOutfixSize(1048576), // 1 MB
+                   compileThreads(1),
                    dumpFlags(0),
                    limitPatternCount(8000000), // 8M patterns
                    limitPatternLength(16000),  // 16K bytes
@@ -221,6 +225,8 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(onlyOneOutfix);
         G_UPDATE(allowShermanStates);
         G_UPDATE(allowMcClellan8);
+        G_UPDATE(allowSheng);
+        G_UPDATE(allowMcSheng);
         G_UPDATE(highlanderPruneDFA);
         G_UPDATE(minimizeDFA);
         G_UPDATE(accelerateDFA);
@@ -229,6 +235,7 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(squashNFA);
         G_UPDATE(compressNFAState);
         G_UPDATE(numberNFAStatesWrong);
+        G_UPDATE(reorderNFAStates);
         G_UPDATE(allowZombies);
         G_UPDATE(floodAsPuffette);
         G_UPDATE(nfaForceSize);
@@ -273,6 +280,7 @@ void applyGreyOverrides(Grey *g, const string &s) {
         G_UPDATE(smallWriteLargestBuffer);
         G_UPDATE(smallWriteLargestBufferBad);
         G_UPDATE(limitSmallWriteOutfixSize);
+        G_UPDATE(compileThreads);
         G_UPDATE(limitPatternCount);
         G_UPDATE(limitPatternLength);
         G_UPDATE(limitGraphVertices);
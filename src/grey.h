@@ -73,6 +73,8 @@ struct Grey {
 
     bool allowShermanStates;
     bool allowMcClellan8;
+    bool allowSheng;
+    bool allowMcSheng;
     bool highlanderPruneDFA;
     bool minimizeDFA;
 
@@ -83,6 +85,7 @@ struct Grey {
     bool squashNFA;
     bool compressNFAState;
     bool numberNFAStatesWrong;
+    bool reorderNFAStates;
     bool highlanderSquash;
     bool allowZombies;
     bool floodAsPuffette;
@@ -144,6 +147,10 @@ struct Grey {
     u32 smallWriteLargestBufferBad;// largest buffer that can be small write
     u32 limitSmallWriteOutfixSize; //!< max total size of outfix DFAs
 
+    /** \brief Number of threads used to build independent engines during
+     * compile, or zero for one per hardware thread. */
+    u32 compileThreads;
+
     enum DumpFlags {
         DUMP_NONE       = 0,
         DUMP_BASICS     = 1 << 0, // Dump basic textual data
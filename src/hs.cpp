@@ -37,34 +37,52 @@
 #include "database.h"
 #include "compiler/compiler.h"
 #include "compiler/error.h"
+#include "compiler/shard.h"
 #include "nfagraph/ng.h"
 #include "nfagraph/ng_expr_info.h"
 #include "nfagraph/ng_extparam.h"
 #include "parser/parse_error.h"
 #include "parser/Parser.h"
 #include "parser/prefilter.h"
+#include "rose/rose_build_engine_cache.h"
 #include "util/compile_error.h"
+#include "util/compile_report.h"
 #include "util/cpuid_flags.h"
 #include "util/depth.h"
 #include "util/popcount.h"
 #include "util/target_info.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstring>
 #include <limits.h>
+#include <new>
 #include <string>
 #include <vector>
 
 using namespace std;
 using namespace ue2;
 
+/** \brief Thread count set by hs_set_compile_threads(). */
+static atomic<unsigned int> compile_threads(1);
+
+/** \brief Grey box settings used by the public compile API calls. */
+static
+Grey defaultGrey() {
+    Grey g;
+    g.compileThreads = compile_threads;
+    return g;
+}
+
 /** \brief Cheap check that no unexpected mode flags are on. */
 static
 bool validModeFlags(unsigned int mode) {
     static const unsigned allModeFlags = HS_MODE_BLOCK
                                        | HS_MODE_STREAM
                                        | HS_MODE_VECTORED
+                                       | HS_MODE_UNORDERED
                                        | HS_MODE_SOM_HORIZON_LARGE
                                        | HS_MODE_SOM_HORIZON_MEDIUM
                                        | HS_MODE_SOM_HORIZON_SMALL;
@@ -120,7 +138,7 @@ bool checkMode(unsigned int mode, hs_compile_error **comp_error) {
 static
 bool checkPlatform(const hs_platform_info *p, hs_compile_error **comp_error) {
 #define HS_TUNE_LAST HS_TUNE_FAMILY_BDW
-#define HS_CPU_FEATURES_ALL (HS_CPU_FEATURES_AVX2)
+#define HS_CPU_FEATURES_ALL (HS_CPU_FEATURES_AVX2 | HS_CPU_FEATURES_AVX512)
 
     if (!p) {
         return true;
@@ -159,6 +177,47 @@ unsigned getSomPrecision(unsigned mode) {
     return 0;
 }
 
+/**
+ * \brief Checks the arguments shared by all of the compile entry points.
+ *
+ * Returns false and writes an error to \a comp_error (which must not be NULL)
+ * if any of them is invalid.
+ */
+static
+bool checkCompileArgs(const char *const *expressions, unsigned elements,
+                      unsigned mode, const hs_platform_info_t *platform,
+                      const Grey &g, hs_compile_error_t **comp_error) {
+    assert(comp_error);
+
+    if (!expressions) {
+        *comp_error
+            = generateCompileError("Invalid parameter: expressions is NULL",
+                                   -1);
+        return false;
+    }
+    if (elements == 0) {
+        *comp_error = generateCompileError("Invalid parameter: elements is zero", -1);
+        return false;
+    }
+
+    if (!checkMode(mode, comp_error)) {
+        assert(*comp_error); // set by checkMode.
+        return false;
+    }
+
+    if (!checkPlatform(platform, comp_error)) {
+        assert(*comp_error); // set by checkPlatform.
+        return false;
+    }
+
+    if (elements > g.limitPatternCount) {
+        *comp_error = generateCompileError("Number of patterns too large", -1);
+        return false;
+    }
+
+    return true;
+}
+
 namespace ue2 {
 
 hs_error_t
@@ -166,7 +225,8 @@ hs_compile_multi_int(const char *const *expressions, const unsigned *flags,
                      const unsigned *ids, const hs_expr_ext *const *ext,
                      unsigned elements, unsigned mode,
                      const hs_platform_info_t *platform, hs_database_t **db,
-                     hs_compile_error_t **comp_error, const Grey &g) {
+                     hs_compile_error_t **comp_error, const Grey &g,
+                     EngineCache *cache, CompileReport *report) {
     // Check the args: note that it's OK for flags, ids or ext to be null.
     if (!comp_error) {
         if (db) {
@@ -179,57 +239,133 @@ hs_compile_multi_int(const char *const *expressions, const unsigned *flags,
         *comp_error = generateCompileError("Invalid parameter: db is NULL", -1);
         return HS_COMPILER_ERROR;
     }
-    if (!expressions) {
+    if (!checkCompileArgs(expressions, elements, mode, platform, g,
+                          comp_error)) {
         *db = nullptr;
-        *comp_error
-            = generateCompileError("Invalid parameter: expressions is NULL",
-                                   -1);
         return HS_COMPILER_ERROR;
     }
-    if (elements == 0) {
+
+    // This function is simply a wrapper around both the parser and compiler
+    bool isStreaming = mode & (HS_MODE_STREAM | HS_MODE_VECTORED);
+    bool isVectored = mode & HS_MODE_VECTORED;
+    bool isUnordered = mode & HS_MODE_UNORDERED;
+    unsigned somPrecision = getSomPrecision(mode);
+
+    target_t target_info = platform ? target_t(*platform)
+                                    : get_current_target();
+
+    CompileContext cc(isStreaming, isVectored, target_info, g, cache,
+                      isUnordered);
+    NG ng(cc, somPrecision);
+
+    try {
+        for (unsigned int i = 0; i < elements; i++) {
+            // Add this expression to the compiler
+            CompilePhase phase(report, "expression");
+            try {
+                addExpression(ng, i, expressions[i], flags ? flags[i] : 0,
+                              ext ? ext[i] : nullptr, ids ? ids[i] : 0);
+            } catch (CompileError &e) {
+                /* Caught a parse error:
+                 * throw it upstream as a CompileError with a specific index */
+                e.setExpressionIndex(i);
+                throw; /* do not slice */
+            }
+            phase.end();
+            if (report) {
+                report->addExpression(i, ids ? ids[i] : 0, phase.elapsed(),
+                                      phase.peakHeap());
+            }
+        }
+
+        unsigned length = 0;
+        struct hs_database *out = build(ng, &length, report);
+
+        assert(out);    // should have thrown exception on error
+        assert(length);
+
+        if (cache) {
+            // Drop engines that this database no longer uses.
+            cache->prune();
+        }
+
+        *db = out;
+        *comp_error = nullptr;
+
+        return HS_SUCCESS;
+    }
+    catch (const CompileError &e) {
+        // Compiler error occurred
         *db = nullptr;
-        *comp_error = generateCompileError("Invalid parameter: elements is zero", -1);
+        *comp_error = generateCompileError(e.reason,
+                                           e.hasIndex ? (int)e.index : -1);
         return HS_COMPILER_ERROR;
     }
-
-    if (!checkMode(mode, comp_error)) {
+    catch (std::bad_alloc) {
         *db = nullptr;
-        assert(*comp_error); // set by checkMode.
+        *comp_error = const_cast<hs_compile_error_t *>(&hs_enomem);
         return HS_COMPILER_ERROR;
     }
-
-    if (!checkPlatform(platform, comp_error)) {
+    catch (...) {
+        assert(!"Internal error, unexpected exception");
         *db = nullptr;
-        assert(*comp_error); // set by checkPlatform.
+        *comp_error = const_cast<hs_compile_error_t *>(&hs_einternal);
         return HS_COMPILER_ERROR;
     }
+}
 
-    if (elements > g.limitPatternCount) {
+hs_error_t
+hs_compile_lit_multi_int(const char *const *expressions, const unsigned *flags,
+                         const unsigned *ids, const size_t *lens,
+                         unsigned elements, unsigned mode,
+                         const hs_platform_info_t *platform, hs_database_t **db,
+                         hs_compile_error_t **comp_error, const Grey &g) {
+    // Check the args: note that it's OK for flags or ids to be null.
+    if (!comp_error) {
+        if (db) {
+            *db = nullptr;
+        }
+        // nowhere to write the string, but we can still report an error code
+        return HS_COMPILER_ERROR;
+    }
+    if (!db) {
+        *comp_error = generateCompileError("Invalid parameter: db is NULL", -1);
+        return HS_COMPILER_ERROR;
+    }
+    if (!lens) {
+        *db = nullptr;
+        *comp_error = generateCompileError("Invalid parameter: len is NULL", -1);
+        return HS_COMPILER_ERROR;
+    }
+    if (!checkCompileArgs(expressions, elements, mode, platform, g,
+                          comp_error)) {
         *db = nullptr;
-        *comp_error = generateCompileError("Number of patterns too large", -1);
         return HS_COMPILER_ERROR;
     }
 
-    // This function is simply a wrapper around both the parser and compiler
     bool isStreaming = mode & (HS_MODE_STREAM | HS_MODE_VECTORED);
     bool isVectored = mode & HS_MODE_VECTORED;
+    bool isUnordered = mode & HS_MODE_UNORDERED;
     unsigned somPrecision = getSomPrecision(mode);
 
     target_t target_info = platform ? target_t(*platform)
                                     : get_current_target();
 
-    CompileContext cc(isStreaming, isVectored, target_info, g);
+    CompileContext cc(isStreaming, isVectored, target_info, g, nullptr,
+                      isUnordered);
     NG ng(cc, somPrecision);
 
     try {
         for (unsigned int i = 0; i < elements; i++) {
-            // Add this expression to the compiler
+            // Add this literal to the compiler; there is no parse step.
             try {
-                addExpression(ng, i, expressions[i], flags ? flags[i] : 0,
-                              ext ? ext[i] : nullptr, ids ? ids[i] : 0);
+                if (!expressions[i]) {
+                    throw CompileError("Invalid parameter: expression is "
+                                       "NULL.");
+                }
+                addLitExpression(ng, i, expressions[i], flags ? flags[i] : 0,
+                                 ids ? ids[i] : 0, lens[i]);
             } catch (CompileError &e) {
-                /* Caught a parse error:
-                 * throw it upstream as a CompileError with a specific index */
                 e.setExpressionIndex(i);
                 throw; /* do not slice */
             }
@@ -247,7 +383,6 @@ hs_compile_multi_int(const char *const *expressions, const unsigned *flags,
         return HS_SUCCESS;
     }
     catch (const CompileError &e) {
-        // Compiler error occurred
         *db = nullptr;
         *comp_error = generateCompileError(e.reason,
                                            e.hasIndex ? (int)e.index : -1);
@@ -283,7 +418,7 @@ hs_error_t hs_compile(const char *expression, unsigned flags, unsigned mode,
     const hs_expr_ext * const *ext = nullptr; // unused for this call.
 
     return hs_compile_multi_int(&expression, &flags, &id, ext, 1, mode,
-                                platform, db, error, Grey());
+                                platform, db, error, defaultGrey());
 }
 
 extern "C" HS_PUBLIC_API
@@ -294,7 +429,7 @@ hs_error_t hs_compile_multi(const char * const *expressions,
                             hs_database_t **db, hs_compile_error_t **error) {
     const hs_expr_ext * const *ext = nullptr; // unused for this call.
     return hs_compile_multi_int(expressions, flags, ids, ext, elements, mode,
-                                platform, db, error, Grey());
+                                platform, db, error, defaultGrey());
 }
 
 extern "C" HS_PUBLIC_API
@@ -306,7 +441,300 @@ hs_error_t hs_compile_ext_multi(const char * const *expressions,
                                 hs_database_t **db,
                                 hs_compile_error_t **error) {
     return hs_compile_multi_int(expressions, flags, ids, ext, elements, mode,
-                                platform, db, error, Grey());
+                                platform, db, error, defaultGrey());
+}
+
+/** \brief Compile cache handed out by hs_alloc_compile_cache(). */
+struct hs_compile_cache {
+    EngineCache engines;
+};
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_alloc_compile_cache(hs_compile_cache_t **cache) {
+    if (!cache) {
+        return HS_INVALID;
+    }
+
+    *cache = new (nothrow) hs_compile_cache;
+    return *cache ? HS_SUCCESS : HS_NOMEM;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_free_compile_cache(hs_compile_cache_t *cache) {
+    delete cache;
+    return HS_SUCCESS;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_compile_ext_multi_cached(const char * const *expressions,
+                                       const unsigned *flags,
+                                       const unsigned *ids,
+                                       const hs_expr_ext * const *ext,
+                                       unsigned elements, unsigned mode,
+                                       const hs_platform_info_t *platform,
+                                       hs_compile_cache_t *cache,
+                                       hs_database_t **db,
+                                       hs_compile_error_t **error) {
+    if (!cache) {
+        if (db) {
+            *db = nullptr;
+        }
+        if (!error) {
+            return HS_COMPILER_ERROR;
+        }
+        *error = generateCompileError("Invalid parameter: cache is NULL", -1);
+        return HS_COMPILER_ERROR;
+    }
+
+    return hs_compile_multi_int(expressions, flags, ids, ext, elements, mode,
+                                platform, db, error, defaultGrey(),
+                                &cache->engines);
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_compile_ext_multi_sharded(const char * const *expressions,
+                                        const unsigned *flags,
+                                        const unsigned *ids,
+                                        const hs_expr_ext * const *ext,
+                                        unsigned elements, unsigned mode,
+                                        const hs_platform_info_t *platform,
+                                        unsigned max_shards,
+                                        hs_database_t **dbs, unsigned *shards,
+                                        hs_compile_error_t **error) {
+    if (dbs) {
+        fill(dbs, dbs + max_shards, nullptr);
+    }
+    if (!error) {
+        return HS_COMPILER_ERROR;
+    }
+    if (!dbs || !max_shards) {
+        *error = generateCompileError("Invalid parameter: dbs is NULL or "
+                                      "max_shards is zero", -1);
+        return HS_COMPILER_ERROR;
+    }
+    if (!shards) {
+        *error = generateCompileError("Invalid parameter: shards is NULL", -1);
+        return HS_COMPILER_ERROR;
+    }
+
+    const Grey g = defaultGrey();
+    if (!checkCompileArgs(expressions, elements, mode, platform, g, error)) {
+        return HS_COMPILER_ERROR;
+    }
+
+    bool isStreaming = mode & (HS_MODE_STREAM | HS_MODE_VECTORED);
+    bool isVectored = mode & HS_MODE_VECTORED;
+    target_t target_info = platform ? target_t(*platform)
+                                    : get_current_target();
+
+    vector<vector<u32>> parts;
+    try {
+        CompileContext cc(isStreaming, isVectored, target_info, g);
+        parts = partitionExpressions(cc, expressions, flags, ids, ext,
+                                     elements, max_shards);
+    } catch (const CompileError &e) {
+        *error = generateCompileError(e.reason,
+                                      e.hasIndex ? (int)e.index : -1);
+        return HS_COMPILER_ERROR;
+    } catch (std::bad_alloc) {
+        *error = const_cast<hs_compile_error_t *>(&hs_enomem);
+        return HS_COMPILER_ERROR;
+    } catch (...) {
+        assert(!"Internal error, unexpected exception");
+        *error = const_cast<hs_compile_error_t *>(&hs_einternal);
+        return HS_COMPILER_ERROR;
+    }
+    assert(!parts.empty() && parts.size() <= max_shards);
+
+    for (size_t i = 0; i < parts.size(); i++) {
+        const auto &members = parts[i];
+        const unsigned num = (unsigned)members.size();
+        hs_error_t err;
+        try {
+            vector<const char *> part_exprs(num);
+            vector<unsigned> part_flags(num, 0);
+            vector<unsigned> part_ids(num, 0);
+            vector<const hs_expr_ext *> part_ext(num, nullptr);
+            for (unsigned j = 0; j < num; j++) {
+                const u32 k = members[j];
+                part_exprs[j] = expressions[k];
+                part_flags[j] = flags ? flags[k] : 0;
+                part_ids[j] = ids ? ids[k] : 0;
+                part_ext[j] = ext ? ext[k] : nullptr;
+            }
+
+            DEBUG_PRINTF("compiling shard %zu: %u expressions\n", i, num);
+            err = hs_compile_multi_int(part_exprs.data(), part_flags.data(),
+                                       part_ids.data(), part_ext.data(), num,
+                                       mode, platform, &dbs[i], error, g);
+        } catch (std::bad_alloc) {
+            *error = const_cast<hs_compile_error_t *>(&hs_enomem);
+            err = HS_COMPILER_ERROR;
+        }
+        if (err != HS_SUCCESS) {
+            // Report the expression index in terms of the caller's arrays.
+            hs_compile_error_t *e = *error;
+            if (e != &hs_enomem && e != &hs_einternal && e->expression >= 0 &&
+                (unsigned)e->expression < num) {
+                e->expression = (int)members[e->expression];
+            }
+            for (size_t j = 0; j < i; j++) {
+                hs_free_database(dbs[j]);
+                dbs[j] = nullptr;
+            }
+            return err;
+        }
+    }
+
+    *shards = (unsigned)parts.size();
+    *error = nullptr;
+    return HS_SUCCESS;
+}
+
+/** \brief Copies \a cr into a single block allocated with the misc
+ * allocator, so that it can be freed in one call. */
+static
+hs_compile_report_t *packCompileReport(const CompileReport &cr) {
+    const size_t phase_offset = ROUNDUP_N(sizeof(hs_compile_report_t),
+                                          alignof(hs_compile_phase_t));
+    const size_t expr_offset =
+        ROUNDUP_N(phase_offset + cr.phases.size() * sizeof(hs_compile_phase_t),
+                  alignof(hs_compile_expr_stats_t));
+    const size_t name_offset = expr_offset +
+        cr.expressions.size() * sizeof(hs_compile_expr_stats_t);
+    size_t len = name_offset;
+    for (const auto &ps : cr.phases) {
+        len += ps.name.size() + 1;
+    }
+
+    char *base = (char *)hs_misc_alloc(len);
+    if (!base) {
+        return nullptr;
+    }
+    memset(base, 0, len);
+
+    auto *rv = (hs_compile_report_t *)base;
+    rv->time_ns = cr.time_ns;
+    rv->peak_heap = cr.peak_heap;
+
+    auto *phases = (hs_compile_phase_t *)(base + phase_offset);
+    char *names = base + name_offset;
+    for (const auto &ps : cr.phases) {
+        hs_compile_phase_t &p = phases[rv->phase_count++];
+        memcpy(names, ps.name.c_str(), ps.name.size() + 1);
+        p.name = names;
+        names += ps.name.size() + 1;
+        p.depth = ps.depth;
+        p.calls = ps.calls;
+        p.time_ns = ps.time_ns;
+        p.peak_heap = ps.peak_heap;
+    }
+    rv->phases = phases;
+
+    auto *exprs = (hs_compile_expr_stats_t *)(base + expr_offset);
+    for (const auto &es : cr.expressions) {
+        hs_compile_expr_stats_t &e = exprs[rv->expression_count++];
+        e.index = es.index;
+        e.id = es.id;
+        e.time_ns = es.time_ns;
+        e.peak_heap = es.peak_heap;
+    }
+    rv->expressions = exprs;
+
+    const EngineCounts &ec = cr.engines;
+    rv->limex_count = ec.limex;
+    rv->mcclellan_count = ec.mcclellan;
+    rv->sheng_count = ec.sheng;
+    rv->mcsheng_count = ec.mcsheng;
+    rv->gough_count = ec.gough;
+    rv->castle_count = ec.castle;
+    rv->lbr_count = ec.lbr;
+    rv->mpv_count = ec.mpv;
+    rv->other_count = ec.other;
+    rv->outfix_count = ec.outfixes;
+    rv->suffix_count = ec.suffixes;
+    rv->leftfix_count = ec.leftfixes;
+    rv->literal_matcher_count = ec.literal_matchers;
+    rv->small_write = ec.small_write ? 1 : 0;
+
+    return rv;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_compile_ext_multi_report(const char * const *expressions,
+                                       const unsigned *flags,
+                                       const unsigned *ids,
+                                       const hs_expr_ext * const *ext,
+                                       unsigned elements, unsigned mode,
+                                       const hs_platform_info_t *platform,
+                                       hs_database_t **db,
+                                       hs_compile_error_t **error,
+                                       hs_compile_report_t **report) {
+    if (!report) {
+        if (db) {
+            *db = nullptr;
+        }
+        if (!error) {
+            return HS_COMPILER_ERROR;
+        }
+        *error = generateCompileError("Invalid parameter: report is NULL",
+                                      -1);
+        return HS_COMPILER_ERROR;
+    }
+    *report = nullptr;
+
+    CompileReport cr;
+    hs_error_t err = hs_compile_multi_int(expressions, flags, ids, ext,
+                                          elements, mode, platform, db, error,
+                                          defaultGrey(), nullptr, &cr);
+    cr.finish();
+
+    *report = packCompileReport(cr);
+    if (!*report && err == HS_SUCCESS) {
+        hs_free_database(*db);
+        *db = nullptr;
+        *error = const_cast<hs_compile_error_t *>(&hs_enomem);
+        return HS_COMPILER_ERROR;
+    }
+
+    return err;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_free_compile_report(hs_compile_report_t *report) {
+    if (report) {
+        hs_misc_free(report);
+    }
+    return HS_SUCCESS;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_compile_lit(const char *expression, unsigned flags,
+                          const size_t len, unsigned mode,
+                          const hs_platform_info_t *platform,
+                          hs_database_t **db, hs_compile_error_t **error) {
+    if (expression == nullptr) {
+        *db = nullptr;
+        *error = generateCompileError("Invalid parameter: expression is NULL",
+                                      -1);
+        return HS_COMPILER_ERROR;
+    }
+
+    unsigned id = 0; // single expressions get zero as an ID
+    return hs_compile_lit_multi_int(&expression, &flags, &id, &len, 1, mode,
+                                    platform, db, error, defaultGrey());
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_compile_lit_multi(const char * const *expressions,
+                                const unsigned *flags, const unsigned *ids,
+                                const size_t *lens, unsigned elements,
+                                unsigned mode,
+                                const hs_platform_info_t *platform,
+                                hs_database_t **db,
+                                hs_compile_error_t **error) {
+    return hs_compile_lit_multi_int(expressions, flags, ids, lens, elements,
+                                    mode, platform, db, error, defaultGrey());
 }
 
 static
@@ -424,6 +852,12 @@ hs_error_t hs_populate_platform(hs_platform_info_t *platform) {
     return HS_SUCCESS;
 }
 
+extern "C" HS_PUBLIC_API
+hs_error_t hs_set_compile_threads(unsigned int num_threads) {
+    compile_threads = num_threads;
+    return HS_SUCCESS;
+}
+
 extern "C" HS_PUBLIC_API
 hs_error_t hs_free_compile_error(hs_compile_error_t *error) {
     freeCompileError(error);
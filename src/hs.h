@@ -41,5 +41,6 @@
 
 #include "hs_compile.h"
 #include "hs_runtime.h"
+#include "hs_shard.h"
 
 #endif /* HS_H_ */
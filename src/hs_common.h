@@ -163,6 +163,74 @@ hs_error_t hs_deserialize_database(const char *bytes, const size_t length,
 hs_error_t hs_deserialize_database_at(const char *bytes, const size_t length,
                                       hs_database_t *db);
 
+/**
+ * Serialize a pattern database to a directly loadable image.
+ *
+ * Unlike the output of @ref hs_serialize_database(), a database image is laid
+ * out exactly as the database is in memory, and can be used for scanning in
+ * place (without copying) once loaded with @ref hs_load_database_image(). This
+ * makes it suitable for writing to a file which is then mapped read-only into
+ * one or more processes, all of which share a single physical copy of the
+ * database via the page cache.
+ *
+ * The allocator callback set by @ref hs_set_misc_allocator() (or @ref
+ * hs_set_allocator()) will be used by this function.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param bytes
+ *      On success, a pointer to an array of bytes will be returned here.
+ *      These bytes can be subsequently written to disk. The caller is
+ *      responsible for freeing this block.
+ *
+ * @param length
+ *      On success, the number of bytes in the generated image will be
+ *      returned here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_NOMEM if the byte array cannot be
+ *      allocated, other values may be returned if errors are detected.
+ */
+hs_error_t hs_serialize_database_image(const hs_database_t *db, char **bytes,
+                                       size_t *length);
+
+/**
+ * Validate a database image previously generated by @ref
+ * hs_serialize_database_image() and prepare it for scanning in place.
+ *
+ * No copy of the database is made: on success, the returned database refers
+ * directly to the memory at @a bytes, which must remain valid (and unmodified)
+ * for as long as the database or any scratch or stream allocated for it is in
+ * use. This memory is only ever read, so a read-only mapping of an image file
+ * (for example, from `mmap()` with `PROT_READ` and `MAP_SHARED`) may be used.
+ * The choice of mapping, including the use of huge pages through
+ * `MAP_HUGETLB` or `madvise()`, is left to the caller.
+ *
+ * The image header, platform and checksum are verified by this function.
+ *
+ * @param bytes
+ *      Pointer to a 64-byte aligned database image generated by @ref
+ *      hs_serialize_database_image(). A page-aligned mapping satisfies this
+ *      requirement.
+ *
+ * @param length
+ *      The length of the image, as returned by @ref
+ *      hs_serialize_database_image().
+ *
+ * @param db
+ *      On success, a pointer to the loaded database is returned here. This
+ *      database can then be used for pattern matching. The user is
+ *      responsible for releasing the underlying memory; the @ref
+ *      hs_free_database() call should not be used.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_BAD_ALIGN if @a bytes is not
+ *      64-byte aligned, other values on failure.
+ */
+hs_error_t hs_load_database_image(const char *bytes, const size_t length,
+                                  const hs_database_t **db);
+
 /**
  * Provides the size of the stream state allocated by a single stream opened
  * against the given database.
@@ -435,6 +503,23 @@ hs_error_t hs_set_stream_allocator(hs_alloc_t alloc_func, hs_free_t free_func);
  */
 const char *hs_version(void);
 
+/**
+ * Utility function to test the current system architecture.
+ *
+ * Hyperscan requires the Supplemental Streaming SIMD Extensions 3 instruction
+ * set. This function can be called on any x86 platform to determine if the
+ * system provides the required instruction set.
+ *
+ * This function does not test for more advanced features if Hyperscan has
+ * been built for a more specific architecture, for example the AVX2
+ * instruction set.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_ARCH_ERROR if system does not
+ *      support Hyperscan.
+ */
+hs_error_t hs_valid_platform(void);
+
 /**
  * @defgroup HS_ERROR hs_error_t values
  *
@@ -519,6 +604,29 @@ const char *hs_version(void);
  */
 #define HS_SCRATCH_IN_USE       (-10)
 
+/**
+ * Unsupported CPU architecture.
+ *
+ * This error is returned when Hyperscan is able to detect that the current
+ * system does not support the required instruction set.
+ *
+ * At a minimum, Hyperscan requires Supplemental Streaming SIMD Extensions 3
+ * (SSSE3).
+ */
+#define HS_ARCH_ERROR           (-11)
+
+/**
+ * Provided buffer was too small.
+ *
+ * This error indicates that there was insufficient space in the buffer. The
+ * call should be repeated with a larger provided buffer.
+ *
+ * Note: in this situation, it is normal for the amount of space required to be
+ * returned in the same manner as the used space would have been returned if
+ * the call was successful.
+ */
+#define HS_INSUFFICIENT_SPACE   (-12)
+
 /** @} */
 
 #ifdef __cplusplus
@@ -156,6 +156,196 @@ typedef struct hs_platform_info {
     unsigned long long reserved2;
 } hs_platform_info_t;
 
+/**
+ * A compile cache, which holds engines built by previous calls to @ref
+ * hs_compile_ext_multi_cached() so that they can be reused by later ones.
+ *
+ * Allocated with @ref hs_alloc_compile_cache() and freed with @ref
+ * hs_free_compile_cache(). The contents of this structure are private.
+ */
+typedef struct hs_compile_cache hs_compile_cache_t;
+
+/**
+ * Timing and heap usage for one compiler phase, as reported in a @ref
+ * hs_compile_report_t.
+ *
+ * Phase names are those of internal compiler passes and may change between
+ * releases; they are intended for diagnosing slow compiles rather than for
+ * programmatic use.
+ */
+typedef struct hs_compile_phase {
+    /**
+     * The path of the phase, made up of the names of the phases it is nested
+     * in and its own name, separated by '/' (for example
+     * "build/rose/merge_small_leftfixes").
+     */
+    const char *name;
+
+    /**
+     * The nesting depth of the phase: zero for a top-level phase.
+     */
+    unsigned int depth;
+
+    /**
+     * The number of times the phase ran during the compile.
+     */
+    unsigned int calls;
+
+    /**
+     * The total wall-clock time spent in the phase, in nanoseconds, including
+     * any phases nested in it. Where the compiler uses more than one thread
+     * (see @ref hs_set_compile_threads()), the times of phases run
+     * concurrently are added together, so may exceed that of their parent.
+     */
+    unsigned long long time_ns;
+
+    /**
+     * The largest growth in heap usage seen during a single run of the phase,
+     * in bytes. Heap usage is sampled at phase boundaries, so this is a lower
+     * bound on the true peak. Zero on platforms where heap usage is not
+     * available.
+     */
+    unsigned long long peak_heap;
+} hs_compile_phase_t;
+
+/**
+ * The cost of one expression, as reported in a @ref hs_compile_report_t.
+ */
+typedef struct hs_compile_expr_stats {
+    /**
+     * The index of the expression in the array passed to the compiler.
+     */
+    unsigned int index;
+
+    /**
+     * The ID of the expression.
+     */
+    unsigned int id;
+
+    /**
+     * The wall-clock time spent parsing and analysing this expression on its
+     * own, in nanoseconds. This does not include the construction of the
+     * database as a whole, which is accounted for in the "build" phase.
+     */
+    unsigned long long time_ns;
+
+    /**
+     * The largest growth in heap usage seen while doing so, in bytes. See @ref
+     * hs_compile_phase_t::peak_heap.
+     */
+    unsigned long long peak_heap;
+} hs_compile_expr_stats_t;
+
+/**
+ * A report describing where a compile spent its time and memory, returned by
+ * @ref hs_compile_ext_multi_report() and freed with @ref
+ * hs_free_compile_report().
+ *
+ * The engine counts describe the database produced, so are all zero if the
+ * compile failed.
+ */
+typedef struct hs_compile_report {
+    /**
+     * The total wall-clock time taken by the compile, in nanoseconds.
+     */
+    unsigned long long time_ns;
+
+    /**
+     * The largest growth in heap usage seen during the compile, in bytes.
+     */
+    unsigned long long peak_heap;
+
+    /**
+     * The number of entries in @a phases.
+     */
+    unsigned int phase_count;
+
+    /**
+     * The number of entries in @a expressions.
+     */
+    unsigned int expression_count;
+
+    /**
+     * The phases that ran, in the order in which they first started. A
+     * phase is listed after the phase it is nested in.
+     */
+    const hs_compile_phase_t *phases;
+
+    /**
+     * One entry for each expression that was successfully added to the
+     * compiler, in the order in which they were added.
+     */
+    const hs_compile_expr_stats_t *expressions;
+
+    /**
+     * The number of LimEx NFA engines in the database.
+     */
+    unsigned int limex_count;
+
+    /**
+     * The number of McClellan DFA engines in the database.
+     */
+    unsigned int mcclellan_count;
+
+    /**
+     * The number of Sheng (small, shuffle-driven) DFA engines in the database.
+     */
+    unsigned int sheng_count;
+
+    /**
+     * The number of McSheng DFA engines (McClellan DFAs whose most frequently
+     * visited states are run as a Sheng) in the database.
+     */
+    unsigned int mcsheng_count;
+
+    /**
+     * The number of Gough (start of match tracking) DFA engines in the
+     * database.
+     */
+    unsigned int gough_count;
+
+    /**
+     * The number of Castle bounded repeat engines in the database.
+     */
+    unsigned int castle_count;
+
+    /**
+     * The number of large bounded repeat (LBR) engines in the database.
+     */
+    unsigned int lbr_count;
+
+    /**
+     * The number of Mega-Puff-Vac engines in the database.
+     */
+    unsigned int mpv_count;
+
+    /**
+     * The number of engines of any other type in the database.
+     */
+    unsigned int other_count;
+
+    /**
+     * The same engines, counted by role: outfixes run on the whole input,
+     * suffixes are triggered by literal matches and leftfixes (prefixes and
+     * infixes) are checked by them.
+     */
+    unsigned int outfix_count;
+    unsigned int suffix_count;
+    unsigned int leftfix_count;
+
+    /**
+     * The number of literal matchers in the database (at most one each for
+     * anchored, floating, end-of-data anchored and small-block literals).
+     */
+    unsigned int literal_matcher_count;
+
+    /**
+     * Non-zero if the database contains a small-write engine, used for
+     * scanning short blocks.
+     */
+    char small_write;
+} hs_compile_report_t;
+
 /**
  * A type containing information related to an expression that is returned by
  * @ref hs_expression_info() or @ref hs_expression_ext_info.
@@ -355,6 +545,9 @@ hs_error_t hs_compile(const char *expression, unsigned int flags,
  *       - HS_FLAG_PREFILTER - Compile pattern in prefiltering mode.
  *       - HS_FLAG_SOM_LEFTMOST - Report the leftmost start of match offset
  *                                when a match is found.
+ *       - HS_FLAG_COMBINATION - Parse the expression as a logical combination
+ *                               of other expressions' match IDs.
+ *       - HS_FLAG_QUIET - Don't report matches for this expression.
  *
  * @param ids
  *      An array of integers specifying the ID number to be associated with the
@@ -433,6 +626,9 @@ hs_error_t hs_compile_multi(const char *const *expressions,
  *       - HS_FLAG_PREFILTER - Compile pattern in prefiltering mode.
  *       - HS_FLAG_SOM_LEFTMOST - Report the leftmost start of match offset
  *                                when a match is found.
+ *       - HS_FLAG_COMBINATION - Parse the expression as a logical combination
+ *                               of other expressions' match IDs.
+ *       - HS_FLAG_QUIET - Don't report matches for this expression.
  *
  * @param ids
  *      An array of integers specifying the ID number to be associated with the
@@ -488,9 +684,412 @@ hs_error_t hs_compile_ext_multi(const char *const *expressions,
                                 const hs_platform_info_t *platform,
                                 hs_database_t **db, hs_compile_error_t **error);
 
+/**
+ * Allocates an empty compile cache for use with @ref
+ * hs_compile_ext_multi_cached().
+ *
+ * @param cache
+ *      On success, a pointer to the new cache is returned in this parameter.
+ *      The caller is responsible for freeing it with @ref
+ *      hs_free_compile_cache().
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_NOMEM if the cache could not be
+ *      allocated, or @ref HS_INVALID if @a cache is NULL.
+ */
+hs_error_t hs_alloc_compile_cache(hs_compile_cache_t **cache);
+
+/**
+ * Frees a compile cache allocated by @ref hs_alloc_compile_cache().
+ *
+ * @param cache
+ *      The cache to free. NULL is accepted and ignored.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_free_compile_cache(hs_compile_cache_t *cache);
+
+/**
+ * The multiple regular expression compiler with a compile cache.
+ *
+ * This function compiles a group of expressions in the same way as @ref
+ * hs_compile_ext_multi(), and produces an identical database. Engines that
+ * were built by earlier calls using the same @a cache are taken from the
+ * cache instead of being built again, so recompiling a pattern set after a
+ * small change to it is faster than compiling it from scratch.
+ *
+ * After a successful compile, the cache holds only the engines used by the new
+ * database. A cache works best when it is used for successive versions of one
+ * pattern set, with the same mode and platform. It must not be used by more
+ * than one compile call at a time.
+ *
+ * @param expressions
+ *      Array of NULL-terminated expressions to compile, as for @ref
+ *      hs_compile_ext_multi().
+ *
+ * @param flags
+ *      Array of flags for each expression, as for @ref hs_compile_ext_multi().
+ *
+ * @param ids
+ *      Array of IDs for each expression, as for @ref hs_compile_ext_multi().
+ *
+ * @param ext
+ *      Array of extended parameter structures, as for @ref
+ *      hs_compile_ext_multi(). May be NULL.
+ *
+ * @param elements
+ *      The number of elements in the input arrays.
+ *
+ * @param mode
+ *      Compiler mode flags that affect the database as a whole, as for @ref
+ *      hs_compile_ext_multi().
+ *
+ * @param platform
+ *      If not NULL, the platform structure is used to determine the target
+ *      platform for the database. If NULL, a database suitable for running
+ *      on the current host platform is produced.
+ *
+ * @param cache
+ *      The compile cache, allocated with @ref hs_alloc_compile_cache().
+ *
+ * @param db
+ *      On success, a pointer to the generated database will be returned in
+ *      this parameter, or NULL on failure. The caller is responsible for
+ *      deallocating the buffer using the @ref hs_free_database() function.
+ *
+ * @param error
+ *      If the compile fails, a pointer to a @ref hs_compile_error_t will be
+ *      returned, providing details of the error condition. The caller is
+ *      responsible for deallocating the buffer using the @ref
+ *      hs_free_compile_error() function.
+ *
+ * @return
+ *      @ref HS_SUCCESS is returned on successful compilation; @ref
+ *      HS_COMPILER_ERROR on failure, with details provided in the @a error
+ *      parameter.
+ */
+hs_error_t hs_compile_ext_multi_cached(const char *const *expressions,
+                                       const unsigned int *flags,
+                                       const unsigned int *ids,
+                                       const hs_expr_ext_t *const *ext,
+                                       unsigned int elements,
+                                       unsigned int mode,
+                                       const hs_platform_info_t *platform,
+                                       hs_compile_cache_t *cache,
+                                       hs_database_t **db,
+                                       hs_compile_error_t **error);
+
+/**
+ * The multiple regular expression compiler, producing a sharded pattern set.
+ *
+ * This function partitions a group of expressions into up to @a max_shards
+ * sets and compiles each set into its own database, as for @ref
+ * hs_compile_ext_multi(). Each shard is smaller than a single database for the
+ * whole group would be, and the shards can be scanned concurrently against the
+ * same input with the functions in hs_shard.h.
+ *
+ * The partition is chosen by a cost model that estimates the work each
+ * expression adds to a database: pure literals are cheap, while other
+ * expressions need an engine whose cost grows with its number of states (and
+ * more so in streaming mode, where those states are held in stream state).
+ * Shards are balanced by this cost, and expressions sharing literal factors
+ * are kept together where the balance allows. A logical combination (see @ref
+ * HS_FLAG_COMBINATION) is always placed in the same shard as all of the
+ * expressions it refers to. Expressions that share an ID are always placed in
+ * the same shard, so that @ref HS_FLAG_SINGLEMATCH and match deduplication
+ * behave as they would for a single database. If @a ids is NULL, every
+ * expression has ID zero and a single shard is produced.
+ *
+ * Fewer than @a max_shards shards are produced if there are too few
+ * expressions, or too little work, to fill them.
+ *
+ * @param expressions
+ *      Array of NULL-terminated expressions to compile, as for @ref
+ *      hs_compile_ext_multi().
+ *
+ * @param flags
+ *      Array of flags for each expression, as for @ref hs_compile_ext_multi().
+ *
+ * @param ids
+ *      Array of IDs for each expression, as for @ref hs_compile_ext_multi().
+ *
+ * @param ext
+ *      Array of extended parameter structures, as for @ref
+ *      hs_compile_ext_multi(). May be NULL.
+ *
+ * @param elements
+ *      The number of elements in the input arrays.
+ *
+ * @param mode
+ *      Compiler mode flags that affect the database as a whole, as for @ref
+ *      hs_compile_ext_multi().
+ *
+ * @param platform
+ *      If not NULL, the platform structure is used to determine the target
+ *      platform for the databases. If NULL, databases suitable for running
+ *      on the current host platform are produced.
+ *
+ * @param max_shards
+ *      The maximum number of shards to produce; must be at least one.
+ *
+ * @param dbs
+ *      An array of @a max_shards database pointers. On success, the generated
+ *      databases are returned in the first @a shards entries of this array and
+ *      the remainder are set to NULL. The caller is responsible for
+ *      deallocating each database using the @ref hs_free_database() function.
+ *      On failure, every entry is set to NULL.
+ *
+ * @param shards
+ *      On success, the number of databases generated is returned here.
+ *
+ * @param error
+ *      If the compile fails, a pointer to a @ref hs_compile_error_t will be
+ *      returned, providing details of the error condition. The expression
+ *      index in the error refers to the @a expressions array given to this
+ *      function. The caller is responsible for deallocating the buffer using
+ *      the @ref hs_free_compile_error() function.
+ *
+ * @return
+ *      @ref HS_SUCCESS is returned on successful compilation; @ref
+ *      HS_COMPILER_ERROR on failure, with details provided in the @a error
+ *      parameter.
+ */
+hs_error_t hs_compile_ext_multi_sharded(const char *const *expressions,
+                                        const unsigned int *flags,
+                                        const unsigned int *ids,
+                                        const hs_expr_ext_t *const *ext,
+                                        unsigned int elements,
+                                        unsigned int mode,
+                                        const hs_platform_info_t *platform,
+                                        unsigned int max_shards,
+                                        hs_database_t **dbs,
+                                        unsigned int *shards,
+                                        hs_compile_error_t **error);
+
+/**
+ * The multiple regular expression compiler with a report of where the compile
+ * spent its time and memory.
+ *
+ * This function compiles a group of expressions in the same way as @ref
+ * hs_compile_ext_multi(), and produces an identical database. It also returns
+ * a @ref hs_compile_report_t, which gives the wall-clock time and peak heap
+ * growth of each phase of the compiler, of each expression, and of the
+ * compile as a whole, and the numbers of engines of each type built.
+ *
+ * A report is returned whether or not the compile succeeds, so that an
+ * expression that exhausts a compiler limit after a long time can be
+ * identified. Collecting the report slows the compile a little.
+ *
+ * @param expressions
+ *      Array of NULL-terminated expressions to compile, as for @ref
+ *      hs_compile_ext_multi().
+ *
+ * @param flags
+ *      Array of flags for each expression, as for @ref hs_compile_ext_multi().
+ *
+ * @param ids
+ *      Array of IDs for each expression, as for @ref hs_compile_ext_multi().
+ *
+ * @param ext
+ *      Array of extended parameter structures, as for @ref
+ *      hs_compile_ext_multi(). May be NULL.
+ *
+ * @param elements
+ *      The number of elements in the input arrays.
+ *
+ * @param mode
+ *      Compiler mode flags that affect the database as a whole, as for @ref
+ *      hs_compile_ext_multi().
+ *
+ * @param platform
+ *      If not NULL, the platform structure is used to determine the target
+ *      platform for the database. If NULL, a database suitable for running
+ *      on the current host platform is produced.
+ *
+ * @param db
+ *      On success, a pointer to the generated database will be returned in
+ *      this parameter, or NULL on failure. The caller is responsible for
+ *      deallocating the buffer using the @ref hs_free_database() function.
+ *
+ * @param error
+ *      If the compile fails, a pointer to a @ref hs_compile_error_t will be
+ *      returned, providing details of the error condition. The caller is
+ *      responsible for deallocating the buffer using the @ref
+ *      hs_free_compile_error() function.
+ *
+ * @param report
+ *      A pointer to the report is returned in this parameter, or NULL if no
+ *      memory could be allocated for it. The caller is responsible for
+ *      deallocating it using the @ref hs_free_compile_report() function.
+ *
+ * @return
+ *      @ref HS_SUCCESS is returned on successful compilation; @ref
+ *      HS_COMPILER_ERROR on failure, with details provided in the @a error
+ *      parameter.
+ */
+hs_error_t hs_compile_ext_multi_report(const char *const *expressions,
+                                       const unsigned int *flags,
+                                       const unsigned int *ids,
+                                       const hs_expr_ext_t *const *ext,
+                                       unsigned int elements,
+                                       unsigned int mode,
+                                       const hs_platform_info_t *platform,
+                                       hs_database_t **db,
+                                       hs_compile_error_t **error,
+                                       hs_compile_report_t **report);
+
+/**
+ * Frees a report returned by @ref hs_compile_ext_multi_report().
+ *
+ * @param report
+ *      The report to free. NULL is accepted and ignored.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_free_compile_report(hs_compile_report_t *report);
+
+/**
+ * The basic pure literal compiler.
+ *
+ * This is the function call with which a literal is compiled into a Hyperscan
+ * database. The literal is matched byte-for-byte: no regular expression
+ * syntax is interpreted, so it may contain any bytes (including NUL) and need
+ * not be escaped. Literals bypass the pattern parser and graph analysis,
+ * which makes compilation of large literal sets considerably cheaper than
+ * supplying the equivalent escaped expressions to @ref hs_compile().
+ *
+ * @param expression
+ *      The literal to compile. It is not required to be NULL-terminated.
+ *
+ * @param flags
+ *      Flags which modify the behaviour of the literal. Multiple flags may be
+ *      used by ORing them together.
+ *      Valid values are:
+ *       - HS_FLAG_CASELESS - Matching will be performed case-insensitively.
+ *       - HS_FLAG_SINGLEMATCH - Only one match will be generated by patterns
+ *                               with this match id per stream.
+ *       - HS_FLAG_SOM_LEFTMOST - Report the leftmost start of match offset
+ *                                when a match is found.
+ *
+ * @param len
+ *      The length of the literal in bytes; it must be non-zero.
+ *
+ * @param mode
+ *      Compiler mode flags that affect the database as a whole. One of @ref
+ *      HS_MODE_STREAM, @ref HS_MODE_BLOCK or @ref HS_MODE_VECTORED must be
+ *      supplied, to select between the generation of a streaming, block or
+ *      vectored database. In addition, other flags (beginning with HS_MODE_)
+ *      may be supplied to enable specific features. See @ref HS_MODE_FLAG for
+ *      more details.
+ *
+ * @param platform
+ *      If not NULL, the platform structure is used to determine the target
+ *      platform for the database. If NULL, a database suitable for running
+ *      on the current host platform is produced.
+ *
+ * @param db
+ *      On success, a pointer to the generated database will be returned in
+ *      this parameter, or NULL on failure. The caller is responsible for
+ *      deallocating the buffer using the @ref hs_free_database() function.
+ *
+ * @param error
+ *      If the compile fails, a pointer to a @ref hs_compile_error_t will be
+ *      returned, providing details of the error condition. The caller is
+ *      responsible for deallocating the buffer using the @ref
+ *      hs_free_compile_error() function.
+ *
+ * @return
+ *      @ref HS_SUCCESS is returned on successful compilation; @ref
+ *      HS_COMPILER_ERROR on failure, with details provided in the @a error
+ *      parameter.
+ *
+ */
+hs_error_t hs_compile_lit(const char *expression, unsigned flags,
+                          const size_t len, unsigned mode,
+                          const hs_platform_info_t *platform,
+                          hs_database_t **db, hs_compile_error_t **error);
+
+/**
+ * The multiple pure literal compiler.
+ *
+ * This function call compiles a set of literals into a database that can be
+ * passed to the runtime functions (such as @ref hs_scan(), @ref
+ * hs_open_stream(), etc.) in the same way as @ref hs_compile_multi(). As with
+ * @ref hs_compile_lit(), the literals are matched byte-for-byte and may
+ * contain NUL bytes.
+ *
+ * @param expressions
+ *      Array of literals to compile. They are not required to be
+ *      NULL-terminated.
+ *
+ * @param flags
+ *      Array of flags which modify the behaviour of each literal. Multiple
+ *      flags may be used by ORing them together. Specifying the NULL pointer
+ *      in place of an array will set the flags value for all literals to zero.
+ *      Valid values are:
+ *       - HS_FLAG_CASELESS - Matching will be performed case-insensitively.
+ *       - HS_FLAG_SINGLEMATCH - Only one match will be generated by patterns
+ *                               with this match id per stream.
+ *       - HS_FLAG_SOM_LEFTMOST - Report the leftmost start of match offset
+ *                                when a match is found.
+ *
+ * @param ids
+ *      An array of integers specifying the ID number to be associated with the
+ *      corresponding literal in the expressions array. Specifying the NULL
+ *      pointer in place of an array will set the ID value for all literals to
+ *      zero.
+ *
+ * @param lens
+ *      Array of lengths, in bytes, of the literals in the expressions array.
+ *      Each length must be non-zero.
+ *
+ * @param elements
+ *      The number of elements in the input arrays.
+ *
+ * @param mode
+ *      Compiler mode flags that affect the database as a whole. One of @ref
+ *      HS_MODE_STREAM, @ref HS_MODE_BLOCK or @ref HS_MODE_VECTORED must be
+ *      supplied, to select between the generation of a streaming, block or
+ *      vectored database. In addition, other flags (beginning with HS_MODE_)
+ *      may be supplied to enable specific features. See @ref HS_MODE_FLAG for
+ *      more details.
+ *
+ * @param platform
+ *      If not NULL, the platform structure is used to determine the target
+ *      platform for the database. If NULL, a database suitable for running
+ *      on the current host platform is produced.
+ *
+ * @param db
+ *      On success, a pointer to the generated database will be returned in
+ *      this parameter, or NULL on failure. The caller is responsible for
+ *      deallocating the buffer using the @ref hs_free_database() function.
+ *
+ * @param error
+ *      If the compile fails, a pointer to a @ref hs_compile_error_t will be
+ *      returned, providing details of the error condition. The caller is
+ *      responsible for deallocating the buffer using the @ref
+ *      hs_free_compile_error() function.
+ *
+ * @return
+ *      @ref HS_SUCCESS is returned on successful compilation; @ref
+ *      HS_COMPILER_ERROR on failure, with details provided in the @a error
+ *      parameter.
+ *
+ */
+hs_error_t hs_compile_lit_multi(const char *const *expressions,
+                                const unsigned *flags, const unsigned *ids,
+                                const size_t *lens, unsigned elements,
+                                unsigned mode,
+                                const hs_platform_info_t *platform,
+                                hs_database_t **db,
+                                hs_compile_error_t **error);
+
 /**
  * Free an error structure generated by @ref hs_compile(), @ref
- * hs_compile_multi() or @ref hs_compile_ext_multi().
+ * hs_compile_multi(), @ref hs_compile_ext_multi(), @ref hs_compile_lit() or
+ * @ref hs_compile_lit_multi().
  *
  * @param error
  *      The @ref hs_compile_error_t to be freed. NULL may also be safely
@@ -619,6 +1218,24 @@ hs_error_t hs_expression_ext_info(const char *expression, unsigned int flags,
  */
 hs_error_t hs_populate_platform(hs_platform_info_t *platform);
 
+/**
+ * Sets the number of threads that subsequent calls to the compile functions
+ * may use to build independent engines concurrently.
+ *
+ * This is a process-wide setting; it affects all compile calls made after it
+ * returns, from any thread. The database produced is identical regardless of
+ * the number of threads used. By default, compilation is single-threaded.
+ *
+ * @param num_threads
+ *      The maximum number of threads to use for each compile call, including
+ *      the calling thread. A value of zero selects one thread per hardware
+ *      thread on the current host.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_set_compile_threads(unsigned int num_threads);
+
 /**
  * @defgroup HS_PATTERN_FLAG Pattern flags
  *
@@ -748,6 +1365,42 @@ hs_error_t hs_populate_platform(hs_platform_info_t *platform);
  */
 #define HS_FLAG_SOM_LEFTMOST    256
 
+/**
+ * Compile flag: Logical combination.
+ *
+ * This flag instructs Hyperscan to parse this expression as a logical
+ * combination of other expressions in the same database, rather than as a
+ * regular expression. The combination is written in terms of the match IDs of
+ * those sub-expressions, using the operators `&` (AND), `|` (OR) and `!` (NOT)
+ * and parentheses for grouping; for example, `(101 & 102) | !103`. NOT binds
+ * most tightly, then AND, then OR.
+ *
+ * The combination is evaluated inside the engine as sub-expression matches
+ * are found. Whenever a sub-expression matches and the combination is true,
+ * the combination's own match ID is reported, with the end offset of that
+ * sub-expression match and a start offset of zero. A combination that is true
+ * without any of its sub-expressions having matched (such as `!103`) is
+ * reported once, at the end of the data, if it has not already been reported.
+ *
+ * Each match ID used in a combination must belong to an expression in the same
+ * database that is not itself a combination. Only @ref HS_FLAG_SINGLEMATCH may
+ * be used alongside this flag, and extended parameters are not supported.
+ */
+#define HS_FLAG_COMBINATION     512
+
+/**
+ * Compile flag: Don't report matches for this expression.
+ *
+ * This flag instructs Hyperscan to never deliver matches for this expression
+ * to the match callback. It is intended for the sub-expressions of a logical
+ * combination (see @ref HS_FLAG_COMBINATION), whose matches are only of
+ * interest to the combination itself.
+ *
+ * If multiple expressions in the database share the same match ID, then they
+ * either must all specify @ref HS_FLAG_QUIET or none of them specify it.
+ */
+#define HS_FLAG_QUIET           1024
+
 /** @} */
 
 /**
@@ -764,6 +1417,15 @@ hs_error_t hs_populate_platform(hs_platform_info_t *platform);
  */
 #define HS_CPU_FEATURES_AVX2             (1ULL << 2)
 
+/**
+ * CPU features flag - Intel(R) Advanced Vector Extensions 512
+ * (Intel(R) AVX512)
+ *
+ * Setting this flag indicates that the target platform supports AVX512
+ * instructions, specifically AVX-512BW. Using AVX512 implies the use of AVX2.
+ */
+#define HS_CPU_FEATURES_AVX512           (1ULL << 3)
+
 /** @} */
 
 /**
@@ -857,6 +1519,31 @@ hs_error_t hs_populate_platform(hs_platform_info_t *platform);
  */
 #define HS_MODE_VECTORED        4
 
+/**
+ * Compiler mode flag: matches may be delivered out of order and may be
+ * duplicated.
+ *
+ * By default, Hyperscan delivers matches in order of increasing end offset
+ * and reports each match only once, which requires the engines that run
+ * behind the literal matchers to be caught up with one another before every
+ * match is delivered. With this flag set, the compiler is permitted to drop
+ * these guarantees: engines report their matches as soon as they are found,
+ * so matches from different patterns may arrive in any order, and a pattern
+ * may be reported more than once at the same offset.
+ *
+ * Every match is still delivered before the scan call that scans its final
+ * byte returns (or, for matches at end of data in streaming mode, before
+ * @ref hs_close_stream() returns).
+ *
+ * This flag is a hint: databases containing patterns that use @ref
+ * HS_FLAG_SOM_LEFTMOST, logical combinations, or bounded repeats that are
+ * implemented by chained engines are still built with ordered delivery.
+ *
+ * This flag may be combined with @ref HS_MODE_BLOCK, @ref HS_MODE_STREAM or
+ * @ref HS_MODE_VECTORED.
+ */
+#define HS_MODE_UNORDERED       (1U << 8)
+
 /**
  * Compiler mode flag: use full precision to track start of match offsets in
  * stream state.
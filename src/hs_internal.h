@@ -40,17 +40,36 @@
 
 namespace ue2 {
 
+class CompileReport;
+class EngineCache;
 struct Grey;
 
 /** \brief Internal use only: takes a Grey argument so that we can use it in
- * tools. */
+ * tools.
+ *
+ * If \a cache is given, engines are reused from and added to it. A cache must
+ * only be used with one Grey configuration. If \a report is given, the time
+ * and memory used by each compile phase is recorded in it. */
 hs_error_t hs_compile_multi_int(const char *const *expressions,
                                 const unsigned *flags, const unsigned *ids,
                                 const hs_expr_ext *const *ext,
                                 unsigned elements, unsigned mode,
                                 const hs_platform_info_t *platform,
                                 hs_database_t **db,
-                                hs_compile_error_t **comp_error, const Grey &g);
+                                hs_compile_error_t **comp_error, const Grey &g,
+                                EngineCache *cache = nullptr,
+                                CompileReport *report = nullptr);
+
+/** \brief Internal use only: literal-only counterpart to
+ * \ref hs_compile_multi_int. */
+hs_error_t hs_compile_lit_multi_int(const char *const *expressions,
+                                    const unsigned *flags, const unsigned *ids,
+                                    const size_t *lens, unsigned elements,
+                                    unsigned mode,
+                                    const hs_platform_info_t *platform,
+                                    hs_database_t **db,
+                                    hs_compile_error_t **comp_error,
+                                    const Grey &g);
 
 } // namespace ue2
 
@@ -69,7 +88,13 @@ extern "C"
                     | HS_FLAG_PREFILTER \
                     | HS_FLAG_SINGLEMATCH \
                     | HS_FLAG_ALLOWEMPTY \
-                    | HS_FLAG_SOM_LEFTMOST)
+                    | HS_FLAG_SOM_LEFTMOST \
+                    | HS_FLAG_QUIET)
+
+/** \brief Bitmask of the flags supported by the pure literal API. */
+#define HS_FLAG_LIT_ALL ( HS_FLAG_CASELESS \
+                        | HS_FLAG_SINGLEMATCH \
+                        | HS_FLAG_SOM_LEFTMOST)
 
 #ifdef __cplusplus
 } /* extern "C" */
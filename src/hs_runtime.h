@@ -65,6 +65,13 @@ struct hs_scratch;
  */
 typedef struct hs_scratch hs_scratch_t;
 
+struct hs_scratch_pool;
+
+/**
+ * A pool of Hyperscan scratch spaces, shared between threads.
+ */
+typedef struct hs_scratch_pool hs_scratch_pool_t;
+
 /**
  * Definition of the match event callback function type.
  *
@@ -320,6 +327,124 @@ hs_error_t hs_reset_and_copy_stream(hs_stream_t *to_id,
                                     match_event_handler onEvent,
                                     void *context);
 
+/**
+ * Creates a compressed representation of the provided stream in the buffer
+ * provided. This compressed representation can be converted back into a stream
+ * state by using @ref hs_expand_stream() or @ref hs_reset_and_expand_stream().
+ * The size of the compressed representation will be placed into @a used_space.
+ *
+ * The compressed representation only holds the parts of the stream state that
+ * are live (for example, the state of engines that are currently active), so
+ * it is usually much smaller than the stream itself, particularly for streams
+ * that have gone quiet. It is only valid for the database the stream was
+ * opened against, and is not portable between platforms.
+ *
+ * If there is not sufficient space in the buffer to hold the compressed
+ * representation, @ref HS_INSUFFICIENT_SPACE will be returned and @a
+ * used_space will be populated with the amount of space required.
+ *
+ * Note: this function does not close the provided stream, you may continue to
+ * use the stream or to free it with @ref hs_close_stream().
+ *
+ * @param stream
+ *      The stream (as created by @ref hs_open_stream()) to be compressed.
+ *
+ * @param buf
+ *      Buffer to write the compressed representation into. Note: if the call
+ *      is just being used to determine the amount of space required, it is
+ *      allowed to pass NULL here and @a buf_space as 0.
+ *
+ * @param buf_space
+ *      The number of bytes in @a buf. If buf_space is too small, the call will
+ *      fail with @ref HS_INSUFFICIENT_SPACE.
+ *
+ * @param used_space
+ *      Pointer to where the amount of used space will be written to. The used
+ *      buffer space is always less than or equal to @a buf_space. If the call
+ *      fails with @ref HS_INSUFFICIENT_SPACE, this pointer will be used to
+ *      write out the amount of buffer space required.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, @ref HS_INSUFFICIENT_SPACE if the provided
+ *      buffer is too small.
+ */
+hs_error_t hs_compress_stream(const hs_stream_t *stream, char *buf,
+                              size_t buf_space, size_t *used_space);
+
+/**
+ * Decompresses a compressed representation created by @ref
+ * hs_compress_stream() into a new stream.
+ *
+ * Note: @a buf must correspond to a complete compressed representation created
+ * by @ref hs_compress_stream() of a stream that was opened against @a db. It is
+ * not always possible to detect misuse of this API and behaviour is undefined
+ * if these properties are not satisfied.
+ *
+ * @param db
+ *      The compiled pattern database that the compressed stream was opened
+ *      against.
+ *
+ * @param stream
+ *      On success, a pointer to the expanded @ref hs_stream_t will be
+ *      returned; NULL on failure.
+ *
+ * @param buf
+ *      A compressed representation of a stream. These compressed forms are
+ *      created by @ref hs_compress_stream().
+ *
+ * @param buf_size
+ *      The size in bytes of the compressed representation.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_expand_stream(const hs_database_t *db, hs_stream_t **stream,
+                            const char *buf, size_t buf_size);
+
+/**
+ * Decompresses a compressed representation created by @ref
+ * hs_compress_stream() on top of the 'to' stream. The 'to' stream will first
+ * be reset (reporting any EOD matches if a non-NULL @a onEvent callback
+ * handler is provided). This avoids allocating a new stream for each flow
+ * that is brought back from its compressed form.
+ *
+ * Note: the 'to' stream must be opened against the same database as the
+ * compressed stream. If @a buf is not a well-formed compressed stream, the
+ * 'to' stream is left in the same state as a newly-opened stream and @ref
+ * HS_INVALID is returned.
+ *
+ * @param to_stream
+ *      The stream (as created by @ref hs_open_stream()) to be overwritten
+ *      with the expanded stream state.
+ *
+ * @param buf
+ *      A compressed representation of a stream. These compressed forms are
+ *      created by @ref hs_compress_stream().
+ *
+ * @param buf_size
+ *      The size in bytes of the compressed representation.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch(). This is
+ *      allowed to be NULL only if the @a onEvent callback is also NULL.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function
+ *      when a match occurs.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_reset_and_expand_stream(hs_stream_t *to_stream,
+                                      const char *buf, size_t buf_size,
+                                      hs_scratch_t *scratch,
+                                      match_event_handler onEvent,
+                                      void *context);
+
 /**
  * The block (non-streaming) regular expression scanner.
  *
@@ -360,6 +485,154 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data,
                    hs_scratch_t *scratch, match_event_handler onEvent,
                    void *context);
 
+/**
+ * The batched block (non-streaming) regular expression scanner.
+ *
+ * This function scans a number of independent buffers against a block-mode
+ * pattern database. The result is identical to calling @ref hs_scan() on
+ * each buffer in turn, but argument validation and scratch setup are only
+ * performed once for the whole batch, and upcoming buffers are prefetched
+ * while earlier ones are scanned. This makes it considerably cheaper than
+ * repeated calls to @ref hs_scan() when scanning many short buffers.
+ *
+ * Matches are delivered in buffer order. The callback is passed the context
+ * pointer for the buffer in which the match occurred, which is how
+ * applications tell which buffer a match belongs to.
+ *
+ * If the callback indicates that scanning should stop, only the scan of the
+ * current buffer is halted; scanning continues with the next buffer in the
+ * batch.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param data
+ *      An array of pointers to the buffers to be scanned.
+ *
+ * @param length
+ *      An array of lengths (in bytes) of each buffer to scan.
+ *
+ * @param count
+ *      Number of buffers to scan. This should correspond to the size of the
+ *      @a data and @a length arrays, and of the @a context array if one is
+ *      given.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function. This parameter is
+ *      provided for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() for this
+ *      database.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      An array of user defined pointers, one per buffer, which will be passed
+ *      to the callback function for matches in the corresponding buffer. If a
+ *      NULL pointer is given, the callback will be passed NULL for all
+ *      buffers.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that scanning should stop for any of the
+ *      buffers; other values on error.
+ */
+hs_error_t hs_scan_batch(const hs_database_t *db, const char *const *data,
+                         const unsigned int *length, unsigned int count,
+                         unsigned int flags, hs_scratch_t *scratch,
+                         match_event_handler onEvent, void *const *context);
+
+/**
+ * The block (non-streaming) regular expression scanner, recording which
+ * patterns matched in a bitmap.
+ *
+ * This function behaves like @ref hs_scan(), but rather than calling a match
+ * callback it sets bit (id % 8) of byte (id / 8) of the @a bitmap for each
+ * match ID that matches in the data. Matches are not delivered in any other
+ * way, and no offsets are reported.
+ *
+ * Bits are only ever set, never cleared, so the bitmap should be zeroed
+ * before the scan. As a pattern need only match once to be recorded, the scan
+ * ends as soon as every pattern in the database has been recorded. Match IDs
+ * greater than or equal to @a num_ids are ignored.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param data
+ *      Pointer to the data to be scanned.
+ *
+ * @param length
+ *      The number of bytes to scan.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function. This parameter is
+ *      provided for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() for this
+ *      database.
+ *
+ * @param bitmap
+ *      The bitmap to record matches in, which must be at least
+ *      (@a num_ids + 7) / 8 bytes long.
+ *
+ * @param num_ids
+ *      The number of match IDs covered by @a bitmap.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; other values on error.
+ */
+hs_error_t hs_scan_bitmap(const hs_database_t *db, const char *data,
+                          unsigned int length, unsigned int flags,
+                          hs_scratch_t *scratch, unsigned char *bitmap,
+                          unsigned int num_ids);
+
+/**
+ * The block (non-streaming) regular expression scanner, counting matches for
+ * each pattern.
+ *
+ * This function behaves like @ref hs_scan(), but rather than calling a match
+ * callback it increments @a counts[id] for each match with match ID id.
+ * Matches are not delivered in any other way, and no offsets are reported.
+ *
+ * Counts are only ever incremented, so the array should be zeroed before the
+ * scan. Match IDs greater than or equal to @a num_ids are ignored.
+ *
+ * @param db
+ *      A compiled pattern database.
+ *
+ * @param data
+ *      Pointer to the data to be scanned.
+ *
+ * @param length
+ *      The number of bytes to scan.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function. This parameter is
+ *      provided for future use and is unused at present.
+ *
+ * @param scratch
+ *      A per-thread scratch space allocated by @ref hs_alloc_scratch() for this
+ *      database.
+ *
+ * @param counts
+ *      An array of @a num_ids match counters, indexed by match ID.
+ *
+ * @param num_ids
+ *      The number of match IDs covered by @a counts.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; other values on error.
+ */
+hs_error_t hs_scan_count(const hs_database_t *db, const char *data,
+                         unsigned int length, unsigned int flags,
+                         hs_scratch_t *scratch, unsigned long long *counts,
+                         unsigned int num_ids);
+
 /**
  * The vectored regular expression scanner.
  *
@@ -482,6 +755,403 @@ hs_error_t hs_scratch_size(const hs_scratch_t *scratch, size_t *scratch_size);
  */
 hs_error_t hs_free_scratch(hs_scratch_t *scratch);
 
+/**
+ * Allocate a pool of scratch spaces for use by multiple threads.
+ *
+ * Instead of keeping a scratch space per thread, threads may take one from
+ * the pool with @ref hs_scratch_pool_acquire() for the duration of a scan and
+ * hand it back with @ref hs_scratch_pool_release(). Neither call takes a
+ * lock. A thread is given the
+ * same scratch space it used last whenever that one is free, and each
+ * scratch space is allocated by the first thread to acquire it, so that on
+ * NUMA systems with a first-touch page placement policy it is local to the
+ * thread that uses it.
+ *
+ * All scratch spaces are allocated with the scratch allocator set by @ref
+ * hs_set_scratch_allocator() or @ref hs_set_allocator().
+ *
+ * @param db
+ *      The database, as produced by @ref hs_compile(). Scratch spaces taken
+ *      from the pool will be suitable for use with this database.
+ *
+ * @param size
+ *      The number of scratch spaces the pool keeps. This would normally be
+ *      the number of threads that scan concurrently. If more threads than
+ *      this acquire scratch at once, the extra ones are given scratch spaces
+ *      that are freed again when released. Must be non-zero.
+ *
+ * @param pool
+ *      On success, a pointer to the new pool is returned here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_NOMEM if the allocation fails.
+ *      Other errors may be returned if invalid parameters are specified.
+ */
+hs_error_t hs_alloc_scratch_pool(const hs_database_t *db, unsigned int size,
+                                 hs_scratch_pool_t **pool);
+
+/**
+ * Make the scratch spaces in a pool suitable for use with another database.
+ *
+ * This is the pool equivalent of passing an existing scratch space to @ref
+ * hs_alloc_scratch(). If the database needs more scratch than the pool
+ * provides, the pool grows: scratch spaces already acquired are not touched,
+ * and each pooled scratch space is reallocated at its larger size the next
+ * time it is acquired. This may be called while other threads are acquiring
+ * and releasing scratch from the pool. Scratch spaces acquired after this
+ * call returns are suitable for use with the database.
+ *
+ * @param pool
+ *      A pool allocated by @ref hs_alloc_scratch_pool().
+ *
+ * @param db
+ *      The database, as produced by @ref hs_compile().
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_NOMEM if the allocation fails.
+ *      Other errors may be returned if invalid parameters are specified.
+ */
+hs_error_t hs_scratch_pool_add_database(hs_scratch_pool_t *pool,
+                                        const hs_database_t *db);
+
+/**
+ * Take a scratch space from a pool.
+ *
+ * The scratch space is suitable for use with every database given to the
+ * pool before this call. It belongs to the calling thread until it is handed
+ * back with @ref hs_scratch_pool_release(), and must not be freed with @ref
+ * hs_free_scratch() or grown with @ref hs_alloc_scratch().
+ *
+ * @param pool
+ *      A pool allocated by @ref hs_alloc_scratch_pool().
+ *
+ * @param scratch
+ *      On success, a pointer to the scratch space is returned here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_NOMEM if a scratch space has to be
+ *      allocated and the allocation fails. Other errors may be returned if
+ *      invalid parameters are specified.
+ */
+hs_error_t hs_scratch_pool_acquire(hs_scratch_pool_t *pool,
+                                   hs_scratch_t **scratch);
+
+/**
+ * Return a scratch space to the pool it was acquired from.
+ *
+ * @param pool
+ *      The pool that the scratch space was acquired from.
+ *
+ * @param scratch
+ *      A scratch space returned by @ref hs_scratch_pool_acquire().
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_SCRATCH_IN_USE if the scratch
+ *      space is still being used by a scan, such as when called from a match
+ *      callback. Other errors may be returned if invalid parameters are
+ *      specified.
+ */
+hs_error_t hs_scratch_pool_release(hs_scratch_pool_t *pool,
+                                   hs_scratch_t *scratch);
+
+/**
+ * Free a scratch pool and all of its scratch spaces.
+ *
+ * Every scratch space acquired from the pool must have been released first.
+ *
+ * @param pool
+ *      The pool to be freed. NULL may also be safely provided.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_SCRATCH_IN_USE if scratch from the
+ *      pool has not been released. Other errors may be returned if invalid
+ *      parameters are specified.
+ */
+hs_error_t hs_free_scratch_pool(hs_scratch_pool_t *pool);
+
+/**
+ * @defgroup HS_PROFILE_TABLE Literal matcher tables
+ *
+ * Indices into @ref hs_profile_t::matchers.
+ *
+ * @{
+ */
+
+/** The floating literal matcher, for literals that may match anywhere. */
+#define HS_PROFILE_TABLE_FLOATING       0
+
+/** The anchored literal matcher, for literals that must match near the start
+ * of the data. */
+#define HS_PROFILE_TABLE_ANCHORED       1
+
+/** The literal matcher for literals anchored to the end of the data. */
+#define HS_PROFILE_TABLE_EOD            2
+
+/** The literal matcher used instead of the others for small blocks. */
+#define HS_PROFILE_TABLE_SMALL_BLOCK    3
+
+/** Number of literal matcher tables. */
+#define HS_PROFILE_TABLE_COUNT          4
+
+/** @} */
+
+/**
+ * @defgroup HS_PROFILE_MATCHER Literal matcher kinds
+ *
+ * Values of @ref hs_profile_matcher_t::kind.
+ *
+ * @{
+ */
+
+/** The database has no such literal matcher. */
+#define HS_PROFILE_MATCHER_NONE         0
+
+/** A single-literal (noodle) matcher. */
+#define HS_PROFILE_MATCHER_NOODLE       1
+
+/** The FDR bucketed hashing matcher. */
+#define HS_PROFILE_MATCHER_FDR          2
+
+/** The Teddy SIMD shuffle matcher. */
+#define HS_PROFILE_MATCHER_TEDDY        3
+
+/** A set of DFAs, used for the anchored table. */
+#define HS_PROFILE_MATCHER_DFA          4
+
+/** @} */
+
+/**
+ * Profiling counters for one literal matcher table.
+ *
+ * Cycle counts are in timestamp counter ticks and include the time spent in
+ * match callbacks, including any engines run as a result.
+ */
+typedef struct hs_profile_matcher {
+    /** The kind of matcher, one of @ref HS_PROFILE_MATCHER. */
+    unsigned int kind;
+
+    /** The number of times the matcher was run. */
+    unsigned long long calls;
+
+    /** The number of bytes it scanned. */
+    unsigned long long bytes;
+
+    /** The time spent in it. */
+    unsigned long long cycles;
+
+    /** The number of literal matches it raised. */
+    unsigned long long matches;
+
+    /** The number of candidate literals checked by FDR or Teddy confirm. A
+     * high ratio of confirms to matches indicates false positives. */
+    unsigned long long confirms;
+} hs_profile_matcher_t;
+
+/**
+ * Profiling totals for a scratch space, as returned by @ref
+ * hs_scratch_profile().
+ */
+typedef struct hs_profile {
+    /** The number of block scans, stream writes and end of stream checks. */
+    unsigned long long scans;
+
+    /** The number of bytes scanned. */
+    unsigned long long bytes;
+
+    /** The time spent scanning, in timestamp counter ticks. */
+    unsigned long long cycles;
+
+    /** Counters for each literal matcher table, indexed by @ref
+     * HS_PROFILE_TABLE. */
+    hs_profile_matcher_t matchers[HS_PROFILE_TABLE_COUNT];
+
+    /** The number of Rose programs run in response to literal matches and
+     * engine reports. */
+    unsigned long long programs;
+
+    /** The number of Rose program instructions executed. */
+    unsigned long long instructions;
+
+    /** The number of priority queue operations done while catching up
+     * engines to deliver matches in order. */
+    unsigned long long catchup_ops;
+
+    /** The number of engine queue executions. */
+    unsigned long long engine_execs;
+
+    /** The number of NFA exception states processed. */
+    unsigned long long exceptions;
+
+    /** The number of acceleration scans run. */
+    unsigned long long accel_calls;
+
+    /** The number of bytes skipped by acceleration. */
+    unsigned long long accel_bytes;
+
+    /** The number of acceleration scans that skipped fewer than 16 bytes. */
+    unsigned long long accel_misses;
+
+    /** The number of matches delivered to the user. */
+    unsigned long long matches;
+
+    /** The number of engines in the database, for use with @ref
+     * hs_scratch_profile_engine(). */
+    unsigned int engine_count;
+
+    /** The number of patterns in the database, for use with @ref
+     * hs_scratch_profile_pattern(). */
+    unsigned int pattern_count;
+} hs_profile_t;
+
+/**
+ * Profiling counters for one engine, as returned by @ref
+ * hs_scratch_profile_engine().
+ */
+typedef struct hs_profile_engine {
+    /** A short description of the engine type, such as "LimEx NFA". */
+    const char *kind;
+
+    /** The number of times the engine was run. */
+    unsigned long long execs;
+
+    /** The number of bytes covered by those runs. */
+    unsigned long long bytes;
+
+    /** The time spent in the engine, in timestamp counter ticks, including
+     * its match callbacks. */
+    unsigned long long cycles;
+
+    /** The number of NFA exception states processed. */
+    unsigned long long exceptions;
+
+    /** The number of acceleration scans run. */
+    unsigned long long accel_calls;
+
+    /** The number of bytes skipped by acceleration. */
+    unsigned long long accel_bytes;
+
+    /** The number of acceleration scans that skipped fewer than 16 bytes. */
+    unsigned long long accel_misses;
+
+    /** The number of entries in @a patterns. */
+    unsigned int pattern_count;
+
+    /** The sorted IDs of the patterns whose matches this engine contributes
+     * to. This points into the database and is valid for its lifetime. */
+    const unsigned int *patterns;
+} hs_profile_engine_t;
+
+/**
+ * Profiling counters for one pattern, as returned by @ref
+ * hs_scratch_profile_pattern().
+ */
+typedef struct hs_profile_pattern {
+    /** The pattern ID. */
+    unsigned int id;
+
+    /** The number of matches delivered to the user for this pattern. */
+    unsigned long long matches;
+} hs_profile_pattern_t;
+
+/**
+ * Retrieve the profiling totals accumulated in a scratch space.
+ *
+ * Profiling is only available when the library is built with the
+ * PROFILE_SUPPORT option. Counters accumulate over every scan that uses the
+ * scratch space until @ref hs_reset_scratch_profile() is called. They are
+ * reset when @ref hs_alloc_scratch() has to grow the scratch space, and are
+ * not copied by @ref hs_clone_scratch(). Engine and pattern counters are
+ * indexed relative to the database being scanned, so a scratch space should
+ * be used with a single database for the results to be meaningful.
+ *
+ * @param db
+ *      The database that was scanned with this scratch space.
+ *
+ * @param scratch
+ *      The scratch space to query.
+ *
+ * @param profile
+ *      On success, the profiling totals are placed here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_INVALID if the library was built
+ *      without profiling support, if a parameter is NULL, or if the scratch
+ *      space was not allocated for this database.
+ */
+hs_error_t hs_scratch_profile(const hs_database_t *db,
+                              const hs_scratch_t *scratch,
+                              hs_profile_t *profile);
+
+/**
+ * Retrieve the profiling counters for one engine.
+ *
+ * Engines are numbered from zero to @ref hs_profile_t::engine_count - 1.
+ * The small write and reverse start of match engines are not included; their
+ * time is counted only in the scan totals.
+ *
+ * @param db
+ *      The database that was scanned with this scratch space.
+ *
+ * @param scratch
+ *      The scratch space to query.
+ *
+ * @param engine
+ *      The index of the engine.
+ *
+ * @param info
+ *      On success, the engine's counters are placed here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_INVALID if the library was built
+ *      without profiling support, if a parameter is invalid, or if the
+ *      scratch space was not allocated for this database.
+ */
+hs_error_t hs_scratch_profile_engine(const hs_database_t *db,
+                                     const hs_scratch_t *scratch,
+                                     unsigned int engine,
+                                     hs_profile_engine_t *info);
+
+/**
+ * Retrieve the profiling counters for one pattern.
+ *
+ * Patterns are numbered from zero to @ref hs_profile_t::pattern_count - 1 in
+ * increasing order of pattern ID.
+ *
+ * @param db
+ *      The database that was scanned with this scratch space.
+ *
+ * @param scratch
+ *      The scratch space to query.
+ *
+ * @param pattern
+ *      The index of the pattern.
+ *
+ * @param info
+ *      On success, the pattern's counters are placed here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_INVALID if the library was built
+ *      without profiling support, if a parameter is invalid, or if the
+ *      scratch space was not allocated for this database.
+ */
+hs_error_t hs_scratch_profile_pattern(const hs_database_t *db,
+                                      const hs_scratch_t *scratch,
+                                      unsigned int pattern,
+                                      hs_profile_pattern_t *info);
+
+/**
+ * Reset the profiling counters in a scratch space to zero.
+ *
+ * @param scratch
+ *      The scratch space whose counters should be reset.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success; @ref HS_INVALID if the library was built
+ *      without profiling support or the scratch space is invalid; @ref
+ *      HS_SCRATCH_IN_USE if the scratch space is in use.
+ */
+hs_error_t hs_reset_scratch_profile(hs_scratch_t *scratch);
+
 /**
  * Callback 'from' return value, indicating that the start of this match was
  * too early to be tracked with the requested SOM_HORIZON precision.
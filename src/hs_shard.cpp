@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Sharded scanning: runs one input across the databases of a sharded
+ * pattern set on a pool of threads, merging their matches.
+ */
+
+#include "hs_shard.h"
+
+#include "ue2common.h"
+#include "util/make_unique.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace ue2;
+
+namespace {
+
+/** \brief A match buffered while its shard is being scanned. */
+struct ShardMatch {
+    unsigned long long from;
+    unsigned long long to;
+    unsigned int id;
+    unsigned int flags;
+};
+
+/** \brief Per-shard results of one call. */
+struct ShardResult {
+    vector<ShardMatch> matches;
+    hs_error_t err = HS_SUCCESS;
+    bool oom = false; //!< ran out of memory buffering matches
+};
+
+using ShardJob = function<hs_error_t(u32 shard)>;
+
+} // namespace
+
+struct hs_shard_scanner {
+    ~hs_shard_scanner() {
+        {
+            lock_guard<mutex> lk(lock);
+            stopping = true;
+        }
+        work_ready.notify_all();
+        for (auto &t : workers) {
+            t.join();
+        }
+        for (auto *s : scratch) {
+            hs_free_scratch(s);
+        }
+    }
+
+    vector<const hs_database_t *> dbs;
+    vector<hs_scratch_t *> scratch;
+    vector<ShardResult> results;
+    vector<size_t> merge_pos;
+
+    /** \brief Workers for shards 1 onwards; shard 0 runs on the caller. */
+    vector<thread> workers;
+    mutex lock;
+    condition_variable work_ready;
+    condition_variable work_done;
+    const ShardJob *job = nullptr;
+    u64a generation = 0;
+    u32 pending = 0;
+    bool stopping = false;
+
+    /** \brief Set while a call is using the scanner. */
+    atomic<bool> busy{false};
+};
+
+struct hs_shard_stream {
+    hs_shard_scanner *scanner = nullptr;
+    vector<hs_stream_t *> streams;
+    bool terminated = false;
+};
+
+namespace {
+
+void workerLoop(hs_shard_scanner *s, u32 shard) {
+    u64a seen = 0;
+    for (;;) {
+        const ShardJob *job;
+        {
+            unique_lock<mutex> lk(s->lock);
+            s->work_ready.wait(lk, [&] {
+                return s->stopping || s->generation != seen;
+            });
+            if (s->stopping) {
+                return;
+            }
+            seen = s->generation;
+            job = s->job;
+        }
+
+        s->results[shard].err = (*job)(shard);
+
+        lock_guard<mutex> lk(s->lock);
+        assert(s->pending);
+        if (--s->pending == 0) {
+            s->work_done.notify_one();
+        }
+    }
+}
+
+/** \brief Runs \a job for every shard, returning once all have finished. */
+void runOnShards(hs_shard_scanner *s, const ShardJob &job) {
+    for (auto &r : s->results) {
+        r.matches.clear();
+        r.err = HS_SUCCESS;
+        r.oom = false;
+    }
+
+    if (!s->workers.empty()) {
+        {
+            lock_guard<mutex> lk(s->lock);
+            s->job = &job;
+            s->pending = (u32)s->workers.size();
+            s->generation++;
+        }
+        s->work_ready.notify_all();
+    }
+
+    s->results[0].err = job(0);
+
+    if (!s->workers.empty()) {
+        unique_lock<mutex> lk(s->lock);
+        s->work_done.wait(lk, [&] { return s->pending == 0; });
+        s->job = nullptr;
+    }
+}
+
+int collectMatch(unsigned int id, unsigned long long from,
+                 unsigned long long to, unsigned int flags, void *ctx) {
+    ShardResult *r = (ShardResult *)ctx;
+    try {
+        r->matches.push_back(ShardMatch{from, to, id, flags});
+    } catch (const std::bad_alloc &) {
+        r->oom = true;
+        return 1; // halt this shard's scan
+    }
+    return 0;
+}
+
+/** \brief Returns the first error raised by any shard, if any. */
+hs_error_t shardStatus(const hs_shard_scanner *s) {
+    for (const auto &r : s->results) {
+        if (r.oom) {
+            return HS_NOMEM;
+        }
+        if (r.err != HS_SUCCESS) {
+            return r.err;
+        }
+    }
+    return HS_SUCCESS;
+}
+
+/** \brief Delivers the buffered matches of all shards in end offset order,
+ * breaking ties by shard. */
+hs_error_t deliverMatches(hs_shard_scanner *s, match_event_handler onEvent,
+                          void *context) {
+    const u32 shards = (u32)s->results.size();
+    auto by_end = [](const ShardMatch &a, const ShardMatch &b) {
+        return a.to < b.to;
+    };
+    for (auto &r : s->results) {
+        if (!is_sorted(r.matches.begin(), r.matches.end(), by_end)) {
+            stable_sort(r.matches.begin(), r.matches.end(), by_end);
+        }
+    }
+
+    auto &pos = s->merge_pos;
+    fill(pos.begin(), pos.end(), 0);
+
+    for (;;) {
+        u32 best = shards;
+        for (u32 i = 0; i < shards; i++) {
+            const auto &m = s->results[i].matches;
+            if (pos[i] < m.size() &&
+                (best == shards ||
+                 m[pos[i]].to < s->results[best].matches[pos[best]].to)) {
+                best = i;
+            }
+        }
+        if (best == shards) {
+            return HS_SUCCESS;
+        }
+
+        const ShardMatch &m = s->results[best].matches[pos[best]++];
+        if (onEvent(m.id, m.from, m.to, m.flags, context)) {
+            return HS_SCAN_TERMINATED;
+        }
+    }
+}
+
+/** \brief Marks the scanner busy for the lifetime of the guard. */
+class BusyGuard {
+public:
+    explicit BusyGuard(hs_shard_scanner *s_in) : s(s_in) {
+        acquired = !s->busy.exchange(true);
+    }
+    ~BusyGuard() {
+        if (acquired) {
+            s->busy = false;
+        }
+    }
+    bool ok() const { return acquired; }
+
+private:
+    hs_shard_scanner *s;
+    bool acquired;
+};
+
+} // namespace
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_alloc_shard_scanner(const hs_database_t *const *dbs,
+                                  unsigned int shards,
+                                  hs_shard_scanner_t **scanner) {
+    if (!dbs || !shards || !scanner) {
+        return HS_INVALID;
+    }
+
+    *scanner = nullptr;
+
+    try {
+        auto s = make_unique<hs_shard_scanner>();
+        s->dbs.assign(dbs, dbs + shards);
+        s->scratch.resize(shards, nullptr);
+        s->results.resize(shards);
+        s->merge_pos.resize(shards);
+
+        for (u32 i = 0; i < shards; i++) {
+            hs_error_t err = hs_alloc_scratch(dbs[i], &s->scratch[i]);
+            if (err != HS_SUCCESS) {
+                return err;
+            }
+        }
+
+        for (u32 i = 1; i < shards; i++) {
+            s->workers.emplace_back(workerLoop, s.get(), i);
+        }
+
+        *scanner = s.release();
+        return HS_SUCCESS;
+    } catch (const std::bad_alloc &) {
+        return HS_NOMEM;
+    } catch (const std::system_error &) {
+        // Unable to start a worker thread.
+        return HS_NOMEM;
+    }
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_free_shard_scanner(hs_shard_scanner_t *scanner) {
+    delete scanner;
+    return HS_SUCCESS;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_scan_sharded(hs_shard_scanner_t *scanner, const char *data,
+                           unsigned int length, unsigned int flags,
+                           match_event_handler onEvent, void *context) {
+    if (!scanner || !data) {
+        return HS_INVALID;
+    }
+
+    BusyGuard guard(scanner);
+    if (!guard.ok()) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    const ShardJob job = [&](u32 i) {
+        return hs_scan(scanner->dbs[i], data, length, flags,
+                       scanner->scratch[i], onEvent ? collectMatch : nullptr,
+                       &scanner->results[i]);
+    };
+    runOnShards(scanner, job);
+
+    hs_error_t err = shardStatus(scanner);
+    if (err != HS_SUCCESS || !onEvent) {
+        return err;
+    }
+    return deliverMatches(scanner, onEvent, context);
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_open_stream_sharded(hs_shard_scanner_t *scanner,
+                                  unsigned int flags,
+                                  hs_shard_stream_t **stream) {
+    if (!scanner || !stream) {
+        return HS_INVALID;
+    }
+
+    *stream = nullptr;
+
+    unique_ptr<hs_shard_stream> s;
+    try {
+        s = make_unique<hs_shard_stream>();
+        s->streams.reserve(scanner->dbs.size());
+    } catch (const std::bad_alloc &) {
+        return HS_NOMEM;
+    }
+    s->scanner = scanner;
+
+    for (const auto *db : scanner->dbs) {
+        hs_stream_t *id = nullptr;
+        hs_error_t err = hs_open_stream(db, flags, &id);
+        if (err != HS_SUCCESS) {
+            for (auto *opened : s->streams) {
+                hs_close_stream(opened, nullptr, nullptr, nullptr);
+            }
+            return err;
+        }
+        s->streams.push_back(id); // reserved above, does not throw
+    }
+
+    *stream = s.release();
+    return HS_SUCCESS;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_scan_stream_sharded(hs_shard_stream_t *stream, const char *data,
+                                  unsigned int length, unsigned int flags,
+                                  match_event_handler onEvent, void *context) {
+    if (!stream || !data) {
+        return HS_INVALID;
+    }
+
+    if (stream->terminated) {
+        return HS_SCAN_TERMINATED;
+    }
+
+    hs_shard_scanner *scanner = stream->scanner;
+    BusyGuard guard(scanner);
+    if (!guard.ok()) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    const ShardJob job = [&](u32 i) {
+        return hs_scan_stream(stream->streams[i], data, length, flags,
+                              scanner->scratch[i],
+                              onEvent ? collectMatch : nullptr,
+                              &scanner->results[i]);
+    };
+    runOnShards(scanner, job);
+
+    hs_error_t err = shardStatus(scanner);
+    if (err != HS_SUCCESS || !onEvent) {
+        return err;
+    }
+
+    err = deliverMatches(scanner, onEvent, context);
+    if (err == HS_SCAN_TERMINATED) {
+        stream->terminated = true;
+    }
+    return err;
+}
+
+extern "C" HS_PUBLIC_API
+hs_error_t hs_close_stream_sharded(hs_shard_stream_t *stream,
+                                   match_event_handler onEvent, void *context) {
+    if (!stream) {
+        return HS_INVALID;
+    }
+
+    unique_ptr<hs_shard_stream> s(stream);
+
+    if (!onEvent || s->terminated) {
+        for (auto *id : s->streams) {
+            hs_close_stream(id, nullptr, nullptr, nullptr);
+        }
+        return HS_SUCCESS;
+    }
+
+    hs_shard_scanner *scanner = s->scanner;
+    BusyGuard guard(scanner);
+    if (!guard.ok()) {
+        s.release(); // left open for the caller to retry
+        return HS_SCRATCH_IN_USE;
+    }
+
+    const ShardJob job = [&](u32 i) {
+        return hs_close_stream(s->streams[i], scanner->scratch[i],
+                               collectMatch, &scanner->results[i]);
+    };
+    runOnShards(scanner, job);
+
+    hs_error_t err = shardStatus(scanner);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+    return deliverMatches(scanner, onEvent, context);
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HS_SHARD_H_
+#define HS_SHARD_H_
+
+/**
+ * @file
+ * @brief The Hyperscan sharded scanning API definition.
+ *
+ * A large pattern set can be split into several databases ("shards") with
+ * @ref hs_compile_ext_multi_sharded(). This header contains functions for
+ * scanning one input against all of the shards at once, each shard on its own
+ * thread, with the matches from all shards delivered through a single
+ * callback in order of end offset.
+ *
+ * These functions are provided by the full Hyperscan library only; they are
+ * not part of the standalone runtime library.
+ */
+
+#include "hs_common.h"
+#include "hs_runtime.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Definition of the sharded scanner type.
+ */
+struct hs_shard_scanner;
+
+/**
+ * A sharded scanner, as returned by @ref hs_alloc_shard_scanner(). It holds a
+ * scratch space and a worker thread for each shard, and like a scratch space
+ * it may only be used by one thread at a time.
+ */
+typedef struct hs_shard_scanner hs_shard_scanner_t;
+
+/**
+ * Definition of the sharded stream type.
+ */
+struct hs_shard_stream;
+
+/**
+ * A stream opened against every shard of a sharded scanner, as returned by
+ * @ref hs_open_stream_sharded().
+ */
+typedef struct hs_shard_stream hs_shard_stream_t;
+
+/**
+ * Allocate a sharded scanner for the given databases.
+ *
+ * The databases must all have been compiled for the same mode, and must
+ * remain valid for the lifetime of the scanner. One worker thread is started
+ * for each shard beyond the first; the first shard is scanned on the calling
+ * thread.
+ *
+ * @param dbs
+ *      An array of @a shards compiled pattern databases, such as those
+ *      returned by @ref hs_compile_ext_multi_sharded().
+ *
+ * @param shards
+ *      The number of databases in the @a dbs array.
+ *
+ * @param scanner
+ *      On success, a pointer to the new scanner is returned here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_alloc_shard_scanner(const hs_database_t *const *dbs,
+                                  unsigned int shards,
+                                  hs_shard_scanner_t **scanner);
+
+/**
+ * Free a sharded scanner, stopping its worker threads. Any streams opened
+ * with it must be closed first.
+ *
+ * @param scanner
+ *      The scanner to free. NULL may also be safely provided.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_free_shard_scanner(hs_shard_scanner_t *scanner);
+
+/**
+ * Scan a block of data against every shard of a sharded scanner.
+ *
+ * The shards are scanned concurrently. Their matches are collected and then
+ * delivered to @a onEvent on the calling thread, in order of end offset; for
+ * matches with equal end offsets, matches from earlier shards are delivered
+ * first. No matches are delivered until every shard has completed its scan.
+ *
+ * @param scanner
+ *      A sharded scanner for block mode databases.
+ *
+ * @param data
+ *      Pointer to the data to be scanned.
+ *
+ * @param length
+ *      The number of bytes to scan.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function. This parameter is
+ *      provided for future use and is unused at present.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that no further matches should be delivered;
+ *      other values on error.
+ */
+hs_error_t hs_scan_sharded(hs_shard_scanner_t *scanner, const char *data,
+                           unsigned int length, unsigned int flags,
+                           match_event_handler onEvent, void *context);
+
+/**
+ * Open a stream against every shard of a sharded scanner.
+ *
+ * @param scanner
+ *      A sharded scanner for streaming mode databases. The stream is bound to
+ *      this scanner, which must outlive it.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of the stream. This parameter is provided
+ *      for future use and is unused at present.
+ *
+ * @param stream
+ *      On success, a pointer to the new stream is returned here.
+ *
+ * @return
+ *      @ref HS_SUCCESS on success, other values on failure.
+ */
+hs_error_t hs_open_stream_sharded(hs_shard_scanner_t *scanner,
+                                  unsigned int flags,
+                                  hs_shard_stream_t **stream);
+
+/**
+ * Write data to be scanned to a sharded stream.
+ *
+ * Matches are delivered as described for @ref hs_scan_sharded(), once every
+ * shard has scanned this write.
+ *
+ * @param stream
+ *      The stream, as returned by @ref hs_open_stream_sharded().
+ *
+ * @param data
+ *      Pointer to the data to be scanned.
+ *
+ * @param length
+ *      The number of bytes to scan.
+ *
+ * @param flags
+ *      Flags modifying the behaviour of this function. This parameter is
+ *      provided for future use and is unused at present.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success; @ref HS_SCAN_TERMINATED if the
+ *      match callback indicated that scanning should stop, in which case all
+ *      further writes to this stream will also return this value; other values
+ *      on error.
+ */
+hs_error_t hs_scan_stream_sharded(hs_shard_stream_t *stream, const char *data,
+                                  unsigned int length, unsigned int flags,
+                                  match_event_handler onEvent, void *context);
+
+/**
+ * Close a sharded stream, delivering any matches raised at end of data.
+ *
+ * @param stream
+ *      The stream to close.
+ *
+ * @param onEvent
+ *      Pointer to a match event callback function. If a NULL pointer is given,
+ *      no matches will be returned.
+ *
+ * @param context
+ *      The user defined pointer which will be passed to the callback function.
+ *
+ * @return
+ *      Returns @ref HS_SUCCESS on success, other values on failure. The stream
+ *      is freed unless @ref HS_INVALID or @ref HS_SCRATCH_IN_USE (if the
+ *      scanner is in use by another call) is returned.
+ */
+hs_error_t hs_close_stream_sharded(hs_shard_stream_t *stream,
+                                   match_event_handler onEvent, void *context);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* HS_SHARD_H_ */
@@ -34,6 +34,7 @@
 #include "multitruffle.h"
 #include "multivermicelli.h"
 #include "ue2common.h"
+#include "util/profile.h"
 
 const u8 *run_accel(const union AccelAux *accel, const u8 *c, const u8 *c_end) {
     assert(ISALIGNED_N(accel, alignof(union AccelAux)));
@@ -359,5 +360,9 @@ const u8 *run_accel(const union AccelAux *accel, const u8 *c, const u8 *c_end) {
 
     DEBUG_PRINTF("advanced %zd\n", rv - c);
 
+    PROFILE_EVENT(accel_calls, 1);
+    PROFILE_EVENT(accel_bytes, rv - c);
+    PROFILE_EVENT(accel_misses, rv - c < PROFILE_ACCEL_MISS_BYTES);
+
     return rv;
 }
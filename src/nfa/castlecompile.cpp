@@ -44,6 +44,7 @@
 #include "nfagraph/ng_util.h"
 #include "util/alloc.h"
 #include "util/compile_context.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/dump_charclass.h"
 #include "util/graph.h"
@@ -441,6 +442,7 @@ aligned_unique_ptr<NFA>
 buildCastle(const CastleProto &proto,
             const map<u32, vector<vector<CharReach>>> &triggers,
             const CompileContext &cc, const ReportManager &rm) {
+    CompilePhase phase("castle_compile");
     assert(cc.grey.allowCastle);
 
     const size_t numRepeats = proto.repeats.size();
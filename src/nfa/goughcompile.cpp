@@ -37,6 +37,7 @@
 #include "nfa_internal.h"
 #include "util/alloc.h"
 #include "util/compile_context.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/graph_range.h"
 #include "util/make_unique.h"
@@ -1039,6 +1040,7 @@ void update_accel_prog_offset(const gough_build_strat &gbs,
 aligned_unique_ptr<NFA> goughCompile(raw_som_dfa &raw, u8 somPrecision,
                                      const CompileContext &cc,
                                      const ReportManager &rm) {
+    CompilePhase phase("gough_compile");
     assert(somPrecision == 2 || somPrecision == 4 || somPrecision == 8
            || !cc.streaming);
 
@@ -107,15 +107,11 @@ size_t doAccel256(const m256 *state, const struct LimExNFA256 *limex,
 #if !defined(__AVX2__)
     u32 idx1 = shufflePshufb128(s.lo, accelPerm.lo, accelComp.lo);
     u32 idx2 = shufflePshufb128(s.hi, accelPerm.hi, accelComp.hi);
-#else
-    // TODO: learn you some avx2 shuffles for great good
-    u32 idx1 = shufflePshufb128(movdq_lo(s), movdq_lo(accelPerm),
-                                movdq_lo(accelComp));
-    u32 idx2 = shufflePshufb128(movdq_hi(s), movdq_hi(accelPerm),
-                                movdq_hi(accelComp));
-#endif
     assert((idx1 & idx2) == 0); // should be no shared bits
     idx = idx1 | idx2;
+#else
+    idx = shufflePshufb256(s, accelPerm, accelComp);
+#endif
     return accelScanWrapper(accelTable, aux, input, idx, i, end);
 }
 
@@ -143,22 +139,82 @@ size_t doAccel512(const m512 *state, const struct LimExNFA512 *limex,
     DEBUG_PRINTF("using PSHUFB for 512-bit shuffle\n");
     m512 accelPerm = limex->accelPermute;
     m512 accelComp = limex->accelCompare;
-#if !defined(__AVX2__)
+#if defined(__AVX512BW__)
+    idx = shufflePshufb512(s, accelPerm, accelComp);
+#elif defined(__AVX2__)
+    u32 idx1 = shufflePshufb256(s.lo, accelPerm.lo, accelComp.lo);
+    u32 idx2 = shufflePshufb256(s.hi, accelPerm.hi, accelComp.hi);
+    assert((idx1 & idx2) == 0); // should be no shared bits
+    idx = idx1 | idx2;
+#else
     u32 idx1 = shufflePshufb128(s.lo.lo, accelPerm.lo.lo, accelComp.lo.lo);
     u32 idx2 = shufflePshufb128(s.lo.hi, accelPerm.lo.hi, accelComp.lo.hi);
     u32 idx3 = shufflePshufb128(s.hi.lo, accelPerm.hi.lo, accelComp.hi.lo);
     u32 idx4 = shufflePshufb128(s.hi.hi, accelPerm.hi.hi, accelComp.hi.hi);
+    assert((idx1 & idx2 & idx3 & idx4) == 0); // should be no shared bits
+    idx = idx1 | idx2 | idx3 | idx4;
+#endif
+    return accelScanWrapper(accelTable, aux, input, idx, i, end);
+}
+
+size_t doAccel768(const m768 *state, const struct LimExNFA768 *limex,
+                  const u8 *accelTable, const union AccelAux *aux,
+                  const u8 *input, size_t i, size_t end) {
+    u32 idx;
+    m768 s = *state;
+    DEBUG_PRINTF("using PSHUFB for 768-bit shuffle\n");
+    m768 accelPerm = limex->accelPermute;
+    m768 accelComp = limex->accelCompare;
+#if defined(__AVX2__)
+    u32 idx1 = shufflePshufb256(s.lo, accelPerm.lo, accelComp.lo);
+    u32 idx2 = shufflePshufb256(s.mid, accelPerm.mid, accelComp.mid);
+    u32 idx3 = shufflePshufb256(s.hi, accelPerm.hi, accelComp.hi);
+    assert((idx1 & idx2 & idx3) == 0); // should be no shared bits
+    idx = idx1 | idx2 | idx3;
 #else
-    u32 idx1 = shufflePshufb128(movdq_lo(s.lo), movdq_lo(accelPerm.lo),
-                                movdq_lo(accelComp.lo));
-    u32 idx2 = shufflePshufb128(movdq_hi(s.lo), movdq_hi(accelPerm.lo),
-                                movdq_hi(accelComp.lo));
-    u32 idx3 = shufflePshufb128(movdq_lo(s.hi), movdq_lo(accelPerm.hi),
-                                movdq_lo(accelComp.hi));
-    u32 idx4 = shufflePshufb128(movdq_hi(s.hi), movdq_hi(accelPerm.hi),
-                                movdq_hi(accelComp.hi));
+    u32 idx1 = shufflePshufb128(s.lo.lo, accelPerm.lo.lo, accelComp.lo.lo);
+    u32 idx2 = shufflePshufb128(s.lo.hi, accelPerm.lo.hi, accelComp.lo.hi);
+    u32 idx3 = shufflePshufb128(s.mid.lo, accelPerm.mid.lo, accelComp.mid.lo);
+    u32 idx4 = shufflePshufb128(s.mid.hi, accelPerm.mid.hi, accelComp.mid.hi);
+    u32 idx5 = shufflePshufb128(s.hi.lo, accelPerm.hi.lo, accelComp.hi.lo);
+    u32 idx6 = shufflePshufb128(s.hi.hi, accelPerm.hi.hi, accelComp.hi.hi);
+    assert((idx1 & idx2 & idx3 & idx4 & idx5 & idx6) == 0);
+    idx = idx1 | idx2 | idx3 | idx4 | idx5 | idx6;
 #endif
+    return accelScanWrapper(accelTable, aux, input, idx, i, end);
+}
+
+/** \brief Gather the accel index for one 512-bit half of a 1024-bit state. */
+static really_inline
+u32 accelIndex512(m512 s, m512 accelPerm, m512 accelComp) {
+#if defined(__AVX512BW__)
+    return shufflePshufb512(s, accelPerm, accelComp);
+#elif defined(__AVX2__)
+    u32 idx1 = shufflePshufb256(s.lo, accelPerm.lo, accelComp.lo);
+    u32 idx2 = shufflePshufb256(s.hi, accelPerm.hi, accelComp.hi);
+    assert((idx1 & idx2) == 0); // should be no shared bits
+    return idx1 | idx2;
+#else
+    u32 idx1 = shufflePshufb128(s.lo.lo, accelPerm.lo.lo, accelComp.lo.lo);
+    u32 idx2 = shufflePshufb128(s.lo.hi, accelPerm.lo.hi, accelComp.lo.hi);
+    u32 idx3 = shufflePshufb128(s.hi.lo, accelPerm.hi.lo, accelComp.hi.lo);
+    u32 idx4 = shufflePshufb128(s.hi.hi, accelPerm.hi.hi, accelComp.hi.hi);
     assert((idx1 & idx2 & idx3 & idx4) == 0); // should be no shared bits
-    idx = idx1 | idx2 | idx3 | idx4;
+    return idx1 | idx2 | idx3 | idx4;
+#endif
+}
+
+size_t doAccel1024(const m1024 *state, const struct LimExNFA1024 *limex,
+                   const u8 *accelTable, const union AccelAux *aux,
+                   const u8 *input, size_t i, size_t end) {
+    u32 idx;
+    m1024 s = *state;
+    DEBUG_PRINTF("using PSHUFB for 1024-bit shuffle\n");
+    m1024 accelPerm = limex->accelPermute;
+    m1024 accelComp = limex->accelCompare;
+    u32 idx1 = accelIndex512(s.lo, accelPerm.lo, accelComp.lo);
+    u32 idx2 = accelIndex512(s.hi, accelPerm.hi, accelComp.hi);
+    assert((idx1 & idx2) == 0); // should be no shared bits
+    idx = idx1 | idx2;
     return accelScanWrapper(accelTable, aux, input, idx, i, end);
 }
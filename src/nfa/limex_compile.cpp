@@ -169,7 +169,7 @@ struct build_info {
 
 // Constants for scoring mechanism
 
-#define LAST_LIMEX_NFA LIMEX_NFA_512_7
+#define LAST_LIMEX_NFA LIMEX_NFA_1024_7
 
 const int LIMEX_INITIAL_SCORE = 2000;
 const int SHIFT_COST = 20; // limex: cost per shift mask
@@ -207,11 +207,14 @@ struct DISPATCH_BY_LIMEX_TYPE_INT<sfunc, rv_t, arg_t,
 
 // Given a number of states, find the size of the smallest container NFA it
 // will fit in. We support NFAs of the following sizes: 32, 64, 128, 256, 384,
-// 512.
+// 512, 768, 1024.
 size_t findContainerSize(size_t states) {
     if (states > 256 && states <= 384) {
         return 384;
     }
+    if (states > 512 && states <= 768) {
+        return 768;
+    }
     return 1ULL << (lg2(states - 1) + 1);
 }
 
@@ -1909,7 +1912,7 @@ struct Factory {
     static int score(const build_info &args) {
         const NGHolder &h = args.h;
 
-        // LimEx NFAs are available in sizes from 32 to 512-bit.
+        // LimEx NFAs are available in sizes from 32 to 1024-bit.
         size_t num_states = args.num_states;
 
         size_t sz = findContainerSize(num_states);
@@ -1924,6 +1927,19 @@ struct Factory {
             sz = 128;
         }
 
+        // Special case: on AVX-512 targets, the 512-bit model holds its state
+        // and masks in a single register, whereas the 384-bit model is still
+        // made up of three 128-bit words. Prefer the former. Likewise, the
+        // 1024-bit model is two 512-bit registers there, which beats the
+        // 768-bit model's three 256-bit words.
+        if (args.cc.target_info.has_avx512()) {
+            if (sz == 384) {
+                sz = 512;
+            } else if (sz == 768) {
+                sz = 1024;
+            }
+        }
+
         if (args.cc.grey.nfaForceSize) {
             sz = args.cc.grey.nfaForceSize;
         }
@@ -2029,6 +2045,20 @@ MAKE_LIMEX_TRAITS(512, 4)
 MAKE_LIMEX_TRAITS(512, 5)
 MAKE_LIMEX_TRAITS(512, 6)
 MAKE_LIMEX_TRAITS(512, 7)
+MAKE_LIMEX_TRAITS(768, 1)
+MAKE_LIMEX_TRAITS(768, 2)
+MAKE_LIMEX_TRAITS(768, 3)
+MAKE_LIMEX_TRAITS(768, 4)
+MAKE_LIMEX_TRAITS(768, 5)
+MAKE_LIMEX_TRAITS(768, 6)
+MAKE_LIMEX_TRAITS(768, 7)
+MAKE_LIMEX_TRAITS(1024, 1)
+MAKE_LIMEX_TRAITS(1024, 2)
+MAKE_LIMEX_TRAITS(1024, 3)
+MAKE_LIMEX_TRAITS(1024, 4)
+MAKE_LIMEX_TRAITS(1024, 5)
+MAKE_LIMEX_TRAITS(1024, 6)
+MAKE_LIMEX_TRAITS(1024, 7)
 
 } // namespace
 
@@ -2087,6 +2117,258 @@ bool isSane(const NGHolder &h, const map<u32, NFAVertex> &tops,
 }
 #endif // NDEBUG
 
+namespace {
+
+/** \brief Exception cost of a state ordering: the number of states with
+ * exceptional outbound transitions, then the number of such transitions.
+ * States that are exceptional whatever the numbering are not counted. */
+struct ExceptionCost {
+    u32 states = 0;
+    u32 edges = 0;
+
+    bool operator<(const ExceptionCost &b) const {
+        const ExceptionCost &a = *this;
+        ORDER_CHECK(states);
+        ORDER_CHECK(edges);
+        return false;
+    }
+};
+
+/**
+ * \brief Searches for a state numbering that lets the shift masks carry more
+ * of the NFA's transitions, so that fewer states need the exception path.
+ *
+ * States are indexed by their original state ID. The search only swaps pairs
+ * of states, which keeps the cost delta local to the two states and their
+ * predecessors.
+ */
+class StateReorderer {
+public:
+    StateReorderer(const NGHolder &h,
+                   const ue2::unordered_map<NFAVertex, u32> &state_ids,
+                   const ue2::unordered_set<NFAVertex> &always_exceptional,
+                   u32 num_states)
+        : succs(num_states), preds(num_states), fixed(num_states, false),
+          pos(num_states), order(num_states) {
+        for (const auto &e : edges_range(h)) {
+            u32 from = state_ids.at(source(e, h));
+            u32 to = state_ids.at(target(e, h));
+            if (from == NO_STATE || to == NO_STATE || from == to) {
+                continue;
+            }
+            succs[from].push_back(to);
+            preds[to].push_back(from);
+        }
+        for (auto v : always_exceptional) {
+            u32 s = state_ids.at(v);
+            if (s != NO_STATE) {
+                fixed[s] = true;
+            }
+        }
+        reset();
+    }
+
+    /** \brief Restore the original ordering. */
+    void reset() {
+        for (u32 i = 0; i < order.size(); i++) {
+            pos[i] = i;
+            order[i] = i;
+        }
+    }
+
+    /** \brief Cost of the current ordering with the given maximum shift. */
+    ExceptionCost cost(u32 max_shift) const {
+        ExceptionCost c;
+        for (u32 s = 0; s < order.size(); s++) {
+            addStateCost(s, max_shift, c);
+        }
+        return c;
+    }
+
+    /** \brief Hill-climb from the current ordering, swapping states when
+     * that reduces the exception cost with the given maximum shift. */
+    void optimise(u32 max_shift) {
+        tries_left = MAX_TRIES;
+        for (u32 pass = 0; pass < MAX_PASSES && tries_left; pass++) {
+            bool improved = false;
+            for (u32 s = 0; s < order.size(); s++) {
+                if (fixed[s]) {
+                    continue;
+                }
+                for (u32 t : succs[s]) {
+                    if (isLimitedTransition(pos[s], pos[t], max_shift)) {
+                        continue;
+                    }
+                    // Either move the successor into the window after this
+                    // state, or move this state into the window before it.
+                    if (pullInto(t, pos[s] + 1, pos[s] + max_shift, max_shift)
+                        || pullInto(s, (int)pos[t] - (int)max_shift,
+                                    (int)pos[t] - 1, max_shift)) {
+                        improved = true;
+                    }
+                }
+            }
+            if (!improved) {
+                break;
+            }
+        }
+    }
+
+    /** \brief New state IDs, indexed by original state ID. */
+    const vector<u32> &positions() const {
+        return pos;
+    }
+
+private:
+    /** \brief Limits on the search effort, to bound compile time on large
+     * or densely connected NFAs. */
+    static constexpr u32 MAX_PASSES = 8;
+    static constexpr u32 MAX_TRIES = 16384;
+
+    void addStateCost(u32 s, u32 max_shift, ExceptionCost &c) const {
+        if (fixed[s]) {
+            return; // exceptional whatever the numbering
+        }
+        u32 edges = 0;
+        for (u32 t : succs[s]) {
+            if (!isLimitedTransition(pos[s], pos[t], max_shift)) {
+                edges++;
+            }
+        }
+        if (edges) {
+            c.states++;
+            c.edges += edges;
+        }
+    }
+
+    /** \brief Cost of the states whose transitions depend on the positions
+     * of states \a a and \a b. */
+    ExceptionCost localCost(u32 a, u32 b, u32 max_shift) const {
+        vector<u32> affected = preds[a];
+        affected.insert(affected.end(), preds[b].begin(), preds[b].end());
+        affected.push_back(a);
+        affected.push_back(b);
+        sort(affected.begin(), affected.end());
+        affected.erase(unique(affected.begin(), affected.end()),
+                       affected.end());
+
+        ExceptionCost c;
+        for (u32 s : affected) {
+            addStateCost(s, max_shift, c);
+        }
+        return c;
+    }
+
+    void swapStates(u32 a, u32 b) {
+        swap(order[pos[a]], order[pos[b]]);
+        swap(pos[a], pos[b]);
+    }
+
+    /** \brief Try to swap state \a s with one of the states at positions
+     * [lo, hi]; keeps the first swap that reduces the cost. */
+    bool pullInto(u32 s, int lo, int hi, u32 max_shift) {
+        lo = max(lo, 0);
+        hi = min(hi, (int)order.size() - 1);
+        for (int p = lo; p <= hi && tries_left; p++) {
+            u32 other = order[p];
+            if (other == s) {
+                continue;
+            }
+            tries_left--;
+            ExceptionCost before = localCost(s, other, max_shift);
+            swapStates(s, other);
+            ExceptionCost after = localCost(s, other, max_shift);
+            if (after < before) {
+                return true;
+            }
+            swapStates(s, other); // revert
+        }
+        return false;
+    }
+
+    vector<vector<u32>> succs;
+    vector<vector<u32>> preds;
+    vector<bool> fixed; //!< states that are always exceptional
+    vector<u32> pos; //!< original state ID -> position (new state ID)
+    vector<u32> order; //!< position -> original state ID
+    u32 tries_left = 0;
+};
+
+} // namespace
+
+/**
+ * \brief Renumber the states of the NFA to reduce the number of exceptional
+ * states.
+ *
+ * The search is run for each shift count a LimEx model can have, and the
+ * ordering with the lowest cost under the same weights used by
+ * Factory::score() is kept. The original numbering is the starting point of
+ * every search, so the result is never worse than it.
+ */
+static
+ue2::unordered_map<NFAVertex, u32>
+reorderStates(const NGHolder &h,
+              const ue2::unordered_map<NFAVertex, u32> &state_ids,
+              const vector<BoundedRepeatData> &repeats,
+              const map<NFAVertex, NFAStateSet> &squashMap, u32 num_states,
+              const Grey &grey) {
+    // States that buildExceptionMap() will make exceptional anyway: repeat
+    // triggers, states that fire reports and predecessors of squash states.
+    // Moving their transitions out of the exception path gains nothing.
+    ue2::unordered_set<NFAVertex> always_exceptional;
+    for (const auto &br : repeats) {
+        always_exceptional.insert(br.pos_trigger);
+        insert(&always_exceptional, br.tug_triggers);
+    }
+    if (generates_callbacks(h)) {
+        insert(&always_exceptional, inv_adjacent_vertices(h.accept, h));
+    }
+    for (const auto &m : squashMap) {
+        for (auto v : inv_adjacent_vertices_range(m.first, h)) {
+            if (v != m.first) {
+                always_exceptional.insert(v);
+            }
+        }
+    }
+
+    StateReorderer reorderer(h, state_ids, always_exceptional, num_states);
+
+    u32 best_shift = 0;
+    int best_cost = 0;
+    ExceptionCost best_exc;
+    vector<u32> best_pos;
+    for (u32 max_shift = 1; max_shift < MAX_MAX_SHIFT; max_shift++) {
+        if (grey.nfaForceShifts && max_shift != grey.nfaForceShifts) {
+            continue;
+        }
+        reorderer.reset();
+        reorderer.optimise(max_shift);
+        ExceptionCost exc = reorderer.cost(max_shift);
+        int cost = SHIFT_COST / 2 + SHIFT_COST * (max_shift - 1) +
+                   EXCEPTION_COST * exc.states;
+        DEBUG_PRINTF("max_shift=%u: %u exceptional states, %u exceptional "
+                     "transitions\n", max_shift, exc.states, exc.edges);
+        if (!best_shift || cost < best_cost ||
+            (cost == best_cost && exc < best_exc)) {
+            best_shift = max_shift;
+            best_cost = cost;
+            best_exc = exc;
+            best_pos = reorderer.positions();
+        }
+    }
+
+    if (!best_shift) {
+        return state_ids;
+    }
+
+    DEBUG_PRINTF("using ordering for max_shift=%u\n", best_shift);
+    ue2::unordered_map<NFAVertex, u32> out;
+    for (const auto &m : state_ids) {
+        out[m.first] = m.second == NO_STATE ? NO_STATE : best_pos[m.second];
+    }
+    return out;
+}
+
 static
 u32 max_state(const ue2::unordered_map<NFAVertex, u32> &state_ids) {
     u32 rv = 0;
@@ -2126,8 +2408,17 @@ aligned_unique_ptr<NFA> generate(NGHolder &h,
     // Sanity check the input data.
     assert(isSane(h, tops, states, num_states));
 
+    // Renumber states so that more transitions fit in the shift masks. This is
+    // skipped when we have been asked to number states badly for testing.
+    const auto state_ids =
+        cc.grey.reorderNFAStates && !cc.grey.numberNFAStatesWrong
+            ? reorderStates(h, states, repeats, squashMap, num_states,
+                            cc.grey)
+            : states;
+    assert(isSane(h, tops, state_ids, num_states));
+
     // Build arguments used in the rest of this file.
-    build_info arg(h, states, repeats, reportSquashMap, squashMap, tops,
+    build_info arg(h, state_ids, repeats, reportSquashMap, squashMap, tops,
                    zombies, do_accel, stateCompression, cc, num_states);
 
     // Acceleration analysis.
@@ -35,6 +35,7 @@
 #include "limex_internal.h"
 #include "nfa_dump_internal.h"
 #include "ue2common.h"
+#include "util/bitutils.h"
 #include "util/dump_charclass.h"
 #include "util/dump_mask.h"
 #include "util/charreach.h"
@@ -54,6 +55,14 @@ using namespace std;
 namespace ue2 {
 
 template<typename T> struct limex_traits {};
+template<> struct limex_traits<LimExNFA1024> {
+    static const u32 size = 1024;
+    typedef NFAException1024 exception_type;
+};
+template<> struct limex_traits<LimExNFA768> {
+    static const u32 size = 768;
+    typedef NFAException768 exception_type;
+};
 template<> struct limex_traits<LimExNFA512> {
     static const u32 size = 512;
     typedef NFAException512 exception_type;
@@ -244,6 +253,49 @@ void dumpLimexExceptions(const limex_type *limex, FILE *f) {
     }
 }
 
+static
+u32 countBits(const u8 *mask, u32 mask_bits) {
+    u32 count = 0;
+    for (u32 i = 0; i < mask_bits / 8; i++) {
+        count += popcount32(mask[i]);
+    }
+    return count;
+}
+
+template<typename limex_type>
+static
+void dumpExceptionStats(const limex_type *limex, FILE *f) {
+    const u32 size = limex_traits<limex_type>::size;
+    const u32 state_count = limex_to_nfa(limex)->nPositions;
+    const u8 *emask = (const u8 *)&limex->exceptionMask;
+
+    // The runtime walks the exception mask a 64-bit chunk at a time.
+    const u32 chunk_bits = min(size, 64U);
+    u32 chunks = 0;
+    for (u32 i = 0; i < size; i += chunk_bits) {
+        if (countBits(emask + i / 8, chunk_bits)) {
+            chunks++;
+        }
+    }
+
+    u32 ex_states = countBits(emask, size);
+    fprintf(f, "\n%u exceptional states (%.1f%% of %u states), "
+               "%u exceptions.\n", ex_states,
+            state_count ? 100.0 * ex_states / state_count : 0.0, state_count,
+            limex->exceptionCount);
+    fprintf(f, "exception mask: %u of %u %u-bit chunks non-zero\n", chunks,
+            size / chunk_bits, chunk_bits);
+
+    u32 limited = 0;
+    fprintf(f, "limited transitions by shift:");
+    for (u32 j = 0; j < MAX_MAX_SHIFT; j++) {
+        u32 count = countBits((const u8 *)&limex->shift[j], size);
+        fprintf(f, " %u", count);
+        limited += count;
+    }
+    fprintf(f, " (total %u)\n", limited);
+}
+
 template<typename limex_type>
 static
 void dumpLimexText(const limex_type *limex, FILE *f) {
@@ -278,6 +330,7 @@ void dumpLimexText(const limex_type *limex, FILE *f) {
 
     dumpAccepts(limex, f);
 
+    dumpExceptionStats(limex, f);
     dumpLimexExceptions<limex_type>(limex, f);
 
     dumpAccel<limex_type>(limex, f);
@@ -494,4 +547,20 @@ LIMEX_DUMP_FNS(m512, 512, 5)
 LIMEX_DUMP_FNS(m512, 512, 6)
 LIMEX_DUMP_FNS(m512, 512, 7)
 
+LIMEX_DUMP_FNS(m768, 768, 1)
+LIMEX_DUMP_FNS(m768, 768, 2)
+LIMEX_DUMP_FNS(m768, 768, 3)
+LIMEX_DUMP_FNS(m768, 768, 4)
+LIMEX_DUMP_FNS(m768, 768, 5)
+LIMEX_DUMP_FNS(m768, 768, 6)
+LIMEX_DUMP_FNS(m768, 768, 7)
+
+LIMEX_DUMP_FNS(m1024, 1024, 1)
+LIMEX_DUMP_FNS(m1024, 1024, 2)
+LIMEX_DUMP_FNS(m1024, 1024, 3)
+LIMEX_DUMP_FNS(m1024, 1024, 4)
+LIMEX_DUMP_FNS(m1024, 1024, 5)
+LIMEX_DUMP_FNS(m1024, 1024, 6)
+LIMEX_DUMP_FNS(m1024, 1024, 7)
+
 } // namespace ue2
@@ -39,6 +39,7 @@
 #include "config.h"
 #include "limex_ring.h"
 #include "util/join.h"
+#include "util/profile.h"
 #include "util/uniform_ops.h"
 
 #define PE_FN                   JOIN(processExceptional, SIZE)
@@ -101,6 +102,7 @@ int RUN_EXCEPTION_FN(const EXCEPTION_T *e, STATE_ARG,
                      char in_rev,
                      const char flags) {
     assert(e);
+    PROFILE_EVENT(exceptions, 1);
 
 #ifdef DEBUG_EXCEPTIONS
     printf("EXCEPTION e=%p reports=%u trigger=", e, e->reports);
@@ -173,6 +173,8 @@ MAKE_GET_NFA_REPEAT_INFO(128)
 MAKE_GET_NFA_REPEAT_INFO(256)
 MAKE_GET_NFA_REPEAT_INFO(384)
 MAKE_GET_NFA_REPEAT_INFO(512)
+MAKE_GET_NFA_REPEAT_INFO(768)
+MAKE_GET_NFA_REPEAT_INFO(1024)
 
 static really_inline
 const struct RepeatInfo *getRepeatInfo(const struct NFARepeatInfo *info) {
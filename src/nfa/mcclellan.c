@@ -783,6 +783,76 @@ char nfaExecMcClellan8_B(const struct NFA *n, u64a offset, const u8 *buffer,
     }
 }
 
+/** \brief Finish a probe of a single block from state \a s: returns non-zero
+ * if an accept state (or EOD accept) is reached. */
+static really_inline
+char mcclellanProbe8(const struct mcclellan *m, u8 s, const u8 *c,
+                     const u8 *c_end) {
+    const u8 *succ_table = (const u8 *)((const char *)m
+                                        + sizeof(struct mcclellan));
+    const u32 as = m->alphaShift;
+    const u16 accept_limit = m->accept_limit_8;
+
+    while (c < c_end && s) {
+        s = succ_table[((u32)s << as) + m->remap[*(c++)]];
+        if (s >= accept_limit) {
+            return 1;
+        }
+    }
+
+    return get_aux(m, s)->accept_eod;
+}
+
+u32 nfaExecMcClellan8_Probe4(const struct NFA *n, const u8 *const *buffer,
+                             const size_t *length) {
+    assert(n->type == MCCLELLAN_NFA_8);
+    const struct mcclellan *m = getImplNfa(n);
+    const u8 *succ_table = (const u8 *)((const char *)m
+                                        + sizeof(struct mcclellan));
+    const u32 as = m->alphaShift;
+    const u16 accept_limit = m->accept_limit_8;
+    const u8 *b0 = buffer[0], *b1 = buffer[1], *b2 = buffer[2],
+             *b3 = buffer[3];
+
+    /* Walk all four blocks in lockstep over their common length; the four
+     * chains of table lookups are independent, so their latencies overlap.
+     * Acceleration is not used: it only skips bytes that cannot change the
+     * state, so it never affects the outcome. */
+    size_t common = MIN(MIN(length[0], length[1]), MIN(length[2], length[3]));
+    u8 s0 = (u8)m->start_anchored, s1 = s0, s2 = s0, s3 = s0;
+    u8 a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+    for (size_t i = 0; i < common; i++) {
+        s0 = succ_table[((u32)s0 << as) + m->remap[b0[i]]];
+        s1 = succ_table[((u32)s1 << as) + m->remap[b1[i]]];
+        s2 = succ_table[((u32)s2 << as) + m->remap[b2[i]]];
+        s3 = succ_table[((u32)s3 << as) + m->remap[b3[i]]];
+        a0 |= s0 >= accept_limit;
+        a1 |= s1 >= accept_limit;
+        a2 |= s2 >= accept_limit;
+        a3 |= s3 >= accept_limit;
+        if (!(s0 | s1 | s2 | s3)) {
+            break; /* all dead */
+        }
+    }
+
+    u32 rv = 0;
+    if (a0 || mcclellanProbe8(m, s0, b0 + common, b0 + length[0])) {
+        rv |= 1U << 0;
+    }
+    if (a1 || mcclellanProbe8(m, s1, b1 + common, b1 + length[1])) {
+        rv |= 1U << 1;
+    }
+    if (a2 || mcclellanProbe8(m, s2, b2 + common, b2 + length[2])) {
+        rv |= 1U << 2;
+    }
+    if (a3 || mcclellanProbe8(m, s3, b3 + common, b3 + length[3])) {
+        rv |= 1U << 3;
+    }
+
+    DEBUG_PRINTF("probe result %x\n", rv);
+    return rv;
+}
+
 char nfaExecMcClellan8_Q(const struct NFA *n, struct mq *q, s64a end) {
     u64a offset = q->offset;
     const u8 *buffer = q->buffer;
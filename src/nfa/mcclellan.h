@@ -106,4 +106,13 @@ char nfaExecMcClellan8_B(const struct NFA *n, u64a offset, const u8 *buffer,
 char nfaExecMcClellan16_B(const struct NFA *n, u64a offset, const u8 *buffer,
                           size_t length, NfaCallback cb, void *context);
 
+/**
+ * Block mode probe of four independent blocks:
+ * - runs the four scans interleaved from the anchored start state
+ * - reports nothing; bit i of the result is set iff nfaExecMcClellan8_B on
+ *   block i would have raised a match (including at EOD)
+ */
+u32 nfaExecMcClellan8_Probe4(const struct NFA *n, const u8 *const *buffer,
+                             const size_t *length);
+
 #endif
@@ -43,6 +43,7 @@
 #include "util/charreach.h"
 #include "util/compare.h"
 #include "util/compile_context.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/make_unique.h"
 #include "util/order_check.h"
@@ -1097,6 +1098,7 @@ aligned_unique_ptr<NFA> mcclellanCompile_i(raw_dfa &raw, dfa_build_strat &strat,
 aligned_unique_ptr<NFA> mcclellanCompile(raw_dfa &raw, const CompileContext &cc,
                                          const ReportManager &rm,
                                          set<dstate_id_t> *accel_states) {
+    CompilePhase phase("mcclellan_compile");
     mcclellan_build_strat mbs(raw, rm);
     return mcclellanCompile_i(raw, mbs, cc, accel_states);
 }
@@ -1123,6 +1125,68 @@ u32 mcclellanStartReachSize(const raw_dfa *raw) {
     return out.count();
 }
 
+/** \brief Number of steps of random input over which findHotStates()
+ * accumulates visit probability. */
+#define HOT_STATE_STEPS 16
+
+vector<dstate_id_t> findHotStates(const raw_dfa &rdfa, u32 max_states) {
+    vector<dstate_id_t> rv;
+    if (rdfa.start_floating == DEAD_STATE) {
+        DEBUG_PRINTF("no floating start\n");
+        return rv;
+    }
+
+    const size_t num_states = rdfa.states.size();
+    const u16 alpha_size = rdfa.getImplAlphaSize();
+
+    /* probability of each symbol under uniformly random bytes */
+    vector<double> sym_prob(alpha_size, 0.0);
+    for (u32 c = 0; c < N_CHARS; c++) {
+        sym_prob[rdfa.alpha_remap[c]] += 1.0 / N_CHARS;
+    }
+
+    vector<double> curr(num_states, 0.0);
+    vector<double> next(num_states);
+    vector<double> visits(num_states, 0.0);
+    curr[rdfa.start_floating] = 1.0;
+
+    for (u32 step = 0; step < HOT_STATE_STEPS; step++) {
+        fill(next.begin(), next.end(), 0.0);
+        for (size_t i = 0; i < num_states; i++) {
+            if (curr[i] == 0.0) {
+                continue;
+            }
+            visits[i] += curr[i];
+            const dstate &ds = rdfa.states[i];
+            for (symbol_t s = 0; s < alpha_size; s++) {
+                next[ds.next[s]] += curr[i] * sym_prob[s];
+            }
+        }
+        /* once dead, a floating scan restarts at the floating start */
+        next[rdfa.start_floating] += next[DEAD_STATE];
+        next[DEAD_STATE] = 0.0;
+        curr.swap(next);
+    }
+
+    for (dstate_id_t i = 0; i < num_states; i++) {
+        if (i != DEAD_STATE && visits[i] > 0.0) {
+            rv.push_back(i);
+        }
+    }
+
+    /* hottest first; lower ids (roughly bfs order) break ties */
+    stable_sort(rv.begin(), rv.end(), [&visits](dstate_id_t a, dstate_id_t b) {
+        return visits[a] > visits[b];
+    });
+
+    if (rv.size() > max_states) {
+        rv.resize(max_states);
+    }
+
+    DEBUG_PRINTF("picked %zu hot states\n", rv.size());
+    return rv;
+}
+
 bool has_accel_dfa(const NFA *nfa) {
     const mcclellan *m = (const mcclellan *)getImplNfa(nfa);
     return m->has_accel;
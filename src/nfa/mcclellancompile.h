@@ -112,6 +112,17 @@ mcclellanCompile_i(raw_dfa &raw, dfa_build_strat &strat,
  */
 u32 mcclellanStartReachSize(const raw_dfa *raw);
 
+/**
+ * \brief Picks the (at most \p max_states) non-dead states in which a scan is
+ * expected to spend most of its time, hottest first.
+ *
+ * Hotness is estimated by propagating visit probability from the floating
+ * start state over uniformly random input for a fixed number of steps. If the
+ * DFA has no floating start, its head is only traversed once per scan and the
+ * returned vector is empty.
+ */
+std::vector<dstate_id_t> findHotStates(const raw_dfa &rdfa, u32 max_states);
+
 std::set<ReportID> all_reports(const raw_dfa &rdfa);
 
 bool has_accel_dfa(const NFA *nfa);
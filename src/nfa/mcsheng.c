@@ -0,0 +1,613 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief McSheng: 16-bit McClellan DFA with a Sheng-accelerated head.
+ *
+ * While the DFA is in one of its hottest states (the head), transitions are
+ * done with PSHUFB exactly as in Sheng. The wide McClellan table is only
+ * consulted when a transition leaves the head, and until the scan comes back.
+ */
+
+#include "mcsheng.h"
+
+#include "accel.h"
+#include "mcsheng_internal.h"
+#include "nfa_api.h"
+#include "nfa_api_queue.h"
+#include "nfa_internal.h"
+#include "util/simd_utils.h"
+#include "util/simd_utils_ssse3.h"
+#include "util/unaligned.h"
+#include "ue2common.h"
+
+enum MatchMode {
+    CALLBACK_OUTPUT,
+    STOP_AT_MATCH,
+    NO_MATCHES
+};
+
+static really_inline
+const struct mcsheng *getMcSheng(const struct NFA *n) {
+    return (const struct mcsheng *)getImplNfa(n);
+}
+
+static really_inline
+const struct mcsheng_aux *get_aux(const struct mcsheng *m, u16 s) {
+    const char *nfa = (const char *)m - sizeof(struct NFA);
+    const struct mcsheng_aux *aux
+        = s + (const struct mcsheng_aux *)(nfa + m->aux_offset);
+
+    assert(s < m->state_count);
+    assert(ISALIGNED(aux));
+    return aux;
+}
+
+static really_inline
+const void *fromNfaOffset(const struct mcsheng *m, u32 offset) {
+    assert(offset);
+    return (const char *)m - sizeof(struct NFA) + offset;
+}
+
+static really_inline
+char doComplexReport(NfaCallback cb, void *ctxt, const struct mcsheng *m,
+                     u16 s, u64a loc, char eod, u16 *const cached_accept_state,
+                     u32 *const cached_accept_id) {
+    DEBUG_PRINTF("reporting state = %hu, loc=%llu, eod %hhu\n", s, loc, eod);
+
+    if (!eod && s == *cached_accept_state) {
+        if (cb(loc, *cached_accept_id, ctxt) == MO_HALT_MATCHING) {
+            return MO_HALT_MATCHING; /* termination requested */
+        }
+
+        return MO_CONTINUE_MATCHING; /* continue execution */
+    }
+
+    const struct mcsheng_aux *aux = get_aux(m, s);
+    const struct report_list *rl
+        = fromNfaOffset(m, eod ? aux->accept_eod : aux->accept);
+    assert(ISALIGNED(rl));
+
+    DEBUG_PRINTF("report list size %u\n", rl->count);
+    u32 count = rl->count;
+
+    if (!eod && count == 1) {
+        *cached_accept_state = s;
+        *cached_accept_id = rl->report[0];
+
+        DEBUG_PRINTF("reporting %u\n", rl->report[0]);
+        if (cb(loc, rl->report[0], ctxt) == MO_HALT_MATCHING) {
+            return MO_HALT_MATCHING; /* termination requested */
+        }
+
+        return MO_CONTINUE_MATCHING; /* continue execution */
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        DEBUG_PRINTF("reporting %u\n", rl->report[i]);
+        if (cb(loc, rl->report[i], ctxt) == MO_HALT_MATCHING) {
+            return MO_HALT_MATCHING; /* termination requested */
+        }
+    }
+
+    return MO_CONTINUE_MATCHING; /* continue execution */
+}
+
+/** \brief Runs the acceleration scheme for state \a s from \a c, updating
+ * \a min_accel_offset per the usual penalty scheme. */
+static really_inline
+const u8 *doAccel(const struct mcsheng *m, u16 s, const u8 *c,
+                  const u8 *c_end, const u8 **min_accel_offset) {
+    DEBUG_PRINTF("skipping\n");
+    const union AccelAux *aaux = fromNfaOffset(m, get_aux(m, s)->accel);
+    const u8 *c2 = run_accel(aaux, c, c_end);
+
+    if (c2 < *min_accel_offset + BAD_ACCEL_DIST) {
+        *min_accel_offset = c2 + BIG_ACCEL_PENALTY;
+    } else {
+        *min_accel_offset = c2 + SMALL_ACCEL_PENALTY;
+    }
+
+    if (*min_accel_offset >= c_end - ACCEL_MIN_LEN) {
+        *min_accel_offset = c_end;
+    }
+
+    DEBUG_PRINTF("advanced %zd, next accel chance in %zd/%zd\n",
+                 c2 - c, *min_accel_offset - c2, c_end - c2);
+    return c2;
+}
+
+/** \brief Number of bytes consumed per iteration of the unrolled head loop. */
+#define MCSHENG_CHUNK 4
+
+static really_inline
+char mcshengExec16_i(const struct mcsheng *m, u16 *state, const u8 *buf,
+                     size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                     char single, const u8 **c_final, enum MatchMode mode) {
+    assert(ISALIGNED_N(state, 2));
+
+    u16 s = *state;
+    const u8 *c = buf, *c_end = buf + len;
+    const m128 *masks = m->sheng_masks;
+    const u16 *succ_table = mcshengSuccTable(m);
+    const u32 as = m->alphaShift;
+    const u16 sheng_end = m->sheng_end;
+
+    u32 cached_accept_id = 0;
+    u16 cached_accept_state = 0;
+
+    DEBUG_PRINTF("s: %hu, len %zu\n", s, len);
+
+    /* head states we must stop and look at; acceleration is only considered
+     * once we are past min_accel_offset */
+    const u8 watch = MCSHENG_EXIT | SHENG_STATE_DEAD
+                   | (mode != NO_MATCHES ? SHENG_STATE_ACCEPT : 0);
+
+    const u8 *min_accel_offset = c;
+    if (!m->has_accel || len < ACCEL_MIN_LEN) {
+        min_accel_offset = c_end;
+    }
+
+    while (c < c_end && s) {
+        if (s < sheng_end) {
+            m128 cur = set16x8(m->sheng_enc[s]);
+
+            while (c < c_end) {
+                const u8 interesting = c >= min_accel_offset
+                                     ? watch | SHENG_STATE_ACCEL : watch;
+                const u8 *slow_end = c_end;
+
+                if (c + MCSHENG_CHUNK <= c_end) {
+                    m128 s1 = pshufb(masks[c[0]], cur);
+                    m128 s2 = pshufb(masks[c[1]], s1);
+                    m128 s3 = pshufb(masks[c[2]], s2);
+                    m128 s4 = pshufb(masks[c[3]], s3);
+                    u8 seen = (u8)movd(or128(or128(s1, s2), or128(s3, s4)));
+                    if (!(seen & interesting)) {
+                        cur = s4;
+                        c += MCSHENG_CHUNK;
+                        continue;
+                    }
+                    /* something in this chunk needs attention: redo it a
+                     * byte at a time */
+                    slow_end = c + MCSHENG_CHUNK;
+                }
+
+                while (c < slow_end) {
+                    m128 next = pshufb(masks[*(c++)], cur);
+                    u8 enc = (u8)movd(next);
+                    DEBUG_PRINTF("c: %02hhx enc: %hhx\n", *(c-1), enc);
+
+                    if (!(enc & interesting)) {
+                        cur = next;
+                        continue;
+                    }
+
+                    if (enc & MCSHENG_EXIT) {
+                        u16 from = (u8)movd(cur) & SHENG_STATE_MASK;
+                        s = succ_table[((u32)from << as) + m->remap[*(c-1)]];
+                        DEBUG_PRINTF("left head %hu -> %hu\n", from,
+                                     (u16)(s & STATE_MASK));
+                        goto check_flags;
+                    }
+
+                    cur = next;
+                    s = enc & SHENG_STATE_MASK;
+
+                    if (enc & SHENG_STATE_DEAD) {
+                        DEBUG_PRINTF("dead\n");
+                        goto done;
+                    }
+
+                    if (mode != NO_MATCHES && (enc & SHENG_STATE_ACCEPT)) {
+                        if (mode == STOP_AT_MATCH) {
+                            DEBUG_PRINTF("match - pausing\n");
+                            *state = s;
+                            *c_final = c - 1;
+                            return MO_CONTINUE_MATCHING;
+                        }
+
+                        u64a loc = (c - 1) - buf + offAdj + 1;
+                        if (single) {
+                            DEBUG_PRINTF("reporting %u\n", m->arb_report);
+                            if (cb(loc, m->arb_report, ctxt)
+                                == MO_HALT_MATCHING) {
+                                return MO_HALT_MATCHING;
+                            }
+                        } else if (doComplexReport(cb, ctxt, m, s, loc, 0,
+                                                   &cached_accept_state,
+                                                   &cached_accept_id)
+                                   == MO_HALT_MATCHING) {
+                            return MO_HALT_MATCHING;
+                        }
+                        continue;
+                    }
+
+                    if (interesting & enc & SHENG_STATE_ACCEL) {
+                        c = doAccel(m, s, c, c_end, &min_accel_offset);
+                        break;
+                    }
+                }
+            }
+
+            s = (u8)movd(cur) & SHENG_STATE_MASK;
+            goto done;
+        }
+
+        /* outside the head: ordinary 16-bit McClellan transition */
+        assert(s < m->state_count);
+        s = succ_table[((u32)s << as) + m->remap[*(c++)]];
+        DEBUG_PRINTF("c: %02hhx s: %hu (%hu)\n", *(c-1), s,
+                     (u16)(s & STATE_MASK));
+
+check_flags:
+        if (mode != NO_MATCHES && (s & ACCEPT_FLAG)) {
+            if (mode == STOP_AT_MATCH) {
+                *state = s & STATE_MASK;
+                *c_final = c - 1;
+                return MO_CONTINUE_MATCHING;
+            }
+
+            u64a loc = (c - 1) - buf + offAdj + 1;
+
+            if (single) {
+                DEBUG_PRINTF("reporting %u\n", m->arb_report);
+                if (cb(loc, m->arb_report, ctxt) == MO_HALT_MATCHING) {
+                    return MO_HALT_MATCHING; /* termination requested */
+                }
+            } else if (doComplexReport(cb, ctxt, m, s & STATE_MASK, loc, 0,
+                                       &cached_accept_state,
+                                       &cached_accept_id) == MO_HALT_MATCHING) {
+                return MO_HALT_MATCHING;
+            }
+        } else if ((s & ACCEL_FLAG) && c >= min_accel_offset) {
+            c = doAccel(m, s & STATE_MASK, c, c_end, &min_accel_offset);
+        }
+
+        s &= STATE_MASK;
+    }
+
+done:
+    if (mode == STOP_AT_MATCH) {
+        *c_final = c_end;
+    }
+    *state = s;
+
+    return MO_CONTINUE_MATCHING;
+}
+
+static never_inline
+char mcshengExec16_i_cb(const struct mcsheng *m, u16 *state, const u8 *buf,
+                        size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                        char single, const u8 **final_point) {
+    return mcshengExec16_i(m, state, buf, len, offAdj, cb, ctxt, single,
+                           final_point, CALLBACK_OUTPUT);
+}
+
+static never_inline
+char mcshengExec16_i_sam(const struct mcsheng *m, u16 *state, const u8 *buf,
+                         size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                         char single, const u8 **final_point) {
+    return mcshengExec16_i(m, state, buf, len, offAdj, cb, ctxt, single,
+                           final_point, STOP_AT_MATCH);
+}
+
+static never_inline
+char mcshengExec16_i_nm(const struct mcsheng *m, u16 *state, const u8 *buf,
+                        size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                        char single, const u8 **final_point) {
+    return mcshengExec16_i(m, state, buf, len, offAdj, cb, ctxt, single,
+                           final_point, NO_MATCHES);
+}
+
+static really_inline
+char mcshengExec16_i_ni(const struct mcsheng *m, u16 *state, const u8 *buf,
+                        size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                        char single, const u8 **final_point,
+                        enum MatchMode mode) {
+    if (mode == CALLBACK_OUTPUT) {
+        return mcshengExec16_i_cb(m, state, buf, len, offAdj, cb, ctxt,
+                                  single, final_point);
+    } else if (mode == STOP_AT_MATCH) {
+        return mcshengExec16_i_sam(m, state, buf, len, offAdj, cb, ctxt,
+                                   single, final_point);
+    } else {
+        assert(mode == NO_MATCHES);
+        return mcshengExec16_i_nm(m, state, buf, len, offAdj, cb, ctxt,
+                                  single, final_point);
+    }
+}
+
+static really_inline
+char mcshengReportCurrent(const struct mcsheng *m, u16 s, u64a loc,
+                          NfaCallback cb, void *ctxt) {
+    if (m->flags & MCSHENG_FLAG_SINGLE) {
+        DEBUG_PRINTF("reporting %u\n", m->arb_report);
+        return cb(loc, m->arb_report, ctxt);
+    }
+
+    u32 cached_accept_id = 0;
+    u16 cached_accept_state = 0;
+    return doComplexReport(cb, ctxt, m, s, loc, 0, &cached_accept_state,
+                           &cached_accept_id);
+}
+
+static really_inline
+char nfaExecMcSheng16_Q2i(const struct NFA *n, u64a offset, const u8 *buffer,
+                          const u8 *hend, NfaCallback cb, void *context,
+                          struct mq *q, char single, s64a end,
+                          enum MatchMode mode) {
+    assert(n->type == MCSHENG_NFA_16);
+    const struct mcsheng *m = getMcSheng(n);
+    s64a sp;
+
+    assert(ISALIGNED_N(q->state, 2));
+    u16 s = *(u16 *)q->state;
+
+    if (q->report_current) {
+        assert(s);
+        assert(get_aux(m, s)->accept);
+
+        int rv = mcshengReportCurrent(m, s, q_cur_offset(q), cb, context);
+
+        q->report_current = 0;
+
+        if (rv == MO_HALT_MATCHING) {
+            return MO_HALT_MATCHING;
+        }
+    }
+
+    sp = q_cur_loc(q);
+    q->cur++;
+
+    const u8 *cur_buf = sp < 0 ? hend : buffer;
+
+    char report = 1;
+    if (mode == CALLBACK_OUTPUT) {
+        /* we are starting inside the history buffer: matches are suppressed */
+        report = !(sp < 0);
+    }
+
+    if (mode != NO_MATCHES && q->items[q->cur - 1].location > end) {
+        DEBUG_PRINTF("this is as far as we go\n");
+        q->cur--;
+        q->items[q->cur].type = MQE_START;
+        q->items[q->cur].location = end;
+        *(u16 *)q->state = s;
+        return MO_ALIVE;
+    }
+
+    while (1) {
+        DEBUG_PRINTF("%s @ %llu\n", q->items[q->cur].type == MQE_TOP ? "TOP" :
+                     q->items[q->cur].type == MQE_END ? "END" : "???",
+                     q->items[q->cur].location + offset);
+        assert(q->cur < q->end);
+        s64a ep = q->items[q->cur].location;
+        if (mode != NO_MATCHES) {
+            ep = MIN(ep, end);
+        }
+
+        assert(ep >= sp);
+
+        s64a local_ep = ep;
+        if (sp < 0) {
+            local_ep = MIN(0, ep);
+        }
+
+        const u8 *final_look;
+        if (mcshengExec16_i_ni(m, &s, cur_buf + sp, local_ep - sp, offset + sp,
+                               cb, context, single, &final_look,
+                               report ? mode : NO_MATCHES)
+            == MO_HALT_MATCHING) {
+            *(u16 *)q->state = 0;
+            return 0;
+        }
+        if (mode == STOP_AT_MATCH && final_look != cur_buf + local_ep) {
+            /* found a match */
+            DEBUG_PRINTF("found a match\n");
+            assert(q->cur);
+            q->cur--;
+            q->items[q->cur].type = MQE_START;
+            q->items[q->cur].location = final_look - cur_buf + 1; /* due to
+                                                                   * early -1 */
+            *(u16 *)q->state = s;
+            return MO_MATCHES_PENDING;
+        }
+
+        assert(q->cur);
+        if (mode != NO_MATCHES && q->items[q->cur].location > end) {
+            DEBUG_PRINTF("this is as far as we go\n");
+            assert(q->cur);
+            q->cur--;
+            q->items[q->cur].type = MQE_START;
+            q->items[q->cur].location = end;
+            *(u16 *)q->state = s;
+            return MO_ALIVE;
+        }
+
+        sp = local_ep;
+
+        if (sp == 0) {
+            cur_buf = buffer;
+            report = 1;
+        }
+
+        if (sp != ep) {
+            continue;
+        }
+
+        switch (q->items[q->cur].type) {
+        case MQE_TOP:
+            assert(sp + offset || !s);
+            if (sp + offset == 0) {
+                s = m->start_anchored;
+                break;
+            }
+            DEBUG_PRINTF("enabling starts %hu->%hu\n", s, get_aux(m, s)->top);
+            s = get_aux(m, s)->top;
+            break;
+        case MQE_END:
+            *(u16 *)q->state = s;
+            q->cur++;
+            return s ? MO_ALIVE : 0;
+        default:
+            assert(!"invalid queue event");
+        }
+
+        q->cur++;
+    }
+}
+
+char nfaExecMcSheng16_Q(const struct NFA *n, struct mq *q, s64a end) {
+    const struct mcsheng *m = getMcSheng(n);
+    const u8 *hend = q->history + q->hlength;
+
+    return nfaExecMcSheng16_Q2i(n, q->offset, q->buffer, hend, q->cb,
+                                q->context, q, m->flags & MCSHENG_FLAG_SINGLE,
+                                end, CALLBACK_OUTPUT);
+}
+
+char nfaExecMcSheng16_Q2(const struct NFA *n, struct mq *q, s64a end) {
+    const struct mcsheng *m = getMcSheng(n);
+    const u8 *hend = q->history + q->hlength;
+
+    return nfaExecMcSheng16_Q2i(n, q->offset, q->buffer, hend, q->cb,
+                                q->context, q, m->flags & MCSHENG_FLAG_SINGLE,
+                                end, STOP_AT_MATCH);
+}
+
+char nfaExecMcSheng16_QR(const struct NFA *n, struct mq *q, ReportID report) {
+    const struct mcsheng *m = getMcSheng(n);
+    const u8 *hend = q->history + q->hlength;
+
+    char rv = nfaExecMcSheng16_Q2i(n, q->offset, q->buffer, hend, q->cb,
+                                   q->context, q,
+                                   m->flags & MCSHENG_FLAG_SINGLE,
+                                   0 /* end */, NO_MATCHES);
+    if (rv && nfaExecMcSheng16_inAccept(n, report, q)) {
+        return MO_MATCHES_PENDING;
+    } else {
+        return rv;
+    }
+}
+
+char nfaExecMcSheng16_reportCurrent(const struct NFA *n, struct mq *q) {
+    const struct mcsheng *m = getMcSheng(n);
+    u16 s = *(u16 *)q->state;
+    assert(q_cur_type(q) == MQE_START);
+    DEBUG_PRINTF("state %hu\n", s);
+    assert(s);
+
+    if (get_aux(m, s)->accept) {
+        mcshengReportCurrent(m, s, q_cur_offset(q), q->cb, q->context);
+    }
+
+    return 0;
+}
+
+char nfaExecMcSheng16_inAccept(const struct NFA *n, ReportID report,
+                               struct mq *q) {
+    assert(n && q);
+
+    const struct mcsheng *m = getMcSheng(n);
+    u16 s = *(u16 *)q->state;
+    DEBUG_PRINTF("checking accepts for %hu\n", s);
+
+    const struct mcsheng_aux *aux = get_aux(m, s);
+    if (!aux->accept) {
+        return 0;
+    }
+
+    const struct report_list *rl = fromNfaOffset(m, aux->accept);
+    assert(ISALIGNED_N(rl, 4));
+
+    DEBUG_PRINTF("report list has %u entries\n", rl->count);
+
+    for (u32 i = 0; i < rl->count; i++) {
+        if (rl->report[i] == report) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+char nfaExecMcSheng16_testEOD(const struct NFA *nfa, const char *state,
+                              UNUSED const char *streamState, u64a offset,
+                              NfaCallback callback,
+                              UNUSED SomNfaCallback som_cb, void *context) {
+    assert(ISALIGNED_N(state, 2));
+    const struct mcsheng *m = getMcSheng(nfa);
+    u16 s = *(const u16 *)state;
+
+    if (!get_aux(m, s)->accept_eod) {
+        return MO_CONTINUE_MATCHING;
+    }
+
+    return doComplexReport(callback, context, m, s, offset, 1, NULL, NULL);
+}
+
+char nfaExecMcSheng16_queueInitState(UNUSED const struct NFA *nfa,
+                                     struct mq *q) {
+    assert(nfa->scratchStateSize == 2);
+    assert(ISALIGNED_N(q->state, 2));
+    *(u16 *)q->state = 0;
+    return 0;
+}
+
+char nfaExecMcSheng16_initCompressedState(const struct NFA *nfa, u64a offset,
+                                          void *state, UNUSED u8 key) {
+    const struct mcsheng *m = getMcSheng(nfa);
+    u16 s = offset ? m->start_floating : m->start_anchored;
+    if (s) {
+        unaligned_store_u16(state, s);
+        return 1;
+    }
+    return 0;
+}
+
+char nfaExecMcSheng16_queueCompressState(UNUSED const struct NFA *nfa,
+                                         const struct mq *q, UNUSED s64a loc) {
+    void *dest = q->streamState;
+    const void *src = q->state;
+    assert(nfa->scratchStateSize == 2);
+    assert(nfa->streamStateSize == 2);
+    assert(ISALIGNED_N(src, 2));
+    unaligned_store_u16(dest, *(const u16 *)(src));
+    return 0;
+}
+
+char nfaExecMcSheng16_expandState(UNUSED const struct NFA *nfa, void *dest,
+                                  const void *src, UNUSED u64a offset,
+                                  UNUSED u8 key) {
+    assert(nfa->scratchStateSize == 2);
+    assert(nfa->streamStateSize == 2);
+    assert(ISALIGNED_N(dest, 2));
+    *(u16 *)dest = unaligned_load_u16(src);
+    return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MCSHENG_INTERNAL_H
+#define MCSHENG_INTERNAL_H
+
+#include "mcclellan_internal.h"
+#include "sheng_internal.h"
+#include "ue2common.h"
+#include "util/simd_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* McSheng is a 16-bit McClellan whose hottest states (the "head") are also
+ * run as a Sheng. States are numbered so that the head, including the dead
+ * state, occupies ids [0, sheng_end).
+ *
+ * Head states are encoded in the shuffle masks with the SHENG_STATE_* flags.
+ * A transition that leaves the head is encoded as MCSHENG_EXIT, and the real
+ * successor is then read from the McClellan transition table, whose entries
+ * carry the usual ACCEPT_FLAG and ACCEL_FLAG. */
+#define MCSHENG_EXIT 0x80
+
+#define MCSHENG_FLAG_SINGLE 1 /**< we raise only single accept id */
+
+struct mcsheng_aux {
+    u32 accept; /**< report list offset from start of NFA; 0 if none */
+    u32 accept_eod; /**< as above, for EOD reports */
+    u32 accel; /**< AccelAux offset from start of NFA; 0 if none */
+    u16 top; /**< state entered on a top */
+};
+
+struct mcsheng {
+    /** \brief Head transitions: byte i of sheng_masks[c] is the encoded
+     * successor of head state i on c. */
+    m128 sheng_masks[N_CHARS];
+    u32 length; /**< length of the engine in bytes, including the NFA header */
+    u32 aux_offset; /**< offset of the mcsheng_aux array from start of NFA */
+    u16 state_count; /**< total number of states */
+    u16 start_anchored; /**< anchored start state */
+    u16 start_floating; /**< floating start state */
+    u16 sheng_end; /**< states below this id are in the head */
+    u8 alphaShift;
+    u8 flags;
+    u8 has_accel; /**< 1 iff there are any accel states */
+    u8 sheng_enc[SHENG_MAX_STATES]; /**< encoded form of each head state */
+    u8 remap[256]; /**< remaps characters to a smaller alphabet */
+    ReportID arb_report; /**< one of the accepts that this dfa may raise */
+};
+
+/** \brief The McClellan transition table, which directly follows the mcsheng
+ * structure (rounded up to a 16-byte boundary). */
+static really_inline
+const u16 *mcshengSuccTable(const struct mcsheng *m) {
+    return (const u16 *)((const char *)m
+                         + ROUNDUP_16(sizeof(struct NFA) + sizeof(*m))
+                         - sizeof(struct NFA));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mcshengcompile.h"
+
+#include "accel.h"
+#include "grey.h"
+#include "mcclellancompile.h"
+#include "mcclellancompile_accel.h"
+#include "mcsheng_internal.h"
+#include "nfa_internal.h"
+#include "ue2common.h"
+#include "util/alloc.h"
+#include "util/bitutils.h"
+#include "util/compile_context.h"
+#include "util/compile_report.h"
+#include "util/container.h"
+#include "util/verify_types.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+namespace ue2 {
+
+/** \brief Largest transition table we are prepared to build. Beyond this the
+ * table will not stay in cache anyway, and McClellan's Sherman compression is
+ * the better trade-off. */
+#define MCSHENG_MAX_TRANSITION_BYTES (1U << 21)
+
+static
+u8 getAlphaShift(const raw_dfa &raw) {
+    u16 impl_alpha_size = raw.getImplAlphaSize();
+    if (impl_alpha_size < 2) {
+        return 1;
+    } else {
+        /* log2 round up */
+        return 32 - clz32(impl_alpha_size - 1);
+    }
+}
+
+/** \brief Numbers the states: dead first, then the hot head, then the rest in
+ * their raw order. Returns the id one past the end of the head. */
+static
+u16 allocateIds(const raw_dfa &raw, const vector<dstate_id_t> &hot,
+                vector<u16> &impl_id) {
+    const size_t num_states = raw.states.size();
+    impl_id.assign(num_states, 0);
+    vector<bool> in_head(num_states, false);
+
+    u16 next_id = 1; /* dead is always 0 */
+    in_head[DEAD_STATE] = true;
+    for (dstate_id_t s : hot) {
+        assert(s != DEAD_STATE);
+        in_head[s] = true;
+        impl_id[s] = next_id++;
+    }
+
+    u16 sheng_end = next_id;
+    assert(sheng_end <= SHENG_MAX_STATES);
+
+    for (dstate_id_t s = 0; s < num_states; s++) {
+        if (!in_head[s]) {
+            impl_id[s] = next_id++;
+        }
+    }
+
+    return sheng_end;
+}
+
+aligned_unique_ptr<NFA> mcshengCompile(raw_dfa &raw, const CompileContext &cc,
+                                       const ReportManager &rm) {
+    if (!cc.grey.allowMcSheng) {
+        DEBUG_PRINTF("mcsheng is disabled\n");
+        return nullptr;
+    }
+
+    const size_t num_states = raw.states.size();
+    if (cc.grey.allowMcClellan8 && num_states <= 256) {
+        DEBUG_PRINTF("small enough for mcclellan 8\n");
+        return nullptr;
+    }
+
+    if (num_states > (size_t)STATE_MASK + 1) {
+        DEBUG_PRINTF("too many states: %zu\n", num_states);
+        return nullptr;
+    }
+
+    const u8 alphaShift = getAlphaShift(raw);
+    assert(alphaShift <= 8);
+    size_t tran_size = sizeof(u16) * (num_states << alphaShift);
+    if (tran_size > MCSHENG_MAX_TRANSITION_BYTES) {
+        DEBUG_PRINTF("transition table too large: %zu bytes\n", tran_size);
+        return nullptr;
+    }
+
+    vector<dstate_id_t> hot = findHotStates(raw, SHENG_MAX_STATES - 1);
+    if (hot.empty()) {
+        DEBUG_PRINTF("no hot head\n");
+        return nullptr;
+    }
+
+    CompilePhase phase("mcsheng_compile");
+
+    if (!cc.streaming) {
+        raw.stripExtraEodReports();
+    }
+
+    mcclellan_build_strat strat(raw, rm);
+
+    vector<u32> reports;
+    vector<u32> reports_eod;
+    ReportID arb;
+    u8 single;
+
+    auto ri = strat.gatherReports(reports, reports_eod, &single, &arb);
+    map<dstate_id_t, AccelScheme> accel_escape_info
+        = populateAccelerationInfo(raw, strat, cc.grey);
+
+    vector<u16> impl_id;
+    u16 sheng_end = allocateIds(raw, hot, impl_id);
+
+    size_t tran_offset = ROUNDUP_16(sizeof(NFA) + sizeof(mcsheng));
+    size_t aux_offset = ROUNDUP_16(tran_offset + tran_size);
+    size_t aux_size = sizeof(mcsheng_aux) * num_states;
+    size_t accel_size = strat.accelSize() * accel_escape_info.size();
+    size_t accel_offset = ROUNDUP_N(aux_offset + aux_size
+                                     + ri->getReportListSize(), 32);
+    size_t total_size = accel_offset + accel_size;
+
+    DEBUG_PRINTF("states %zu, head %hu\n", num_states, sheng_end);
+    DEBUG_PRINTF("tran_size %zu\n", tran_size);
+    DEBUG_PRINTF("aux_offset %zu\n", aux_offset);
+    DEBUG_PRINTF("rl size %u\n", ri->getReportListSize());
+    DEBUG_PRINTF("accel_offset %zu\n", accel_offset);
+    DEBUG_PRINTF("total_size %zu\n", total_size);
+
+    assert(ISALIGNED_N(accel_offset, alignof(union AccelAux)));
+
+    aligned_unique_ptr<NFA> nfa = aligned_zmalloc_unique<NFA>(total_size);
+    char *nfa_base = (char *)nfa.get();
+    mcsheng *m = (mcsheng *)getMutableImplNfa(nfa.get());
+
+    nfa->type = MCSHENG_NFA_16;
+    nfa->length = verify_u32(total_size);
+    nfa->nPositions = verify_u32(num_states);
+    nfa->scratchStateSize = sizeof(u16);
+    nfa->streamStateSize = sizeof(u16);
+    if (raw.hasEodReports()) {
+        nfa->flags |= NFA_ACCEPTS_EOD;
+    }
+
+    m->length = verify_u32(total_size);
+    m->aux_offset = verify_u32(aux_offset);
+    m->state_count = verify_u16(num_states);
+    m->start_anchored = impl_id[raw.start_anchored];
+    m->start_floating = impl_id[raw.start_floating];
+    m->sheng_end = sheng_end;
+    m->alphaShift = alphaShift;
+    m->arb_report = arb;
+    m->has_accel = accel_escape_info.empty() ? 0 : 1;
+    if (single) {
+        m->flags |= MCSHENG_FLAG_SINGLE;
+    }
+    for (u32 i = 0; i < N_CHARS; i++) {
+        m->remap[i] = verify_u8(raw.alpha_remap[i]);
+    }
+
+    /* state ids with flags, as stored in the transition table */
+    vector<u16> table_id(num_states);
+    vector<dstate_id_t> raw_id(num_states);
+    for (dstate_id_t i = 0; i < num_states; i++) {
+        u16 id = impl_id[i];
+        raw_id[id] = i;
+        if (!raw.states[i].reports.empty()) {
+            id |= ACCEPT_FLAG;
+        }
+        if (contains(accel_escape_info, i)) {
+            id |= ACCEL_FLAG;
+        }
+        table_id[i] = id;
+    }
+
+    /* head states as encoded in the shuffle masks */
+    for (u16 j = 0; j < sheng_end; j++) {
+        dstate_id_t i = raw_id[j];
+        u8 enc = verify_u8(j);
+        if (i == DEAD_STATE) {
+            enc |= SHENG_STATE_DEAD;
+        }
+        if (!raw.states[i].reports.empty()) {
+            enc |= SHENG_STATE_ACCEPT;
+        }
+        if (contains(accel_escape_info, i)) {
+            enc |= SHENG_STATE_ACCEL;
+        }
+        m->sheng_enc[j] = enc;
+    }
+
+    for (u32 c = 0; c < N_CHARS; c++) {
+        u8 *mask = (u8 *)&m->sheng_masks[c];
+        /* unused lanes lead to the dead state */
+        fill(mask, mask + SHENG_MAX_STATES, m->sheng_enc[0]);
+        for (u16 j = 0; j < sheng_end; j++) {
+            dstate_id_t next = raw.states[raw_id[j]].next[raw.alpha_remap[c]];
+            u16 next_id = impl_id[next];
+            mask[j] = next_id < sheng_end ? m->sheng_enc[next_id]
+                                          : MCSHENG_EXIT;
+        }
+    }
+
+    u16 *succ_table = (u16 *)(nfa_base + tran_offset);
+    assert(succ_table == mcshengSuccTable(m));
+    const u16 impl_alpha_size = raw.getImplAlphaSize();
+    for (dstate_id_t i = 0; i < num_states; i++) {
+        u16 *row = succ_table + ((size_t)impl_id[i] << alphaShift);
+        for (symbol_t s = 0; s < impl_alpha_size; s++) {
+            row[s] = table_id[raw.states[i].next[s]];
+        }
+    }
+
+    vector<u32> reportOffsets;
+    ri->fillReportLists(nfa.get(), aux_offset + aux_size, reportOffsets);
+
+    mcsheng_aux *aux = (mcsheng_aux *)(nfa_base + aux_offset);
+    for (dstate_id_t i = 0; i < num_states; i++) {
+        const dstate &ds = raw.states[i];
+        mcsheng_aux &this_aux = aux[impl_id[i]];
+        this_aux.accept = ds.reports.empty() ? 0 : reportOffsets[reports[i]];
+        this_aux.accept_eod = ds.reports_eod.empty()
+                            ? 0 : reportOffsets[reports_eod[i]];
+        this_aux.top = impl_id[i ? ds.next[raw.alpha_remap[TOP]]
+                                 : raw.start_floating];
+
+        if (contains(accel_escape_info, i)) {
+            this_aux.accel = verify_u32(accel_offset);
+            strat.buildAccel(i, accel_escape_info.at(i),
+                             nfa_base + accel_offset);
+            accel_offset += strat.accelSize();
+        }
+    }
+
+    assert(accel_offset <= total_size);
+
+    DEBUG_PRINTF("built mcsheng with %zu states, %hu in head\n", num_states,
+                 sheng_end);
+    return nfa;
+}
+
+bool has_accel_mcsheng(const NFA *nfa) {
+    const mcsheng *m = (const mcsheng *)getImplNfa(nfa);
+    return m->has_accel;
+}
+
+} // namespace ue2
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include "mcshengdump.h"
+
+#include "accel_dump.h"
+#include "mcclellandump.h"
+#include "mcsheng_internal.h"
+#include "nfa_dump_internal.h"
+#include "nfa_internal.h"
+#include "rdfa.h"
+#include "ue2common.h"
+
+#include <cstdio>
+
+#ifndef DUMP_SUPPORT
+#error No dump support!
+#endif
+
+using namespace std;
+
+namespace ue2 {
+
+static
+const mcsheng_aux *getMcShengAux(const NFA *n, u16 i) {
+    const mcsheng *m = (const mcsheng *)getImplNfa(n);
+    assert(i < m->state_count);
+    const mcsheng_aux *aux = (const mcsheng_aux *)((const char *)n
+                                                    + m->aux_offset);
+    return aux + i;
+}
+
+static
+const AccelAux *getMcShengAccel(const NFA *n, const mcsheng_aux *aux) {
+    if (!aux->accel) {
+        return nullptr;
+    }
+    return (const AccelAux *)((const char *)n + aux->accel);
+}
+
+static
+void mcshengGetTransitions(const NFA *n, u16 s, u16 *t) {
+    const mcsheng *m = (const mcsheng *)getImplNfa(n);
+    const u16 *succ_table = mcshengSuccTable(m);
+    for (u32 c = 0; c < N_CHARS; c++) {
+        t[c] = succ_table[((u32)s << m->alphaShift) + m->remap[c]]
+             & STATE_MASK;
+    }
+    t[TOP] = getMcShengAux(n, s)->top;
+}
+
+static
+void describeNode(const NFA *n, const mcsheng *m, u16 i, FILE *f) {
+    const mcsheng_aux *aux = getMcShengAux(n, i);
+
+    bool isHead = i < m->sheng_end;
+
+    fprintf(f, "%u [ width = 1, fixedsize = true, fontsize = 12, "
+            "label = \"%u%s\" ]; \n", i, i, isHead ? "s" : "");
+
+    if (const AccelAux *accel = getMcShengAccel(n, aux)) {
+        dumpAccelDot(f, i, accel);
+    }
+
+    if (aux->accept_eod) {
+        fprintf(f, "%u [ color = darkorchid ];\n", i);
+    }
+
+    if (aux->accept) {
+        fprintf(f, "%u [ shape = doublecircle ];\n", i);
+    }
+
+    if (aux->top && aux->top != i) {
+        fprintf(f, "%u -> %u [color = darkgoldenrod weight=0.1 ]\n", i,
+                aux->top);
+    }
+
+    if (i == m->start_anchored) {
+        fprintf(f, "STARTA -> %u [color = blue ]\n", i);
+    }
+
+    if (i == m->start_floating) {
+        fprintf(f, "STARTF -> %u [color = red ]\n", i);
+    }
+
+    if (isHead) {
+        fprintf(f, "%u [ fillcolor = lightpink style=filled ];\n", i);
+    }
+}
+
+void nfaExecMcSheng16_dumpDot(const NFA *nfa, FILE *f) {
+    assert(nfa->type == MCSHENG_NFA_16);
+    const mcsheng *m = (const mcsheng *)getImplNfa(nfa);
+
+    dumpDotPreambleDfa(f);
+
+    for (u16 i = 1; i < m->state_count; i++) {
+        describeNode(nfa, m, i, f);
+
+        u16 t[ALPHABET_SIZE];
+        mcshengGetTransitions(nfa, i, t);
+        describeEdge(f, t, i);
+    }
+
+    fprintf(f, "}\n");
+}
+
+static
+void dumpTransitions(FILE *f, const NFA *nfa, const mcsheng *m) {
+    for (u16 i = 0; i < m->state_count; i++) {
+        fprintf(f, "%05hu", i);
+        if (const AccelAux *accel
+                = getMcShengAccel(nfa, getMcShengAux(nfa, i))) {
+            dumpAccelText(f, accel);
+        }
+
+        u16 trans[ALPHABET_SIZE];
+        mcshengGetTransitions(nfa, i, trans);
+
+        int rstart = 0;
+        u16 prev = 0xffff;
+        for (int j = 0; j < N_CHARS; j++) {
+            u16 curr = trans[j];
+            if (curr == prev) {
+                continue;
+            }
+
+            if (prev != 0xffff) {
+                if (j == rstart + 1) {
+                    fprintf(f, " %02x->%hu", rstart, prev);
+                } else {
+                    fprintf(f, " [%02x - %02x]->%hu", rstart, j - 1, prev);
+                }
+            }
+
+            prev = curr;
+            rstart = j;
+        }
+        if (N_CHARS == rstart + 1) {
+            fprintf(f, " %02x->%hu", rstart, prev);
+        } else {
+            fprintf(f, " [%02x - %02x]->%hu", rstart, N_CHARS - 1, prev);
+        }
+        fprintf(f, "\n");
+    }
+}
+
+static
+void dumpAccelMasks(FILE *f, const NFA *nfa, const mcsheng *m) {
+    fprintf(f, "\n");
+    fprintf(f, "Acceleration\n");
+    fprintf(f, "------------\n");
+
+    for (u16 i = 0; i < m->state_count; i++) {
+        const AccelAux *accel = getMcShengAccel(nfa, getMcShengAux(nfa, i));
+        if (!accel) {
+            continue;
+        }
+
+        fprintf(f, "%05hu ", i);
+        dumpAccelInfo(f, *accel);
+    }
+}
+
+void nfaExecMcSheng16_dumpText(const NFA *nfa, FILE *f) {
+    assert(nfa->type == MCSHENG_NFA_16);
+    const mcsheng *m = (const mcsheng *)getImplNfa(nfa);
+
+    fprintf(f, "mcsheng 16\n");
+    fprintf(f, "report: %u, states: %u, length: %u\n", m->arb_report,
+            m->state_count, m->length);
+    fprintf(f, "astart: %hu, fstart: %hu\n", m->start_anchored,
+            m->start_floating);
+    fprintf(f, "single accept: %d, has_accel: %d\n",
+            !!(m->flags & MCSHENG_FLAG_SINGLE), m->has_accel);
+    fprintf(f, "sheng_end: %hu\n", m->sheng_end);
+    fprintf(f, "\n");
+
+    dumpTransitions(f, nfa, m);
+    dumpAccelMasks(f, nfa, m);
+
+    fprintf(f, "\n");
+    dumpTextReverse(nfa, f);
+}
+
+} // namespace ue2
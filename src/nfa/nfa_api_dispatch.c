@@ -34,6 +34,7 @@
 #include "nfa_api_queue.h"
 #include "nfa_internal.h"
 #include "ue2common.h"
+#include "util/profile.h"
 
 // Engine implementations.
 #include "castle.h"
@@ -41,7 +42,9 @@
 #include "lbr.h"
 #include "limex.h"
 #include "mcclellan.h"
+#include "mcsheng.h"
 #include "mpv.h"
+#include "sheng.h"
 
 #define DISPATCH_CASE(dc_ltype, dc_ftype, dc_subtype, dc_func_call) \
     case dc_ltype##_NFA_##dc_subtype:                               \
@@ -87,6 +90,20 @@
         DISPATCH_CASE(LIMEX,   LimEx,   512_5, dbnt_func);    \
         DISPATCH_CASE(LIMEX,   LimEx,   512_6, dbnt_func);    \
         DISPATCH_CASE(LIMEX,   LimEx,   512_7, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_1, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_2, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_3, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_4, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_5, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_6, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   768_7, dbnt_func);    \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_1, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_2, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_3, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_4, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_5, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_6, dbnt_func);   \
+        DISPATCH_CASE(LIMEX,   LimEx,   1024_7, dbnt_func);   \
         DISPATCH_CASE(MCCLELLAN, McClellan, 8, dbnt_func);    \
         DISPATCH_CASE(MCCLELLAN, McClellan, 16, dbnt_func);   \
         DISPATCH_CASE(GOUGH, Gough, 8, dbnt_func);            \
@@ -98,6 +115,8 @@
         DISPATCH_CASE(LBR, Lbr, Shuf, dbnt_func);             \
         DISPATCH_CASE(LBR, Lbr, Truf, dbnt_func);             \
         DISPATCH_CASE(CASTLE, Castle, 0, dbnt_func);          \
+        DISPATCH_CASE(SHENG, Sheng, 0, dbnt_func);            \
+        DISPATCH_CASE(MCSHENG, McSheng, 16, dbnt_func);       \
     default:                                                  \
         assert(0);                                            \
     }
@@ -239,8 +258,18 @@ char nfaQueueExec(const struct NFA *nfa, struct mq *q, s64a end) {
         return 0;
     }
 
+#ifdef PROFILE_SUPPORT
+    struct ProfileMark mark;
+    profileMark(&mark);
+    s64a from = q->items[q->cur].location;
+#endif
+
     char rv = nfaQueueExec_i(nfa, q, end);
 
+#ifdef PROFILE_SUPPORT
+    profileEngineDone(q->profile, &mark, from, end);
+#endif
+
 #ifdef DEBUG
     debugQueue(q);
 #endif
@@ -289,7 +318,18 @@ char nfaQueueExecToMatch(const struct NFA *nfa, struct mq *q, s64a end) {
         return 0;
     }
 
+#ifdef PROFILE_SUPPORT
+    struct ProfileMark mark;
+    profileMark(&mark);
+    s64a from = q->items[q->cur].location;
+#endif
+
     char rv = nfaQueueExec2_i(nfa, q, end);
+
+#ifdef PROFILE_SUPPORT
+    profileEngineDone(q->profile, &mark, from, end);
+#endif
+
     assert(!q->report_current);
     DEBUG_PRINTF("returned rv=%d, q_trimmed=%d\n", rv, q_trimmed);
     if (rv == MO_MATCHES_PENDING) {
@@ -327,7 +367,20 @@ char nfaQueueExecRose(const struct NFA *nfa, struct mq *q, ReportID r) {
     assert(ISALIGNED_CL(nfa) && ISALIGNED_CL(getImplNfa(nfa)));
     assert(!q->report_current);
 
+#ifdef PROFILE_SUPPORT
+    struct ProfileMark mark;
+    profileMark(&mark);
+    s64a from = 0, to = 0;
+    if (q->cur < q->end) {
+        from = q->items[q->cur].location;
+        to = q->items[q->end - 1].location;
+    }
+    char rv = nfaQueueExecRose_i(nfa, q, r);
+    profileEngineDone(q->profile, &mark, from, to);
+    return rv;
+#else
     return nfaQueueExecRose_i(nfa, q, r);
+#endif
 }
 
 char nfaBlockExecReverse(const struct NFA *nfa, u64a offset, const u8 *buf,
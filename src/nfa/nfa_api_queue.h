@@ -70,6 +70,7 @@ struct mq_item {
 
 // Forward decl.
 struct NFA;
+struct ProfileEngine;
 
 /**
  * Queue of events to control engine execution.  mq::cur is index of first
@@ -98,6 +99,10 @@ struct mq {
     NfaCallback cb; /**< callback to trigger on matches */
     SomNfaCallback som_cb; /**< callback with som info;  used by haig */
     void *context; /**< context to pass along with a callback */
+#ifdef PROFILE_SUPPORT
+    struct ProfileEngine *profile; /**< profiling counters for this engine, or
+                                    * NULL; set when scratch is allocated */
+#endif
     struct mq_item items[MAX_MQE_LEN]; /**< queue items */
 };
 
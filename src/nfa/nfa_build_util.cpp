@@ -30,8 +30,10 @@
 
 #include "limex_internal.h"
 #include "mcclellancompile.h"
+#include "mcshengcompile.h"
 #include "nfa_internal.h"
 #include "repeat_internal.h"
+#include "shengcompile.h"
 #include "ue2common.h"
 
 #include <algorithm>
@@ -197,6 +199,20 @@ MAKE_LIMEX_TRAITS(512, 4)
 MAKE_LIMEX_TRAITS(512, 5)
 MAKE_LIMEX_TRAITS(512, 6)
 MAKE_LIMEX_TRAITS(512, 7)
+MAKE_LIMEX_TRAITS(768, 1)
+MAKE_LIMEX_TRAITS(768, 2)
+MAKE_LIMEX_TRAITS(768, 3)
+MAKE_LIMEX_TRAITS(768, 4)
+MAKE_LIMEX_TRAITS(768, 5)
+MAKE_LIMEX_TRAITS(768, 6)
+MAKE_LIMEX_TRAITS(768, 7)
+MAKE_LIMEX_TRAITS(1024, 1)
+MAKE_LIMEX_TRAITS(1024, 2)
+MAKE_LIMEX_TRAITS(1024, 3)
+MAKE_LIMEX_TRAITS(1024, 4)
+MAKE_LIMEX_TRAITS(1024, 5)
+MAKE_LIMEX_TRAITS(1024, 6)
+MAKE_LIMEX_TRAITS(1024, 7)
 
 template<> struct NFATraits<MCCLELLAN_NFA_8> {
     UNUSED static const char *name;
@@ -330,6 +346,30 @@ const has_accel_fn NFATraits<LBR_NFA_Truf>::has_accel = has_accel_generic;
 const char *NFATraits<LBR_NFA_Truf>::name = "Lim Bounded Repeat (M)";
 #endif
 
+template<> struct NFATraits<SHENG_NFA_0> {
+    UNUSED static const char *name;
+    static const NFACategory category = NFA_OTHER;
+    static const u32 stateAlign = 1;
+    static const bool fast = true;
+    static const has_accel_fn has_accel;
+};
+const has_accel_fn NFATraits<SHENG_NFA_0>::has_accel = has_accel_sheng;
+#if defined(DUMP_SUPPORT)
+const char *NFATraits<SHENG_NFA_0>::name = "Sheng";
+#endif
+
+template<> struct NFATraits<MCSHENG_NFA_16> {
+    UNUSED static const char *name;
+    static const NFACategory category = NFA_OTHER;
+    static const u32 stateAlign = 2;
+    static const bool fast = true;
+    static const has_accel_fn has_accel;
+};
+const has_accel_fn NFATraits<MCSHENG_NFA_16>::has_accel = has_accel_mcsheng;
+#if defined(DUMP_SUPPORT)
+const char *NFATraits<MCSHENG_NFA_16>::name = "McSheng 16";
+#endif
+
 } // namespace
 
 #if defined(DUMP_SUPPORT)
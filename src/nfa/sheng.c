@@ -0,0 +1,554 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Sheng: small DFA engine driven by PSHUFB.
+ *
+ * The state is kept broadcast across every lane of an m128, so a single
+ * shuffle of the per-character successor mask yields the next state. Flag
+ * bits carried in the state byte let the inner loop skip all aux lookups
+ * unless something needs to be done.
+ */
+
+#include "sheng.h"
+
+#include "accel.h"
+#include "mcclellan_internal.h"
+#include "nfa_api.h"
+#include "nfa_api_queue.h"
+#include "nfa_internal.h"
+#include "sheng_internal.h"
+#include "util/simd_utils.h"
+#include "util/simd_utils_ssse3.h"
+#include "ue2common.h"
+
+enum MatchMode {
+    CALLBACK_OUTPUT,
+    STOP_AT_MATCH,
+    NO_MATCHES
+};
+
+static really_inline
+const struct sheng *getSheng(const struct NFA *n) {
+    return (const struct sheng *)getImplNfa(n);
+}
+
+static really_inline
+const struct sstate_aux *get_aux(const struct sheng *sh, u8 s) {
+    const char *nfa = (const char *)sh - sizeof(struct NFA);
+    const struct sstate_aux *aux
+        = (s & SHENG_STATE_MASK)
+        + (const struct sstate_aux *)(nfa + sh->aux_offset);
+
+    assert(ISALIGNED(aux));
+    return aux;
+}
+
+static really_inline
+const struct report_list *get_rl(const struct sheng *sh, u32 offset) {
+    assert(offset);
+    const struct report_list *rl = (const struct report_list *)
+            ((const char *)sh + offset - sizeof(struct NFA));
+    assert(ISALIGNED(rl));
+    return rl;
+}
+
+static really_inline
+char shengIsDead(u8 s) {
+    return !!(s & SHENG_STATE_DEAD);
+}
+
+static really_inline
+char doComplexReport(NfaCallback cb, void *ctxt, const struct sheng *sh,
+                     u8 s, u64a loc, char eod, u8 *const cached_accept_state,
+                     u32 *const cached_accept_id) {
+    DEBUG_PRINTF("reporting state = %hhu, loc=%llu, eod %hhu\n",
+                 (u8)(s & SHENG_STATE_MASK), loc, eod);
+
+    if (!eod && s == *cached_accept_state) {
+        if (cb(loc, *cached_accept_id, ctxt) == MO_HALT_MATCHING) {
+            return MO_HALT_MATCHING; /* termination requested */
+        }
+
+        return MO_CONTINUE_MATCHING; /* continue execution */
+    }
+
+    const struct sstate_aux *aux = get_aux(sh, s);
+    const struct report_list *rl
+        = get_rl(sh, eod ? aux->accept_eod : aux->accept);
+
+    DEBUG_PRINTF("report list size %u\n", rl->count);
+    u32 count = rl->count;
+
+    if (!eod && count == 1) {
+        *cached_accept_state = s;
+        *cached_accept_id = rl->report[0];
+
+        DEBUG_PRINTF("reporting %u\n", rl->report[0]);
+        if (cb(loc, rl->report[0], ctxt) == MO_HALT_MATCHING) {
+            return MO_HALT_MATCHING; /* termination requested */
+        }
+
+        return MO_CONTINUE_MATCHING; /* continue execution */
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        DEBUG_PRINTF("reporting %u\n", rl->report[i]);
+        if (cb(loc, rl->report[i], ctxt) == MO_HALT_MATCHING) {
+            return MO_HALT_MATCHING; /* termination requested */
+        }
+    }
+
+    return MO_CONTINUE_MATCHING; /* continue execution */
+}
+
+/** \brief Number of bytes consumed per iteration of the unrolled fast path. */
+#define SHENG_CHUNK 4
+
+static really_inline
+char shengExec_i(const struct sheng *sh, u8 *state, const u8 *buf, size_t len,
+                 u64a offAdj, NfaCallback cb, void *ctxt, char single,
+                 const u8 **c_final, enum MatchMode mode) {
+    const m128 *masks = sh->shuffle_masks;
+    const u8 *c = buf, *c_end = buf + len;
+    u8 s = *state;
+    m128 cur = set16x8(s);
+
+    u32 cached_accept_id = 0;
+    u8 cached_accept_state = 0;
+
+    DEBUG_PRINTF("s: %hhx, len %zu\n", s, len);
+
+    /* states we must stop and look at; acceleration is only considered once
+     * we are past min_accel_offset */
+    const u8 watch = SHENG_STATE_DEAD
+                   | (mode != NO_MATCHES ? SHENG_STATE_ACCEPT : 0);
+
+    const u8 *min_accel_offset = c;
+    if (!(sh->flags & SHENG_FLAG_HAS_ACCEL) || len < ACCEL_MIN_LEN) {
+        min_accel_offset = c_end;
+    }
+
+    if (shengIsDead(s)) {
+        goto done;
+    }
+
+    while (c < c_end) {
+        const u8 interesting = c >= min_accel_offset
+                             ? watch | SHENG_STATE_ACCEL : watch;
+        const u8 *slow_end = c_end;
+
+        if (c + SHENG_CHUNK <= c_end) {
+            m128 s1 = pshufb(masks[c[0]], cur);
+            m128 s2 = pshufb(masks[c[1]], s1);
+            m128 s3 = pshufb(masks[c[2]], s2);
+            m128 s4 = pshufb(masks[c[3]], s3);
+            u8 seen = (u8)movd(or128(or128(s1, s2), or128(s3, s4)));
+            if (!(seen & interesting)) {
+                cur = s4;
+                c += SHENG_CHUNK;
+                continue;
+            }
+            /* something in this chunk needs attention: redo it a byte at a
+             * time */
+            slow_end = c + SHENG_CHUNK;
+        }
+
+        while (c < slow_end) {
+            cur = pshufb(masks[*(c++)], cur);
+            s = (u8)movd(cur);
+            DEBUG_PRINTF("c: %02hhx '%c' s: %hhx\n", *(c-1),
+                         ourisprint(*(c-1)) ? *(c-1) : '?', s);
+
+            if (!(s & interesting)) {
+                continue;
+            }
+
+            if (shengIsDead(s)) {
+                DEBUG_PRINTF("dead\n");
+                goto done;
+            }
+
+            if (mode != NO_MATCHES && (s & SHENG_STATE_ACCEPT)) {
+                if (mode == STOP_AT_MATCH) {
+                    DEBUG_PRINTF("match - pausing\n");
+                    *state = s;
+                    *c_final = c - 1;
+                    return MO_CONTINUE_MATCHING;
+                }
+
+                u64a loc = (c - 1) - buf + offAdj + 1;
+                if (single) {
+                    DEBUG_PRINTF("reporting %u\n", sh->report);
+                    if (cb(loc, sh->report, ctxt) == MO_HALT_MATCHING) {
+                        return MO_HALT_MATCHING;
+                    }
+                } else if (doComplexReport(cb, ctxt, sh, s, loc, 0,
+                                           &cached_accept_state,
+                                           &cached_accept_id)
+                           == MO_HALT_MATCHING) {
+                    return MO_HALT_MATCHING;
+                }
+                continue;
+            }
+
+            if (interesting & s & SHENG_STATE_ACCEL) {
+                DEBUG_PRINTF("skipping\n");
+                const struct sstate_aux *aux = get_aux(sh, s);
+                assert(aux->accel);
+                const union AccelAux *aaux = (const void *)
+                    ((const char *)sh + aux->accel - sizeof(struct NFA));
+                const u8 *c2 = run_accel(aaux, c, c_end);
+
+                if (c2 < min_accel_offset + BAD_ACCEL_DIST) {
+                    min_accel_offset = c2 + BIG_ACCEL_PENALTY;
+                } else {
+                    min_accel_offset = c2 + SMALL_ACCEL_PENALTY;
+                }
+
+                if (min_accel_offset >= c_end - ACCEL_MIN_LEN) {
+                    min_accel_offset = c_end;
+                }
+
+                DEBUG_PRINTF("advanced %zd, next accel chance in %zd/%zd\n",
+                             c2 - c, min_accel_offset - c2, c_end - c2);
+
+                c = c2;
+                break;
+            }
+        }
+    }
+
+    s = (u8)movd(cur);
+
+done:
+    *state = s;
+    if (mode == STOP_AT_MATCH) {
+        *c_final = c_end;
+    }
+    return MO_CONTINUE_MATCHING;
+}
+
+static never_inline
+char shengExec_i_cb(const struct sheng *sh, u8 *state, const u8 *buf,
+                    size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                    char single, const u8 **final_point) {
+    return shengExec_i(sh, state, buf, len, offAdj, cb, ctxt, single,
+                       final_point, CALLBACK_OUTPUT);
+}
+
+static never_inline
+char shengExec_i_sam(const struct sheng *sh, u8 *state, const u8 *buf,
+                     size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                     char single, const u8 **final_point) {
+    return shengExec_i(sh, state, buf, len, offAdj, cb, ctxt, single,
+                       final_point, STOP_AT_MATCH);
+}
+
+static never_inline
+char shengExec_i_nm(const struct sheng *sh, u8 *state, const u8 *buf,
+                    size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                    char single, const u8 **final_point) {
+    return shengExec_i(sh, state, buf, len, offAdj, cb, ctxt, single,
+                       final_point, NO_MATCHES);
+}
+
+static really_inline
+char shengExec_i_ni(const struct sheng *sh, u8 *state, const u8 *buf,
+                    size_t len, u64a offAdj, NfaCallback cb, void *ctxt,
+                    char single, const u8 **final_point, enum MatchMode mode) {
+    if (mode == CALLBACK_OUTPUT) {
+        return shengExec_i_cb(sh, state, buf, len, offAdj, cb, ctxt, single,
+                              final_point);
+    } else if (mode == STOP_AT_MATCH) {
+        return shengExec_i_sam(sh, state, buf, len, offAdj, cb, ctxt, single,
+                               final_point);
+    } else {
+        assert(mode == NO_MATCHES);
+        return shengExec_i_nm(sh, state, buf, len, offAdj, cb, ctxt, single,
+                              final_point);
+    }
+}
+
+static really_inline
+char shengReportCurrent(const struct sheng *sh, u8 s, u64a loc,
+                        NfaCallback cb, void *ctxt) {
+    if (sh->flags & SHENG_FLAG_SINGLE_REPORT) {
+        DEBUG_PRINTF("reporting %u\n", sh->report);
+        return cb(loc, sh->report, ctxt);
+    }
+
+    u32 cached_accept_id = 0;
+    u8 cached_accept_state = 0;
+    return doComplexReport(cb, ctxt, sh, s, loc, 0, &cached_accept_state,
+                           &cached_accept_id);
+}
+
+static really_inline
+char nfaExecSheng0_Q2i(const struct NFA *n, u64a offset, const u8 *buffer,
+                       const u8 *hend, NfaCallback cb, void *context,
+                       struct mq *q, char single, s64a end,
+                       enum MatchMode mode) {
+    assert(n->type == SHENG_NFA_0);
+    const struct sheng *sh = getSheng(n);
+    s64a sp;
+
+    u8 s = *(u8 *)q->state;
+
+    if (q->report_current) {
+        assert(s & SHENG_STATE_ACCEPT);
+
+        int rv = shengReportCurrent(sh, s, q_cur_offset(q), cb, context);
+
+        q->report_current = 0;
+
+        if (rv == MO_HALT_MATCHING) {
+            return MO_HALT_MATCHING;
+        }
+    }
+
+    sp = q_cur_loc(q);
+    q->cur++;
+
+    const u8 *cur_buf = sp < 0 ? hend : buffer;
+
+    char report = 1;
+    if (mode == CALLBACK_OUTPUT) {
+        /* we are starting inside the history buffer: matches are suppressed */
+        report = !(sp < 0);
+    }
+
+    if (mode != NO_MATCHES && q->items[q->cur - 1].location > end) {
+        DEBUG_PRINTF("this is as far as we go\n");
+        q->cur--;
+        q->items[q->cur].type = MQE_START;
+        q->items[q->cur].location = end;
+        *(u8 *)q->state = s;
+        return MO_ALIVE;
+    }
+
+    while (1) {
+        DEBUG_PRINTF("%s @ %llu\n", q->items[q->cur].type == MQE_TOP ? "TOP" :
+                     q->items[q->cur].type == MQE_END ? "END" : "???",
+                     q->items[q->cur].location + offset);
+        assert(q->cur < q->end);
+        s64a ep = q->items[q->cur].location;
+        if (mode != NO_MATCHES) {
+            ep = MIN(ep, end);
+        }
+
+        assert(ep >= sp);
+
+        s64a local_ep = ep;
+        if (sp < 0) {
+            local_ep = MIN(0, ep);
+        }
+
+        const u8 *final_look;
+        if (shengExec_i_ni(sh, &s, cur_buf + sp, local_ep - sp, offset + sp,
+                           cb, context, single, &final_look,
+                           report ? mode : NO_MATCHES)
+            == MO_HALT_MATCHING) {
+            *(u8 *)q->state = SHENG_STATE_DEAD;
+            return 0;
+        }
+        if (mode == STOP_AT_MATCH && final_look != cur_buf + local_ep) {
+            /* found a match */
+            DEBUG_PRINTF("found a match\n");
+            assert(q->cur);
+            q->cur--;
+            q->items[q->cur].type = MQE_START;
+            q->items[q->cur].location = final_look - cur_buf + 1; /* due to
+                                                                   * early -1 */
+            *(u8 *)q->state = s;
+            return MO_MATCHES_PENDING;
+        }
+
+        assert(q->cur);
+        if (mode != NO_MATCHES && q->items[q->cur].location > end) {
+            DEBUG_PRINTF("this is as far as we go\n");
+            assert(q->cur);
+            q->cur--;
+            q->items[q->cur].type = MQE_START;
+            q->items[q->cur].location = end;
+            *(u8 *)q->state = s;
+            return MO_ALIVE;
+        }
+
+        sp = local_ep;
+
+        if (sp == 0) {
+            cur_buf = buffer;
+            report = 1;
+        }
+
+        if (sp != ep) {
+            continue;
+        }
+
+        switch (q->items[q->cur].type) {
+        case MQE_TOP:
+            assert(sp + offset || shengIsDead(s));
+            if (sp + offset == 0) {
+                s = sh->anchored;
+                break;
+            }
+            DEBUG_PRINTF("enabling starts %hhx->%hhx\n", s,
+                         get_aux(sh, s)->top);
+            s = get_aux(sh, s)->top;
+            break;
+        case MQE_END:
+            *(u8 *)q->state = s;
+            q->cur++;
+            return shengIsDead(s) ? 0 : MO_ALIVE;
+        default:
+            assert(!"invalid queue event");
+        }
+
+        q->cur++;
+    }
+}
+
+char nfaExecSheng0_Q(const struct NFA *n, struct mq *q, s64a end) {
+    const struct sheng *sh = getSheng(n);
+    const u8 *hend = q->history + q->hlength;
+
+    return nfaExecSheng0_Q2i(n, q->offset, q->buffer, hend, q->cb, q->context,
+                             q, sh->flags & SHENG_FLAG_SINGLE_REPORT, end,
+                             CALLBACK_OUTPUT);
+}
+
+char nfaExecSheng0_Q2(const struct NFA *n, struct mq *q, s64a end) {
+    const struct sheng *sh = getSheng(n);
+    const u8 *hend = q->history + q->hlength;
+
+    return nfaExecSheng0_Q2i(n, q->offset, q->buffer, hend, q->cb, q->context,
+                             q, sh->flags & SHENG_FLAG_SINGLE_REPORT, end,
+                             STOP_AT_MATCH);
+}
+
+char nfaExecSheng0_QR(const struct NFA *n, struct mq *q, ReportID report) {
+    const struct sheng *sh = getSheng(n);
+    const u8 *hend = q->history + q->hlength;
+
+    char rv = nfaExecSheng0_Q2i(n, q->offset, q->buffer, hend, q->cb,
+                                q->context, q,
+                                sh->flags & SHENG_FLAG_SINGLE_REPORT,
+                                0 /* end */, NO_MATCHES);
+    if (rv && nfaExecSheng0_inAccept(n, report, q)) {
+        return MO_MATCHES_PENDING;
+    } else {
+        return rv;
+    }
+}
+
+char nfaExecSheng0_reportCurrent(const struct NFA *n, struct mq *q) {
+    const struct sheng *sh = getSheng(n);
+    u8 s = *(u8 *)q->state;
+    assert(q_cur_type(q) == MQE_START);
+    assert(!shengIsDead(s));
+
+    if (s & SHENG_STATE_ACCEPT) {
+        shengReportCurrent(sh, s, q_cur_offset(q), q->cb, q->context);
+    }
+
+    return 0;
+}
+
+char nfaExecSheng0_inAccept(const struct NFA *n, ReportID report,
+                            struct mq *q) {
+    assert(n && q);
+
+    const struct sheng *sh = getSheng(n);
+    u8 s = *(u8 *)q->state;
+    DEBUG_PRINTF("checking accepts for %hhx\n", s);
+    if (!(s & SHENG_STATE_ACCEPT)) {
+        return 0;
+    }
+
+    const struct report_list *rl = get_rl(sh, get_aux(sh, s)->accept);
+    DEBUG_PRINTF("report list has %u entries\n", rl->count);
+
+    for (u32 i = 0; i < rl->count; i++) {
+        if (rl->report[i] == report) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+char nfaExecSheng0_testEOD(const struct NFA *nfa, const char *state,
+                           UNUSED const char *streamState, u64a offset,
+                           NfaCallback callback, UNUSED SomNfaCallback som_cb,
+                           void *context) {
+    const struct sheng *sh = getSheng(nfa);
+    u8 s = *(const u8 *)state;
+
+    if (!get_aux(sh, s)->accept_eod) {
+        return MO_CONTINUE_MATCHING;
+    }
+
+    return doComplexReport(callback, context, sh, s, offset, 1, NULL, NULL);
+}
+
+char nfaExecSheng0_queueInitState(UNUSED const struct NFA *nfa,
+                                 struct mq *q) {
+    assert(nfa->scratchStateSize == 1);
+    *(u8 *)q->state = SHENG_STATE_DEAD;
+    return 0;
+}
+
+char nfaExecSheng0_initCompressedState(const struct NFA *nfa, u64a offset,
+                                       void *state, UNUSED u8 key) {
+    const struct sheng *sh = getSheng(nfa);
+    u8 s = offset ? sh->floating : sh->anchored;
+    if (shengIsDead(s)) {
+        return 0;
+    }
+
+    *(u8 *)state = s;
+    return 1;
+}
+
+char nfaExecSheng0_queueCompressState(UNUSED const struct NFA *nfa,
+                                      const struct mq *q, UNUSED s64a loc) {
+    assert(nfa->scratchStateSize == 1);
+    assert(nfa->streamStateSize == 1);
+    *(u8 *)q->streamState = *(const u8 *)q->state;
+    return 0;
+}
+
+char nfaExecSheng0_expandState(UNUSED const struct NFA *nfa, void *dest,
+                               const void *src, UNUSED u64a offset,
+                               UNUSED u8 key) {
+    assert(nfa->scratchStateSize == 1);
+    assert(nfa->streamStateSize == 1);
+    *(u8 *)dest = *(const u8 *)src;
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SHENG_INTERNAL_H_
+#define SHENG_INTERNAL_H_
+
+#include "ue2common.h"
+#include "util/simd_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** \brief Maximum number of states (including the dead state) in a Sheng. */
+#define SHENG_MAX_STATES 16
+
+/* A Sheng state is a byte: the low four bits are the state index, and the
+ * bits above carry flags so that the runtime can tell whether anything needs
+ * doing without consulting the aux structures. The top bit must stay clear:
+ * pshufb zeroes lanes whose index has it set. The dead state is always index
+ * zero, so its encoding is simply SHENG_STATE_DEAD. */
+#define SHENG_STATE_ACCEPT 0x10
+#define SHENG_STATE_DEAD 0x20
+#define SHENG_STATE_ACCEL 0x40
+#define SHENG_STATE_MASK 0xF
+#define SHENG_STATE_FLAG_MASK 0x70
+
+#define SHENG_FLAG_SINGLE_REPORT 0x1
+#define SHENG_FLAG_HAS_ACCEL 0x2
+
+struct sstate_aux {
+    u32 accept; /**< report list offset from start of NFA; 0 if none */
+    u32 accept_eod; /**< as above, for EOD reports */
+    u32 accel; /**< AccelAux offset from start of NFA; 0 if none */
+    u8 top; /**< state (with flags) entered on a top */
+};
+
+struct sheng {
+    /** \brief For each input byte, the successor of every state: byte i of
+     * shuffle_masks[c] is the successor of state i on c. */
+    m128 shuffle_masks[256];
+    u32 length; /**< length of the engine in bytes, including the NFA header */
+    u32 aux_offset; /**< offset of the sstate_aux array from start of NFA */
+    u8 n_states; /**< number of states, including the dead state */
+    u8 anchored; /**< anchored start state (with flags) */
+    u8 floating; /**< floating start state (with flags) */
+    u8 flags;
+    ReportID report; /**< the only report raised, if SHENG_FLAG_SINGLE_REPORT */
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHENG_INTERNAL_H_ */
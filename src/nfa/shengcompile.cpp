@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "shengcompile.h"
+
+#include "accel.h"
+#include "grey.h"
+#include "mcclellan_internal.h"
+#include "mcclellancompile.h"
+#include "mcclellancompile_accel.h"
+#include "nfa_internal.h"
+#include "sheng_internal.h"
+#include "ue2common.h"
+#include "util/alloc.h"
+#include "util/compile_context.h"
+#include "util/compile_report.h"
+#include "util/container.h"
+#include "util/verify_types.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+namespace ue2 {
+
+/** \brief Returns the encoded (index plus flags) form of raw state \a i. */
+static
+u8 encodeState(const raw_dfa &raw, dstate_id_t i,
+               const map<dstate_id_t, AccelScheme> &accel_escape_info) {
+    assert(i < SHENG_MAX_STATES);
+    u8 s = verify_u8(i);
+    if (i == DEAD_STATE) {
+        return s | SHENG_STATE_DEAD;
+    }
+    if (!raw.states[i].reports.empty()) {
+        s |= SHENG_STATE_ACCEPT;
+    }
+    if (contains(accel_escape_info, i)) {
+        s |= SHENG_STATE_ACCEL;
+    }
+    return s;
+}
+
+static
+void fillShuffleMasks(const raw_dfa &raw, const vector<u8> &encoded,
+                      sheng *sh) {
+    for (u32 c = 0; c < N_CHARS; c++) {
+        u8 *mask = (u8 *)&sh->shuffle_masks[c];
+        /* unused lanes lead to the dead state */
+        fill(mask, mask + SHENG_MAX_STATES, encoded[DEAD_STATE]);
+        for (size_t i = 0; i < raw.states.size(); i++) {
+            dstate_id_t next = raw.states[i].next[raw.alpha_remap[c]];
+            mask[i] = encoded[next];
+        }
+    }
+}
+
+aligned_unique_ptr<NFA> shengCompile(raw_dfa &raw, const CompileContext &cc,
+                                     const ReportManager &rm) {
+    if (!cc.grey.allowSheng) {
+        DEBUG_PRINTF("sheng is disabled\n");
+        return nullptr;
+    }
+
+    if (raw.states.size() > SHENG_MAX_STATES) {
+        DEBUG_PRINTF("too many states for sheng: %zu\n", raw.states.size());
+        return nullptr;
+    }
+
+    CompilePhase phase("sheng_compile");
+
+    if (!cc.streaming) {
+        raw.stripExtraEodReports();
+    }
+
+    mcclellan_build_strat strat(raw, rm);
+
+    vector<u32> reports;
+    vector<u32> reports_eod;
+    ReportID arb;
+    u8 single;
+
+    auto ri = strat.gatherReports(reports, reports_eod, &single, &arb);
+    map<dstate_id_t, AccelScheme> accel_escape_info
+        = populateAccelerationInfo(raw, strat, cc.grey);
+
+    size_t state_count = raw.states.size();
+    size_t aux_offset = ROUNDUP_16(sizeof(NFA) + sizeof(sheng));
+    size_t aux_size = sizeof(sstate_aux) * state_count;
+    size_t accel_size = strat.accelSize() * accel_escape_info.size();
+    size_t accel_offset = ROUNDUP_N(aux_offset + aux_size
+                                     + ri->getReportListSize(), 32);
+    size_t total_size = accel_offset + accel_size;
+
+    DEBUG_PRINTF("states %zu\n", state_count);
+    DEBUG_PRINTF("aux_offset %zu\n", aux_offset);
+    DEBUG_PRINTF("rl size %u\n", ri->getReportListSize());
+    DEBUG_PRINTF("accel_offset %zu\n", accel_offset);
+    DEBUG_PRINTF("total_size %zu\n", total_size);
+
+    assert(ISALIGNED_N(accel_offset, alignof(union AccelAux)));
+
+    aligned_unique_ptr<NFA> nfa = aligned_zmalloc_unique<NFA>(total_size);
+    sheng *sh = (sheng *)getMutableImplNfa(nfa.get());
+
+    nfa->type = SHENG_NFA_0;
+    nfa->length = verify_u32(total_size);
+    nfa->nPositions = verify_u32(state_count);
+    nfa->scratchStateSize = 1;
+    nfa->streamStateSize = 1;
+    if (raw.hasEodReports()) {
+        nfa->flags |= NFA_ACCEPTS_EOD;
+    }
+
+    vector<u8> encoded(state_count);
+    for (dstate_id_t i = 0; i < state_count; i++) {
+        encoded[i] = encodeState(raw, i, accel_escape_info);
+    }
+
+    sh->length = verify_u32(total_size);
+    sh->aux_offset = verify_u32(aux_offset);
+    sh->n_states = verify_u8(state_count);
+    sh->anchored = encoded[raw.start_anchored];
+    sh->floating = encoded[raw.start_floating];
+    sh->report = arb;
+    if (single) {
+        sh->flags |= SHENG_FLAG_SINGLE_REPORT;
+    }
+    if (!accel_escape_info.empty()) {
+        sh->flags |= SHENG_FLAG_HAS_ACCEL;
+    }
+
+    fillShuffleMasks(raw, encoded, sh);
+
+    vector<u32> reportOffsets;
+    ri->fillReportLists(nfa.get(), aux_offset + aux_size, reportOffsets);
+
+    sstate_aux *aux = (sstate_aux *)((char *)nfa.get() + aux_offset);
+    for (dstate_id_t i = 0; i < state_count; i++) {
+        const dstate &ds = raw.states[i];
+        aux[i].accept = ds.reports.empty() ? 0 : reportOffsets[reports[i]];
+        aux[i].accept_eod = ds.reports_eod.empty()
+                          ? 0 : reportOffsets[reports_eod[i]];
+        aux[i].top = encoded[i ? ds.next[raw.alpha_remap[TOP]]
+                               : raw.start_floating];
+
+        if (contains(accel_escape_info, i)) {
+            aux[i].accel = verify_u32(accel_offset);
+            strat.buildAccel(i, accel_escape_info.at(i),
+                             (char *)nfa.get() + accel_offset);
+            accel_offset += strat.accelSize();
+        }
+    }
+
+    assert(accel_offset <= total_size);
+
+    DEBUG_PRINTF("built sheng with %zu states\n", state_count);
+    return nfa;
+}
+
+bool has_accel_sheng(const NFA *nfa) {
+    const sheng *sh = (const sheng *)getImplNfa(nfa);
+    return sh->flags & SHENG_FLAG_HAS_ACCEL;
+}
+
+} // namespace ue2
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include "shengdump.h"
+
+#include "accel_dump.h"
+#include "mcclellandump.h"
+#include "nfa_dump_internal.h"
+#include "nfa_internal.h"
+#include "rdfa.h"
+#include "sheng_internal.h"
+#include "ue2common.h"
+
+#include <cstdio>
+
+#ifndef DUMP_SUPPORT
+#error No dump support!
+#endif
+
+using namespace std;
+
+namespace ue2 {
+
+static
+const sstate_aux *getShengAux(const NFA *n, u8 i) {
+    const sheng *sh = (const sheng *)getImplNfa(n);
+    assert(i < sh->n_states);
+    const sstate_aux *aux = (const sstate_aux *)((const char *)n
+                                                  + sh->aux_offset);
+    return aux + i;
+}
+
+static
+const AccelAux *getShengAccel(const NFA *n, const sstate_aux *aux) {
+    if (!aux->accel) {
+        return nullptr;
+    }
+    return (const AccelAux *)((const char *)n + aux->accel);
+}
+
+static
+void shengGetTransitions(const NFA *n, u8 s, u16 *t) {
+    const sheng *sh = (const sheng *)getImplNfa(n);
+    for (u32 c = 0; c < N_CHARS; c++) {
+        const u8 *mask = (const u8 *)&sh->shuffle_masks[c];
+        t[c] = mask[s] & SHENG_STATE_MASK;
+    }
+    t[TOP] = getShengAux(n, s)->top & SHENG_STATE_MASK;
+}
+
+static
+void describeNode(const NFA *n, const sheng *sh, u8 i, FILE *f) {
+    const sstate_aux *aux = getShengAux(n, i);
+
+    fprintf(f, "%u [ width = 1, fixedsize = true, fontsize = 12, "
+            "label = \"%u\" ]; \n", i, i);
+
+    if (const AccelAux *accel = getShengAccel(n, aux)) {
+        dumpAccelDot(f, i, accel);
+    }
+
+    if (aux->accept_eod) {
+        fprintf(f, "%u [ color = darkorchid ];\n", i);
+    }
+
+    if (aux->accept) {
+        fprintf(f, "%u [ shape = doublecircle ];\n", i);
+    }
+
+    u8 top = aux->top & SHENG_STATE_MASK;
+    if (top && top != i) {
+        fprintf(f, "%u -> %u [color = darkgoldenrod weight=0.1 ]\n", i, top);
+    }
+
+    if (i == (sh->anchored & SHENG_STATE_MASK)) {
+        fprintf(f, "STARTA -> %u [color = blue ]\n", i);
+    }
+
+    if (i == (sh->floating & SHENG_STATE_MASK)) {
+        fprintf(f, "STARTF -> %u [color = red ]\n", i);
+    }
+}
+
+void nfaExecSheng0_dumpDot(const NFA *nfa, FILE *f) {
+    assert(nfa->type == SHENG_NFA_0);
+    const sheng *sh = (const sheng *)getImplNfa(nfa);
+
+    dumpDotPreambleDfa(f);
+
+    for (u8 i = 1; i < sh->n_states; i++) {
+        describeNode(nfa, sh, i, f);
+
+        u16 t[ALPHABET_SIZE];
+        shengGetTransitions(nfa, i, t);
+        describeEdge(f, t, i);
+    }
+
+    fprintf(f, "}\n");
+}
+
+static
+void dumpTransitions(FILE *f, const NFA *nfa, const sheng *sh) {
+    for (u8 i = 0; i < sh->n_states; i++) {
+        fprintf(f, "%02hhu", i);
+        if (const AccelAux *accel = getShengAccel(nfa, getShengAux(nfa, i))) {
+            dumpAccelText(f, accel);
+        }
+
+        u16 trans[ALPHABET_SIZE];
+        shengGetTransitions(nfa, i, trans);
+
+        int rstart = 0;
+        u16 prev = 0xffff;
+        for (int j = 0; j < N_CHARS; j++) {
+            u16 curr = trans[j];
+            if (curr == prev) {
+                continue;
+            }
+
+            if (prev != 0xffff) {
+                if (j == rstart + 1) {
+                    fprintf(f, " %02x->%hu", rstart, prev);
+                } else {
+                    fprintf(f, " [%02x - %02x]->%hu", rstart, j - 1, prev);
+                }
+            }
+
+            prev = curr;
+            rstart = j;
+        }
+        if (N_CHARS == rstart + 1) {
+            fprintf(f, " %02x->%hu", rstart, prev);
+        } else {
+            fprintf(f, " [%02x - %02x]->%hu", rstart, N_CHARS - 1, prev);
+        }
+        fprintf(f, "\n");
+    }
+}
+
+static
+void dumpAccelMasks(FILE *f, const NFA *nfa, const sheng *sh) {
+    fprintf(f, "\n");
+    fprintf(f, "Acceleration\n");
+    fprintf(f, "------------\n");
+
+    for (u8 i = 0; i < sh->n_states; i++) {
+        const AccelAux *accel = getShengAccel(nfa, getShengAux(nfa, i));
+        if (!accel) {
+            continue;
+        }
+
+        fprintf(f, "%02hhu ", i);
+        dumpAccelInfo(f, *accel);
+    }
+}
+
+void nfaExecSheng0_dumpText(const NFA *nfa, FILE *f) {
+    assert(nfa->type == SHENG_NFA_0);
+    const sheng *sh = (const sheng *)getImplNfa(nfa);
+
+    fprintf(f, "sheng\n");
+    fprintf(f, "report: %u, states: %u, length: %u\n", sh->report,
+            sh->n_states, sh->length);
+    fprintf(f, "astart: %u, fstart: %u\n", sh->anchored & SHENG_STATE_MASK,
+            sh->floating & SHENG_STATE_MASK);
+    fprintf(f, "single accept: %d, has_accel: %d\n",
+            !!(sh->flags & SHENG_FLAG_SINGLE_REPORT),
+            !!(sh->flags & SHENG_FLAG_HAS_ACCEL));
+    fprintf(f, "\n");
+
+    dumpTransitions(f, nfa, sh);
+    dumpAccelMasks(f, nfa, sh);
+
+    fprintf(f, "\n");
+    dumpTextReverse(nfa, f);
+}
+
+} // namespace ue2
@@ -37,6 +37,7 @@
 #include "util/simd_utils.h"
 #include "util/unaligned.h"
 
+#include "vermicelli_avx.h"
 #include "vermicelli_sse.h"
 
 static really_inline
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2015-2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Vermicelli: Intel AVX2 and AVX-512 implementation of the aligned
+ * loops.
+ *
+ * The aligned search routines in vermicelli_sse.h hand long buffers to the
+ * routines here, which walk 16 bytes at a time up to a 32-byte (AVX2) or
+ * 64-byte (AVX-512) boundary and then scan a full vector per iteration. Each
+ * takes its buffer bound by reference and advances it past the bytes it has
+ * scanned, returning NULL if nothing was found so that the 16-byte loops can
+ * finish off the tail.
+ *
+ * Case and mask handling is expressed with AND masks throughout; callers pass
+ * all-ones masks for the exact-case variants.
+ *
+ * (users should include vermicelli.h)
+ */
+
+#if defined(__AVX512BW__)
+
+#define VERM_WIDE_BOUNDARY 64
+#define VERM_WIDE_TYPE __m512i
+
+static really_inline
+__m512i vermWideSet(m128 a) {
+    return _mm512_broadcast_i32x4(a);
+}
+
+static really_inline
+__m512i vermWideLoad(const u8 *ptr) {
+    assert(ISALIGNED_N(ptr, 64));
+    return _mm512_load_si512((const void *)ptr);
+}
+
+static really_inline
+__m512i vermWideAnd(__m512i a, __m512i b) {
+    return _mm512_and_si512(a, b);
+}
+
+static really_inline
+u64a vermWideEqMask(__m512i a, __m512i b) {
+    return _mm512_cmpeq_epi8_mask(a, b);
+}
+
+#elif defined(__AVX2__)
+
+#define VERM_WIDE_BOUNDARY 32
+#define VERM_WIDE_TYPE m256
+
+static really_inline
+m256 vermWideSet(m128 a) {
+    return set2x128(a);
+}
+
+static really_inline
+m256 vermWideLoad(const u8 *ptr) {
+    return load256(ptr);
+}
+
+static really_inline
+m256 vermWideAnd(m256 a, m256 b) {
+    return and256(a, b);
+}
+
+static really_inline
+u64a vermWideEqMask(m256 a, m256 b) {
+    return movemask256(eq256(a, b));
+}
+
+#endif
+
+#if defined(VERM_WIDE_BOUNDARY)
+
+/** \brief All bits set for one match mask of VERM_WIDE_BOUNDARY bytes. */
+#define VERM_WIDE_ALL (~0ULL >> (64 - VERM_WIDE_BOUNDARY))
+
+/* Buffers shorter than this are left to the 16-byte loops, as walking up to
+ * the wide boundary would eat most of them anyway. */
+#define VERM_WIDE_MIN_LEN (2 * VERM_WIDE_BOUNDARY + 1)
+
+static really_inline
+u64a vermEqMask128(m128 a, m128 b) {
+    return movemask128(eq128(a, b));
+}
+
+/** \brief Pointer to the byte for the highest bit set in \a z, where \a z is
+ * the match mask for the \a width bytes ending at \a block_end. */
+static really_inline
+const u8 *lastMatchOffsetWide(const u8 *block_end, u64a z, u32 width) {
+    assert(z);
+    return block_end - width + 63 - clz64(z);
+}
+
+static really_inline
+const u8 *vermSearchAlignedWide(m128 chars, m128 casemask, const u8 **buf_io,
+                                const u8 *buf_end, char negate) {
+    const u8 *buf = *buf_io;
+    assert((size_t)buf % 16 == 0);
+    if (buf_end - buf < VERM_WIDE_MIN_LEN) {
+        return NULL;
+    }
+
+    for (; !ISALIGNED_N(buf, VERM_WIDE_BOUNDARY); buf += 16) {
+        m128 data = load128(buf);
+        u64a z = vermEqMask128(chars, and128(casemask, data));
+        if (negate) {
+            z = ~z & 0xffff;
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+
+    VERM_WIDE_TYPE wchars = vermWideSet(chars);
+    VERM_WIDE_TYPE wcasemask = vermWideSet(casemask);
+    for (; buf + VERM_WIDE_BOUNDARY - 1 < buf_end;
+         buf += VERM_WIDE_BOUNDARY) {
+        VERM_WIDE_TYPE data = vermWideLoad(buf);
+        u64a z = vermWideEqMask(wchars, vermWideAnd(wcasemask, data));
+        if (negate) {
+            z = ~z & VERM_WIDE_ALL;
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+
+    *buf_io = buf;
+    return NULL;
+}
+
+static really_inline
+const u8 *dvermSearchAlignedWide(m128 chars1, m128 chars2, m128 mask1,
+                                 m128 mask2, u8 c1, u8 c2, u8 m1, u8 m2,
+                                 const u8 **buf_io, const u8 *buf_end) {
+    const u8 *buf = *buf_io;
+    assert((size_t)buf % 16 == 0);
+    if (buf_end - buf < VERM_WIDE_MIN_LEN) {
+        return NULL;
+    }
+
+    for (; !ISALIGNED_N(buf, VERM_WIDE_BOUNDARY); buf += 16) {
+        m128 data = load128(buf);
+        u64a z = vermEqMask128(chars1, and128(data, mask1))
+               & (vermEqMask128(chars2, and128(data, mask2)) >> 1);
+        if ((buf[15] & m1) == c1 && (buf[16] & m2) == c2) {
+            z |= (1 << 15);
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+
+    VERM_WIDE_TYPE wchars1 = vermWideSet(chars1);
+    VERM_WIDE_TYPE wchars2 = vermWideSet(chars2);
+    VERM_WIDE_TYPE wmask1 = vermWideSet(mask1);
+    VERM_WIDE_TYPE wmask2 = vermWideSet(mask2);
+    for (; buf + VERM_WIDE_BOUNDARY < buf_end; buf += VERM_WIDE_BOUNDARY) {
+        VERM_WIDE_TYPE data = vermWideLoad(buf);
+        u64a z = vermWideEqMask(wchars1, vermWideAnd(data, wmask1))
+               & (vermWideEqMask(wchars2, vermWideAnd(data, wmask2)) >> 1);
+        if ((buf[VERM_WIDE_BOUNDARY - 1] & m1) == c1
+            && (buf[VERM_WIDE_BOUNDARY] & m2) == c2) {
+            z |= 1ULL << (VERM_WIDE_BOUNDARY - 1);
+        }
+        if (unlikely(z)) {
+            return buf + ctz64(z);
+        }
+    }
+
+    *buf_io = buf;
+    return NULL;
+}
+
+static really_inline
+const u8 *rvermSearchAlignedWide(m128 chars, m128 casemask, const u8 *buf,
+                                 const u8 **buf_end_io, char negate) {
+    const u8 *buf_end = *buf_end_io;
+    assert((size_t)buf_end % 16 == 0);
+    if (buf_end - buf < VERM_WIDE_MIN_LEN) {
+        return NULL;
+    }
+
+    for (; !ISALIGNED_N(buf_end, VERM_WIDE_BOUNDARY); buf_end -= 16) {
+        m128 data = load128(buf_end - 16);
+        u64a z = vermEqMask128(chars, and128(casemask, data));
+        if (negate) {
+            z = ~z & 0xffff;
+        }
+        if (unlikely(z)) {
+            return lastMatchOffsetWide(buf_end, z, 16);
+        }
+    }
+
+    VERM_WIDE_TYPE wchars = vermWideSet(chars);
+    VERM_WIDE_TYPE wcasemask = vermWideSet(casemask);
+    for (; buf + VERM_WIDE_BOUNDARY - 1 < buf_end;
+         buf_end -= VERM_WIDE_BOUNDARY) {
+        VERM_WIDE_TYPE data = vermWideLoad(buf_end - VERM_WIDE_BOUNDARY);
+        u64a z = vermWideEqMask(wchars, vermWideAnd(wcasemask, data));
+        if (negate) {
+            z = ~z & VERM_WIDE_ALL;
+        }
+        if (unlikely(z)) {
+            return lastMatchOffsetWide(buf_end, z, VERM_WIDE_BOUNDARY);
+        }
+    }
+
+    *buf_end_io = buf_end;
+    return NULL;
+}
+
+static really_inline
+const u8 *rdvermSearchAlignedWide(m128 chars1, m128 chars2, m128 casemask,
+                                  u8 c1, u8 c2, u8 m, const u8 *buf,
+                                  const u8 **buf_end_io) {
+    const u8 *buf_end = *buf_end_io;
+    assert((size_t)buf_end % 16 == 0);
+    if (buf_end - buf < VERM_WIDE_MIN_LEN) {
+        return NULL;
+    }
+
+    for (; !ISALIGNED_N(buf_end, VERM_WIDE_BOUNDARY); buf_end -= 16) {
+        m128 v = and128(casemask, load128(buf_end - 16));
+        u64a z = vermEqMask128(chars2, v)
+               & (vermEqMask128(chars1, v) << 1) & 0xffff;
+        if ((buf_end[-17] & m) == c1 && (buf_end[-16] & m) == c2) {
+            z |= 1;
+        }
+        if (unlikely(z)) {
+            return lastMatchOffsetWide(buf_end, z, 16);
+        }
+    }
+
+    VERM_WIDE_TYPE wchars1 = vermWideSet(chars1);
+    VERM_WIDE_TYPE wchars2 = vermWideSet(chars2);
+    VERM_WIDE_TYPE wcasemask = vermWideSet(casemask);
+    for (; buf + VERM_WIDE_BOUNDARY < buf_end;
+         buf_end -= VERM_WIDE_BOUNDARY) {
+        VERM_WIDE_TYPE v = vermWideAnd(wcasemask,
+                                       vermWideLoad(buf_end -
+                                                    VERM_WIDE_BOUNDARY));
+        u64a z = vermWideEqMask(wchars2, v)
+               & (vermWideEqMask(wchars1, v) << 1) & VERM_WIDE_ALL;
+        if ((buf_end[-VERM_WIDE_BOUNDARY - 1] & m) == c1
+            && (buf_end[-VERM_WIDE_BOUNDARY] & m) == c2) {
+            z |= 1;
+        }
+        if (unlikely(z)) {
+            return lastMatchOffsetWide(buf_end, z, VERM_WIDE_BOUNDARY);
+        }
+    }
+
+    *buf_end_io = buf_end;
+    return NULL;
+}
+
+#endif // VERM_WIDE_BOUNDARY
@@ -29,6 +29,9 @@
 /** \file
  * \brief Vermicelli: Intel SSE implementation.
  *
+ * On AVX2 and AVX-512 builds the aligned loops pass long buffers to the wider
+ * implementations in vermicelli_avx.h first.
+ *
  * (users should include vermicelli.h)
  */
 
@@ -40,6 +43,13 @@ static really_inline
 const u8 *vermSearchAligned(m128 chars, const u8 *buf, const u8 *buf_end,
                             char negate) {
     assert((size_t)buf % 16 == 0);
+#if defined(VERM_WIDE_BOUNDARY)
+    const u8 *ptr = vermSearchAlignedWide(chars, ones128(), &buf, buf_end,
+                                          negate);
+    if (ptr) {
+        return ptr;
+    }
+#endif
     for (; buf + 31 < buf_end; buf += 32) {
         m128 data = load128(buf);
         u32 z1 = movemask128(eq128(chars, data));
@@ -73,6 +83,13 @@ const u8 *vermSearchAlignedNocase(m128 chars, const u8 *buf,
                                   const u8 *buf_end, char negate) {
     assert((size_t)buf % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
+#if defined(VERM_WIDE_BOUNDARY)
+    const u8 *ptr = vermSearchAlignedWide(chars, casemask, &buf, buf_end,
+                                          negate);
+    if (ptr) {
+        return ptr;
+    }
+#endif
 
     for (; buf + 31 < buf_end; buf += 32) {
         m128 data = load128(buf);
@@ -135,6 +152,16 @@ const u8 *vermUnalignNocase(m128 chars, const u8 *buf, char negate) {
 static really_inline
 const u8 *dvermSearchAligned(m128 chars1, m128 chars2, u8 c1, u8 c2,
                              const u8 *buf, const u8 *buf_end) {
+    assert((size_t)buf % 16 == 0);
+#if defined(VERM_WIDE_BOUNDARY)
+    const u8 *ptr = dvermSearchAlignedWide(chars1, chars2, ones128(),
+                                           ones128(), c1, c2, 0xff, 0xff,
+                                           &buf, buf_end);
+    if (ptr) {
+        return ptr;
+    }
+#endif
+
     for (; buf + 16 < buf_end; buf += 16) {
         m128 data = load128(buf);
         u32 z = movemask128(and128(eq128(chars1, data),
@@ -156,6 +183,14 @@ const u8 *dvermSearchAlignedNocase(m128 chars1, m128 chars2, u8 c1, u8 c2,
                                    const u8 *buf, const u8 *buf_end) {
     assert((size_t)buf % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
+#if defined(VERM_WIDE_BOUNDARY)
+    const u8 *ptr = dvermSearchAlignedWide(chars1, chars2, casemask,
+                                           casemask, c1, c2, CASE_CLEAR,
+                                           CASE_CLEAR, &buf, buf_end);
+    if (ptr) {
+        return ptr;
+    }
+#endif
 
     for (; buf + 16 < buf_end; buf += 16) {
         m128 data = load128(buf);
@@ -179,6 +214,13 @@ const u8 *dvermSearchAlignedMasked(m128 chars1, m128 chars2,
                                    m128 mask1, m128 mask2, u8 c1, u8 c2, u8 m1,
                                    u8 m2, const u8 *buf, const u8 *buf_end) {
     assert((size_t)buf % 16 == 0);
+#if defined(VERM_WIDE_BOUNDARY)
+    const u8 *ptr = dvermSearchAlignedWide(chars1, chars2, mask1, mask2, c1,
+                                           c2, m1, m2, &buf, buf_end);
+    if (ptr) {
+        return ptr;
+    }
+#endif
 
     for (; buf + 16 < buf_end; buf += 16) {
         m128 data = load128(buf);
@@ -255,6 +297,13 @@ static really_inline
 const u8 *rvermSearchAligned(m128 chars, const u8 *buf, const u8 *buf_end,
                              char negate) {
     assert((size_t)buf_end % 16 == 0);
+#if defined(VERM_WIDE_BOUNDARY)
+    const u8 *ptr = rvermSearchAlignedWide(chars, ones128(), buf, &buf_end,
+                                           negate);
+    if (ptr) {
+        return ptr;
+    }
+#endif
     for (; buf + 15 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
         u32 z = movemask128(eq128(chars, data));
@@ -273,6 +322,13 @@ const u8 *rvermSearchAlignedNocase(m128 chars, const u8 *buf,
                                    const u8 *buf_end, char negate) {
     assert((size_t)buf_end % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
+#if defined(VERM_WIDE_BOUNDARY)
+    const u8 *ptr = rvermSearchAlignedWide(chars, casemask, buf, &buf_end,
+                                           negate);
+    if (ptr) {
+        return ptr;
+    }
+#endif
 
     for (; buf + 15 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
@@ -320,6 +376,13 @@ static really_inline
 const u8 *rdvermSearchAligned(m128 chars1, m128 chars2, u8 c1, u8 c2,
                               const u8 *buf, const u8 *buf_end) {
     assert((size_t)buf_end % 16 == 0);
+#if defined(VERM_WIDE_BOUNDARY)
+    const u8 *ptr = rdvermSearchAlignedWide(chars1, chars2, ones128(), c1,
+                                            c2, 0xff, buf, &buf_end);
+    if (ptr) {
+        return ptr;
+    }
+#endif
 
     for (; buf + 16 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
@@ -340,6 +403,13 @@ const u8 *rdvermSearchAlignedNocase(m128 chars1, m128 chars2, u8 c1, u8 c2,
                                     const u8 *buf, const u8 *buf_end) {
     assert((size_t)buf_end % 16 == 0);
     m128 casemask = set16x8(CASE_CLEAR);
+#if defined(VERM_WIDE_BOUNDARY)
+    const u8 *ptr = rdvermSearchAlignedWide(chars1, chars2, casemask, c1,
+                                            c2, CASE_CLEAR, buf, &buf_end);
+    if (ptr) {
+        return ptr;
+    }
+#endif
 
     for (; buf + 16 < buf_end; buf_end -= 16) {
         m128 data = load128(buf_end - 16);
@@ -65,6 +65,7 @@
 #include "smallwrite/smallwrite_build.h"
 #include "rose/rose_build.h"
 #include "util/compile_error.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/depth.h"
 #include "util/graph_range.h"
@@ -101,6 +102,7 @@ static
 bool addComponentSom(NG &ng, NGHolder &g, const NGWrapper &w,
                      const som_type som, const u32 comp_id) {
     DEBUG_PRINTF("doing som\n");
+    CompilePhase phase("som");
     dumpComponent(g, "03_presom", w.expressionIndex, comp_id, ng.cc.grey);
     assert(hasCorrectlyNumberedVertices(g));
 
@@ -206,6 +208,7 @@ bool addComponent(NG &ng, NGHolder &g, const NGWrapper &w, const som_type som,
 
     dumpComponent(g, "01_begin", w.expressionIndex, comp_id, ng.cc.grey);
 
+    CompilePhase reduce_phase("reduce");
     reduceGraph(g, som, w.utf8, cc);
 
     dumpComponent(g, "02_reduced", w.expressionIndex, comp_id, ng.cc.grey);
@@ -214,6 +217,7 @@ bool addComponent(NG &ng, NGHolder &g, const NGWrapper &w, const som_type som,
     if (cc.grey.performGraphSimplification) {
         removeRegionRedundancy(g, som);
     }
+    reduce_phase.end();
 
     // "Short Exhaustible Passthrough" patterns always become outfixes.
     if (!som && isSEP(g, ng.rm, cc.grey)) {
@@ -321,6 +325,8 @@ bool processComponents(NG &ng, NGWrapper &w,
 }
 
 bool NG::addGraph(NGWrapper &w) {
+    CompilePhase phase("graph");
+
     // remove reports that aren't on vertices connected to accept.
     clearReports(w);
 
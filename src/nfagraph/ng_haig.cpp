@@ -40,6 +40,7 @@
 #include "ng_squash.h"
 #include "ng_util.h"
 #include "util/bitfield.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/determinise.h"
 #include "util/graph_range.h"
@@ -574,6 +575,7 @@ attemptToBuildHaig(const NGHolder &g, som_type som, u32 somPrecision,
     }
 
     DEBUG_PRINTF("attempting to build haig \n");
+    CompilePhase phase("haig_determinise");
     assert(allMatchStatesHaveReports(g));
     assert(hasCorrectlyNumberedVertices(g));
 
@@ -48,6 +48,7 @@
 #include "nfa/limex_limits.h"
 #include "nfa/nfa_internal.h"
 #include "util/compile_context.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/graph_range.h"
 #include "util/report_manager.h"
@@ -373,6 +374,7 @@ constructNFA(const NGHolder &h_in, const ReportManager *rm,
              const map<u32, vector<vector<CharReach>>> &triggers,
              bool compress_state, bool do_accel, bool impl_test_only, u32 hint,
              const CompileContext &cc) {
+    CompilePhase phase("limex_compile");
     if (!generates_callbacks(h_in)) {
         rm = nullptr;
     } else {
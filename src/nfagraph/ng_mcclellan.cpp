@@ -41,6 +41,7 @@
 #include "ng_util.h"
 #include "ue2common.h"
 #include "util/bitfield.h"
+#include "util/compile_report.h"
 #include "util/determinise.h"
 #include "util/graph_range.h"
 #include "util/make_unique.h"
@@ -529,6 +530,7 @@ unique_ptr<raw_dfa> buildMcClellan(const NGHolder &graph,
     auto unused = findUnusedStates(graph);
 
     DEBUG_PRINTF("attempting to build ?%d? mcclellan\n", (int)graph.kind);
+    CompilePhase phase("mcclellan_determinise");
     assert(allMatchStatesHaveReports(graph));
 
     bool prunable = grey.highlanderPruneDFA && generates_callbacks(graph);
@@ -44,6 +44,7 @@
 #include "nfa/limex_limits.h"
 #include "nfa/repeat_internal.h"
 #include "nfa/repeatcompile.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/dump_charclass.h"
 #include "util/graph_range.h"
@@ -2224,6 +2225,8 @@ void analyseRepeats(NGHolder &g, const ReportManager *rm,
         return;
     }
 
+    CompilePhase phase("repeat_analysis");
+
     // Quick sanity test.
     assert(allMatchStatesHaveReports(g));
 
@@ -49,6 +49,7 @@
 #include "ng_split.h"
 #include "ng_util.h"
 #include "ng_width.h"
+#include "nfa/limex_limits.h"
 #include "rose/rose_build.h"
 #include "rose/rose_build_util.h"
 #include "rose/rose_in_dump.h"
@@ -2364,7 +2365,7 @@ void tryNetflowCutForRHS(RoseInGraph &ig, const Grey &grey) {
         }
 
         DEBUG_PRINTF("%zu vertices\n", num_vertices(*ig[rhs].graph));
-        if (num_vertices(*ig[rhs].graph) < 512) {
+        if (num_vertices(*ig[rhs].graph) < NFA_MAX_STATES) {
             DEBUG_PRINTF("small\n");
             continue;
         }
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Parsing and storage of logical combinations of expressions.
+ */
+
+#include "logical_combination.h"
+#include "util/compile_error.h"
+
+#include <cctype>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace ue2 {
+
+/* Operator tokens used on the parse stack; '(' marks an open group. */
+static const char TOK_NOT = '!';
+static const char TOK_AND = '&';
+static const char TOK_OR = '|';
+static const char TOK_OPEN = '(';
+
+static
+u32 precedence(char tok) {
+    switch (tok) {
+    case TOK_NOT:
+        return 3;
+    case TOK_AND:
+        return 2;
+    case TOK_OR:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static
+u32 tokenToOp(char tok) {
+    switch (tok) {
+    case TOK_NOT:
+        return LOGICAL_OP_NOT;
+    case TOK_AND:
+        return LOGICAL_OP_AND;
+    default:
+        assert(tok == TOK_OR);
+        return LOGICAL_OP_OR;
+    }
+}
+
+static
+void throwSyntaxError(u32 index, size_t pos, const char *what) {
+    ostringstream oss;
+    oss << "Invalid logical combination: " << what << " at index " << pos
+        << ".";
+    throw CompileError(index, oss.str());
+}
+
+u32 ParsedLogical::getLogicalKey(ReportID id) const {
+    auto it = toLogicalKeyMap.find(id);
+    if (it == toLogicalKeyMap.end()) {
+        return INVALID_LKEY;
+    }
+    return it->second;
+}
+
+u32 ParsedLogical::getOrAssignLogicalKey(ReportID id, u32 index) {
+    auto it = toLogicalKeyMap.find(id);
+    if (it != toLogicalKeyMap.end()) {
+        return it->second;
+    }
+    u32 lkey = lkeyCount++;
+    toLogicalKeyMap.emplace(id, lkey);
+    subIdToIndex.emplace(id, index);
+    DEBUG_PRINTF("id %u -> lkey %u\n", id, lkey);
+    return lkey;
+}
+
+u32 ParsedLogical::addOp(u32 op, u32 lo, u32 ro) {
+    LogicalOp lop;
+    lop.id = lkeyCount++;
+    lop.op = op;
+    lop.lo = lo;
+    lop.ro = ro;
+    ops.push_back(lop);
+    DEBUG_PRINTF("op %u(%u, %u) -> lkey %u\n", op, lo, ro, lop.id);
+    return lop.id;
+}
+
+void ParsedLogical::applyOp(u32 op, vector<u32> &operands, u32 index) {
+    if (op == LOGICAL_OP_NOT) {
+        if (operands.empty()) {
+            throw CompileError(index, "Invalid logical combination: missing "
+                                      "operand.");
+        }
+        u32 lo = operands.back();
+        operands.back() = addOp(op, lo, INVALID_LKEY);
+        return;
+    }
+
+    if (operands.size() < 2) {
+        throw CompileError(index, "Invalid logical combination: missing "
+                                  "operand.");
+    }
+    u32 ro = operands.back();
+    operands.pop_back();
+    u32 lo = operands.back();
+    operands.back() = addOp(op, lo, ro);
+}
+
+void ParsedLogical::addCombination(u32 id, const char *expression,
+                                   bool highlander, u32 index) {
+    assert(expression);
+    DEBUG_PRINTF("id=%u, expr='%s'\n", id, expression);
+
+    // Operator precedence parse, kept iterative so that deeply nested
+    // expressions cannot exhaust the stack.
+    const size_t first_op = ops.size();
+    vector<u32> operands;
+    vector<char> stack;
+    bool want_operand = true;
+
+    for (size_t i = 0; expression[i];) {
+        const char c = expression[i];
+        if (isspace((unsigned char)c)) {
+            i++;
+            continue;
+        }
+
+        if (want_operand) {
+            if (isdigit((unsigned char)c)) {
+                u64a val = 0;
+                const size_t start = i;
+                for (; isdigit((unsigned char)expression[i]); i++) {
+                    val = val * 10 + (expression[i] - '0');
+                    if (val > ~0U) {
+                        throwSyntaxError(index, start, "match ID too large");
+                    }
+                }
+                operands.push_back(getOrAssignLogicalKey((ReportID)val,
+                                                         index));
+                want_operand = false;
+                continue;
+            } else if (c == TOK_NOT || c == TOK_OPEN) {
+                stack.push_back(c);
+                i++;
+                continue;
+            }
+            throwSyntaxError(index, i, "expected a match ID");
+        }
+
+        if (c == TOK_AND || c == TOK_OR) {
+            while (!stack.empty() && stack.back() != TOK_OPEN &&
+                   precedence(stack.back()) >= precedence(c)) {
+                applyOp(tokenToOp(stack.back()), operands, index);
+                stack.pop_back();
+            }
+            stack.push_back(c);
+            want_operand = true;
+        } else if (c == ')') {
+            while (!stack.empty() && stack.back() != TOK_OPEN) {
+                applyOp(tokenToOp(stack.back()), operands, index);
+                stack.pop_back();
+            }
+            if (stack.empty()) {
+                throwSyntaxError(index, i, "unmatched ')'");
+            }
+            stack.pop_back();
+        } else {
+            throwSyntaxError(index, i, "expected an operator");
+        }
+        i++;
+    }
+
+    if (want_operand) {
+        throw CompileError(index, "Invalid logical combination: unexpected "
+                                  "end of expression.");
+    }
+
+    while (!stack.empty()) {
+        if (stack.back() == TOK_OPEN) {
+            throw CompileError(index, "Invalid logical combination: missing "
+                                      "')'.");
+        }
+        applyOp(tokenToOp(stack.back()), operands, index);
+        stack.pop_back();
+    }
+
+    assert(operands.size() == 1);
+
+    CombInfo ci;
+    memset(&ci, 0, sizeof(ci));
+    ci.id = verify_u32(combs.size());
+    ci.result = operands.back();
+    ci.onmatch = id;
+    ci.highlander = highlander ? 1 : 0;
+    combs.push_back(ci);
+
+    // Find out whether this combination holds before anything has matched.
+    map<u32, bool> val;
+    for (size_t i = first_op; i < ops.size(); i++) {
+        const LogicalOp &op = ops[i];
+        bool lv = val[op.lo];
+        switch (op.op) {
+        case LOGICAL_OP_NOT:
+            val[op.id] = !lv;
+            break;
+        case LOGICAL_OP_AND:
+            val[op.id] = lv && val[op.ro];
+            break;
+        default:
+            assert(op.op == LOGICAL_OP_OR);
+            val[op.id] = lv || val[op.ro];
+            break;
+        }
+    }
+    if (val[ci.result]) {
+        DEBUG_PRINTF("combination %u holds on empty input\n", ci.id);
+        emptyComb = true;
+    }
+}
+
+} // namespace ue2
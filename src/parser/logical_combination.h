@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Parsing and storage of logical combinations of expressions.
+ */
+
+#ifndef LOGICAL_COMBINATION_H
+#define LOGICAL_COMBINATION_H
+
+#include "ue2common.h"
+#include "rose/rose_internal.h"
+#include "util/logical.h"
+#include "util/verify_types.h"
+
+#include <map>
+#include <vector>
+
+namespace ue2 {
+
+/**
+ * \brief Holds the logical combinations in a pattern set.
+ *
+ * Each sub-expression used by a combination is assigned a logical key
+ * (lkey), as is the result of each operation in the combinations' trees.
+ * Each combination is assigned a combination key (ckey).
+ */
+class ParsedLogical {
+public:
+    /**
+     * \brief Parse the logical combination \a expression and add it.
+     *
+     * Throws a CompileError, carrying \a index, if the expression is not
+     * well formed.
+     */
+    void addCombination(u32 id, const char *expression, bool highlander,
+                        u32 index);
+
+    /** \brief Logical key of the sub-expression with match ID \a id, or
+     * INVALID_LKEY if no combination uses it. */
+    u32 getLogicalKey(ReportID id) const;
+
+    /** \brief Mapping from each match ID used by a combination to the index
+     * of the first combination that uses it. */
+    const std::map<ReportID, u32> &subExpressionRefs() const {
+        return subIdToIndex;
+    }
+
+    /** \brief Operations of all combinations, operands first. */
+    const std::vector<LogicalOp> &logicalTree() const { return ops; }
+
+    /** \brief Combination table, indexed by ckey. */
+    const std::vector<CombInfo> &combInfoMap() const { return combs; }
+
+    /** \brief Total number of logical keys. */
+    u32 numLogicalKeys() const { return lkeyCount; }
+
+    /** \brief Total number of combination keys. */
+    u32 numCkeys() const { return verify_u32(combs.size()); }
+
+    /** \brief True if some combination holds before any of its
+     * sub-expressions has matched, and so may need to be reported at the end
+     * of data that produced no matches at all. */
+    bool hasEmptyCombination() const { return emptyComb; }
+
+private:
+    u32 getOrAssignLogicalKey(ReportID id, u32 index);
+    u32 addOp(u32 op, u32 lo, u32 ro);
+    void applyOp(u32 op, std::vector<u32> &operands, u32 index);
+
+    /** \brief Mapping from sub-expression match ID to logical key. */
+    std::map<ReportID, u32> toLogicalKeyMap;
+
+    /** \brief Mapping from sub-expression match ID to the index of the first
+     * combination that uses it. */
+    std::map<ReportID, u32> subIdToIndex;
+
+    std::vector<LogicalOp> ops;
+    std::vector<CombInfo> combs;
+    u32 lkeyCount = 0;
+    bool emptyComb = false;
+};
+
+} // namespace ue2
+
+#endif
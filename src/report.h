@@ -43,6 +43,8 @@
 #include "som/som_runtime.h"
 #include "util/exhaust.h"
 #include "util/fatbit.h"
+#include "util/logical.h"
+#include "util/multibit.h"
 
 enum DedupeResult {
     DEDUPE_CONTINUE, //!< Continue with match, not a dupe.
@@ -147,11 +149,9 @@ int roseDeliverReport(u64a offset, ReportID onmatch, s32 offset_adjust,
     DEBUG_PRINTF(">> reporting match @[%llu,%llu] for sig %u ctxt %p <<\n",
                  from_offset, to_offset, onmatch, ci->userContext);
 
-    int halt = ci->userCallback(onmatch, from_offset, to_offset, flags,
-                                ci->userContext);
+    int halt = deliverUserMatch(ci, onmatch, from_offset, to_offset, flags);
     if (halt) {
-        DEBUG_PRINTF("callback requested to terminate matches\n");
-        ci->status |= STATUS_TERMINATED;
+        DEBUG_PRINTF("told to stop matching\n");
         return MO_HALT_MATCHING;
     }
 
@@ -196,12 +196,9 @@ int roseDeliverSomReport(u64a from_offset, u64a to_offset, ReportID onmatch,
     DEBUG_PRINTF(">> reporting match @[%llu,%llu] for sig %u ctxt %p <<\n",
                  from_offset, to_offset, onmatch, ci->userContext);
 
-    int halt = ci->userCallback(onmatch, from_offset, to_offset, flags,
-                                ci->userContext);
-
+    int halt = deliverUserMatch(ci, onmatch, from_offset, to_offset, flags);
     if (halt) {
-        DEBUG_PRINTF("callback requested to terminate matches\n");
-        ci->status |= STATUS_TERMINATED;
+        DEBUG_PRINTF("told to stop matching\n");
         return MO_HALT_MATCHING;
     }
 
@@ -213,4 +210,113 @@ int roseDeliverSomReport(u64a from_offset, u64a to_offset, ReportID onmatch,
     }
 }
 
+/**
+ * \brief Deliver the given logical combination to the user callback and
+ * record that it has been reported.
+ */
+static really_inline
+int roseDeliverCombination(const struct RoseEngine *t,
+                           struct hs_scratch *scratch,
+                           const struct CombInfo *comb, u64a end) {
+    struct core_info *ci = &scratch->core_info;
+    u8 *cvec = (u8 *)ci->state + t->stateOffsets.combVec;
+
+    DEBUG_PRINTF(">> reporting combination @[0,%llu] for sig %u ctxt %p <<\n",
+                 end, comb->onmatch, ci->userContext);
+
+    mmbit_set(cvec, t->ckeyCount, comb->id);
+
+    int halt = deliverUserMatch(ci, comb->onmatch, 0, end, 0);
+    if (halt) {
+        DEBUG_PRINTF("told to stop matching\n");
+        return MO_HALT_MATCHING;
+    }
+
+    return MO_CONTINUE_MATCHING;
+}
+
+/**
+ * \brief Report the logical combinations that hold after the sub-expression
+ * matches recorded at offset \a end.
+ */
+static really_inline
+int roseFlushCombination(const struct RoseEngine *t,
+                         struct hs_scratch *scratch, u64a end) {
+    u8 *lvec = (u8 *)scratch->core_info.state + t->stateOffsets.logicalVec;
+    const u8 *cvec = (const u8 *)scratch->core_info.state +
+                     t->stateOffsets.combVec;
+    const struct CombInfo *comb = (const struct CombInfo *)
+        ((const char *)t + t->combInfoMapOffset);
+
+    DEBUG_PRINTF("flush combinations at %llu\n", end);
+    evalLogicalTree(t, lvec);
+
+    for (u32 i = 0; i < t->ckeyCount; i++, comb++) {
+        if (!getLogicalVal(t, lvec, comb->result)) {
+            continue;
+        }
+        if (comb->highlander && mmbit_isset(cvec, t->ckeyCount, comb->id)) {
+            DEBUG_PRINTF("combination %u already reported\n", comb->id);
+            continue;
+        }
+        if (roseDeliverCombination(t, scratch, comb, end) ==
+            MO_HALT_MATCHING) {
+            return MO_HALT_MATCHING;
+        }
+    }
+
+    return MO_CONTINUE_MATCHING;
+}
+
+/**
+ * \brief Report combinations for the last offset at which sub-expression
+ * matches were recorded, if that has not been done yet.
+ */
+static really_inline
+int roseFlushPendingCombination(const struct RoseEngine *t,
+                                struct hs_scratch *scratch) {
+    struct RoseContext *tctxt = &scratch->tctxt;
+    if (tctxt->lastCombMatchOffset == ~0ULL) {
+        return MO_CONTINUE_MATCHING;
+    }
+
+    u64a end = tctxt->lastCombMatchOffset;
+    tctxt->lastCombMatchOffset = ~0ULL;
+    return roseFlushCombination(t, scratch, end);
+}
+
+/**
+ * \brief Final combination processing at the end of data: flushes anything
+ * pending, then reports each combination that holds at \a end but has never
+ * been reported (for example, one made only of negated sub-expressions).
+ */
+static really_inline
+int roseFlushLastCombination(const struct RoseEngine *t,
+                             struct hs_scratch *scratch, u64a end) {
+    if (roseFlushPendingCombination(t, scratch) == MO_HALT_MATCHING) {
+        return MO_HALT_MATCHING;
+    }
+
+    u8 *lvec = (u8 *)scratch->core_info.state + t->stateOffsets.logicalVec;
+    const u8 *cvec = (const u8 *)scratch->core_info.state +
+                     t->stateOffsets.combVec;
+    const struct CombInfo *comb = (const struct CombInfo *)
+        ((const char *)t + t->combInfoMapOffset);
+
+    evalLogicalTree(t, lvec);
+
+    for (u32 i = 0; i < t->ckeyCount; i++, comb++) {
+        if (!getLogicalVal(t, lvec, comb->result) ||
+            mmbit_isset(cvec, t->ckeyCount, comb->id)) {
+            continue;
+        }
+        if (roseDeliverCombination(t, scratch, comb, end) ==
+            MO_HALT_MATCHING) {
+            return MO_HALT_MATCHING;
+        }
+    }
+
+    return MO_CONTINUE_MATCHING;
+}
+
 #endif // REPORT_H
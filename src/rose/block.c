@@ -34,6 +34,7 @@
 #include "nfa/nfa_rev_api.h"
 #include "nfa/mcclellan.h"
 #include "util/fatbit.h"
+#include "util/profile.h"
 #include "rose.h"
 #include "rose_common.h"
 
@@ -187,8 +188,10 @@ void roseBlockExec_i(const struct RoseEngine *t, struct hs_scratch *scratch) {
 
         DEBUG_PRINTF("BEGIN SMALL BLOCK (over %zu/%zu)\n", sblen, length);
         DEBUG_PRINTF("-- %016llx\n", tctxt->groups);
+        PROFILE_MARK(mark);
         hwlmExec(sbtable, scratch->core_info.buf, sblen, 0, roseCallback,
                  scratch, tctxt->groups);
+        PROFILE_MATCHER(scratch, SMALL_BLOCK, mark, sblen);
         goto exit;
     }
 
@@ -204,8 +207,10 @@ void roseBlockExec_i(const struct RoseEngine *t, struct hs_scratch *scratch) {
             goto skip_atable;
         }
 
-
+        PROFILE_MARK(mark);
         runAnchoredTableBlock(t, atable, scratch);
+        PROFILE_MATCHER(scratch, ANCHORED, mark,
+                        MIN(length, t->anchoredDistance));
 
         if (can_stop_matching(scratch)) {
             goto exit;
@@ -243,8 +248,10 @@ void roseBlockExec_i(const struct RoseEngine *t, struct hs_scratch *scratch) {
 
         DEBUG_PRINTF("BEGIN FLOATING (over %zu/%zu)\n", flen, length);
         DEBUG_PRINTF("-- %016llx\n", tctxt->groups);
+        PROFILE_MARK(mark);
         hwlmExec(ftable, buffer, flen, t->floatingMinDistance,
                  roseCallback, scratch, tctxt->groups);
+        PROFILE_MATCHER(scratch, FLOATING, mark, flen);
     }
 
 exit:;
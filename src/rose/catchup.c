@@ -45,11 +45,18 @@ typedef struct queue_match PQ_T;
 #define PQ_COMP_B(pqc_items, a, b_fixed) ((pqc_items)[a].loc < (b_fixed).loc)
 
 #include "util/pqueue.h"
+#include "util/profile.h"
 
 static really_inline
 int roseNfaRunProgram(const struct RoseEngine *rose, struct hs_scratch *scratch,
                       u64a som, u64a offset, ReportID id, const char from_mpv) {
     const u32 program = id;
+    if (!program) {
+        DEBUG_PRINTF("no program for report, nothing to do\n");
+        return can_stop_matching(scratch) ? MO_HALT_MATCHING
+                                          : MO_CONTINUE_MATCHING;
+    }
+
     const size_t match_len = 0; // Unused in this path.
     const char in_anchored = 0;
     const char in_catchup = 1;
@@ -98,6 +105,7 @@ void pq_replace_top_with(struct catchup_pq *pq,
     assert(loc > 0);
     assert(pq->qm_size);
     assert(loc <= (s64a)scratch->core_info.len);
+    PROFILE_EVENT(catchup_ops, 1);
     pq_replace_top(pq->qm, pq->qm_size, temp);
 }
 
@@ -112,12 +120,14 @@ void pq_insert_with(struct catchup_pq *pq,
 
     assert(loc > 0);
     assert(loc <= (s64a)scratch->core_info.len);
+    PROFILE_EVENT(catchup_ops, 1);
     pq_insert(pq->qm, pq->qm_size, temp);
     ++pq->qm_size;
 }
 
 static really_inline
 void pq_pop_nice(struct catchup_pq *pq) {
+    PROFILE_EVENT(catchup_ops, 1);
     pq_pop(pq->qm, pq->qm_size);
     pq->qm_size--;
 }
@@ -673,6 +683,12 @@ void blockInitSufPQ(const struct RoseEngine *t, char *state,
         nfaQueueInitState(nfa, q);
         pushQueueAt(q, 0, MQE_START, 0);
         pushQueueAt(q, 1, MQE_TOP, 0);
+
+        if (t->unordered) {
+            /* run to completion when we catch up at the end of the block */
+            continue;
+        }
+
         pushQueueAt(q, 2, MQE_END, length);
 
         DEBUG_PRINTF("adding qi=%u to pq\n", qi);
@@ -904,6 +920,102 @@ hwlmcb_rv_t roseCatchUpAll(s64a loc, struct hs_scratch *scratch) {
     return rv;
 }
 
+static really_inline
+void compactQueue(struct mq *q) {
+    u32 i = 0;
+    while (q->cur < q->end) {
+        q->items[i] = q->items[q->cur++];
+        assert(q->items[i].type != MQE_END);
+        i++;
+    }
+    q->cur = 0;
+    q->end = i;
+}
+
+hwlmcb_rv_t roseFlushQueueUnordered(const struct RoseEngine *t,
+                                    struct hs_scratch *scratch, u32 qi,
+                                    s64a loc) {
+    assert(t->unordered);
+    assert(!has_chained_nfas(t));
+
+    struct mq *q = scratch->queues + qi;
+    DEBUG_PRINTF("flushing qi=%u to %lld\n", qi, loc);
+
+    pushQueueNoMerge(q, MQE_END, loc);
+    char alive = blast_queue(t, scratch, q, qi, loc, 0);
+
+    if (!alive) {
+        if (can_stop_matching(scratch)) {
+            DEBUG_PRINTF("bailing\n");
+            return HWLM_TERMINATE_MATCHING;
+        }
+
+        /* our caller will reinitialise the queue for the new top */
+        deactivateQueue(t, getActiveLeafArray(t, scratch->core_info.state),
+                        qi, scratch);
+        return HWLM_CONTINUE_MATCHING;
+    }
+
+    q->cur = q->end = 0;
+    pushQueueAt(q, 0, MQE_START, loc);
+    return HWLM_CONTINUE_MATCHING;
+}
+
+hwlmcb_rv_t roseCatchUpUnordered(const struct RoseEngine *t, s64a loc,
+                                 struct hs_scratch *scratch) {
+    assert(t->unordered);
+    assert(!has_chained_nfas(t));
+    DEBUG_PRINTF("unordered catchup to %lld\n", loc);
+
+    u8 *aa = getActiveLeafArray(t, scratch->core_info.state);
+    u32 aaCount = t->activeArrayCount;
+
+    /* No priority queue: each engine runs straight through to loc, reporting
+     * matches as it finds them. Unsetting an entry does not invalidate the
+     * iteration (see deactivateQueue). */
+    for (u32 qi = aaCount ? mmbit_iterate(aa, aaCount, MMB_INVALID)
+                          : MMB_INVALID;
+         qi != MMB_INVALID; qi = mmbit_iterate(aa, aaCount, qi)) {
+        struct mq *q = scratch->queues + qi;
+        const struct NfaInfo *info = getNfaInfoByQueue(t, qi);
+
+        if (roseSuffixInfoIsExhausted(t, info,
+                                      scratch->core_info.exhaustionVector)) {
+            deactivateQueue(t, aa, qi, scratch);
+            continue;
+        }
+
+        ensureQueueActive(t, qi, t->queueCount, q, scratch);
+
+        if (unlikely(loc < q_cur_loc(q))) {
+            DEBUG_PRINTF("err loc %lld < location %lld\n", loc, q_cur_loc(q));
+            continue;
+        }
+
+        ensureEnd(q, qi, loc);
+
+        char alive = blast_queue(t, scratch, q, qi, loc, 0);
+        if (!alive) {
+            if (can_stop_matching(scratch)) {
+                DEBUG_PRINTF("bailing\n");
+                return HWLM_TERMINATE_MATCHING;
+            }
+            deactivateQueue(t, aa, qi, scratch);
+        } else if (q->cur == q->end) {
+            DEBUG_PRINTF("queue %u finished, nfa lives [%lld]\n", qi, loc);
+            q->cur = q->end = 0;
+            pushQueueAt(q, 0, MQE_START, loc);
+        } else {
+            DEBUG_PRINTF("queue %u unfinished, nfa lives\n", qi);
+            compactQueue(q);
+        }
+    }
+
+    updateMinMatchOffset(&scratch->tctxt, scratch->core_info.buf_offset + loc);
+    return can_stop_matching(scratch) ? HWLM_TERMINATE_MATCHING
+                                      : HWLM_CONTINUE_MATCHING;
+}
+
 hwlmcb_rv_t roseCatchUpSuf(s64a loc, struct hs_scratch *scratch) {
     /* just need suf/outfixes. mpv will be caught up only to last reported
      * external match */
@@ -64,6 +64,17 @@ hwlmcb_rv_t roseCatchUpSuf(s64a loc, struct hs_scratch *scratch);
 hwlmcb_rv_t roseCatchUpMPV_i(const struct RoseEngine *t, s64a loc,
                              struct hs_scratch *scratch);
 
+/* unordered databases only: runs all active suffixes and outfixes to loc,
+ * reporting their matches as they are found */
+hwlmcb_rv_t roseCatchUpUnordered(const struct RoseEngine *t, s64a loc,
+                                 struct hs_scratch *scratch);
+
+/* unordered databases only: runs the (full) queue qi to loc, reporting its
+ * matches as they are found */
+hwlmcb_rv_t roseFlushQueueUnordered(const struct RoseEngine *t,
+                                    struct hs_scratch *scratch, u32 qi,
+                                    s64a loc);
+
 void blockInitSufPQ(const struct RoseEngine *t, char *state,
                     struct hs_scratch *scratch, char is_small_block);
 void streamInitSufPQ(const struct RoseEngine *t, char *state,
@@ -130,6 +141,10 @@ hwlmcb_rv_t roseCatchUpTo(const struct RoseEngine *t,
     char *state = scratch->core_info.state;
     s64a loc = end - scratch->core_info.buf_offset;
 
+    if (t->unordered) {
+        return roseCatchUpUnordered(t, loc, scratch);
+    }
+
     if (end <= scratch->tctxt.minNonMpvMatchOffset) {
         /* only need to catch up the mpv */
         return roseCatchUpMPV(t, loc, scratch);
@@ -31,6 +31,7 @@
 #include "program_runtime.h"
 #include "rose.h"
 #include "util/fatbit.h"
+#include "util/profile.h"
 
 static really_inline
 void initContext(const struct RoseEngine *t, char *state, u64a offset,
@@ -90,8 +91,10 @@ hwlmcb_rv_t roseEodRunMatcher(const struct RoseEngine *t, u64a offset,
     struct RoseContext *tctxt = &scratch->tctxt;
     const struct HWLM *etable = getELiteralMatcher(t);
 
+    PROFILE_MARK(mark);
     hwlmExec(etable, eod_data, eod_len, adj, roseCallback, scratch,
              tctxt->groups);
+    PROFILE_MATCHER(scratch, EOD, mark, eod_len);
 
     // We may need to fire delayed matches
     return cleanUpDelayed(t, scratch, 0, offset);
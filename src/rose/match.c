@@ -79,6 +79,8 @@ hwlmcb_rv_t roseDelayRebuildCallback(size_t start, size_t end, u32 id,
     const struct RoseEngine *t = ci->rose;
     size_t rb_len = MIN(ci->hlen, t->delayRebuildLength);
 
+    PROFILE_EVENT(literal_matches, 1);
+
     u64a real_end = ci->buf_offset - rb_len + end + 1; // index after last byte
 
 #ifdef DEBUG
@@ -226,6 +228,8 @@ int roseAnchoredCallback(u64a end, u32 id, void *ctx) {
     struct core_info *ci = &scratch->core_info;
     const struct RoseEngine *t = ci->rose;
 
+    PROFILE_EVENT(literal_matches, 1);
+
     u64a real_end = ci->buf_offset + end; // index after last byte
 
     DEBUG_PRINTF("MATCH id=%u offsets=[???,%llu]\n", id, real_end);
@@ -252,6 +256,11 @@ int roseAnchoredCallback(u64a end, u32 id, void *ctx) {
 
     const u32 *programs = getByOffset(t, t->litProgramOffset);
     assert(id < t->literalCount);
+    if (!programs[id]) {
+        DEBUG_PRINTF("no program for literal, nothing to do\n");
+        return MO_CONTINUE_MATCHING;
+    }
+
     const u64a som = 0;
     const char in_anchored = 1;
     const char in_catchup = 0;
@@ -283,6 +292,11 @@ hwlmcb_rv_t roseProcessMatch(const struct RoseEngine *t,
     DEBUG_PRINTF("id=%u\n", id);
     const u32 *programs = getByOffset(t, t->litProgramOffset);
     assert(id < t->literalCount);
+    if (!programs[id]) {
+        DEBUG_PRINTF("no program for literal, nothing to do\n");
+        return HWLM_CONTINUE_MATCHING;
+    }
+
     const u64a som = 0;
     const char in_anchored = 0;
     const char in_catchup = 0;
@@ -523,6 +537,8 @@ hwlmcb_rv_t roseCallback(size_t start, size_t end, u32 id, void *ctxt) {
 
     u64a real_end = end + tctx->lit_offset_adjust;
 
+    PROFILE_EVENT(literal_matches, 1);
+
 #if defined(DEBUG)
     DEBUG_PRINTF("MATCH id=%u offsets=[%llu,%llu]: ", id,
                  start + tctx->lit_offset_adjust, real_end);
@@ -582,6 +598,12 @@ hwlmcb_rv_t rosePureLiteralCallback(size_t start, size_t end, u32 id,
     const struct RoseEngine *rose = ci->rose;
     const u32 *programs = getByOffset(rose, rose->litProgramOffset);
     assert(id < rose->literalCount);
+    PROFILE_EVENT(literal_matches, 1);
+    if (!programs[id]) {
+        DEBUG_PRINTF("no program for literal, nothing to do\n");
+        return HWLM_CONTINUE_MATCHING;
+    }
+
     const char in_anchored = 0;
     const char in_catchup = 0;
     const char from_mpv = 0;
@@ -646,6 +668,12 @@ int roseReportAdaptor_i(u64a som, u64a offset, ReportID id, void *context) {
 
     // Our match ID is the program offset.
     const u32 program = id;
+    if (!program) {
+        DEBUG_PRINTF("no program for report, nothing to do\n");
+        return can_stop_matching(scratch) ? MO_HALT_MATCHING
+                                          : MO_CONTINUE_MATCHING;
+    }
+
     const size_t match_len = 0; // Unused in this path.
     const char in_anchored = 0;
     const char in_catchup = 0;
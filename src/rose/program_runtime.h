@@ -45,6 +45,7 @@
 #include "util/compare.h"
 #include "util/fatbit.h"
 #include "util/multibit.h"
+#include "util/profile.h"
 
 static rose_inline
 int roseCheckBenefits(const struct core_info *ci, u64a end, u32 mask_rewind,
@@ -222,6 +223,27 @@ hwlmcb_rv_t roseHaltIfExhausted(const struct RoseEngine *t,
     return HWLM_CONTINUE_MATCHING;
 }
 
+/**
+ * \brief Record a match for the sub-expression with logical key \a lkey at
+ * \a offset, first reporting the combinations for any earlier offset.
+ */
+static rose_inline
+hwlmcb_rv_t roseSetLogical(const struct RoseEngine *t,
+                           struct hs_scratch *scratch, u64a offset,
+                           u32 lkey) {
+    struct RoseContext *tctxt = &scratch->tctxt;
+    if (tctxt->lastCombMatchOffset != offset) {
+        if (roseFlushPendingCombination(t, scratch) == MO_HALT_MATCHING) {
+            return HWLM_TERMINATE_MATCHING;
+        }
+        tctxt->lastCombMatchOffset = offset;
+    }
+
+    u8 *lvec = (u8 *)scratch->core_info.state + t->stateOffsets.logicalVec;
+    setLogicalVal(t, lvec, lkey, 1);
+    return HWLM_CONTINUE_MATCHING;
+}
+
 static really_inline
 hwlmcb_rv_t ensureQueueFlushed_i(const struct RoseEngine *t,
                                  struct hs_scratch *scratch, u32 qi, s64a loc,
@@ -243,6 +265,14 @@ hwlmcb_rv_t ensureQueueFlushed_i(const struct RoseEngine *t,
         nfaQueueExec(q->nfa, q, loc);
         q->cur = q->end = 0;
         pushQueueAt(q, 0, MQE_START, loc);
+    } else if (t->unordered) {
+        /* matches need not be ordered, so this engine can be run on its own
+         * without catching anybody else up */
+        assert(!is_mpv);
+        if (roseFlushQueueUnordered(t, scratch, qi, loc) ==
+            HWLM_TERMINATE_MATCHING) {
+            return HWLM_TERMINATE_MATCHING;
+        }
     } else if (!in_catchup) {
         if (is_mpv) {
             tctxt->next_mpv_offset = 0; /* force us to catch the mpv */
@@ -577,7 +607,7 @@ hwlmcb_rv_t roseReport(const struct RoseEngine *t, struct hs_scratch *scratch,
                        u32 ekey) {
     assert(!t->needsCatchup || end == scratch->tctxt.minMatchOffset);
     DEBUG_PRINTF("firing callback onmatch=%u, end=%llu\n", onmatch, end);
-    updateLastMatchOffset(&scratch->tctxt, end);
+    updateLastMatchOffset(t, &scratch->tctxt, end);
 
     int cb_rv = roseDeliverReport(end, onmatch, offset_adjust, scratch, ekey);
     if (cb_rv == MO_HALT_MATCHING) {
@@ -616,7 +646,7 @@ void roseHandleSom(UNUSED const struct RoseEngine *t,
                  scratch->tctxt.minMatchOffset);
 
     assert(!t->needsCatchup || end == scratch->tctxt.minMatchOffset);
-    updateLastMatchOffset(&scratch->tctxt, end);
+    updateLastMatchOffset(t, &scratch->tctxt, end);
     handleSomInternal(scratch, sr, end);
 }
 
@@ -627,7 +657,7 @@ hwlmcb_rv_t roseReportSom(const struct RoseEngine *t,
     assert(!t->needsCatchup || end == scratch->tctxt.minMatchOffset);
     DEBUG_PRINTF("firing som callback onmatch=%u, start=%llu, end=%llu\n",
                  onmatch, start, end);
-    updateLastMatchOffset(&scratch->tctxt, end);
+    updateLastMatchOffset(t, &scratch->tctxt, end);
 
     int cb_rv = roseDeliverSomReport(start, end, onmatch, offset_adjust,
                                      scratch, ekey);
@@ -651,7 +681,7 @@ void roseHandleSomSom(UNUSED const struct RoseEngine *t,
                  scratch->tctxt.minMatchOffset);
 
     assert(!t->needsCatchup || end == scratch->tctxt.minMatchOffset);
-    updateLastMatchOffset(&scratch->tctxt, end);
+    updateLastMatchOffset(t, &scratch->tctxt, end);
     setSomFromSomAware(scratch, sr, start, end);
 }
 
@@ -848,12 +878,15 @@ hwlmcb_rv_t roseRunProgram(const struct RoseEngine *t,
 
     assert(*(const u8 *)pc != ROSE_INSTR_END);
 
+    PROFILE_EVENT(programs, 1);
+
     for (;;) {
         assert(ISALIGNED_N(pc, ROSE_INSTR_MIN_ALIGN));
         assert(pc >= pc_base);
         assert((size_t)(pc - pc_base) < t->size);
         const u8 code = *(const u8 *)pc;
         assert(code <= ROSE_INSTR_END);
+        PROFILE_EVENT(instructions, 1);
 
         switch ((enum RoseInstructionCode)code) {
             PROGRAM_CASE(ANCHORED_DELAY) {
@@ -1301,6 +1334,31 @@ hwlmcb_rv_t roseRunProgram(const struct RoseEngine *t,
             }
             PROGRAM_NEXT_INSTRUCTION
 
+            PROGRAM_CASE(SET_LOGICAL) {
+                DEBUG_PRINTF("set logical value of lkey %u, "
+                             "offset_adjust=%d\n", ri->lkey,
+                             ri->offset_adjust);
+                if (roseSetLogical(t, scratch, end + ri->offset_adjust,
+                                   ri->lkey) == HWLM_TERMINATE_MATCHING) {
+                    return HWLM_TERMINATE_MATCHING;
+                }
+                work_done = 1;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
+            PROGRAM_CASE(SET_EXHAUST) {
+                DEBUG_PRINTF("set ekey %u\n", ri->ekey);
+                assert(ri->ekey != INVALID_EKEY);
+                markAsMatched(t, scratch->core_info.exhaustionVector,
+                              ri->ekey);
+                if (roseHaltIfExhausted(t, scratch) ==
+                    HWLM_TERMINATE_MATCHING) {
+                    return HWLM_TERMINATE_MATCHING;
+                }
+                work_done = 1;
+            }
+            PROGRAM_NEXT_INSTRUCTION
+
             PROGRAM_CASE(END) {
                 DEBUG_PRINTF("finished\n");
                 return HWLM_CONTINUE_MATCHING;
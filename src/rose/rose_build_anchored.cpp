@@ -46,11 +46,13 @@
 #include "util/charreach.h"
 #include "util/compile_context.h"
 #include "util/compile_error.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/determinise.h"
 #include "util/graph_range.h"
 #include "util/make_unique.h"
 #include "util/order_check.h"
+#include "util/parallel.h"
 #include "util/ue2_containers.h"
 #include "util/ue2string.h"
 #include "util/verify_types.h"
@@ -775,14 +777,13 @@ size_t buildNfas(vector<raw_dfa> &anchored_dfas,
                  const ReportManager &rm) {
     const size_t num_dfas = anchored_dfas.size();
 
-    nfas->reserve(num_dfas);
-    start_offset->reserve(num_dfas);
+    nfas->resize(num_dfas);
+    start_offset->resize(num_dfas);
 
-    size_t total_size = 0;
-
-    for (auto &rdfa : anchored_dfas) {
-        u32 removed_dots = remove_leading_dots(rdfa);
-        start_offset->push_back(removed_dots);
+    // Each DFA is minimised and compiled independently of the others.
+    parallelFor(num_dfas, cc.grey.compileThreads, [&](size_t i) {
+        raw_dfa &rdfa = anchored_dfas[i];
+        (*start_offset)[i] = remove_leading_dots(rdfa);
 
         minimize_hopcroft(rdfa, cc.grey);
 
@@ -793,8 +794,12 @@ size_t buildNfas(vector<raw_dfa> &anchored_dfas,
         }
 
         assert(nfa->length);
+        (*nfas)[i] = move(nfa);
+    });
+
+    size_t total_size = 0;
+    for (const auto &nfa : *nfas) {
         total_size += ROUNDUP_CL(sizeof(anchored_matcher_info) + nfa->length);
-        nfas->push_back(move(nfa));
     }
 
     // We no longer need to keep the raw_dfa structures around.
@@ -811,6 +816,7 @@ vector<raw_dfa> buildAnchoredDfas(RoseBuildImpl &build) {
         return dfas;
     }
 
+    CompilePhase phase("anchored_dfas");
     remapAnchoredReports(build);
 
     auto anch_dfas = getAnchoredDfas(build);
@@ -835,6 +841,8 @@ buildAnchoredMatcher(RoseBuildImpl &build, vector<raw_dfa> &dfas,
         return nullptr;
     }
 
+    CompilePhase phase("anchored_matcher");
+
     vector<aligned_unique_ptr<NFA>> nfas;
     vector<u32> start_offset; // start offset for each dfa (dots removed)
     size_t total_size = buildNfas(dfas, &nfas, &start_offset, cc, build.rm);
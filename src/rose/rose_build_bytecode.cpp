@@ -33,6 +33,7 @@
 #include "hs_compile.h" // for HS_MODE_*
 #include "rose_build_add_internal.h"
 #include "rose_build_anchored.h"
+#include "rose_build_engine_cache.h"
 #include "rose_build_infix.h"
 #include "rose_build_lookaround.h"
 #include "rose_build_matchers.h"
@@ -45,9 +46,11 @@
 #include "nfa/goughcompile.h"
 #include "nfa/mcclellancompile.h"
 #include "nfa/mcclellancompile_util.h"
+#include "nfa/mcshengcompile.h"
 #include "nfa/nfa_api_queue.h"
 #include "nfa/nfa_build_util.h"
 #include "nfa/nfa_internal.h"
+#include "nfa/shengcompile.h"
 #include "nfa/shufticompile.h"
 #include "nfagraph/ng_holder.h"
 #include "nfagraph/ng_lbr.h"
@@ -67,10 +70,12 @@
 #include "util/charreach_util.h"
 #include "util/compile_context.h"
 #include "util/compile_error.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/graph_range.h"
 #include "util/multibit_build.h"
 #include "util/order_check.h"
+#include "util/parallel.h"
 #include "util/queue_index_factory.h"
 #include "util/report_manager.h"
 #include "util/ue2string.h"
@@ -222,6 +227,8 @@ public:
         case ROSE_INSTR_CHECK_STATE: return &u.checkState;
         case ROSE_INSTR_SPARSE_ITER_BEGIN: return &u.sparseIterBegin;
         case ROSE_INSTR_SPARSE_ITER_NEXT: return &u.sparseIterNext;
+        case ROSE_INSTR_SET_LOGICAL: return &u.setLogical;
+        case ROSE_INSTR_SET_EXHAUST: return &u.setExhaust;
         case ROSE_INSTR_END: return &u.end;
         }
         assert(0);
@@ -268,6 +275,8 @@ public:
         case ROSE_INSTR_CHECK_STATE: return sizeof(u.checkState);
         case ROSE_INSTR_SPARSE_ITER_BEGIN: return sizeof(u.sparseIterBegin);
         case ROSE_INSTR_SPARSE_ITER_NEXT: return sizeof(u.sparseIterNext);
+        case ROSE_INSTR_SET_LOGICAL: return sizeof(u.setLogical);
+        case ROSE_INSTR_SET_EXHAUST: return sizeof(u.setExhaust);
         case ROSE_INSTR_END: return sizeof(u.end);
         }
         assert(0);
@@ -313,6 +322,8 @@ public:
         ROSE_STRUCT_CHECK_STATE checkState;
         ROSE_STRUCT_SPARSE_ITER_BEGIN sparseIterBegin;
         ROSE_STRUCT_SPARSE_ITER_NEXT sparseIterNext;
+        ROSE_STRUCT_SET_LOGICAL setLogical;
+        ROSE_STRUCT_SET_EXHAUST setExhaust;
         ROSE_STRUCT_END end;
     } u;
 
@@ -405,6 +416,10 @@ struct build_context : boost::noncopyable {
     /** \brief True if this Rose engine has an MPV engine. */
     bool needs_mpv_catchup = false;
 
+    /** \brief True if matches may be delivered out of order and without
+     * deduplication (HS_MODE_UNORDERED). */
+    bool unordered = false;
+
     /** \brief Resources in use (tracked as programs are added). */
     RoseResources resources;
 
@@ -659,6 +674,40 @@ bool needsMpvCatchup(const RoseBuildImpl &build) {
     return true;
 }
 
+/**
+ * \brief True if this Rose engine can be run without ordering or deduping its
+ * matches, as requested by HS_MODE_UNORDERED.
+ *
+ * SOM slots, logical combinations and the MPV all depend on seeing matches in
+ * order, so we keep the ordered runtime for anything that uses them.
+ */
+static
+bool canRunUnordered(const RoseBuildImpl &build) {
+    if (!build.cc.unordered) {
+        return false;
+    }
+
+    if (build.hasSom) {
+        DEBUG_PRINTF("has som\n");
+        return false;
+    }
+
+    if (build.rm.pl.numCkeys()) {
+        DEBUG_PRINTF("has logical combinations\n");
+        return false;
+    }
+
+    const auto &outfixes = build.outfixes;
+    if (any_of(begin(outfixes), end(outfixes), [](const OutfixInfo &outfix) {
+            return outfix.is_nonempty_mpv();
+        })) {
+        DEBUG_PRINTF("has mpv\n");
+        return false;
+    }
+
+    return true;
+}
+
 static
 void fillStateOffsets(const RoseBuildImpl &tbi, u32 rolesWithStateCount,
                       u32 anchorStateSize, u32 activeArrayCount,
@@ -704,6 +753,14 @@ void fillStateOffsets(const RoseBuildImpl &tbi, u32 rolesWithStateCount,
     so->exhausted = curr_offset;
     curr_offset += mmbit_size(tbi.rm.numEkeys());
 
+    // Logical multibit, one bit per sub-expression of a logical combination.
+    so->logicalVec = curr_offset;
+    curr_offset += mmbit_size(tbi.rm.pl.numLogicalKeys());
+
+    // Combination multibit, one bit per combination that has been reported.
+    so->combVec = curr_offset;
+    curr_offset += mmbit_size(tbi.rm.pl.numCkeys());
+
     // SOM locations and valid/writeable multibit structures.
     if (tbi.ssm.numSomSlots()) {
         const u32 somWidth = tbi.ssm.somPrecision();
@@ -729,6 +786,22 @@ void fillStateOffsets(const RoseBuildImpl &tbi, u32 rolesWithStateCount,
     so->end = curr_offset;
 }
 
+/** \brief Distinct match IDs that may be delivered to the user. Their count
+ * is used to end callback-free bitmap scans early. */
+static
+set<u32> findMatchIds(const ReportManager &rm) {
+    set<u32> ids;
+    for (const auto &report : rm.reports()) {
+        if (isExternalReport(report) && !rm.isQuiet(report.onmatch)) {
+            ids.insert(report.onmatch);
+        }
+    }
+    for (const auto &ci : rm.pl.combInfoMap()) {
+        ids.insert(ci.onmatch);
+    }
+    return ids;
+}
+
 // Get the mask of initial vertices due to root and anchored_root.
 rose_group RoseBuildImpl::getInitialGroups() const {
     rose_group groups = getSuccGroups(root) | getSuccGroups(anchored_root);
@@ -810,6 +883,32 @@ void findFixedDepthTops(const RoseGraph &g, const set<PredTopPair> &triggers,
     }
 }
 
+/**
+ * \brief Builds the best DFA engine for the given raw_dfa: a Sheng if it is
+ * small enough, a McSheng if it is large and has a hot head, otherwise a
+ * McClellan.
+ *
+ * \p is_transient is true if the engine will only ever be run over a short
+ * window of history (such as a transient prefix), in which case a McSheng
+ * head would not have time to pay for itself.
+ */
+static
+aligned_unique_ptr<NFA> getDfa(raw_dfa &rdfa, bool is_transient,
+                               const CompileContext &cc,
+                               const ReportManager &rm) {
+    // Unleash the Sheng!
+    auto dfa = shengCompile(rdfa, cc, rm);
+    if (!dfa && !is_transient) {
+        // Sheng wasn't successful, so unleash McSheng!
+        dfa = mcshengCompile(rdfa, cc, rm);
+    }
+    if (!dfa) {
+        // Sheng/McSheng weren't successful, so unleash McClellan!
+        dfa = mcclellanCompile(rdfa, cc, rm);
+    }
+    return dfa;
+}
+
 /**
  * \brief Heuristic for picking between a DFA or NFA implementation of an
  * engine.
@@ -819,7 +918,8 @@ aligned_unique_ptr<NFA> pickImpl(aligned_unique_ptr<NFA> dfa_impl,
                                  aligned_unique_ptr<NFA> nfa_impl) {
     assert(nfa_impl);
     assert(dfa_impl);
-    assert(isMcClellanType(dfa_impl->type));
+    assert(isMcClellanType(dfa_impl->type) || isShengType(dfa_impl->type)
+           || isMcShengType(dfa_impl->type));
 
     // If our NFA is an LBR, it always wins.
     if (isLbrType(nfa_impl->type)) {
@@ -828,7 +928,8 @@ aligned_unique_ptr<NFA> pickImpl(aligned_unique_ptr<NFA> dfa_impl,
 
     bool d_accel = has_accel(*dfa_impl);
     bool n_accel = has_accel(*nfa_impl);
-    bool d_big = dfa_impl->type == MCCLELLAN_NFA_16;
+    bool d_big = dfa_impl->type == MCCLELLAN_NFA_16
+              || isMcShengType(dfa_impl->type);
     bool n_vsmall = nfa_impl->nPositions <= 32;
     bool n_br = has_bounded_repeats(*nfa_impl);
     DEBUG_PRINTF("da %d na %d db %d nvs %d nbr %d\n", (int)d_accel,
@@ -848,8 +949,8 @@ aligned_unique_ptr<NFA> pickImpl(aligned_unique_ptr<NFA> dfa_impl,
             }
         }
     } else {
-        /* favour a McClellan 8, unless the nfa looks really good and the dfa
-         * looks like trouble */
+        /* favour a McClellan 8 (or Sheng), unless the nfa looks really good and
+         * the dfa looks like trouble */
         if (!d_accel && n_vsmall && n_accel && !n_br) {
             return nfa_impl;
         } else {
@@ -878,6 +979,32 @@ buildRepeatEngine(const CastleProto &proto,
     return castle_nfa;
 }
 
+/** \brief Returns the engine cache key for a suffix, or an empty string if it
+ * cannot be cached. */
+static
+string suffixCacheKey(const RoseBuildImpl &build,
+                      const map<u32, u32> &fixed_depth_tops,
+                      const map<u32, vector<vector<CharReach>>> &triggers,
+                      const suffix_id &suff) {
+    if (!build.cc.engine_cache || suff.haig()) {
+        return string();
+    }
+
+    EngineCacheKey key(build.cc, "suffix");
+    if (suff.castle()) {
+        key.add(*suff.castle());
+    } else if (suff.dfa()) {
+        key.add(*suff.dfa());
+    } else {
+        assert(suff.graph());
+        key.add(*suff.graph());
+    }
+    key.add(fixed_depth_tops);
+    key.add(triggers);
+    key.addReports(all_reports(suff), build.rm);
+    return key.str();
+}
+
 /* builds suffix nfas */
 static
 aligned_unique_ptr<NFA>
@@ -898,7 +1025,7 @@ buildSuffix(const ReportManager &rm, const SomSlotManager &ssm,
     }
 
     if (suff.dfa()) {
-        auto d = mcclellanCompile(*suff.dfa(), cc, rm);
+        auto d = getDfa(*suff.dfa(), false, cc, rm);
         assert(d);
         return d;
     }
@@ -927,7 +1054,7 @@ buildSuffix(const ReportManager &rm, const SomSlotManager &ssm,
             auto rdfa = buildMcClellan(holder, &rm, false, triggers.at(0),
                                        cc.grey);
             if (rdfa) {
-                auto d = mcclellanCompile(*rdfa, cc, rm);
+                auto d = getDfa(*rdfa, false, cc, rm);
                 assert(d);
                 if (cc.grey.roseMcClellanSuffix != 2) {
                     n = pickImpl(move(d), move(n));
@@ -936,7 +1063,7 @@ buildSuffix(const ReportManager &rm, const SomSlotManager &ssm,
                 }
 
                 assert(n);
-                if (isMcClellanType(n->type)) {
+                if (isDfaType(n->type)) {
                     // DFA chosen. We may be able to set some more properties
                     // in the NFA structure here.
                     u64a maxOffset = findMaxOffset(holder, rm);
@@ -1009,6 +1136,60 @@ void findTriggerSequences(const RoseBuildImpl &tbi,
     }
 }
 
+/**
+ * \brief Returns the number of threads to use to build the given engines.
+ *
+ * McClellan and Gough compilation may modify the raw DFA they are given, so
+ * engines that share one must be built serially.
+ */
+template<class EngineId>
+u32 engineBuildThreads(const vector<EngineId> &engines, const Grey &grey) {
+    set<const void *> seen;
+    for (const auto &e : engines) {
+        if ((e.dfa() && !seen.insert(e.dfa()).second) ||
+            (e.haig() && !seen.insert(e.haig()).second)) {
+            DEBUG_PRINTF("shared dfa, building serially\n");
+            return 1;
+        }
+    }
+    return grey.compileThreads;
+}
+
+/** \brief Returns the engine cache key for a leftfix, or an empty string if it
+ * cannot be cached. */
+static
+string leftfixCacheKey(const RoseBuildImpl &tbi, const left_id &left,
+                       const bool is_prefix, const bool is_transient,
+                       const map<left_id, set<PredTopPair> > &infixTriggers) {
+    if (!tbi.cc.engine_cache || left.haig()) {
+        return string();
+    }
+
+    EngineCacheKey key(tbi.cc, is_prefix ? "prefix" : "infix");
+    key.add(is_transient);
+    if (left.castle()) {
+        key.add(*left.castle());
+    }
+    if (left.dfa()) {
+        key.add(*left.dfa());
+    }
+    if (left.graph()) {
+        key.add(*left.graph());
+    }
+
+    if (!is_prefix) {
+        const set<PredTopPair> &triggers = infixTriggers.at(left);
+        map<u32, u32> fixed_depth_tops;
+        findFixedDepthTops(tbi.g, triggers, &fixed_depth_tops);
+        map<u32, vector<vector<CharReach>>> trigger_lits;
+        findTriggerSequences(tbi, triggers, &trigger_lits);
+        key.add(fixed_depth_tops);
+        key.add(trigger_lits);
+    }
+
+    return key.str();
+}
+
 static aligned_unique_ptr<NFA>
 makeLeftNfa(const RoseBuildImpl &tbi, left_id &left,
             const bool is_prefix, const bool is_transient,
@@ -1046,12 +1227,12 @@ makeLeftNfa(const RoseBuildImpl &tbi, left_id &left,
     }
 
     if (left.dfa()) {
-        n = mcclellanCompile(*left.dfa(), cc, rm);
+        n = getDfa(*left.dfa(), is_transient, cc, rm);
     } else if (left.graph() && cc.grey.roseMcClellanPrefix == 2 && is_prefix &&
                !is_transient) {
         auto rdfa = buildMcClellan(*left.graph(), nullptr, cc.grey);
         if (rdfa) {
-            n = mcclellanCompile(*rdfa, cc, rm);
+            n = getDfa(*rdfa, is_transient, cc, rm);
         }
     }
 
@@ -1075,7 +1256,7 @@ makeLeftNfa(const RoseBuildImpl &tbi, left_id &left,
         && (!n || !has_bounded_repeats_other_than_firsts(*n) || !is_fast(*n))) {
         auto rdfa = buildMcClellan(*left.graph(), nullptr, cc.grey);
         if (rdfa) {
-            auto d = mcclellanCompile(*rdfa, cc, rm);
+            auto d = getDfa(*rdfa, is_transient, cc, rm);
             assert(d);
             n = pickImpl(move(d), move(n));
         }
@@ -1105,15 +1286,20 @@ static
 bool buildLeftfixes(const RoseBuildImpl &tbi, build_context &bc,
                     QueueIndexFactory &qif, set<u32> *no_retrigger_queues,
                     bool do_prefix) {
+    CompilePhase phase(do_prefix ? "build_prefixes" : "build_infixes");
     const RoseGraph &g = tbi.g;
     const CompileContext &cc = tbi.cc;
     const ReportManager &rm = tbi.rm;
 
-    ue2::unordered_map<left_id, u32> seen; // already built queue indices
-
     map<left_id, set<PredTopPair> > infixTriggers;
     findInfixTriggers(tbi, &infixTriggers);
 
+    // Find the vertices that need leftfix engines, and the distinct engines
+    // to build in order of first use.
+    vector<RoseVertex> verts;
+    vector<left_id> to_build;
+    ue2::unordered_set<left_id> to_build_set;
+
     for (auto v : vertices_range(g)) {
         if (!g[v].left) {
             continue;
@@ -1132,8 +1318,6 @@ bool buildLeftfixes(const RoseBuildImpl &tbi, build_context &bc,
         // our in-edges.
         assert(roseHasTops(g, v));
 
-        u32 qi; // queue index, set below.
-        u32 lag = g[v].left.lag;
         bool is_transient = contains(tbi.transient, leftfix);
 
         if (is_transient && tbi.cc.grey.roseLookaroundMasks) {
@@ -1145,26 +1329,56 @@ bool buildLeftfixes(const RoseBuildImpl &tbi, build_context &bc,
             }
         }
 
+        verts.push_back(v);
+        if (to_build_set.insert(leftfix).second) {
+            assert(leftfix.haig() ||
+                   tbi.isNonRootSuccessor(v) != tbi.isRootSuccessor(v));
+            to_build.push_back(leftfix);
+        }
+    }
+
+    // The engines are independent, so they may be built concurrently.
+    vector<aligned_unique_ptr<NFA>> built(to_build.size());
+    parallelFor(to_build.size(), engineBuildThreads(to_build, cc.grey),
+                [&](size_t i) {
+        left_id &leftfix = to_build[i];
+        bool is_transient = contains(tbi.transient, leftfix);
+        DEBUG_PRINTF("making %sleftfix\n", is_transient ? "transient " : "");
+
+        // Need to build NFA, which is either predestined to be a Haig (in
+        // SOM mode) or could be all manner of things.
+        if (leftfix.haig()) {
+            built[i] = goughCompile(*leftfix.haig(), tbi.ssm.somPrecision(), cc,
+                                    rm);
+        } else {
+            auto key = leftfixCacheKey(tbi, leftfix, do_prefix, is_transient,
+                                       infixTriggers);
+            built[i] = buildWithCache(cc.engine_cache, key, [&] {
+                return makeLeftNfa(tbi, leftfix, do_prefix, is_transient,
+                                   infixTriggers, cc);
+            });
+        }
+    });
+
+    ue2::unordered_map<left_id, u32> seen; // already built queue indices
+    size_t next_built = 0;
+
+    for (auto v : verts) {
+        bool is_prefix = do_prefix;
+        left_id leftfix(g[v].left);
+        u32 qi; // queue index, set below.
+        u32 lag = g[v].left.lag;
+        bool is_transient = contains(tbi.transient, leftfix);
+
         if (contains(seen, leftfix)) {
             // NFA already built.
             qi = seen[leftfix];
             assert(contains(bc.engineOffsets, qi));
             DEBUG_PRINTF("sharing leftfix, qi=%u\n", qi);
         } else {
-            DEBUG_PRINTF("making %sleftfix\n", is_transient ? "transient " : "");
-
-            aligned_unique_ptr<NFA> nfa;
-
-            // Need to build NFA, which is either predestined to be a Haig (in
-            // SOM mode) or could be all manner of things.
-            if (leftfix.haig()) {
-                nfa = goughCompile(*leftfix.haig(), tbi.ssm.somPrecision(), cc,
-                                   rm);
-            }  else {
-                assert(tbi.isNonRootSuccessor(v) != tbi.isRootSuccessor(v));
-                nfa = makeLeftNfa(tbi, leftfix, is_prefix, is_transient,
-                                  infixTriggers, cc);
-            }
+            assert(next_built < built.size());
+            assert(to_build[next_built] == leftfix);
+            auto &nfa = built[next_built++];
 
             if (!nfa) {
                 assert(!"failed to build leftfix");
@@ -1184,6 +1398,7 @@ bool buildLeftfixes(const RoseBuildImpl &tbi, build_context &bc,
 
             DEBUG_PRINTF("built leftfix, qi=%u\n", qi);
             add_nfa_to_blob(bc, *nfa);
+            nfa.reset();
             seen.emplace(leftfix, qi);
         }
 
@@ -1271,8 +1486,7 @@ public:
     };
 
     aligned_unique_ptr<NFA> operator()(unique_ptr<raw_dfa> &rdfa) const {
-        // Unleash the McClellan!
-        return mcclellanCompile(*rdfa, build.cc, build.rm);
+        return getDfa(*rdfa, false, build.cc, build.rm);
     }
 
     aligned_unique_ptr<NFA> operator()(unique_ptr<raw_som_dfa> &haig) const {
@@ -1300,7 +1514,7 @@ public:
             !has_bounded_repeats_other_than_firsts(*n)) {
             auto rdfa = buildMcClellan(h, &rm, cc.grey);
             if (rdfa) {
-                auto d = mcclellanCompile(*rdfa, cc, rm);
+                auto d = getDfa(*rdfa, false, cc, rm);
                 if (d) {
                     n = pickImpl(move(d), move(n));
                 }
@@ -1321,11 +1535,34 @@ private:
 };
 }
 
+/** \brief Returns the engine cache key for an outfix, or an empty string if it
+ * cannot be cached. */
+static
+string outfixCacheKey(const RoseBuildImpl &build, const OutfixInfo &outfix) {
+    if (!build.cc.engine_cache) {
+        return string();
+    }
+
+    EngineCacheKey key(build.cc, "outfix");
+    if (outfix.holder()) {
+        key.add(*outfix.holder());
+    } else if (outfix.rdfa()) {
+        key.add(*outfix.rdfa());
+    } else {
+        return string(); // Haig and MPV outfixes are not cached.
+    }
+    key.addReports(all_reports(outfix), build.rm);
+    return key.str();
+}
+
 static
 aligned_unique_ptr<NFA> buildOutfix(RoseBuildImpl &build, OutfixInfo &outfix) {
     assert(!outfix.is_dead()); // should not be marked dead.
 
-    auto n = boost::apply_visitor(OutfixBuilder(build), outfix.proto);
+    auto n = buildWithCache(build.cc.engine_cache,
+                            outfixCacheKey(build, outfix), [&] {
+        return boost::apply_visitor(OutfixBuilder(build), outfix.proto);
+    });
     if (n && build.cc.grey.reverseAccelerate) {
         buildReverseAcceleration(n.get(), outfix.rev_info, outfix.minWidth);
     }
@@ -1404,6 +1641,7 @@ void setOutfixProperties(NFA &n, const OutfixInfo &outfix) {
 static
 bool prepOutfixes(RoseBuildImpl &tbi, build_context &bc,
                   size_t *historyRequired) {
+    CompilePhase phase("build_outfixes");
     if (tbi.cc.grey.onlyOneOutfix && tbi.outfixes.size() > 1) {
         DEBUG_PRINTF("we have %zu outfixes, but Grey::onlyOneOutfix is set\n",
                      tbi.outfixes.size());
@@ -1412,12 +1650,24 @@ bool prepOutfixes(RoseBuildImpl &tbi, build_context &bc,
 
     assert(tbi.qif.allocated_count() == bc.engineOffsets.size());
 
+    vector<OutfixInfo *> to_build;
     for (auto &out : tbi.outfixes) {
         if (out.mpv()) {
             continue; /* already done */
         }
-        DEBUG_PRINTF("building outfix %zd\n", &out - &tbi.outfixes[0]);
-        auto n = buildOutfix(tbi, out);
+        to_build.push_back(&out);
+    }
+
+    // Each outfix owns its engine proto, so they may be built concurrently.
+    vector<aligned_unique_ptr<NFA>> built(to_build.size());
+    parallelFor(to_build.size(), tbi.cc.grey.compileThreads, [&](size_t i) {
+        DEBUG_PRINTF("building outfix %zd\n", to_build[i] - &tbi.outfixes[0]);
+        built[i] = buildOutfix(tbi, *to_build[i]);
+    });
+
+    for (size_t i = 0; i < to_build.size(); i++) {
+        OutfixInfo &out = *to_build[i];
+        auto &n = built[i];
         if (!n) {
             assert(0);
             return false;
@@ -1432,6 +1682,7 @@ bool prepOutfixes(RoseBuildImpl &tbi, build_context &bc,
         }
 
         add_nfa_to_blob(bc, *n);
+        n.reset();
     }
 
     return true;
@@ -1483,6 +1734,7 @@ void setSuffixProperties(NFA &n, const suffix_id &suff,
 static
 bool buildSuffixes(const RoseBuildImpl &tbi, build_context &bc,
                    set<u32> *no_retrigger_queues) {
+    CompilePhase phase("build_suffixes");
     map<suffix_id, set<PredTopPair> > suffixTriggers;
     findSuffixTriggers(tbi, &suffixTriggers);
 
@@ -1495,19 +1747,33 @@ bool buildSuffixes(const RoseBuildImpl &tbi, build_context &bc,
     }
     sort(begin(ordered), end(ordered));
 
-    for (const auto &e : ordered) {
-        const u32 queue = e.first;
-        const suffix_id &s = e.second;
+    vector<suffix_id> suffixes;
+    vector<map<u32, u32>> fixed_depth_tops(ordered.size());
+    vector<map<u32, vector<vector<CharReach>>>> triggers(ordered.size());
+    for (size_t i = 0; i < ordered.size(); i++) {
+        const suffix_id &s = ordered[i].second;
         const set<PredTopPair> &s_triggers = suffixTriggers.at(s);
+        findFixedDepthTops(tbi.g, s_triggers, &fixed_depth_tops[i]);
+        findTriggerSequences(tbi, s_triggers, &triggers[i]);
+        suffixes.push_back(s);
+    }
+
+    // The engines are independent, so they may be built concurrently.
+    vector<aligned_unique_ptr<NFA>> built(ordered.size());
+    parallelFor(ordered.size(), engineBuildThreads(suffixes, tbi.cc.grey),
+                [&](size_t i) {
+        auto key = suffixCacheKey(tbi, fixed_depth_tops[i], triggers[i],
+                                  suffixes[i]);
+        built[i] = buildWithCache(tbi.cc.engine_cache, key, [&] {
+            return buildSuffix(tbi.rm, tbi.ssm, fixed_depth_tops[i],
+                               triggers[i], suffixes[i], tbi.cc);
+        });
+    });
 
-        map<u32, u32> fixed_depth_tops;
-        findFixedDepthTops(tbi.g, s_triggers, &fixed_depth_tops);
-
-        map<u32, vector<vector<CharReach>>> triggers;
-        findTriggerSequences(tbi, s_triggers, &triggers);
-
-        auto n = buildSuffix(tbi.rm, tbi.ssm, fixed_depth_tops, triggers,
-                             s, tbi.cc);
+    for (size_t i = 0; i < ordered.size(); i++) {
+        const u32 queue = ordered[i].first;
+        const suffix_id &s = ordered[i].second;
+        auto &n = built[i];
         if (!n) {
             return false;
         }
@@ -1523,6 +1789,7 @@ bool buildSuffixes(const RoseBuildImpl &tbi, build_context &bc,
         }
 
         add_nfa_to_blob(bc, *n);
+        n.reset();
     }
 
     return true;
@@ -1869,6 +2136,85 @@ void buildSuffixEkeyLists(const RoseBuildImpl &tbi, build_context &bc,
     }
 }
 
+#ifdef PROFILE_SUPPORT
+template<class Container>
+static
+void addMatchIds(const ReportManager &rm, const Container &reports,
+                 set<u32> &ids) {
+    for (ReportID r : reports) {
+        const Report &report = rm.getReport(r);
+        if (isExternalReport(report) && !rm.isQuiet(report.onmatch)) {
+            ids.insert(report.onmatch);
+        }
+    }
+}
+
+/** \brief Match IDs reported by \a v and its descendants, all of which
+ * depend on the leftfix guarding \a v. */
+static
+set<u32> reachableMatchIds(const RoseBuildImpl &build, RoseVertex v) {
+    const RoseGraph &g = build.g;
+    set<u32> ids;
+    ue2::unordered_set<RoseVertex> seen;
+    vector<RoseVertex> pending = {v};
+    while (!pending.empty()) {
+        RoseVertex u = pending.back();
+        pending.pop_back();
+        if (!seen.insert(u).second) {
+            continue;
+        }
+        addMatchIds(build.rm, g[u].reports, ids);
+        if (g[u].suffix) {
+            addMatchIds(build.rm, all_reports(g[u].suffix), ids);
+        }
+        insert(&pending, pending.end(), adjacent_vertices(u, g));
+    }
+    return ids;
+}
+
+/**
+ * \brief Build the tables used by the runtime profiler to map its counters
+ * back to patterns: the sorted list of match IDs (which indexes the
+ * per-pattern counters) and, for each queue, the match IDs its engine can
+ * contribute to.
+ */
+static
+void buildProfileTables(const RoseBuildImpl &build, build_context &bc,
+                        u32 queue_count, u32 *idOffset, u32 *idCount,
+                        u32 *engineOffset) {
+    const ReportManager &rm = build.rm;
+    vector<set<u32>> engine_ids(queue_count);
+
+    for (const auto &outfix : build.outfixes) {
+        addMatchIds(rm, all_reports(outfix), engine_ids.at(outfix.get_queue()));
+    }
+
+    for (const auto &e : bc.suffixes) {
+        addMatchIds(rm, all_reports(e.first), engine_ids.at(e.second));
+    }
+
+    for (const auto &m : bc.leftfix_info) {
+        if (m.second.has_lookaround) {
+            continue;
+        }
+        insert(&engine_ids.at(m.second.queue),
+               reachableMatchIds(build, m.first));
+    }
+
+    vector<ProfileEngineInfo> infos(queue_count);
+    for (u32 qi = 0; qi < queue_count; qi++) {
+        const auto &ids = engine_ids[qi];
+        infos[qi].idOffset = add_to_engine_blob(bc, ids.begin(), ids.end());
+        infos[qi].idCount = verify_u32(ids.size());
+    }
+    *engineOffset = add_to_engine_blob(bc, infos.begin(), infos.end());
+
+    const set<u32> all_ids = findMatchIds(rm);
+    *idOffset = add_to_engine_blob(bc, all_ids.begin(), all_ids.end());
+    *idCount = verify_u32(all_ids.size());
+}
+#endif
+
 /** Returns sparse iter offset in engine blob. */
 static
 u32 buildEodNfaIterator(build_context &bc, const u32 activeQueueCount) {
@@ -2663,8 +3009,41 @@ void writeSomOperation(const Report &report, som_operation *op) {
 }
 
 static
-void makeReport(RoseBuildImpl &build, const ReportID id,
-                const bool has_som, vector<RoseInstruction> &program) {
+void makeLogicalSet(const RoseBuildImpl &build, const Report &report,
+                    vector<RoseInstruction> &report_block) {
+    if (!isExternalReport(report)) {
+        return;
+    }
+
+    u32 lkey = build.rm.pl.getLogicalKey(report.onmatch);
+    if (lkey == INVALID_LKEY) {
+        return;
+    }
+
+    auto ri = RoseInstruction(ROSE_INSTR_SET_LOGICAL);
+    ri.u.setLogical.lkey = lkey;
+    ri.u.setLogical.offset_adjust = report.offsetAdjust;
+    report_block.push_back(move(ri));
+}
+
+static
+void makeQuietReport(const Report &report,
+                     vector<RoseInstruction> &report_block) {
+    // A quiet report is never delivered, but it must still exhaust its
+    // pattern so that single-match sub-expressions stop matching.
+    if (report.ekey == INVALID_EKEY) {
+        return;
+    }
+
+    auto ri = RoseInstruction(ROSE_INSTR_SET_EXHAUST);
+    ri.u.setExhaust.ekey = report.ekey;
+    report_block.push_back(move(ri));
+}
+
+static
+void makeReport(RoseBuildImpl &build, const build_context &bc,
+                const ReportID id, const bool has_som,
+                vector<RoseInstruction> &program) {
     assert(id < build.rm.numReports());
     const Report &report = build.rm.getReport(id);
 
@@ -2711,12 +3090,25 @@ void makeReport(RoseBuildImpl &build, const ReportID id,
         report_block.emplace_back(ROSE_INSTR_SOM_ZERO);
     }
 
+    makeLogicalSet(build, report, report_block);
+
+    // Quiet reports only feed logical combinations and are never delivered
+    // to the user.
+    const bool quiet =
+        isExternalReport(report) && build.rm.isQuiet(report.onmatch);
+
     switch (report.type) {
     case EXTERNAL_CALLBACK:
+        if (quiet) {
+            makeQuietReport(report, report_block);
+            break;
+        }
         if (!has_som) {
             // Dedupe is only necessary if this report has a dkey, or if there
-            // are SOM reports to catch up.
-            bool needs_dedupe = build.rm.getDkey(report) != ~0U || build.hasSom;
+            // are SOM reports to catch up. Unordered databases tolerate
+            // duplicates.
+            bool needs_dedupe = !bc.unordered &&
+                (build.rm.getDkey(report) != ~0U || build.hasSom);
             if (report.ekey == INVALID_EKEY) {
                 if (needs_dedupe) {
                     report_block.emplace_back(ROSE_INSTR_DEDUPE_AND_REPORT,
@@ -2790,6 +3182,10 @@ void makeReport(RoseBuildImpl &build, const ReportID id,
     case EXTERNAL_CALLBACK_SOM_STORED:
     case EXTERNAL_CALLBACK_SOM_ABS:
     case EXTERNAL_CALLBACK_SOM_REV_NFA:
+        if (quiet) {
+            makeQuietReport(report, report_block);
+            break;
+        }
         makeDedupeSom(build, report, report_block);
         if (report.ekey == INVALID_EKEY) {
             report_block.emplace_back(ROSE_INSTR_REPORT_SOM);
@@ -2805,6 +3201,10 @@ void makeReport(RoseBuildImpl &build, const ReportID id,
         }
         break;
     case EXTERNAL_CALLBACK_SOM_PASS:
+        if (quiet) {
+            makeQuietReport(report, report_block);
+            break;
+        }
         makeDedupeSom(build, report, report_block);
         if (report.ekey == INVALID_EKEY) {
             report_block.emplace_back(ROSE_INSTR_REPORT_SOM);
@@ -2825,7 +3225,11 @@ void makeReport(RoseBuildImpl &build, const ReportID id,
         throw CompileError("Unable to generate bytecode.");
     }
 
-    assert(!report_block.empty());
+    if (report_block.empty()) {
+        assert(quiet);
+        return;
+    }
+
     report_block = flattenProgram({report_block});
     assert(report_block.back().code() == ROSE_INSTR_END);
     report_block.pop_back();
@@ -2859,7 +3263,7 @@ void makeRoleReports(RoseBuildImpl &build, build_context &bc, RoseVertex v,
     makeCatchup(build, bc, reports, program);
 
     for (ReportID id : reports) {
-        makeReport(build, id, has_som, program);
+        makeReport(build, bc, id, has_som, program);
     }
 }
 
@@ -3094,7 +3498,10 @@ u32 writeBoundaryProgram(RoseBuildImpl &build, build_context &bc,
     const bool has_som = false;
     vector<RoseInstruction> program;
     for (const auto &id : reports) {
-        makeReport(build, id, has_som, program);
+        makeReport(build, bc, id, has_som, program);
+    }
+    if (program.empty()) {
+        return 0; // Only quiet reports with nothing to do.
     }
     program = flattenProgram({program});
     applyFinalSpecialisation(program);
@@ -3410,6 +3817,12 @@ pair<u32, u32> makeSparseIterProgram(build_context &bc,
         program.insert(end(program), begin(root_program), end(root_program));
     }
 
+    if (program.size() == 1) {
+        // Only END remains, e.g. for a literal whose roles raise nothing but
+        // quiet reports that feed no combination.
+        return {0, iter_offset};
+    }
+
     applyFinalSpecialisation(program);
     return {writeProgram(bc, program), iter_offset};
 }
@@ -3751,10 +4164,17 @@ u32 buildReportPrograms(RoseBuildImpl &build, build_context &bc) {
         program.clear();
         const bool has_som = false;
         makeCatchupMpv(build, bc, id, program);
-        makeReport(build, id, has_som, program);
-        program = flattenProgram({program});
-        applyFinalSpecialisation(program);
-        programs[id] = writeProgram(bc, program);
+        makeReport(build, bc, id, has_som, program);
+        if (program.empty()) {
+            // A quiet report that feeds no combination has nothing to do, so
+            // it gets no program and its matches are dropped at runtime.
+            assert(rm.isQuiet(rm.getReport(id).onmatch));
+            programs[id] = 0;
+        } else {
+            program = flattenProgram({program});
+            applyFinalSpecialisation(program);
+            programs[id] = writeProgram(bc, program);
+        }
         build.rm.setProgramOffset(id, programs[id]);
         DEBUG_PRINTF("program for report %u @ %u (%zu instructions)\n", id,
                      programs.back(), program.size());
@@ -3786,7 +4206,7 @@ vector<RoseInstruction> makeEodAnchorProgram(RoseBuildImpl &build,
 
     const bool has_som = false;
     for (const auto &id : reports) {
-        makeReport(build, id, has_som, program);
+        makeReport(build, bc, id, has_som, program);
     }
 
     return program;
@@ -3966,6 +4386,7 @@ void fillMatcherDistances(const RoseBuildImpl &build, RoseEngine *engine) {
 }
 
 aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
+    CompilePhase phase("bytecode");
     DerivedBoundaryReports dboundary(boundary);
 
     size_t historyRequired = calcHistoryRequired(); // Updated by HWLM.
@@ -3975,7 +4396,8 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     build_context bc;
     bc.floatingMinLiteralMatchOffset =
         findMinFloatingLiteralMatch(*this, anchored_dfas);
-    bc.needs_catchup = needsCatchup(*this);
+    bc.unordered = canRunUnordered(*this);
+    bc.needs_catchup = !bc.unordered && needsCatchup(*this);
     recordResources(bc.resources, *this);
     if (!anchored_dfas.empty()) {
         bc.resources.has_anchored = true;
@@ -3986,6 +4408,11 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
 
     u32 reportProgramOffset = buildReportPrograms(*this, bc);
 
+    const auto &lop = rm.pl.logicalTree();
+    u32 logicalTreeOffset = add_to_engine_blob(bc, begin(lop), end(lop));
+    const auto &ci = rm.pl.combInfoMap();
+    u32 combInfoMapOffset = add_to_engine_blob(bc, begin(ci), end(ci));
+
     // Build NFAs
     set<u32> no_retrigger_queues;
     bool mpv_as_outfix;
@@ -4013,6 +4440,14 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     vector<u32> suffixEkeyLists;
     buildSuffixEkeyLists(*this, bc, qif, &suffixEkeyLists);
 
+    u32 profileIdOffset = 0;
+    u32 profileIdCount = 0;
+    u32 profileEngineOffset = 0;
+#ifdef PROFILE_SUPPORT
+    buildProfileTables(*this, bc, queue_count, &profileIdOffset,
+                       &profileIdCount, &profileEngineOffset);
+#endif
+
     assignStateIndices(*this, bc);
 
     u32 laggedRoseCount = 0;
@@ -4187,14 +4622,25 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     engine->historyRequired = verify_u32(historyRequired);
 
     engine->ekeyCount = rm.numEkeys();
-    engine->dkeyCount = rm.numDkeys();
+    engine->dkeyCount = bc.unordered ? 0 : rm.numDkeys();
     engine->invDkeyOffset = dkeyOffset;
     copy_bytes(ptr + dkeyOffset, rm.getDkeyToReportTable());
 
+    engine->lkeyCount = rm.pl.numLogicalKeys();
+    engine->lopCount = verify_u32(lop.size());
+    engine->ckeyCount = rm.pl.numCkeys();
+    engine->logicalTreeOffset = logicalTreeOffset;
+    engine->combInfoMapOffset = combInfoMapOffset;
+    engine->matchIdCount = verify_u32(findMatchIds(rm).size());
+    engine->profileIdOffset = profileIdOffset;
+    engine->profileIdCount = profileIdCount;
+    engine->profileEngineOffset = profileEngineOffset;
+
     engine->somHorizon = ssm.somPrecision();
     engine->somLocationCount = ssm.numSomSlots();
 
     engine->needsCatchup = bc.needs_catchup ? 1 : 0;
+    engine->unordered = bc.unordered ? 1 : 0;
 
     engine->literalCount = verify_u32(final_id_to_literal.size());
     engine->litProgramOffset = litProgramOffset;
@@ -4268,6 +4714,11 @@ aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildFinalEngine(u32 minWidth) {
     engine->fmatcherMaxBiAnchoredWidth = findMaxBAWidth(*this, ROSE_FLOATING);
     engine->size = currOffset;
     engine->minWidth = hasBoundaryReports(boundary) ? 0 : minWidth;
+    if (rm.pl.hasEmptyCombination()) {
+        // A combination that is true without any sub-expression matches must
+        // be reported even for empty or short data.
+        engine->minWidth = 0;
+    }
     engine->minWidthExcludingBoundaries = minWidth;
     engine->floatingMinLiteralMatchOffset = bc.floatingMinLiteralMatchOffset;
 
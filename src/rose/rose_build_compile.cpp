@@ -56,6 +56,7 @@
 #include "util/charreach_util.h"
 #include "util/compare.h"
 #include "util/compile_context.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/dump_charclass.h"
 #include "util/graph_range.h"
@@ -2096,6 +2097,7 @@ bool hasOrphanedTops(const RoseBuildImpl &tbi) {
 #endif // NDEBUG
 
 aligned_unique_ptr<RoseEngine> RoseBuildImpl::buildRose(u32 minWidth) {
+    CompilePhase phase("rose");
     dumpRoseGraph(*this, nullptr, "rose_early.dot");
 
     // Early check for Rose implementability.
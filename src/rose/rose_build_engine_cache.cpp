@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Cache of engine bytecode carried between compiles.
+ */
+#include "rose_build_engine_cache.h"
+
+#include "nfa/castlecompile.h"
+#include "nfa/nfa_internal.h"
+#include "nfa/rdfa.h"
+#include "nfagraph/ng_holder.h"
+#include "nfagraph/ng_repeat.h"
+#include "util/charreach.h"
+#include "util/compile_context.h"
+#include "util/container.h"
+#include "util/depth.h"
+#include "util/graph_range.h"
+#include "util/report.h"
+#include "util/report_manager.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace ue2 {
+
+aligned_unique_ptr<NFA> EngineCache::get(const string &key) {
+    lock_guard<mutex> guard(lock);
+
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return nullptr;
+    }
+
+    Entry &e = it->second;
+    e.used = true;
+
+    auto n = aligned_zmalloc_unique<NFA>(e.bytes.size());
+    memcpy(n.get(), e.bytes.data(), e.bytes.size());
+    return n;
+}
+
+void EngineCache::put(const string &key, const NFA &nfa) {
+    assert(nfa.length >= sizeof(NFA));
+    string bytes((const char *)&nfa, nfa.length);
+
+    lock_guard<mutex> guard(lock);
+    Entry &e = entries[key];
+    e.bytes = move(bytes);
+    e.used = true;
+}
+
+void EngineCache::prune() {
+    lock_guard<mutex> guard(lock);
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (!it->second.used) {
+            it = entries.erase(it);
+        } else {
+            it->second.used = false;
+            ++it;
+        }
+    }
+
+    DEBUG_PRINTF("%zu engines cached\n", entries.size());
+}
+
+void EngineCache::clear() {
+    lock_guard<mutex> guard(lock);
+    entries.clear();
+}
+
+size_t EngineCache::size() const {
+    lock_guard<mutex> guard(lock);
+    return entries.size();
+}
+
+EngineCacheKey::EngineCacheKey(const CompileContext &cc, const char *role) {
+    key.append(role);
+    key.push_back('\0');
+    add(cc.streaming);
+    add(cc.vectored);
+    add(cc.target_info.has_avx2());
+    add(cc.target_info.has_avx512());
+    add(cc.target_info.is_atom_class());
+}
+
+void EngineCacheKey::add(u64a val) {
+    key.append((const char *)&val, sizeof(val));
+}
+
+void EngineCacheKey::add(const CharReach &cr) {
+    u8 bits[N_CHARS / 8] = {0};
+    for (size_t i = cr.find_first(); i != CharReach::npos;
+         i = cr.find_next(i)) {
+        bits[i / 8] |= 1U << (i % 8);
+    }
+    key.append((const char *)bits, sizeof(bits));
+}
+
+void EngineCacheKey::add(const depth &d) {
+    if (d.is_finite()) {
+        add((u32)d);
+    } else {
+        add(d.is_infinite() ? ~0ULL : ~1ULL);
+    }
+}
+
+void EngineCacheKey::add(const flat_set<u32> &vals) {
+    add(vals.size());
+    for (u32 val : vals) {
+        add(val);
+    }
+}
+
+void EngineCacheKey::add(const map<u32, u32> &vals) {
+    add(vals.size());
+    for (const auto &m : vals) {
+        add(m.first);
+        add(m.second);
+    }
+}
+
+void EngineCacheKey::add(const map<u32, vector<vector<CharReach>>> &lits) {
+    add(lits.size());
+    for (const auto &m : lits) {
+        add(m.first);
+        add(m.second.size());
+        for (const auto &lit : m.second) {
+            add(lit.size());
+            for (const auto &cr : lit) {
+                add(cr);
+            }
+        }
+    }
+}
+
+void EngineCacheKey::add(const NGHolder &h) {
+    // Vertices and edges are described in the graph's own iteration order,
+    // along with their indices, as engine construction may depend on both.
+    add(h.kind);
+    add(num_vertices(h));
+    for (auto v : vertices_range(h)) {
+        add(h[v].index);
+        add(h[v].char_reach);
+        add(h[v].reports);
+        add(h[v].assert_flags);
+        add(out_degree(v, h));
+        for (const auto &e : out_edges_range(v, h)) {
+            add(h[target(e, h)].index);
+            add(h[e].index);
+            add(h[e].top);
+            add(h[e].assert_flags);
+        }
+    }
+}
+
+void EngineCacheKey::add(const raw_dfa &rdfa) {
+    add(rdfa.kind);
+    add(rdfa.start_anchored);
+    add(rdfa.start_floating);
+    add(rdfa.alpha_size);
+    for (u16 a : rdfa.alpha_remap) {
+        add(a);
+    }
+    add(rdfa.states.size());
+    for (const auto &ds : rdfa.states) {
+        add(ds.next.size());
+        for (dstate_id_t s : ds.next) {
+            add(s);
+        }
+        add(ds.daddy);
+        add(ds.impl_id);
+        add(ds.reports);
+        add(ds.reports_eod);
+    }
+}
+
+void EngineCacheKey::add(const CastleProto &proto) {
+    add(proto.kind);
+    add(proto.repeats.size());
+    for (const auto &m : proto.repeats) {
+        const PureRepeat &pr = m.second;
+        add(m.first);
+        add(pr.reach);
+        add(pr.bounds.min);
+        add(pr.bounds.max);
+        add(pr.reports);
+    }
+}
+
+void EngineCacheKey::addReports(const set<ReportID> &reports,
+                                const ReportManager &rm) {
+    add(reports.size());
+    for (ReportID id : reports) {
+        const Report &ir = rm.getReport(id);
+        add(id);
+        add(ir.type);
+        add(ir.quashSom);
+        add(ir.minOffset);
+        add(ir.maxOffset);
+        add(ir.minLength);
+        add(ir.ekey);
+        add((u64a)(s64a)ir.offsetAdjust);
+        add(ir.onmatch);
+        add(ir.revNfaIndex);
+        add(ir.somDistance);
+        add(ir.topSquashDistance);
+        add(rm.getProgramOffset(id));
+    }
+}
+
+} // namespace ue2
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Cache of engine bytecode carried between compiles.
+ */
+
+#ifndef ROSE_BUILD_ENGINE_CACHE_H
+#define ROSE_BUILD_ENGINE_CACHE_H
+
+#include "ue2common.h"
+#include "util/alloc.h"
+#include "util/ue2_containers.h"
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+struct NFA;
+
+namespace ue2 {
+
+struct CastleProto;
+class CharReach;
+class NGHolder;
+class ReportManager;
+class depth;
+struct CompileContext;
+struct raw_dfa;
+
+/**
+ * \brief Cache of engine bytecode, keyed by a complete description of the
+ * input to the engine build.
+ *
+ * Entries that are not used during a compile are discarded by \ref prune()
+ * once it has completed, so the cache holds the engines of the most recent
+ * database, plus any engines added since. The cache is safe to use from the
+ * threads of a single multi-threaded compile.
+ */
+class EngineCache : boost::noncopyable {
+public:
+    /** \brief Returns a copy of the engine stored under \a key, or nullptr if
+     * there is none. */
+    aligned_unique_ptr<NFA> get(const std::string &key);
+
+    /** \brief Stores a copy of the given engine under \a key. */
+    void put(const std::string &key, const NFA &nfa);
+
+    /** \brief Discards entries not used since the last call to prune(). */
+    void prune();
+
+    /** \brief Discards all entries. */
+    void clear();
+
+    /** \brief Number of engines stored. */
+    size_t size() const;
+
+private:
+    struct Entry {
+        std::string bytes;
+        bool used;
+    };
+
+    mutable std::mutex lock;
+    ue2::unordered_map<std::string, Entry> entries;
+};
+
+/**
+ * \brief Builder for engine cache keys.
+ *
+ * Keys describe everything that an engine build depends on. Two inputs with
+ * the same key must produce identical bytecode.
+ */
+class EngineCacheKey {
+public:
+    /** \brief Starts a key for an engine of the given role, including the
+     * mode and target information from the compile context. */
+    EngineCacheKey(const CompileContext &cc, const char *role);
+
+    void add(u64a val);
+    void add(const CharReach &cr);
+    void add(const depth &d);
+    void add(const flat_set<u32> &vals);
+    void add(const std::map<u32, u32> &vals);
+    void add(const std::map<u32, std::vector<std::vector<CharReach>>> &lits);
+    void add(const NGHolder &h);
+    void add(const raw_dfa &rdfa);
+    void add(const CastleProto &proto);
+
+    /** \brief Adds the full description of each report, and the program offset
+     * each will be remapped to. Used for engines with managed reports. */
+    void addReports(const std::set<ReportID> &reports,
+                    const ReportManager &rm);
+
+    const std::string &str() const { return key; }
+
+private:
+    std::string key;
+};
+
+/**
+ * \brief Returns the engine from \a cache for \a key if there is one,
+ * otherwise calls \a build and stores the engine it returns.
+ *
+ * An empty key means that the engine is not cacheable.
+ */
+template<class BuildFunc>
+aligned_unique_ptr<NFA> buildWithCache(EngineCache *cache,
+                                       const std::string &key,
+                                       BuildFunc &&build) {
+    if (!cache || key.empty()) {
+        return build();
+    }
+
+    auto n = cache->get(key);
+    if (n) {
+        DEBUG_PRINTF("engine cache hit\n");
+        return n;
+    }
+
+    n = build();
+    if (n) {
+        cache->put(key, *n);
+    }
+    return n;
+}
+
+} // namespace ue2
+
+#endif
@@ -41,6 +41,7 @@
 #include "util/charreach_util.h"
 #include "util/compile_context.h"
 #include "util/compile_error.h"
+#include "util/compile_report.h"
 #include "util/dump_charclass.h"
 #include "util/report.h"
 #include "util/report_manager.h"
@@ -526,6 +527,7 @@ aligned_unique_ptr<HWLM> buildFloatingMatcher(const RoseBuildImpl &build,
                                               size_t *fsize,
                                               size_t *historyRequired,
                                               size_t *streamStateRequired) {
+    CompilePhase phase("floating_matcher");
     *fsize = 0;
 
     auto fl = fillHamsterLiteralList(build, ROSE_FLOATING);
@@ -573,6 +575,7 @@ aligned_unique_ptr<HWLM> buildFloatingMatcher(const RoseBuildImpl &build,
 
 aligned_unique_ptr<HWLM> buildSmallBlockMatcher(const RoseBuildImpl &build,
                                                 size_t *sbsize) {
+    CompilePhase phase("small_block_matcher");
     *sbsize = 0;
 
     if (build.cc.streaming) {
@@ -634,6 +637,7 @@ aligned_unique_ptr<HWLM> buildSmallBlockMatcher(const RoseBuildImpl &build,
 
 aligned_unique_ptr<HWLM> buildEodAnchoredMatcher(const RoseBuildImpl &build,
                                                  size_t *esize) {
+    CompilePhase phase("eod_anchored_matcher");
     *esize = 0;
 
     auto el = fillHamsterLiteralList(build, ROSE_EOD_ANCHORED);
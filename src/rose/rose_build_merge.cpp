@@ -61,6 +61,7 @@
 #include "util/bitutils.h"
 #include "util/charreach.h"
 #include "util/compile_context.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/dump_charclass.h"
 #include "util/graph_range.h"
@@ -197,6 +198,7 @@ struct UncalcLeafKey {
  * same suffix is required for a merge to occur.
  */
 void mergeDupeLeaves(RoseBuildImpl &tbi) {
+    CompilePhase phase("merge_dupe_leaves");
     map<DupeLeafKey, RoseVertex> leaves;
     vector<RoseVertex> changed;
 
@@ -535,6 +537,7 @@ private:
  * should be retired entirely.
  */
 bool dedupeLeftfixes(RoseBuildImpl &tbi) {
+    CompilePhase phase("dedupe_leftfixes");
     DEBUG_PRINTF("deduping leftfixes\n");
     map<RoseGroup, deque<RoseVertex>> roses;
     bool work_done = false;
@@ -637,6 +640,7 @@ bool is_equal(const suffix_id &s1, const suffix_id &s2) {
  * Note: does not dedupe suffixes of vertices in the EOD table.
  */
 void dedupeSuffixes(RoseBuildImpl &tbi) {
+    CompilePhase phase("dedupe_suffixes");
     DEBUG_PRINTF("deduping suffixes\n");
 
     ue2::unordered_map<suffix_id, set<RoseVertex>> suffix_map;
@@ -1490,6 +1494,7 @@ u32 commonPrefixLength(left_id &r1, left_id &r2) {
  *   reformed to optimise a leading repeat.
  */
 void mergeLeftfixesVariableLag(RoseBuildImpl &tbi) {
+    CompilePhase phase("merge_leftfixes_variable_lag");
     if (!tbi.cc.grey.mergeRose) {
         return;
     }
@@ -1671,6 +1676,7 @@ private:
  * logic checks are shared with the mergeLeftfix functions.
  */
 void dedupeLeftfixesVariableLag(RoseBuildImpl &tbi) {
+    CompilePhase phase("dedupe_leftfixes_variable_lag");
     map<DedupeLeftKey, RoseBouquet> roseGrouping;
 
     DEBUG_PRINTF("entry\n");
@@ -2044,6 +2050,7 @@ void mergeCastleChunk(RoseBuildImpl &tbi, RoseBouquet &cands) {
  * pass and will remain using an unmerged graph.
  */
 void mergeSmallLeftfixes(RoseBuildImpl &tbi) {
+    CompilePhase phase("merge_small_leftfixes");
     DEBUG_PRINTF("entry\n");
 
     if (!tbi.cc.grey.mergeRose || !tbi.cc.grey.roseMultiTopRoses) {
@@ -2116,6 +2123,7 @@ void mergeSmallLeftfixes(RoseBuildImpl &tbi) {
 }
 
 void mergeCastleLeftfixes(RoseBuildImpl &tbi) {
+    CompilePhase phase("merge_castle_leftfixes");
     DEBUG_PRINTF("entry\n");
 
     if (!tbi.cc.grey.mergeRose || !tbi.cc.grey.roseMultiTopRoses ||
@@ -2288,6 +2296,7 @@ void mergeSuffixes(RoseBuildImpl &tbi, SuffixBouquet &suffixes,
  * handled outside of an NFA or DFA.
  */
 void mergeAcyclicSuffixes(RoseBuildImpl &tbi) {
+    CompilePhase phase("merge_acyclic_suffixes");
     DEBUG_PRINTF("entry\n");
 
     if (!tbi.cc.grey.mergeSuffixes) {
@@ -2351,6 +2360,7 @@ void mergeAcyclicSuffixes(RoseBuildImpl &tbi) {
  * handled outside of an NFA or DFA.
  */
 void mergeSmallSuffixes(RoseBuildImpl &tbi) {
+    CompilePhase phase("merge_small_suffixes");
     DEBUG_PRINTF("entry\n");
 
     if (!tbi.cc.grey.mergeSuffixes) {
@@ -2706,6 +2716,7 @@ void mergeOutfixHaigs(RoseBuildImpl &tbi, vector<raw_som_dfa *> &dfas,
  * implemented efficiently.
  */
 void mergeOutfixes(RoseBuildImpl &tbi) {
+    CompilePhase phase("merge_outfixes");
     if (!tbi.cc.grey.mergeOutfixes) {
         return;
     }
@@ -2770,6 +2781,7 @@ u32 allowedSquashDistance(const CharReach &cr, u32 min_width,
 }
 
 void mergePuffixes(RoseBuildImpl &tbi) {
+    CompilePhase phase("merge_puffixes");
     DEBUG_PRINTF("entry\n");
 
     if (!tbi.cc.grey.mergeSuffixes) {
@@ -2902,6 +2914,7 @@ void mergeCastleSuffixes(RoseBuildImpl &tbi,
 }
 
 void mergeCastleSuffixes(RoseBuildImpl &tbi) {
+    CompilePhase phase("merge_castle_suffixes");
     DEBUG_PRINTF("entry\n");
 
     if (!(tbi.cc.grey.allowCastle && tbi.cc.grey.mergeSuffixes)) {
@@ -45,6 +45,7 @@
 #include "nfagraph/ng_util.h"
 #include "util/bitutils.h"
 #include "util/compile_context.h"
+#include "util/compile_report.h"
 #include "util/container.h"
 #include "util/graph.h"
 #include "util/graph_range.h"
@@ -1940,6 +1941,7 @@ void filterDiamondCandidates(RoseGraph &g, CandidateSet &candidates) {
 }
 
 void aliasRoles(RoseBuildImpl &build, bool mergeRoses) {
+    CompilePhase phase("alias_roles");
     const CompileContext &cc = build.cc;
     RoseGraph &g = build.g;
 
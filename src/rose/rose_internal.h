@@ -196,6 +196,19 @@ struct RoseStateOffsets {
      * reports with that ekey should not be delivered to the user. */
     u32 exhausted;
 
+    /** Logical multibit.
+     *
+     * 1 bit per logical key: one for each sub-expression used by a logical
+     * combination, and one for the result of each operation in the
+     * combination trees. */
+    u32 logicalVec;
+
+    /** Combination multibit.
+     *
+     * 1 bit per logical combination, set once the combination has been
+     * reported to the user. */
+    u32 combVec;
+
     /** Multibit for active suffix/outfix engines. */
     u32 activeLeafArray;
 
@@ -271,6 +284,36 @@ struct RoseBoundaryReports {
  *  #
  */
 
+#define LOGICAL_OP_NOT 0
+#define LOGICAL_OP_AND 1
+#define LOGICAL_OP_OR  2
+
+/** \brief An operation in the tree of a logical combination.
+ *
+ * Operations are stored with operands before the operations that use them,
+ * so the whole table can be evaluated in a single pass. */
+struct LogicalOp {
+    u32 id; //!< Logical key that receives the result of this operation.
+    u32 op; //!< One of LOGICAL_OP_{NOT,AND,OR}.
+    u32 lo; //!< Logical key of the left (or only) operand.
+    u32 ro; //!< Logical key of the right operand, unused for LOGICAL_OP_NOT.
+};
+
+/** \brief A logical combination, reported when its result key is on. */
+struct CombInfo {
+    u32 id; //!< Combination key, indexing the combination multibit.
+    u32 result; //!< Logical key holding the value of the combination.
+    ReportID onmatch; //!< Report ID to deliver to user.
+    u8 highlander; //!< Only report this combination once.
+};
+
+/** \brief Profiling record for the engine on one queue: the match IDs that
+ * the engine can contribute to. Only built by profiling builds. */
+struct ProfileEngineInfo {
+    u32 idOffset; //!< Offset of a sorted array of match IDs, or 0.
+    u32 idCount; //!< Number of entries in that array.
+};
+
 #define ROSE_RUNTIME_FULL_ROSE     0
 #define ROSE_RUNTIME_PURE_LITERAL  1
 #define ROSE_RUNTIME_SINGLE_OUTFIX 2
@@ -306,12 +349,27 @@ struct RoseEngine {
     u8  somHorizon; /**< width in bytes of SOM offset storage (governed by
                         SOM precision) */
     u8 needsCatchup; /** catch up needs to be run on every report. */
+    u8 unordered; /**< matches need not be delivered in order; engines are
+                   * run to completion without cross-engine catch up. */
     u32 mode; /**< scanning mode, one of HS_MODE_{BLOCK,STREAM,VECTORED} */
     u32 historyRequired; /**< max amount of history required for streaming */
     u32 ekeyCount; /**< number of exhaustion keys */
     u32 dkeyCount; /**< number of dedupe keys */
     u32 invDkeyOffset; /**< offset to table mapping from dkeys to the external
                          *  report ids */
+    u32 lkeyCount; /**< number of logical keys */
+    u32 lopCount; /**< number of logical operations */
+    u32 ckeyCount; /**< number of logical combinations */
+    u32 logicalTreeOffset; /**< offset to array of struct LogicalOp */
+    u32 combInfoMapOffset; /**< offset to array of struct CombInfo */
+    u32 matchIdCount; /**< number of distinct match IDs that can be delivered
+                       * to the user */
+    u32 profileIdOffset; /**< offset to the sorted array of those match IDs,
+                          * used to index per-pattern profiling counters; 0
+                          * unless built with profiling support */
+    u32 profileIdCount; /**< number of entries in the profileIdOffset array */
+    u32 profileEngineOffset; /**< offset to array of struct ProfileEngineInfo,
+                              * one per queue, or 0 */
     u32 somLocationCount; /**< number of som locations required */
     u32 rolesWithStateCount; // number of roles with entries in state bitset
     u32 stateSize; /* size of the state bitset
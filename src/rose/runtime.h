@@ -147,12 +147,14 @@ u32 has_chained_nfas(const struct RoseEngine *t) {
 }
 
 static really_inline
-void updateLastMatchOffset(struct RoseContext *tctxt, u64a offset) {
+void updateLastMatchOffset(UNUSED const struct RoseEngine *t,
+                           struct RoseContext *tctxt, u64a offset) {
     DEBUG_PRINTF("match @%llu, last match @%llu\n", offset,
                  tctxt->lastMatchOffset);
 
-    assert(offset >= tctxt->minMatchOffset);
-    assert(offset >= tctxt->lastMatchOffset);
+    /* unordered databases may report matches in any order */
+    assert(t->unordered || offset >= tctxt->minMatchOffset);
+    assert(t->unordered || offset >= tctxt->lastMatchOffset);
     tctxt->lastMatchOffset = offset;
 }
 
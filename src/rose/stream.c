@@ -37,6 +37,7 @@
 #include "nfa/nfa_api_queue.h"
 #include "nfa/nfa_internal.h"
 #include "util/fatbit.h"
+#include "util/profile.h"
 #include "rose.h"
 
 static rose_inline
@@ -417,8 +418,10 @@ void do_rebuild(const struct RoseEngine *t, const struct HWLM *ftable,
 
     scratch->core_info.status &= ~STATUS_DELAY_DIRTY;
 
+    PROFILE_MARK(mark);
     hwlmExec(ftable, buf, len, 0, roseDelayRebuildCallback, scratch,
              scratch->tctxt.groups);
+    PROFILE_MATCHER(scratch, FLOATING, mark, len);
     assert(!can_stop_matching(scratch));
 }
 
@@ -467,7 +470,9 @@ void roseStreamExec(const struct RoseEngine *t, struct hs_scratch *scratch) {
     scratch->al_log_sum = 0;
     scratch->catchup_pq.qm_size = 0;
 
-    if (t->outfixBeginQueue != t->outfixEndQueue) {
+    /* unordered databases run their outfixes when they catch up at the end
+     * of the write instead */
+    if (t->outfixBeginQueue != t->outfixEndQueue && !t->unordered) {
         streamInitSufPQ(t, state, scratch);
     }
 
@@ -477,7 +482,9 @@ void roseStreamExec(const struct RoseEngine *t, struct hs_scratch *scratch) {
     const struct anchored_matcher_info *atable = getALiteralMatcher(t);
     if (atable && alen) {
         DEBUG_PRINTF("BEGIN ANCHORED %zu/%u\n", scratch->core_info.hlen, alen);
+        PROFILE_MARK(mark);
         runAnchoredTableStream(t, atable, alen, offset, scratch);
+        PROFILE_MATCHER(scratch, ANCHORED, mark, alen);
 
         if (can_stop_matching(scratch)) {
             goto exit;
@@ -539,8 +546,10 @@ void roseStreamExec(const struct RoseEngine *t, struct hs_scratch *scratch) {
         }
 
         DEBUG_PRINTF("BEGIN FLOATING (over %zu/%zu)\n", flen, length);
+        PROFILE_MARK(mark);
         hwlmExecStreaming(ftable, scratch, flen, start, roseCallback, scratch,
                           tctxt->groups, stream_state);
+        PROFILE_MATCHER(scratch, FLOATING, mark, flen);
     }
 
 flush_delay_and_exit:
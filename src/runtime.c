@@ -52,10 +52,12 @@
 #include "som/som_runtime.h"
 #include "som/som_stream.h"
 #include "state.h"
+#include "stream_compress.h"
 #include "ue2common.h"
 #include "util/exhaust.h"
 #include "util/fatbit.h"
 #include "util/multibit.h"
+#include "util/profile.h"
 
 static really_inline
 void prefetch_data(const char *data, unsigned length) {
@@ -105,6 +107,13 @@ char validScratch(const struct RoseEngine *t, const struct hs_scratch *s) {
         return 0;
     }
 
+    if (t->mode == HS_MODE_VECTORED
+        && (sizeof(struct hs_stream) + t->stateOffsets.end > s->bStateSize
+            || s->vectorBufSize < VECTORED_GATHER_SIZE)) {
+        DEBUG_PRINTF("bad vectored state size\n");
+        return 0;
+    }
+
     if (t->queueCount > s->queueCount) {
         DEBUG_PRINTF("bad queue count\n");
         return 0;
@@ -134,6 +143,12 @@ void populateCoreInfo(struct hs_scratch *s, const struct RoseEngine *rose,
     s->core_info.hbuf = history;
     s->core_info.hlen = hlen;
     s->core_info.buf_offset = offset;
+    s->core_info.resultMode = RESULT_MODE_CALLBACK;
+
+#ifdef PROFILE_SUPPORT
+    s->profile->ids = getByOffset(rose, rose->profileIdOffset);
+    s->profile->idCount = rose->profileIdCount;
+#endif
 
     /* and some stuff not actually in core info */
     s->som_set_now_offset = ~0ULL;
@@ -143,6 +158,7 @@ void populateCoreInfo(struct hs_scratch *s, const struct RoseEngine *rose,
     // Rose program execution (used for some report paths) depends on these
     // values being initialised.
     s->tctxt.lastMatchOffset = 0;
+    s->tctxt.lastCombMatchOffset = ~0ULL;
     s->tctxt.minMatchOffset = offset;
     s->tctxt.minNonMpvMatchOffset = offset;
 }
@@ -198,8 +214,10 @@ void pureLiteralBlockExec(const struct RoseEngine *rose,
     size_t length = scratch->core_info.len;
     DEBUG_PRINTF("rose engine %d\n", rose->runtimeImpl);
 
+    PROFILE_MARK(mark);
     hwlmExec(ftable, buffer, length, 0, rosePureLiteralCallback, scratch,
              rose->initialGroups);
+    PROFILE_MATCHER(scratch, FLOATING, mark, length);
 }
 
 static really_inline
@@ -293,39 +311,26 @@ void runSmallWriteEngine(const struct SmallWriteEngine *smwr,
     }
 }
 
-HS_PUBLIC_API
-hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
-                   unsigned flags, hs_scratch_t *scratch,
-                   match_event_handler onEvent, void *userCtx) {
-    if (unlikely(!scratch || !data)) {
-        return HS_INVALID;
-    }
-
-    hs_error_t err = validDatabase(db);
-    if (unlikely(err != HS_SUCCESS)) {
-        return err;
-    }
-
-    const struct RoseEngine *rose = hs_get_bytecode(db);
-    if (unlikely(!ISALIGNED_16(rose))) {
-        return HS_INVALID;
-    }
-
-    if (unlikely(rose->mode != HS_MODE_BLOCK)) {
-        return HS_DB_MODE_ERROR;
-    }
-
-    if (unlikely(!validScratch(rose, scratch))) {
-        return HS_INVALID;
-    }
-
-    if (unlikely(markScratchInUse(scratch))) {
-        return HS_SCRATCH_IN_USE;
-    }
+/** \brief Set up scratch to record matches in a caller-provided result array
+ * rather than calling the user callback. */
+static really_inline
+void initResults(struct hs_scratch *scratch, const struct RoseEngine *rose,
+                 u8 result_mode, void *results, u32 result_size) {
+    struct core_info *ci = &scratch->core_info;
+    ci->resultMode = result_mode;
+    ci->resultSize = result_size;
+    ci->resultPending = rose->matchIdCount;
+    ci->resultBitmap = result_mode == RESULT_MODE_BITMAP ? results : NULL;
+    ci->resultCounts = result_mode == RESULT_MODE_COUNT ? results : NULL;
+}
 
+static really_inline
+hs_error_t scanBlock_i(const struct RoseEngine *rose, const char *data,
+                       unsigned length, unsigned flags, hs_scratch_t *scratch,
+                       match_event_handler onEvent, void *userCtx,
+                       u8 result_mode, void *results, u32 result_size) {
     if (rose->minWidth > length) {
         DEBUG_PRINTF("minwidth=%u > length=%u\n", rose->minWidth, length);
-        unmarkScratchInUse(scratch);
         return HS_SUCCESS;
     }
 
@@ -335,8 +340,18 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
     populateCoreInfo(scratch, rose, scratch->bstate, onEvent, userCtx, data,
                      length, NULL, 0, 0, 0, flags);
 
+    if (result_mode != RESULT_MODE_CALLBACK) {
+        initResults(scratch, rose, result_mode, results, result_size);
+    }
+
     clearEvec(rose, scratch->core_info.exhaustionVector);
 
+    if (rose->ckeyCount) {
+        u8 *state = (u8 *)scratch->core_info.state;
+        clearLvec(rose, state + rose->stateOffsets.logicalVec);
+        clearCvec(rose, state + rose->stateOffsets.combVec);
+    }
+
     if (!length) {
         if (rose->boundary.reportZeroEodOffset) {
             roseRunBoundaryProgram(rose, rose->boundary.reportZeroEodOffset, 0,
@@ -399,15 +414,13 @@ hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
 
 done_scan:
     if (told_to_stop_matching(scratch)) {
-        unmarkScratchInUse(scratch);
         return HS_SCAN_TERMINATED;
     }
 
     if (rose->hasSom) {
         int halt = flushStoredSomMatches(scratch, ~0ULL);
         if (halt) {
-            unmarkScratchInUse(scratch);
-            return HS_SCAN_TERMINATED;
+            goto set_retval;
         }
     }
 
@@ -417,14 +430,273 @@ done_scan:
     }
 
 set_retval:
+    if (rose->ckeyCount && !can_stop_matching(scratch)) {
+        roseFlushLastCombination(rose, scratch, length);
+    }
+
     DEBUG_PRINTF("done. told_to_stop_matching=%d\n",
                  told_to_stop_matching(scratch));
-    hs_error_t rv = told_to_stop_matching(scratch) ? HS_SCAN_TERMINATED
-                                                   : HS_SUCCESS;
+    return told_to_stop_matching(scratch) ? HS_SCAN_TERMINATED : HS_SUCCESS;
+}
+
+/** \brief Scan a single block with a validated database and scratch that has
+ * already been marked in use. Shared by \ref hs_scan, \ref hs_scan_batch and
+ * the callback-free scan modes.
+ */
+static really_inline
+hs_error_t scanBlock(const struct RoseEngine *rose, const char *data,
+                     unsigned length, unsigned flags, hs_scratch_t *scratch,
+                     match_event_handler onEvent, void *userCtx,
+                     u8 result_mode, void *results, u32 result_size) {
+    PROFILE_MARK(mark);
+    hs_error_t rv = scanBlock_i(rose, data, length, flags, scratch, onEvent,
+                                userCtx, result_mode, results, result_size);
+    PROFILE_SCAN(scratch, mark, length);
+    return rv;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scan(const hs_database_t *db, const char *data, unsigned length,
+                   unsigned flags, hs_scratch_t *scratch,
+                   match_event_handler onEvent, void *userCtx) {
+    if (unlikely(!scratch || !data)) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(rose->mode != HS_MODE_BLOCK)) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    if (unlikely(!validScratch(rose, scratch))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(markScratchInUse(scratch))) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    hs_error_t rv = scanBlock(rose, data, length, flags, scratch, onEvent,
+                              userCtx, RESULT_MODE_CALLBACK, NULL, 0);
     unmarkScratchInUse(scratch);
     return rv;
 }
 
+/** \brief How many buffers ahead of the current one \ref hs_scan_batch
+ * prefetches. */
+#define BATCH_PREFETCH_DISTANCE 8
+
+/** \brief Number of buffers \ref hs_scan_batch probes together with the small
+ * write DFA. Must match \ref nfaExecMcClellan8_Probe4. */
+#define BATCH_PROBE_WIDTH 4
+
+/** \brief Number of buffers \ref hs_scan_batch scans without probing after a
+ * probe in which every buffer could match, as probing is wasted effort when
+ * most buffers match. */
+#define BATCH_PROBE_BACKOFF 64
+
+/** \brief Returns non-zero if \ref scanBlock on a block of this length would
+ * do nothing but run the small write engine. */
+static really_inline
+char batchProbeable(const struct RoseEngine *rose,
+                    const struct SmallWriteEngine *smwr, unsigned length) {
+    return !rose->ckeyCount
+        && length >= rose->minWidth
+        && length >= rose->minWidthExcludingBoundaries
+        && (rose->maxBiAnchoredWidth == ROSE_BOUND_INF
+            || length <= rose->maxBiAnchoredWidth)
+        && length < smwr->largestBuffer
+        && length > smwr->start_offset;
+}
+
+/** \brief Run the small write DFA over the next group of buffers in lockstep.
+ *
+ * Returns zero if any buffer in the group is unsuitable. Otherwise, bit i of
+ * \a hits is set for each buffer that may raise a match; the others need no
+ * further scanning at all.
+ */
+static really_inline
+char batchProbeGroup(const struct RoseEngine *rose,
+                     const struct SmallWriteEngine *smwr,
+                     const char *const *data, const unsigned int *length,
+                     u32 *hits) {
+    const u8 *buf[BATCH_PROBE_WIDTH];
+    size_t len[BATCH_PROBE_WIDTH];
+
+    for (u32 i = 0; i < BATCH_PROBE_WIDTH; i++) {
+        if (!batchProbeable(rose, smwr, length[i])) {
+            return 0;
+        }
+        buf[i] = (const u8 *)data[i] + smwr->start_offset;
+        len[i] = length[i] - smwr->start_offset;
+    }
+
+    *hits = nfaExecMcClellan8_Probe4(getSmwrNfa(smwr), buf, len);
+    return 1;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scan_batch(const hs_database_t *db, const char *const *data,
+                         const unsigned int *length, unsigned int count,
+                         unsigned int flags, hs_scratch_t *scratch,
+                         match_event_handler onEvent, void *const *context) {
+    if (unlikely(!scratch || !data || !length)) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(rose->mode != HS_MODE_BLOCK)) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    if (unlikely(!validScratch(rose, scratch))) {
+        return HS_INVALID;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        if (unlikely(!data[i])) {
+            return HS_INVALID;
+        }
+    }
+
+    if (unlikely(markScratchInUse(scratch))) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    for (u32 i = 0; i < count && i < BATCH_PREFETCH_DISTANCE; i++) {
+        prefetch_data(data[i], length[i]);
+    }
+
+    /* When the small write engine would be the only thing run over a group
+     * of buffers, we first run its DFA over the whole group interleaved and
+     * only scan the buffers that can match. This is not possible if boundary
+     * reports have to be raised for every buffer regardless. */
+    const struct SmallWriteEngine *smwr = NULL;
+    if (rose->smallWriteOffset && !rose->boundary.reportZeroOffset
+        && !rose->boundary.reportEodOffset) {
+        smwr = getSmallWrite(rose);
+        if (getSmwrNfa(smwr)->type != MCCLELLAN_NFA_8) {
+            smwr = NULL;
+        }
+    }
+
+    hs_error_t rv = HS_SUCCESS;
+    u32 i = 0;
+    u32 no_probe_until = 0;
+    while (i < count) {
+        u32 group = 1;
+        u32 hits = 1;
+        if (smwr && i >= no_probe_until && count - i >= BATCH_PROBE_WIDTH
+            && batchProbeGroup(rose, smwr, data + i, length + i, &hits)) {
+            group = BATCH_PROBE_WIDTH;
+            if (hits == (1U << BATCH_PROBE_WIDTH) - 1) {
+                no_probe_until = i + BATCH_PROBE_BACKOFF;
+            }
+        }
+
+        for (u32 j = 0; j < group; j++, i++) {
+            u32 ahead = i + BATCH_PREFETCH_DISTANCE;
+            if (ahead < count) {
+                prefetch_data(data[ahead], length[ahead]);
+            }
+
+            if (!(hits & (1U << j))) {
+                DEBUG_PRINTF("buffer %u/%u len=%u cannot match\n", i, count,
+                             length[i]);
+                continue;
+            }
+
+            DEBUG_PRINTF("buffer %u/%u len=%u\n", i, count, length[i]);
+            hs_error_t ret = scanBlock(rose, data[i], length[i], flags,
+                                       scratch, onEvent,
+                                       context ? context[i] : NULL,
+                                       RESULT_MODE_CALLBACK, NULL, 0);
+            if (ret != HS_SUCCESS) {
+                /* termination only ends the scan of the current buffer */
+                assert(ret == HS_SCAN_TERMINATED);
+                rv = ret;
+            }
+        }
+    }
+
+    unmarkScratchInUse(scratch);
+    return rv;
+}
+
+/** \brief Shared implementation of the callback-free block mode scans. */
+static really_inline
+hs_error_t scanResults(const hs_database_t *db, const char *data,
+                       unsigned length, unsigned flags, hs_scratch_t *scratch,
+                       u8 result_mode, void *results, unsigned num_ids) {
+    if (unlikely(!scratch || !data || !results)) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(rose->mode != HS_MODE_BLOCK)) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    if (unlikely(!validScratch(rose, scratch))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(markScratchInUse(scratch))) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    hs_error_t rv = scanBlock(rose, data, length, flags, scratch, NULL, NULL,
+                              result_mode, results, num_ids);
+    assert(rv == HS_SUCCESS);
+    unmarkScratchInUse(scratch);
+    return rv;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scan_bitmap(const hs_database_t *db, const char *data,
+                          unsigned int length, unsigned int flags,
+                          hs_scratch_t *scratch, unsigned char *bitmap,
+                          unsigned int num_ids) {
+    return scanResults(db, data, length, flags, scratch, RESULT_MODE_BITMAP,
+                       bitmap, num_ids);
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scan_count(const hs_database_t *db, const char *data,
+                         unsigned int length, unsigned int flags,
+                         hs_scratch_t *scratch, unsigned long long *counts,
+                         unsigned int num_ids) {
+    return scanResults(db, data, length, flags, scratch, RESULT_MODE_COUNT,
+                       counts, num_ids);
+}
+
 static really_inline
 void maintainHistoryBuffer(const struct RoseEngine *rose, char *state,
                            const char *buffer, size_t length) {
@@ -477,6 +749,10 @@ void init_stream(struct hs_stream *s, const struct RoseEngine *rose) {
     roseInitState(rose, state);
 
     clearEvec(rose, state + rose->stateOffsets.exhausted);
+    if (rose->ckeyCount) {
+        clearLvec(rose, (u8 *)state + rose->stateOffsets.logicalVec);
+        clearCvec(rose, (u8 *)state + rose->stateOffsets.combVec);
+    }
 
     // SOM state multibit structures.
     initSomState(rose, state);
@@ -572,8 +848,8 @@ void soleOutfixEodExec(hs_stream_t *id, hs_scratch_t *scratch) {
 }
 
 static really_inline
-void report_eod_matches(hs_stream_t *id, hs_scratch_t *scratch,
-                        match_event_handler onEvent, void *context) {
+void report_eod_matches_i(hs_stream_t *id, hs_scratch_t *scratch,
+                          match_event_handler onEvent, void *context) {
     DEBUG_PRINTF("--- report eod matches at offset %llu\n", id->offset);
     assert(onEvent);
 
@@ -633,6 +909,18 @@ void report_eod_matches(hs_stream_t *id, hs_scratch_t *scratch,
             scratch->core_info.status |= STATUS_TERMINATED;
         }
     }
+
+    if (rose->ckeyCount && !told_to_stop_matching(scratch)) {
+        roseFlushLastCombination(rose, scratch, id->offset);
+    }
+}
+
+static really_inline
+void report_eod_matches(hs_stream_t *id, hs_scratch_t *scratch,
+                        match_event_handler onEvent, void *context) {
+    PROFILE_MARK(mark);
+    report_eod_matches_i(id, scratch, onEvent, context);
+    PROFILE_SCAN(scratch, mark, 0);
 }
 
 HS_PUBLIC_API
@@ -699,6 +987,95 @@ hs_error_t hs_reset_and_copy_stream(hs_stream_t *to_id,
     return HS_SUCCESS;
 }
 
+HS_PUBLIC_API
+hs_error_t hs_compress_stream(const hs_stream_t *stream, char *buf,
+                              size_t buf_space, size_t *used_space) {
+    if (unlikely(!stream || !stream->rose || !used_space)) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(!buf && buf_space)) {
+        return HS_INVALID;
+    }
+
+    *used_space = compressStream(stream, buf, buf_space);
+    if (!buf || *used_space > buf_space) {
+        return HS_INSUFFICIENT_SPACE;
+    }
+
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_expand_stream(const hs_database_t *db, hs_stream_t **stream,
+                            const char *buf, size_t buf_size) {
+    if (unlikely(!stream || !buf)) {
+        return HS_INVALID;
+    }
+
+    *stream = NULL;
+
+    hs_error_t err = validDatabase(db);
+    if (unlikely(err != HS_SUCCESS)) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    if (unlikely(!ISALIGNED_16(rose))) {
+        return HS_INVALID;
+    }
+
+    if (unlikely(rose->mode != HS_MODE_STREAM)) {
+        return HS_DB_MODE_ERROR;
+    }
+
+    size_t stateSize = sizeof(struct hs_stream) + rose->stateOffsets.end;
+    struct hs_stream *s = hs_stream_alloc(stateSize);
+    if (unlikely(!s)) {
+        return HS_NOMEM;
+    }
+
+    if (!expandStream(s, rose, buf, buf_size)) {
+        hs_stream_free(s);
+        return HS_INVALID;
+    }
+
+    *stream = s;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_reset_and_expand_stream(hs_stream_t *to_stream,
+                                      const char *buf, size_t buf_size,
+                                      hs_scratch_t *scratch,
+                                      match_event_handler onEvent,
+                                      void *context) {
+    if (unlikely(!to_stream || !to_stream->rose || !buf)) {
+        return HS_INVALID;
+    }
+
+    const struct RoseEngine *rose = to_stream->rose;
+
+    if (onEvent) {
+        if (!scratch || !validScratch(rose, scratch)) {
+            return HS_INVALID;
+        }
+        if (unlikely(markScratchInUse(scratch))) {
+            return HS_SCRATCH_IN_USE;
+        }
+        report_eod_matches(to_stream, scratch, onEvent, context);
+        unmarkScratchInUse(scratch);
+    }
+
+    if (!expandStream(to_stream, rose, buf, buf_size)) {
+        // leave a usable, freshly-opened stream behind
+        init_stream(to_stream, rose);
+        return HS_INVALID;
+    }
+
+    return HS_SUCCESS;
+}
+
 static really_inline
 void rawStreamExec(struct hs_stream *stream_state, struct hs_scratch *scratch) {
     assert(stream_state);
@@ -747,8 +1124,10 @@ void pureLiteralStreamExec(struct hs_stream *stream_state,
     // start the match region at zero.
     const size_t start = 0;
 
+    PROFILE_MARK(mark);
     hwlmExecStreaming(ftable, scratch, len2, start, rosePureLiteralCallback,
                       scratch, rose->initialGroups, hwlm_stream_state);
+    PROFILE_MATCHER(scratch, FLOATING, mark, len2);
 
     if (!told_to_stop_matching(scratch) &&
         isAllExhausted(rose, scratch->core_info.exhaustionVector)) {
@@ -793,11 +1172,10 @@ void soleOutfixStreamExec(struct hs_stream *stream_state,
     }
 }
 
-static inline
-hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
-                                   unsigned length, UNUSED unsigned flags,
-                                   hs_scratch_t *scratch,
-                                   match_event_handler onEvent, void *context) {
+static really_inline
+hs_error_t scanStream_i(hs_stream_t *id, const char *data, unsigned length,
+                        UNUSED unsigned flags, hs_scratch_t *scratch,
+                        match_event_handler onEvent, void *context) {
     assert(id);
     assert(scratch);
 
@@ -875,6 +1253,10 @@ hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
         }
     }
 
+    if (rose->ckeyCount && !told_to_stop_matching(scratch)) {
+        roseFlushPendingCombination(rose, scratch);
+    }
+
     setStreamStatus(state, scratch->core_info.status);
 
     if (likely(!can_stop_matching(scratch))) {
@@ -891,6 +1273,18 @@ hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
     return HS_SUCCESS;
 }
 
+static inline
+hs_error_t hs_scan_stream_internal(hs_stream_t *id, const char *data,
+                                   unsigned length, unsigned flags,
+                                   hs_scratch_t *scratch,
+                                   match_event_handler onEvent, void *context) {
+    PROFILE_MARK(mark);
+    hs_error_t rv = scanStream_i(id, data, length, flags, scratch, onEvent,
+                                 context);
+    PROFILE_SCAN(scratch, mark, length);
+    return rv;
+}
+
 HS_PUBLIC_API
 hs_error_t hs_scan_stream(hs_stream_t *id, const char *data, unsigned length,
                           unsigned flags, hs_scratch_t *scratch,
@@ -1034,19 +1428,68 @@ hs_error_t hs_scan_vector(const hs_database_t *db, const char * const * data,
         return HS_SCRATCH_IN_USE;
     }
 
+    for (u32 i = 0; i < count; i++) {
+        if (unlikely(!data[i])) {
+            unmarkScratchInUse(scratch);
+            return HS_INVALID;
+        }
+    }
+
     hs_stream_t *id = (hs_stream_t *)(scratch->bstate);
 
     init_stream(id, rose); /* open stream */
 
+    /* Each write to the pseudo-stream pays for expanding and compressing
+     * engine state and maintaining history, which dominates when the vector
+     * is made up of many short blocks. Short blocks are therefore gathered
+     * into scratch and scanned as a single write; blocks at least as large
+     * as the gather buffer are scanned in place. */
+    char *gather = scratch->vector_buf;
+    const u32 gather_size = scratch->vectorBufSize;
+    u32 gathered = 0;
+
     for (u32 i = 0; i < count; i++) {
-        DEBUG_PRINTF("block %u/%u offset=%llu len=%u\n", i, count, id->offset,
-                     length[i]);
+        DEBUG_PRINTF("block %u/%u offset=%llu len=%u\n", i, count,
+                     id->offset + gathered, length[i]);
 #ifdef DEBUG
         dumpData(data[i], length[i]);
 #endif
-        hs_error_t ret
-            = hs_scan_stream_internal(id, data[i], length[i], 0, scratch,
-                                      onEvent, context);
+        const char *block = data[i];
+        u32 len = length[i];
+
+        while (len) {
+            const char *buf;
+            u32 buf_len;
+            if (!gathered && len >= gather_size) {
+                buf = block;
+                buf_len = len;
+                len = 0;
+            } else {
+                u32 n = MIN(len, gather_size - gathered);
+                memcpy(gather + gathered, block, n);
+                gathered += n;
+                block += n;
+                len -= n;
+                if (gathered < gather_size) {
+                    continue;
+                }
+                buf = gather;
+                buf_len = gathered;
+                gathered = 0;
+            }
+
+            hs_error_t ret = hs_scan_stream_internal(id, buf, buf_len, 0,
+                                                     scratch, onEvent, context);
+            if (ret != HS_SUCCESS) {
+                unmarkScratchInUse(scratch);
+                return ret;
+            }
+        }
+    }
+
+    if (gathered) {
+        hs_error_t ret = hs_scan_stream_internal(id, gather, gathered, 0,
+                                                 scratch, onEvent, context);
         if (ret != HS_SUCCESS) {
             unmarkScratchInUse(scratch);
             return ret;
@@ -40,10 +40,15 @@
 #include "state.h"
 #include "ue2common.h"
 #include "database.h"
+#include "fdr/fdr.h"
+#include "hwlm/hwlm_internal.h"
 #include "nfa/nfa_api_queue.h"
+#include "nfa/nfa_internal.h"
 #include "rose/rose_internal.h"
+#include "rose/runtime.h"
 #include "util/fatbit.h"
 #include "util/multibit.h"
+#include "util/profile.h"
 
 /**
  * Determine the space required for a correctly aligned array of fatbit
@@ -75,6 +80,7 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     u32 bStateSize = proto->bStateSize;
     u32 tStateSize = proto->tStateSize;
     u32 fullStateSize = proto->fullStateSize;
+    u32 vectorBufSize = proto->vectorBufSize;
     u32 anchored_literal_region_len = proto->anchored_literal_region_len;
     u32 anchored_literal_region_width = proto->anchored_literal_count;
 
@@ -95,10 +101,19 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     size_t delay_region_size =
         fatbit_array_size(DELAY_SLOT_COUNT, proto->delay_count);
 
+#ifdef PROFILE_SUPPORT
+    size_t profile_size = sizeof(struct ProfileCounters)
+                          + queueCount * sizeof(struct ProfileEngine)
+                          + proto->profilePatternCount * sizeof(u64a) + 8;
+#else
+    size_t profile_size = 0;
+#endif
+
     // the size is all the allocated stuff, not including the struct itself
     size_t size = queue_size + 63
                   + bStateSize + tStateSize
                   + fullStateSize + 63 /* cacheline padding */
+                  + vectorBufSize
                   + fatbit_size(proto->handledKeyCount) /* handled roles */
                   + fatbit_size(queueCount) /* active queue array */
                   + 2 * fatbit_size(deduperCount) /* need odd and even logs */
@@ -109,7 +124,8 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
                   + som_store_size
                   + som_now_size
                   + som_attempted_size
-                  + som_attempted_store_size + 15;
+                  + som_attempted_store_size + 15
+                  + profile_size;
 
     /* the struct plus the allocated stuff plus padding for cacheline
      * alignment */
@@ -130,6 +146,8 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
 
     s->magic = SCRATCH_MAGIC;
     s->in_use = 0;
+    s->pool = NULL;
+    s->pool_slot = 0;
     s->scratchSize = alloc_size;
     s->scratch_alloc = (char *)s_tmp;
 
@@ -222,6 +240,28 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     s->fullStateSize = fullStateSize;
     current += fullStateSize;
 
+    s->vector_buf = vectorBufSize ? current : NULL;
+    s->vectorBufSize = vectorBufSize;
+    current += vectorBufSize;
+
+#ifdef PROFILE_SUPPORT
+    current = ROUNDUP_PTR(current, 8);
+    struct ProfileCounters *profile = (struct ProfileCounters *)current;
+    current += sizeof(struct ProfileCounters);
+    profile->engines = (struct ProfileEngine *)current;
+    profile->engineCount = queueCount;
+    current += queueCount * sizeof(struct ProfileEngine);
+    profile->patterns = (u64a *)current;
+    profile->patternCount = proto->profilePatternCount;
+    current += proto->profilePatternCount * sizeof(u64a);
+
+    for (u32 i = 0; i < queueCount; i++) {
+        s->queues[i].profile = &profile->engines[i];
+    }
+    s->profile = profile;
+    s->core_info.profile = profile;
+#endif
+
     *scratch = s;
 
     // Don't get too big for your boots
@@ -230,6 +270,98 @@ hs_error_t alloc_scratch(const hs_scratch_t *proto, hs_scratch_t **scratch) {
     return HS_SUCCESS;
 }
 
+/** Widens the sizes in \a proto so that a scratch allocated from it can be
+ * used with \a rose. Returns non-zero if any size grew. */
+static
+int growProto(hs_scratch_t *proto, const struct RoseEngine *rose) {
+    int grow = 0;
+
+    if (rose->anchoredDistance > proto->anchored_literal_region_len) {
+        grow = 1;
+        proto->anchored_literal_region_len = rose->anchoredDistance;
+    }
+
+    if (rose->anchored_count > proto->anchored_literal_count) {
+        grow = 1;
+        proto->anchored_literal_count = rose->anchored_count;
+    }
+
+    if (rose->delay_count > proto->delay_count) {
+        grow = 1;
+        proto->delay_count = rose->delay_count;
+    }
+
+    if (rose->handledKeyCount > proto->handledKeyCount) {
+        grow = 1;
+        proto->handledKeyCount = rose->handledKeyCount;
+    }
+
+    if (rose->tStateSize > proto->tStateSize) {
+        grow = 1;
+        proto->tStateSize = rose->tStateSize;
+    }
+
+    u32 som_store_count = rose->somLocationCount;
+    if (som_store_count > proto->som_store_count) {
+        grow = 1;
+        proto->som_store_count = som_store_count;
+    }
+
+    u32 queueCount = rose->queueCount;
+    if (queueCount > proto->queueCount) {
+        grow = 1;
+        proto->queueCount = queueCount;
+    }
+
+    u32 bStateSize = 0;
+    if (rose->mode == HS_MODE_BLOCK) {
+        bStateSize = rose->stateOffsets.end;
+    } else if (rose->mode == HS_MODE_VECTORED) {
+        /* vectoring database require a full stream state (inc header) */
+        bStateSize = sizeof(struct hs_stream) + rose->stateOffsets.end;
+    }
+
+    if (bStateSize > proto->bStateSize) {
+        grow = 1;
+        proto->bStateSize = bStateSize;
+    }
+
+    u32 vectorBufSize = 0;
+    if (rose->mode == HS_MODE_VECTORED) {
+        vectorBufSize = VECTORED_GATHER_SIZE;
+    }
+
+    if (vectorBufSize > proto->vectorBufSize) {
+        grow = 1;
+        proto->vectorBufSize = vectorBufSize;
+    }
+
+    u32 fullStateSize = rose->scratchStateSize;
+    if (fullStateSize > proto->fullStateSize) {
+        grow = 1;
+        proto->fullStateSize = fullStateSize;
+    }
+
+    if (rose->dkeyCount > proto->deduper.log_size) {
+        grow = 1;
+        proto->deduper.log_size = rose->dkeyCount;
+    }
+
+#ifdef PROFILE_SUPPORT
+    if (rose->profileIdCount > proto->profilePatternCount) {
+        grow = 1;
+        proto->profilePatternCount = rose->profileIdCount;
+    }
+#endif
+
+    return grow;
+}
+
+char scratchCoversRose(const hs_scratch_t *s, const struct RoseEngine *rose) {
+    struct hs_scratch proto = *s;
+    return !growProto(&proto, rose);
+}
+
 HS_PUBLIC_API
 hs_error_t hs_alloc_scratch(const hs_database_t *db, hs_scratch_t **scratch) {
     if (!db || !scratch) {
@@ -255,6 +387,10 @@ hs_error_t hs_alloc_scratch(const hs_database_t *db, hs_scratch_t **scratch) {
         if ((*scratch)->magic != SCRATCH_MAGIC) {
             return HS_INVALID;
         }
+        /* pooled scratch is grown by hs_scratch_pool_add_database() */
+        if ((*scratch)->pool) {
+            return HS_INVALID;
+        }
         if (markScratchInUse(*scratch)) {
             return HS_SCRATCH_IN_USE;
         }
@@ -283,65 +419,8 @@ hs_error_t hs_alloc_scratch(const hs_database_t *db, hs_scratch_t **scratch) {
     }
     proto->scratch_alloc = (char *)proto_tmp;
 
-    if (rose->anchoredDistance > proto->anchored_literal_region_len) {
-        resize = 1;
-        proto->anchored_literal_region_len = rose->anchoredDistance;
-    }
-
-    if (rose->anchored_count > proto->anchored_literal_count) {
-        resize = 1;
-        proto->anchored_literal_count = rose->anchored_count;
-    }
-
-    if (rose->delay_count > proto->delay_count) {
-        resize = 1;
-        proto->delay_count = rose->delay_count;
-    }
-
-    if (rose->handledKeyCount > proto->handledKeyCount) {
-        resize = 1;
-        proto->handledKeyCount = rose->handledKeyCount;
-    }
-
-    if (rose->tStateSize > proto->tStateSize) {
-        resize = 1;
-        proto->tStateSize = rose->tStateSize;
-    }
-
-    u32 som_store_count = rose->somLocationCount;
-    if (som_store_count > proto->som_store_count) {
-        resize = 1;
-        proto->som_store_count = som_store_count;
-    }
-
-    u32 queueCount = rose->queueCount;
-    if (queueCount > proto->queueCount) {
-        resize = 1;
-        proto->queueCount = queueCount;
-    }
-
-    u32 bStateSize = 0;
-    if (rose->mode == HS_MODE_BLOCK) {
-        bStateSize = rose->stateOffsets.end;
-    } else if (rose->mode == HS_MODE_VECTORED) {
-        /* vectoring database require a full stream state (inc header) */
-        bStateSize = sizeof(struct hs_stream) + rose->stateOffsets.end;
-    }
-
-    if (bStateSize > proto->bStateSize) {
-        resize = 1;
-        proto->bStateSize = bStateSize;
-    }
-
-    u32 fullStateSize = rose->scratchStateSize;
-    if (fullStateSize > proto->fullStateSize) {
+    if (growProto(proto, rose)) {
         resize = 1;
-        proto->fullStateSize = fullStateSize;
-    }
-
-    if (rose->dkeyCount > proto->deduper.log_size) {
-        resize = 1;
-        proto->deduper.log_size = rose->dkeyCount;
     }
 
     if (resize) {
@@ -391,6 +470,10 @@ hs_error_t hs_free_scratch(hs_scratch_t *scratch) {
         if (scratch->magic != SCRATCH_MAGIC) {
             return HS_INVALID;
         }
+        /* pooled scratch is owned by its pool */
+        if (scratch->pool) {
+            return HS_INVALID;
+        }
         if (markScratchInUse(scratch)) {
             return HS_SCRATCH_IN_USE;
         }
@@ -416,3 +499,233 @@ hs_error_t hs_scratch_size(const hs_scratch_t *scratch, size_t *size) {
 
     return HS_SUCCESS;
 }
+
+#ifdef PROFILE_SUPPORT
+
+/** \brief Check that the scratch was allocated for the given database, so
+ * that its profiling counters can be indexed by the database's queues. */
+static
+hs_error_t checkProfileArgs(const hs_database_t *db,
+                            const hs_scratch_t *scratch,
+                            const struct RoseEngine **rose_out) {
+    if (!db || !scratch || !ISALIGNED_CL(scratch) ||
+        scratch->magic != SCRATCH_MAGIC) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = validDatabase(db);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+    const struct ProfileCounters *profile = scratch->profile;
+    if (rose->queueCount > profile->engineCount ||
+        rose->profileIdCount > profile->patternCount) {
+        return HS_INVALID;
+    }
+
+    *rose_out = rose;
+    return HS_SUCCESS;
+}
+
+static
+unsigned int matcherKind(const struct RoseEngine *rose, u32 table) {
+    u32 offset = 0;
+    switch (table) {
+    case PROFILE_TABLE_FLOATING:
+        offset = rose->fmatcherOffset;
+        break;
+    case PROFILE_TABLE_ANCHORED:
+        return rose->amatcherOffset ? HS_PROFILE_MATCHER_DFA
+                                    : HS_PROFILE_MATCHER_NONE;
+    case PROFILE_TABLE_EOD:
+        offset = rose->ematcherOffset;
+        break;
+    case PROFILE_TABLE_SMALL_BLOCK:
+        offset = rose->sbmatcherOffset;
+        break;
+    default:
+        assert(0);
+        break;
+    }
+
+    if (!offset) {
+        return HS_PROFILE_MATCHER_NONE;
+    }
+
+    const struct HWLM *hwlm = getByOffset(rose, offset);
+    if (hwlm->type == HWLM_ENGINE_NOOD) {
+        return HS_PROFILE_MATCHER_NOODLE;
+    }
+    return fdrEngineIsTeddy(HWLM_C_DATA(hwlm)) ? HS_PROFILE_MATCHER_TEDDY
+                                         : HS_PROFILE_MATCHER_FDR;
+}
+
+static
+const char *engineKind(const struct NFA *nfa) {
+    if (isNfaType(nfa->type)) {
+        return "LimEx NFA";
+    } else if (isMcClellanType(nfa->type)) {
+        return "McClellan DFA";
+    } else if (isShengType(nfa->type)) {
+        return "Sheng DFA";
+    } else if (isMcShengType(nfa->type)) {
+        return "McSheng DFA";
+    } else if (isGoughType(nfa->type)) {
+        return "Gough DFA";
+    } else if (isLbrType(nfa->type)) {
+        return "LBR";
+    } else if (nfa->type == MPV_NFA_0) {
+        return "MPV";
+    } else if (nfa->type == CASTLE_NFA_0) {
+        return "Castle";
+    }
+    return "unknown";
+}
+
+#endif // PROFILE_SUPPORT
+
+HS_PUBLIC_API
+hs_error_t hs_scratch_profile(UNUSED const hs_database_t *db,
+                              UNUSED const hs_scratch_t *scratch,
+                              UNUSED hs_profile_t *out) {
+#ifdef PROFILE_SUPPORT
+    const struct RoseEngine *rose;
+    hs_error_t err = checkProfileArgs(db, scratch, &rose);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+    if (!out) {
+        return HS_INVALID;
+    }
+
+    const struct ProfileCounters *p = scratch->profile;
+    memset(out, 0, sizeof(*out));
+    out->scans = p->scans;
+    out->bytes = p->bytes;
+    out->cycles = p->cycles;
+
+    for (u32 i = 0; i < PROFILE_TABLE_COUNT; i++) {
+        const struct ProfileMatcher *pm = &p->matchers[i];
+        hs_profile_matcher_t *m = &out->matchers[i];
+        m->kind = matcherKind(rose, i);
+        m->calls = pm->calls;
+        m->bytes = pm->bytes;
+        m->cycles = pm->cycles;
+        m->matches = pm->events.literal_matches;
+        m->confirms = pm->events.confirms;
+    }
+
+    out->programs = p->events.programs;
+    out->instructions = p->events.instructions;
+    out->catchup_ops = p->events.catchup_ops;
+    for (u32 i = 0; i < rose->queueCount; i++) {
+        out->engine_execs += p->engines[i].execs;
+    }
+    out->exceptions = p->events.exceptions;
+    out->accel_calls = p->events.accel_calls;
+    out->accel_bytes = p->events.accel_bytes;
+    out->accel_misses = p->events.accel_misses;
+    out->matches = p->matches;
+    out->engine_count = rose->queueCount;
+    out->pattern_count = rose->profileIdCount;
+    return HS_SUCCESS;
+#else
+    return HS_INVALID;
+#endif
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scratch_profile_engine(UNUSED const hs_database_t *db,
+                                     UNUSED const hs_scratch_t *scratch,
+                                     UNUSED unsigned int engine,
+                                     UNUSED hs_profile_engine_t *info) {
+#ifdef PROFILE_SUPPORT
+    const struct RoseEngine *rose;
+    hs_error_t err = checkProfileArgs(db, scratch, &rose);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+    if (!info || engine >= rose->queueCount) {
+        return HS_INVALID;
+    }
+
+    const struct ProfileEngine *e = &scratch->profile->engines[engine];
+    info->kind = engineKind(getNfaByQueue(rose, engine));
+    info->execs = e->execs;
+    info->bytes = e->bytes;
+    info->cycles = e->cycles;
+    info->exceptions = e->events.exceptions;
+    info->accel_calls = e->events.accel_calls;
+    info->accel_bytes = e->events.accel_bytes;
+    info->accel_misses = e->events.accel_misses;
+    info->pattern_count = 0;
+    info->patterns = NULL;
+
+    if (rose->profileEngineOffset) {
+        const struct ProfileEngineInfo *pei =
+            (const struct ProfileEngineInfo *)getByOffset(
+                rose, rose->profileEngineOffset) + engine;
+        if (pei->idCount) {
+            info->pattern_count = pei->idCount;
+            info->patterns = getByOffset(rose, pei->idOffset);
+        }
+    }
+    return HS_SUCCESS;
+#else
+    return HS_INVALID;
+#endif
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scratch_profile_pattern(UNUSED const hs_database_t *db,
+                                      UNUSED const hs_scratch_t *scratch,
+                                      UNUSED unsigned int pattern,
+                                      UNUSED hs_profile_pattern_t *info) {
+#ifdef PROFILE_SUPPORT
+    const struct RoseEngine *rose;
+    hs_error_t err = checkProfileArgs(db, scratch, &rose);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+    if (!info || pattern >= rose->profileIdCount) {
+        return HS_INVALID;
+    }
+
+    const u32 *ids = getByOffset(rose, rose->profileIdOffset);
+    info->id = ids[pattern];
+    info->matches = scratch->profile->patterns[pattern];
+    return HS_SUCCESS;
+#else
+    return HS_INVALID;
+#endif
+}
+
+HS_PUBLIC_API
+hs_error_t hs_reset_scratch_profile(UNUSED hs_scratch_t *scratch) {
+#ifdef PROFILE_SUPPORT
+    if (!scratch || !ISALIGNED_CL(scratch) ||
+        scratch->magic != SCRATCH_MAGIC) {
+        return HS_INVALID;
+    }
+    if (markScratchInUse(scratch)) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    struct ProfileCounters *p = scratch->profile;
+    memset(p->matchers, 0, sizeof(p->matchers));
+    memset(&p->events, 0, sizeof(p->events));
+    p->scans = 0;
+    p->bytes = 0;
+    p->cycles = 0;
+    p->matches = 0;
+    memset(p->engines, 0, p->engineCount * sizeof(struct ProfileEngine));
+    memset(p->patterns, 0, p->patternCount * sizeof(u64a));
+
+    unmarkScratchInUse(scratch);
+    return HS_SUCCESS;
+#else
+    return HS_INVALID;
+#endif
+}
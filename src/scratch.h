@@ -38,6 +38,7 @@
 
 #include "ue2common.h"
 #include "rose/rose_types.h"
+#include "util/profile.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -47,8 +48,13 @@ extern "C"
 UNUSED static const u32 SCRATCH_MAGIC = 0x544F4259;
 #define FDR_TEMP_BUF_SIZE 200
 
+/** \brief Size of the scratch buffer used to gather short blocks together in
+ * vectored mode, so that each gathered run is scanned as a single write. */
+#define VECTORED_GATHER_SIZE 2048
+
 struct fatbit;
 struct hs_scratch;
+struct hs_scratch_pool;
 struct RoseEngine;
 struct mq;
 
@@ -81,6 +87,16 @@ struct catchup_pq {
  * history. */
 #define STATUS_DELAY_DIRTY  (1U << 2)
 
+/** \brief Result mode: matches are delivered to the user callback. */
+#define RESULT_MODE_CALLBACK 0
+
+/** \brief Result mode: matched IDs are set in a caller-provided bitmap. */
+#define RESULT_MODE_BITMAP   1
+
+/** \brief Result mode: matches are counted per ID in a caller-provided
+ * array. */
+#define RESULT_MODE_COUNT    2
+
 /** \brief Core information about the current scan, used everywhere. */
 struct core_info {
     void *userContext; /**< user-supplied context */
@@ -98,6 +114,16 @@ struct core_info {
     size_t hlen; /**< length of history buffer in bytes. */
     u64a buf_offset; /**< stream offset, for the base of the buffer */
     u8 status; /**< stream status bitmask, using STATUS_ flags above */
+    u8 resultMode; /**< one of the RESULT_MODE_ values above */
+    u32 resultSize; /**< number of match IDs covered by the result array */
+    u32 resultPending; /**< bitmap mode: number of match IDs that have not
+                        * been recorded yet by this scan */
+    u8 *resultBitmap; /**< result array for RESULT_MODE_BITMAP */
+    unsigned long long *resultCounts; /**< result array for
+                                       * RESULT_MODE_COUNT */
+#ifdef PROFILE_SUPPORT
+    struct ProfileCounters *profile; /**< profiling counters in scratch */
+#endif
 };
 
 /** \brief Rose state information. */
@@ -119,6 +145,10 @@ struct RoseContext {
                                 * still allowed to report */
     u64a next_mpv_offset; /**< earliest offset that the MPV can next report a
                            * match, cleared if top events arrive */
+    u64a lastCombMatchOffset; /**< offset of the last sub-expression match
+                               * recorded for logical combinations whose
+                               * combinations have not been reported yet, or
+                               * ~0ULL if there is none */
     u32 filledDelayedSlots;
     u32 curr_qi;    /**< currently executing main queue index during
                      * \ref nfaQueueExec */
@@ -146,10 +176,12 @@ struct ALIGN_CL_DIRECTIVE hs_scratch {
     u32 bStateSize; /**< sizeof block mode states */
     u32 tStateSize; /**< sizeof transient rose states */
     u32 fullStateSize; /**< size of uncompressed nfa state */
+    u32 vectorBufSize; /**< size of vector_buf, zero if not vectored */
     struct RoseContext tctxt;
     char *bstate; /**< block mode states */
     char *tstate; /**< state for transient roses */
     char *fullState; /**< uncompressed NFA state */
+    char *vector_buf; /**< gather buffer for short vectored mode blocks */
     struct mq *queues;
     struct fatbit *aqa; /**< active queue array; fatbit of queues that are valid
                          * & active */
@@ -176,8 +208,20 @@ struct ALIGN_CL_DIRECTIVE hs_scratch {
                             * location had been writable */
     u64a som_set_now_offset; /**< offset at which som_set_now represents */
     u32 som_store_count;
+    struct hs_scratch_pool *pool; /**< owning pool, NULL if not pooled */
+    u32 pool_slot; /**< one plus the owning pool slot, zero for a scratch
+                    * handed out when every slot was busy */
+#ifdef PROFILE_SUPPORT
+    struct ProfileCounters *profile; /**< runtime profiling counters */
+    u32 profilePatternCount; /**< number of per-pattern profiling slots */
+#endif
 };
 
+/** \brief Returns non-zero if scratch \a s is already large enough to be used
+ * with \a rose. */
+char scratchCoversRose(const struct hs_scratch *s,
+                       const struct RoseEngine *rose);
+
 /* array of fatbit ptr; TODO: why not an array of fatbits? */
 static really_inline
 struct fatbit **getAnchoredLiteralLog(struct hs_scratch *scratch) {
@@ -199,6 +243,59 @@ char can_stop_matching(const struct hs_scratch *scratch) {
     return scratch->core_info.status & (STATUS_TERMINATED | STATUS_EXHAUSTED);
 }
 
+/**
+ * \brief Deliver a match for match ID \a id to the user.
+ *
+ * In the callback-free result modes, the match is recorded in the caller's
+ * result array instead of calling the user callback.
+ *
+ * Returns non-zero if matching should stop, having set the reason in the
+ * status: STATUS_TERMINATED if the callback asked us to halt, or
+ * STATUS_EXHAUSTED if every match ID has been recorded in bitmap mode.
+ */
+static really_inline
+int deliverUserMatch(struct core_info *ci, u32 id, u64a from, u64a to,
+                     u32 flags) {
+#ifdef PROFILE_SUPPORT
+    profileUserMatch(ci->profile, id);
+#endif
+
+    if (likely(ci->resultMode == RESULT_MODE_CALLBACK)) {
+        if (ci->userCallback(id, from, to, flags, ci->userContext)) {
+            ci->status |= STATUS_TERMINATED;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (id >= ci->resultSize) {
+        DEBUG_PRINTF("id %u outside result array of %u\n", id,
+                     ci->resultSize);
+        return 0;
+    }
+
+    if (ci->resultMode == RESULT_MODE_COUNT) {
+        ci->resultCounts[id]++;
+        return 0;
+    }
+
+    assert(ci->resultMode == RESULT_MODE_BITMAP);
+    u8 *b = ci->resultBitmap + id / 8;
+    const u8 mask = 1U << (id % 8);
+    if (*b & mask) {
+        return 0;
+    }
+    *b |= mask;
+
+    assert(ci->resultPending);
+    if (!--ci->resultPending) {
+        DEBUG_PRINTF("all match ids recorded\n");
+        ci->status |= STATUS_EXHAUSTED;
+        return 1;
+    }
+    return 0;
+}
+
 /**
  * \brief Mark scratch as in use.
  *
@@ -54,6 +54,7 @@ void dumpScratch(const struct hs_scratch *s, FILE *f) {
     fprintf(f, "  queues               : %zu bytes\n",
             s->queueCount * sizeof(struct mq));
     fprintf(f, "  bStateSize           : %u bytes\n", s->bStateSize);
+    fprintf(f, "  vector gather buffer : %u bytes\n", s->vectorBufSize);
     fprintf(f, "  active queue array   : %u bytes\n",
             mmbit_size(s->queueCount));
     fprintf(f, "  qmpq                 : %zu bytes\n",
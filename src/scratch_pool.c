@@ -0,0 +1,421 @@
+/*
+ * Copyright (c) 2015-2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Library-managed pool of scratch spaces.
+ *
+ * The pool is a fixed array of slots, one cache line each. A thread claims a
+ * slot with a single compare-and-swap on its busy flag, starting from the slot
+ * it used last, so in the steady state each thread keeps coming back to the
+ * same scratch without contending with the others. If every slot is busy, a
+ * one-off scratch is cloned and then freed when it is released.
+ *
+ * Scratch is cloned lazily by the first thread to claim a slot. The clone
+ * zeroes the whole region, so under a first-touch NUMA policy its pages are
+ * placed on that thread's node; slot affinity then keeps it there.
+ *
+ * The sizes every scratch must have are kept in a prototype scratch tagged
+ * with a generation number. Adding a database that needs more space publishes
+ * a new, larger prototype with the next generation; slots holding an older
+ * generation are re-cloned the next time they are claimed. Replaced
+ * prototypes are only freed with the pool, as another thread may be cloning
+ * from them.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "database.h"
+#include "hs_internal.h"
+#include "hs_runtime.h"
+#include "scratch.h"
+#include "ue2common.h"
+
+#if defined(_WIN32)
+#include <intrin.h>
+#define POOL_TLS __declspec(thread)
+#else
+#define POOL_TLS __thread
+#endif
+
+static const u32 SCRATCH_POOL_MAGIC = 0x504F4F4C;
+
+/** \brief A prototype scratch and the generation it belongs to. */
+struct pool_proto {
+    hs_scratch_t *scratch;
+    u32 generation;
+    struct pool_proto *prev; //!< replaced prototype, freed with the pool
+};
+
+/** \brief One pooled scratch. Padded to a cache line so that threads claiming
+ * neighbouring slots do not contend. */
+struct ALIGN_CL_DIRECTIVE pool_slot {
+    u32 busy; //!< non-zero while handed out
+    u32 generation; //!< generation of the prototype \a scratch came from
+    hs_scratch_t *scratch; //!< NULL until the slot is first claimed
+};
+
+struct hs_scratch_pool {
+    u32 magic;
+    u32 slotCount;
+    struct pool_proto *proto; //!< current prototype
+    struct pool_slot *slots;
+    char *pool_alloc; //!< allocation containing this structure
+};
+
+/** \brief One plus the slot this thread last claimed, or zero if none. */
+static POOL_TLS u32 tls_slot_hint = 0;
+
+#if defined(_WIN32)
+static really_inline
+u32 loadBusy(const u32 *busy) {
+    u32 v = *(const volatile u32 *)busy;
+    _ReadWriteBarrier();
+    return v;
+}
+
+static really_inline
+void storeBusy(u32 *busy, u32 v) {
+    _ReadWriteBarrier();
+    *(volatile u32 *)busy = v;
+}
+
+static really_inline
+char claimBusy(u32 *busy) {
+    return _InterlockedCompareExchange((volatile long *)busy, 1, 0) == 0;
+}
+
+static really_inline
+struct pool_proto *loadProto(struct pool_proto *const *proto) {
+    struct pool_proto *p = *(struct pool_proto *const volatile *)proto;
+    _ReadWriteBarrier();
+    return p;
+}
+
+static really_inline
+char swapProto(struct pool_proto **proto, struct pool_proto *expected,
+               struct pool_proto *desired) {
+    return _InterlockedCompareExchangePointer((void *volatile *)proto,
+                                              desired, expected) == expected;
+}
+#else
+static really_inline
+u32 loadBusy(const u32 *busy) {
+    return __atomic_load_n(busy, __ATOMIC_RELAXED);
+}
+
+static really_inline
+void storeBusy(u32 *busy, u32 v) {
+    __atomic_store_n(busy, v, __ATOMIC_RELEASE);
+}
+
+static really_inline
+char claimBusy(u32 *busy) {
+    u32 expected = 0;
+    return __atomic_compare_exchange_n(busy, &expected, 1, 0, __ATOMIC_ACQUIRE,
+                                       __ATOMIC_RELAXED);
+}
+
+static really_inline
+struct pool_proto *loadProto(struct pool_proto *const *proto) {
+    return __atomic_load_n(proto, __ATOMIC_ACQUIRE);
+}
+
+static really_inline
+char swapProto(struct pool_proto **proto, struct pool_proto *expected,
+               struct pool_proto *desired) {
+    return __atomic_compare_exchange_n(proto, &expected, desired, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#endif
+
+static really_inline
+char validPool(const hs_scratch_pool_t *pool) {
+    return pool && ISALIGNED_CL(pool) && pool->magic == SCRATCH_POOL_MAGIC;
+}
+
+/** \brief Slot to try first: the one this thread claimed last, or else one
+ * picked from the address of its thread-local storage to spread threads over
+ * the pool. */
+static really_inline
+u32 firstSlot(u32 slotCount) {
+    if (tls_slot_hint) {
+        return (tls_slot_hint - 1) % slotCount;
+    }
+    return (u32)(((size_t)&tls_slot_hint >> 6) % slotCount);
+}
+
+/** \brief Frees a scratch that the pool handed out. */
+static
+void freePooled(hs_scratch_t *scratch) {
+    scratch->pool = NULL;
+    UNUSED hs_error_t err = hs_free_scratch(scratch);
+    assert(err == HS_SUCCESS);
+}
+
+static
+hs_error_t allocProto(hs_scratch_t *scratch, u32 generation,
+                      struct pool_proto *prev, struct pool_proto **out) {
+    struct pool_proto *p = hs_scratch_alloc(sizeof(struct pool_proto));
+    hs_error_t err = hs_check_alloc(p);
+    if (err != HS_SUCCESS) {
+        hs_scratch_free(p);
+        return err;
+    }
+
+    p->scratch = scratch;
+    p->generation = generation;
+    p->prev = prev;
+    *out = p;
+    return HS_SUCCESS;
+}
+
+/** \brief Makes sure the scratch in a freshly claimed slot was cloned from
+ * the current prototype. */
+static
+hs_error_t refreshSlot(hs_scratch_pool_t *pool, u32 idx) {
+    struct pool_slot *slot = &pool->slots[idx];
+    const struct pool_proto *proto = loadProto(&pool->proto);
+    if (slot->scratch && slot->generation == proto->generation) {
+        return HS_SUCCESS;
+    }
+
+    DEBUG_PRINTF("slot %u: cloning generation %u\n", idx, proto->generation);
+    hs_scratch_t *s = NULL;
+    hs_error_t err = hs_clone_scratch(proto->scratch, &s);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+
+    if (slot->scratch) {
+        freePooled(slot->scratch);
+    }
+    s->pool = pool;
+    s->pool_slot = idx + 1;
+    slot->scratch = s;
+    slot->generation = proto->generation;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_alloc_scratch_pool(const hs_database_t *db, unsigned int size,
+                                 hs_scratch_pool_t **pool) {
+    if (!db || !pool || !size) {
+        return HS_INVALID;
+    }
+
+    *pool = NULL;
+
+    hs_scratch_t *scratch = NULL;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+
+    struct pool_proto *proto;
+    err = allocProto(scratch, 0, NULL, &proto);
+    if (err != HS_SUCCESS) {
+        hs_free_scratch(scratch);
+        return err;
+    }
+
+    size_t slots_size = (size_t)size * sizeof(struct pool_slot);
+    size_t alloc_size = sizeof(struct hs_scratch_pool) + slots_size + 128;
+    char *mem = hs_scratch_alloc(alloc_size);
+    err = hs_check_alloc(mem);
+    if (err != HS_SUCCESS) {
+        hs_scratch_free(mem);
+        hs_scratch_free(proto);
+        hs_free_scratch(scratch);
+        return err;
+    }
+
+    memset(mem, 0, alloc_size);
+    hs_scratch_pool_t *p = (hs_scratch_pool_t *)ROUNDUP_PTR(mem, 64);
+    char *slots = (char *)p + sizeof(*p);
+    p->slots = (struct pool_slot *)ROUNDUP_PTR(slots, 64);
+    assert((char *)(p->slots + size) <= mem + alloc_size);
+    p->magic = SCRATCH_POOL_MAGIC;
+    p->slotCount = size;
+    p->proto = proto;
+    p->pool_alloc = mem;
+
+    *pool = p;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scratch_pool_add_database(hs_scratch_pool_t *pool,
+                                        const hs_database_t *db) {
+    if (!validPool(pool) || !db) {
+        return HS_INVALID;
+    }
+
+    hs_error_t err = dbIsValid(db);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+
+    const struct RoseEngine *rose = hs_get_bytecode(db);
+
+    for (;;) {
+        struct pool_proto *curr = loadProto(&pool->proto);
+        if (scratchCoversRose(curr->scratch, rose)) {
+            return HS_SUCCESS;
+        }
+
+        hs_scratch_t *scratch = NULL;
+        err = hs_clone_scratch(curr->scratch, &scratch);
+        if (err != HS_SUCCESS) {
+            return err;
+        }
+        err = hs_alloc_scratch(db, &scratch);
+        if (err != HS_SUCCESS) {
+            return err;
+        }
+
+        struct pool_proto *next;
+        err = allocProto(scratch, curr->generation + 1, curr, &next);
+        if (err != HS_SUCCESS) {
+            hs_free_scratch(scratch);
+            return err;
+        }
+
+        if (swapProto(&pool->proto, curr, next)) {
+            DEBUG_PRINTF("pool grown to generation %u\n", next->generation);
+            return HS_SUCCESS;
+        }
+
+        /* lost a race with another thread growing the pool; retry against
+         * its prototype */
+        hs_free_scratch(scratch);
+        hs_scratch_free(next);
+    }
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scratch_pool_acquire(hs_scratch_pool_t *pool,
+                                   hs_scratch_t **scratch) {
+    if (!validPool(pool) || !scratch) {
+        return HS_INVALID;
+    }
+
+    *scratch = NULL;
+
+    const u32 count = pool->slotCount;
+    u32 idx = firstSlot(count);
+    for (u32 i = 0; i < count; i++) {
+        struct pool_slot *slot = &pool->slots[idx];
+        if (!loadBusy(&slot->busy) && claimBusy(&slot->busy)) {
+            hs_error_t err = refreshSlot(pool, idx);
+            if (err != HS_SUCCESS) {
+                storeBusy(&slot->busy, 0);
+                return err;
+            }
+            tls_slot_hint = idx + 1;
+            *scratch = slot->scratch;
+            return HS_SUCCESS;
+        }
+        if (++idx == count) {
+            idx = 0;
+        }
+    }
+
+    /* every slot is busy: hand out a scratch that is freed on release */
+    DEBUG_PRINTF("pool of %u exhausted\n", count);
+    const struct pool_proto *proto = loadProto(&pool->proto);
+    hs_scratch_t *s = NULL;
+    hs_error_t err = hs_clone_scratch(proto->scratch, &s);
+    if (err != HS_SUCCESS) {
+        return err;
+    }
+    s->pool = pool;
+    *scratch = s;
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_scratch_pool_release(hs_scratch_pool_t *pool,
+                                   hs_scratch_t *scratch) {
+    if (!validPool(pool) || !scratch || !ISALIGNED_CL(scratch) ||
+        scratch->magic != SCRATCH_MAGIC || scratch->pool != pool) {
+        return HS_INVALID;
+    }
+
+    if (scratch->in_use) {
+        return HS_SCRATCH_IN_USE;
+    }
+
+    if (!scratch->pool_slot) {
+        freePooled(scratch);
+        return HS_SUCCESS;
+    }
+
+    struct pool_slot *slot = &pool->slots[scratch->pool_slot - 1];
+    if (slot->scratch != scratch || !loadBusy(&slot->busy)) {
+        return HS_INVALID;
+    }
+
+    storeBusy(&slot->busy, 0);
+    return HS_SUCCESS;
+}
+
+HS_PUBLIC_API
+hs_error_t hs_free_scratch_pool(hs_scratch_pool_t *pool) {
+    if (!pool) {
+        return HS_SUCCESS;
+    }
+    if (!validPool(pool)) {
+        return HS_INVALID;
+    }
+
+    for (u32 i = 0; i < pool->slotCount; i++) {
+        if (loadBusy(&pool->slots[i].busy)) {
+            return HS_SCRATCH_IN_USE;
+        }
+    }
+
+    for (u32 i = 0; i < pool->slotCount; i++) {
+        if (pool->slots[i].scratch) {
+            freePooled(pool->slots[i].scratch);
+        }
+    }
+
+    struct pool_proto *proto = pool->proto;
+    while (proto) {
+        struct pool_proto *prev = proto->prev;
+        hs_free_scratch(proto->scratch);
+        hs_scratch_free(proto);
+        proto = prev;
+    }
+
+    pool->magic = 0;
+    hs_scratch_free(pool->pool_alloc);
+    return HS_SUCCESS;
+}
@@ -0,0 +1,437 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Stream state compression.
+ *
+ * Most of a stream's state is only meaningful while the engines, roles or SOM
+ * slots it belongs to are switched on, and for an idle stream that is usually
+ * very little of it. The compressed form holds, in order:
+ *
+ * -# the stream offset (varint)
+ * -# the runtime status byte
+ * -# the role state, active leaf and active leftfix multibits
+ * -# floating matcher state, leftfix lag table, anchored matcher state and
+ *    groups, copied verbatim
+ * -# the valid part of the history buffer
+ * -# the exhaustion multibit
+ * -# SOM valid/writable multibits and the locations of valid SOM slots
+ * -# the NFA stream state of each active outfix, suffix and leftfix
+ *
+ * Multibits are stored as a varint header followed by either a list of set
+ * keys (header is twice the key count) or a flat bitvector (header is one),
+ * whichever is smaller.
+ */
+
+#include "stream_compress.h"
+
+#include "state.h"
+#include "nfa/nfa_internal.h"
+#include "rose/rose_internal.h"
+#include "util/multibit.h"
+#include "util/partial_store.h"
+
+#include <string.h>
+
+/** \brief Output buffer; writes past the end are counted but not made. */
+struct sc_out {
+    char *buf;
+    size_t space;
+    size_t used;
+};
+
+/** \brief Input buffer. */
+struct sc_in {
+    const char *buf;
+    size_t len;
+    size_t pos;
+};
+
+static really_inline
+void sc_write(struct sc_out *out, const void *src, size_t len) {
+    if (len && out->used + len <= out->space) {
+        memcpy(out->buf + out->used, src, len);
+    }
+    out->used += len;
+}
+
+/** \brief Reserve \a len zeroed bytes, returning NULL if they do not fit. */
+static really_inline
+u8 *sc_reserve(struct sc_out *out, size_t len) {
+    u8 *p = NULL;
+    if (out->used + len <= out->space) {
+        p = (u8 *)out->buf + out->used;
+        memset(p, 0, len);
+    }
+    out->used += len;
+    return p;
+}
+
+static
+void sc_write_varint(struct sc_out *out, u64a val) {
+    u8 tmp[10];
+    u32 n = 0;
+    do {
+        u8 b = val & 0x7f;
+        val >>= 7;
+        tmp[n++] = val ? b | 0x80 : b;
+    } while (val);
+    sc_write(out, tmp, n);
+}
+
+/** \brief Consume \a len bytes, returning NULL on overrun. */
+static really_inline
+const u8 *sc_consume(struct sc_in *in, size_t len) {
+    if (len > in->len - in->pos) {
+        return NULL;
+    }
+    const u8 *p = (const u8 *)in->buf + in->pos;
+    in->pos += len;
+    return p;
+}
+
+static really_inline
+char sc_read(struct sc_in *in, void *dst, size_t len) {
+    const u8 *p = sc_consume(in, len);
+    if (!p) {
+        return 0;
+    }
+    if (len) {
+        memcpy(dst, p, len);
+    }
+    return 1;
+}
+
+static
+char sc_read_varint(struct sc_in *in, u64a *val) {
+    u64a v = 0;
+    for (u32 shift = 0; shift < 64; shift += 7) {
+        const u8 *p = sc_consume(in, 1);
+        if (!p) {
+            return 0;
+        }
+        v |= (u64a)(*p & 0x7f) << shift;
+        if (!(*p & 0x80)) {
+            *val = v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/** \brief Bytes needed to store any key of a multibit of \a total_bits. */
+static really_inline
+u32 mmbitKeyWidth(u32 total_bits) {
+    if (total_bits <= (1U << 8)) {
+        return 1;
+    } else if (total_bits <= (1U << 16)) {
+        return 2;
+    } else if (total_bits <= (1U << 24)) {
+        return 3;
+    }
+    return 4;
+}
+
+static
+void sc_write_mmbit(struct sc_out *out, const u8 *bits, u32 total_bits) {
+    if (!total_bits) {
+        return;
+    }
+
+    u32 count = 0;
+    for (u32 i = mmbit_iterate(bits, total_bits, MMB_INVALID);
+         i != MMB_INVALID; i = mmbit_iterate(bits, total_bits, i)) {
+        count++;
+    }
+
+    const u32 width = mmbitKeyWidth(total_bits);
+    const size_t flat_len = ROUNDUP_N(total_bits, 8) / 8;
+
+    if ((size_t)count * width < flat_len) {
+        sc_write_varint(out, (u64a)count << 1);
+        for (u32 i = mmbit_iterate(bits, total_bits, MMB_INVALID);
+             i != MMB_INVALID; i = mmbit_iterate(bits, total_bits, i)) {
+            u8 key[4];
+            partial_store_u32(key, i, width);
+            sc_write(out, key, width);
+        }
+        return;
+    }
+
+    sc_write_varint(out, 1);
+    u8 *flat = sc_reserve(out, flat_len);
+    if (!flat) {
+        return;
+    }
+    for (u32 i = mmbit_iterate(bits, total_bits, MMB_INVALID);
+         i != MMB_INVALID; i = mmbit_iterate(bits, total_bits, i)) {
+        flat[i / 8] |= 1U << (i % 8);
+    }
+}
+
+static
+char sc_read_mmbit(struct sc_in *in, u8 *bits, u32 total_bits) {
+    if (!total_bits) {
+        return 1;
+    }
+
+    mmbit_clear(bits, total_bits);
+
+    u64a header;
+    if (!sc_read_varint(in, &header)) {
+        return 0;
+    }
+
+    if (header & 1) {
+        if (header != 1) {
+            return 0;
+        }
+        const size_t flat_len = ROUNDUP_N(total_bits, 8) / 8;
+        const u8 *flat = sc_consume(in, flat_len);
+        if (!flat) {
+            return 0;
+        }
+        for (size_t i = 0; i < flat_len; i++) {
+            for (u32 b = 0; b < 8; b++) {
+                if (!(flat[i] & (1U << b))) {
+                    continue;
+                }
+                u32 key = i * 8 + b;
+                if (key >= total_bits) {
+                    return 0;
+                }
+                mmbit_set(bits, total_bits, key);
+            }
+        }
+        return 1;
+    }
+
+    const u64a count = header >> 1;
+    if (count > total_bits) {
+        return 0;
+    }
+    const u32 width = mmbitKeyWidth(total_bits);
+    for (u64a j = 0; j < count; j++) {
+        const u8 *p = sc_consume(in, width);
+        if (!p) {
+            return 0;
+        }
+        u32 key = partial_load_u32(p, width);
+        if (key >= total_bits) {
+            return 0;
+        }
+        mmbit_set(bits, total_bits, key);
+    }
+    return 1;
+}
+
+static really_inline
+u32 lagTableSize(const struct RoseEngine *rose) {
+    /* one byte per lagged leftfix, laid out directly before the anchored
+     * matcher state */
+    const struct RoseStateOffsets *so = &rose->stateOffsets;
+    assert(so->anchorState >= so->leftfixLagTable);
+    return so->anchorState - so->leftfixLagTable;
+}
+
+static really_inline
+u32 historyAmount(const struct RoseEngine *rose, u64a offset) {
+    return MIN(rose->historyRequired, offset);
+}
+
+size_t compressStream(const struct hs_stream *stream, char *buf,
+                      size_t buf_space) {
+    assert(stream && stream->rose);
+    const struct RoseEngine *rose = stream->rose;
+    const struct RoseStateOffsets *so = &rose->stateOffsets;
+    const char *state = getMultiStateConst(stream);
+
+    struct sc_out out = { buf, buf ? buf_space : 0, 0 };
+
+    sc_write_varint(&out, stream->offset);
+    sc_write(&out, state, sizeof(u8)); // status flags
+
+    const u8 *leaf = (const u8 *)state + so->activeLeafArray;
+    const u8 *left = (const u8 *)state + so->activeLeftArray;
+    sc_write_mmbit(&out, (const u8 *)state + sizeof(u8),
+                   rose->rolesWithStateCount);
+    sc_write_mmbit(&out, leaf, rose->activeArrayCount);
+    sc_write_mmbit(&out, left, rose->activeLeftCount);
+
+    sc_write(&out, state + so->floatingMatcherState,
+             rose->floatingStreamState);
+    sc_write(&out, state + so->leftfixLagTable, lagTableSize(rose));
+    sc_write(&out, state + so->anchorState, rose->anchorStateSize);
+    sc_write(&out, state + so->groups, so->groups_size);
+
+    const u32 hlen = historyAmount(rose, stream->offset);
+    sc_write(&out, state + so->history + rose->historyRequired - hlen, hlen);
+
+    sc_write_mmbit(&out, (const u8 *)state + so->exhausted, rose->ekeyCount);
+    sc_write_mmbit(&out, (const u8 *)state + so->logicalVec, rose->lkeyCount);
+    sc_write_mmbit(&out, (const u8 *)state + so->combVec, rose->ckeyCount);
+
+    if (rose->somLocationCount) {
+        const u32 count = rose->somLocationCount;
+        const u8 *som_valid = (const u8 *)state + so->somValid;
+        sc_write_mmbit(&out, som_valid, count);
+        sc_write_mmbit(&out, (const u8 *)state + so->somWritable, count);
+        if (so->somLocation) {
+            const char *som_store = state + so->somLocation;
+            for (u32 i = mmbit_iterate(som_valid, count, MMB_INVALID);
+                 i != MMB_INVALID; i = mmbit_iterate(som_valid, count, i)) {
+                sc_write(&out, som_store + i * rose->somHorizon,
+                         rose->somHorizon);
+            }
+        }
+    }
+
+    for (u32 qi = mmbit_iterate(leaf, rose->activeArrayCount, MMB_INVALID);
+         qi != MMB_INVALID;
+         qi = mmbit_iterate(leaf, rose->activeArrayCount, qi)) {
+        const struct NfaInfo *info = getNfaInfoByQueue(rose, qi);
+        const struct NFA *nfa = getNfaByInfo(rose, info);
+        sc_write(&out, state + info->stateOffset, nfa->streamStateSize);
+    }
+
+    const struct LeftNfaInfo *left_table = getLeftTable(rose);
+    for (u32 ri = mmbit_iterate(left, rose->activeLeftCount, MMB_INVALID);
+         ri != MMB_INVALID;
+         ri = mmbit_iterate(left, rose->activeLeftCount, ri)) {
+        if (left_table[ri].transient) {
+            continue; // state lives in scratch
+        }
+        u32 qi = ri + rose->leftfixBeginQueue;
+        const struct NfaInfo *info = getNfaInfoByQueue(rose, qi);
+        const struct NFA *nfa = getNfaByInfo(rose, info);
+        sc_write(&out, state + info->stateOffset, nfa->streamStateSize);
+    }
+
+    DEBUG_PRINTF("compressed %u bytes of state into %zu\n", so->end,
+                 out.used);
+    return out.used;
+}
+
+char expandStream(struct hs_stream *stream, const struct RoseEngine *rose,
+                  const char *buf, size_t buf_size) {
+    assert(stream && rose && buf);
+    const struct RoseStateOffsets *so = &rose->stateOffsets;
+    char *state = getMultiState(stream);
+
+    /* everything not restored below is dead, but keep it deterministic */
+    memset(state, 0, so->end);
+    stream->rose = rose;
+
+    struct sc_in in = { buf, buf_size, 0 };
+
+    u64a offset;
+    if (!sc_read_varint(&in, &offset)) {
+        return 0;
+    }
+    stream->offset = offset;
+
+    if (!sc_read(&in, state, sizeof(u8))) {
+        return 0;
+    }
+
+    u8 *leaf = (u8 *)state + so->activeLeafArray;
+    u8 *left = (u8 *)state + so->activeLeftArray;
+    if (!sc_read_mmbit(&in, (u8 *)state + sizeof(u8),
+                       rose->rolesWithStateCount)
+        || !sc_read_mmbit(&in, leaf, rose->activeArrayCount)
+        || !sc_read_mmbit(&in, left, rose->activeLeftCount)) {
+        return 0;
+    }
+
+    if (!sc_read(&in, state + so->floatingMatcherState,
+                 rose->floatingStreamState)
+        || !sc_read(&in, state + so->leftfixLagTable, lagTableSize(rose))
+        || !sc_read(&in, state + so->anchorState, rose->anchorStateSize)
+        || !sc_read(&in, state + so->groups, so->groups_size)) {
+        return 0;
+    }
+
+    const u32 hlen = historyAmount(rose, offset);
+    if (!sc_read(&in, state + so->history + rose->historyRequired - hlen,
+                 hlen)) {
+        return 0;
+    }
+
+    if (!sc_read_mmbit(&in, (u8 *)state + so->exhausted, rose->ekeyCount)
+        || !sc_read_mmbit(&in, (u8 *)state + so->logicalVec, rose->lkeyCount)
+        || !sc_read_mmbit(&in, (u8 *)state + so->combVec, rose->ckeyCount)) {
+        return 0;
+    }
+
+    if (rose->somLocationCount) {
+        const u32 count = rose->somLocationCount;
+        u8 *som_valid = (u8 *)state + so->somValid;
+        if (!sc_read_mmbit(&in, som_valid, count)
+            || !sc_read_mmbit(&in, (u8 *)state + so->somWritable, count)) {
+            return 0;
+        }
+        if (so->somLocation) {
+            char *som_store = state + so->somLocation;
+            for (u32 i = mmbit_iterate(som_valid, count, MMB_INVALID);
+                 i != MMB_INVALID; i = mmbit_iterate(som_valid, count, i)) {
+                if (!sc_read(&in, som_store + i * rose->somHorizon,
+                             rose->somHorizon)) {
+                    return 0;
+                }
+            }
+        }
+    }
+
+    for (u32 qi = mmbit_iterate(leaf, rose->activeArrayCount, MMB_INVALID);
+         qi != MMB_INVALID;
+         qi = mmbit_iterate(leaf, rose->activeArrayCount, qi)) {
+        const struct NfaInfo *info = getNfaInfoByQueue(rose, qi);
+        const struct NFA *nfa = getNfaByInfo(rose, info);
+        if (!sc_read(&in, state + info->stateOffset, nfa->streamStateSize)) {
+            return 0;
+        }
+    }
+
+    const struct LeftNfaInfo *left_table = getLeftTable(rose);
+    for (u32 ri = mmbit_iterate(left, rose->activeLeftCount, MMB_INVALID);
+         ri != MMB_INVALID;
+         ri = mmbit_iterate(left, rose->activeLeftCount, ri)) {
+        if (left_table[ri].transient) {
+            continue;
+        }
+        u32 qi = ri + rose->leftfixBeginQueue;
+        const struct NfaInfo *info = getNfaInfoByQueue(rose, qi);
+        const struct NFA *nfa = getNfaByInfo(rose, info);
+        if (!sc_read(&in, state + info->stateOffset, nfa->streamStateSize)) {
+            return 0;
+        }
+    }
+
+    /* trailing bytes mean this was not produced for this engine */
+    return in.pos == in.len;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Stream state compression: packing the live parts of a stream's state
+ * into a flat byte buffer and rebuilding a stream from it.
+ */
+
+#ifndef STREAM_COMPRESS_H
+#define STREAM_COMPRESS_H
+
+#include "ue2common.h"
+
+#include <stddef.h>
+
+struct hs_stream;
+struct RoseEngine;
+
+/** \brief Compress the given stream into \a buf.
+ *
+ * Returns the number of bytes required for the compressed stream. The
+ * compressed stream has only been written if this is no greater than
+ * \a buf_space; \a buf may be NULL to query the required size.
+ */
+size_t compressStream(const struct hs_stream *stream, char *buf,
+                      size_t buf_space);
+
+/** \brief Rebuild a stream for the given Rose engine from the compressed
+ * stream in \a buf.
+ *
+ * The stream must have been allocated with enough space for the engine's
+ * stream state. Returns zero if \a buf does not hold a well-formed compressed
+ * stream for this engine, in which case the stream's contents are undefined.
+ */
+char expandStream(struct hs_stream *stream, const struct RoseEngine *rose,
+                  const char *buf, size_t buf_size);
+
+#endif // STREAM_COMPRESS_H
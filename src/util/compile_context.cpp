@@ -36,11 +36,15 @@ namespace ue2 {
 
 CompileContext::CompileContext(bool in_isStreaming, bool in_isVectored,
                                const target_t &in_target_info,
-                               const Grey &in_grey)
+                               const Grey &in_grey,
+                               EngineCache *in_engine_cache,
+                               bool in_isUnordered)
     : streaming(in_isStreaming || in_isVectored),
       vectored(in_isVectored),
+      unordered(in_isUnordered),
       target_info(in_target_info),
-      grey(in_grey) {
+      grey(in_grey),
+      engine_cache(in_engine_cache) {
 }
 
 } // namespace ue2
@@ -38,20 +38,31 @@
 
 namespace ue2 {
 
+class EngineCache;
+
 /** \brief Structure for describing the compile environment: grey box settings,
  * target arch, mode flags, etc. */
 struct CompileContext {
     CompileContext(bool isStreaming, bool isVectored,
-                   const target_t &target_info, const Grey &grey);
+                   const target_t &target_info, const Grey &grey,
+                   EngineCache *engine_cache = nullptr,
+                   bool isUnordered = false);
 
     const bool streaming; /* streaming or vectored mode */
     const bool vectored;
 
+    /** \brief Matches need not be delivered in order or deduplicated
+     * (HS_MODE_UNORDERED). */
+    const bool unordered;
+
     /** \brief Target platform info. */
     const target_t target_info;
 
     /** \brief Greybox structure, allows tuning of all sorts of behaviour. */
     const Grey grey;
+
+    /** \brief Cache of engines from previous compiles, or nullptr. */
+    EngineCache *const engine_cache;
 };
 
 } // namespace ue2
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file
+ * \brief Compile-time phase timing and heap usage report.
+ */
+#include "compile_report.h"
+
+#include <algorithm>
+#include <new>
+
+#if defined(HAVE_MALLINFO2) || defined(HAVE_MALLINFO)
+#include <malloc.h>
+#endif
+
+using namespace std;
+using namespace std::chrono;
+
+namespace ue2 {
+
+#if defined(_WIN32)
+#define REPORT_TLS __declspec(thread)
+#else
+#define REPORT_TLS __thread
+#endif
+
+/** \brief Innermost phase being recorded on this thread. */
+static REPORT_TLS CompilePhase *tls_top = nullptr;
+
+/** \brief Phase on another thread that this thread's work belongs to. */
+static REPORT_TLS const CompilePhase *tls_outer = nullptr;
+
+/** \brief Bytes currently allocated from the heap, or zero if we have no way
+ * of finding out. */
+static
+u64a heapInUse() {
+#if defined(HAVE_MALLINFO2)
+    struct mallinfo2 mi = mallinfo2();
+    return (u64a)mi.uordblks + (u64a)mi.hblkhd;
+#elif defined(HAVE_MALLINFO)
+    // Older interface: these are ints, which wrap above 2GB.
+    struct mallinfo mi = mallinfo();
+    return (u64a)(unsigned int)mi.uordblks + (u64a)(unsigned int)mi.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+static
+u64a nanosSince(steady_clock::time_point t) {
+    return duration_cast<nanoseconds>(steady_clock::now() - t).count();
+}
+
+CompileReport::CompileReport()
+    : start(steady_clock::now()), heap_base(heapInUse()),
+      heap_high(heap_base) {}
+
+PhaseStats &CompileReport::lookupPhase(const string &path, u32 depth) {
+    auto it = phase_index.find(path);
+    if (it == phase_index.end()) {
+        it = phase_index.emplace(path, phases.size()).first;
+        phases.push_back(PhaseStats());
+        phases.back().name = path;
+        phases.back().depth = depth;
+    }
+    return phases[it->second];
+}
+
+void CompileReport::startPhase(const string &path, u32 depth) {
+    lock_guard<mutex> guard(lock);
+    lookupPhase(path, depth);
+}
+
+void CompileReport::addPhase(const string &path, u32 depth, u64a time,
+                             u64a heap_start, u64a heap_max) {
+    lock_guard<mutex> guard(lock);
+
+    PhaseStats &ps = lookupPhase(path, depth);
+    ps.calls++;
+    ps.time_ns += time;
+    if (heap_max > heap_start) {
+        ps.peak_heap = max(ps.peak_heap, heap_max - heap_start);
+    }
+    heap_high = max(heap_high, heap_max);
+}
+
+void CompileReport::addExpression(u32 index, u32 id, u64a time,
+                                  u64a peak) {
+    lock_guard<mutex> guard(lock);
+    expressions.push_back(ExpressionStats{index, id, time, peak});
+}
+
+void CompileReport::finish() {
+    lock_guard<mutex> guard(lock);
+    time_ns = nanosSince(start);
+    heap_high = max(heap_high, heapInUse());
+    peak_heap = heap_high - heap_base;
+}
+
+CompilePhase::CompilePhase(CompileReport *r, const char *name) {
+    if (!r) {
+        return;
+    }
+    prev = tls_top;
+    path = name;
+    begin(r);
+}
+
+CompilePhase::CompilePhase(const char *name) {
+    const CompilePhase *up = tls_top;
+    if (up) {
+        parent = tls_top;
+    } else {
+        up = tls_outer;
+        if (!up) {
+            return;
+        }
+    }
+    prev = tls_top;
+    path = up->path + '/' + name;
+    depth = up->depth + 1;
+    begin(up->report);
+}
+
+void CompilePhase::begin(CompileReport *r) {
+    r->startPhase(path, depth);
+    report = r;
+    heap_start = heapInUse();
+    heap_max = heap_start;
+    if (parent) {
+        parent->heap_max = max(parent->heap_max, heap_start);
+    }
+    tls_top = this;
+    start = steady_clock::now();
+}
+
+CompilePhase::~CompilePhase() {
+    end();
+}
+
+void CompilePhase::end() {
+    if (!report) {
+        return;
+    }
+
+    time_ns = nanosSince(start);
+    heap_max = max(heap_max, heapInUse());
+    if (parent) {
+        parent->heap_max = max(parent->heap_max, heap_max);
+    }
+
+    assert(tls_top == this);
+    tls_top = prev;
+
+    try {
+        report->addPhase(path, depth, time_ns, heap_start, heap_max);
+    } catch (const std::bad_alloc &) {
+        // We may be running during unwinding; drop this sample rather than
+        // throwing from a destructor.
+    }
+    report = nullptr;
+}
+
+const CompilePhase *CompilePhase::current() {
+    return tls_top ? tls_top : tls_outer;
+}
+
+CompilePhase::Inherit::Inherit(const CompilePhase *parent)
+    : prev(tls_outer) {
+    tls_outer = parent;
+}
+
+CompilePhase::Inherit::~Inherit() {
+    tls_outer = prev;
+}
+
+} // namespace ue2
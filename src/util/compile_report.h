@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file
+ * \brief Compile-time phase timing and heap usage report.
+ *
+ * Compiler code marks out the phases it wants accounted for with a scoped
+ * \ref CompilePhase. Phases nest: a phase started while another is running on
+ * the same thread is recorded as its child, under a '/'-separated path such as
+ * "build/rose/merge_small_leftfixes". Work handed to other threads by
+ * parallelFor() is recorded under the phase that handed it out.
+ *
+ * Phases only do any work when a \ref CompileReport is being collected, which
+ * is decided by the outermost phase; otherwise they cost a thread-local load.
+ *
+ * Heap usage is sampled from the C library's allocator statistics when a
+ * phase starts and ends, so the peak recorded for a phase is the highest
+ * sample taken inside it (including those of its children), not an exact
+ * high-water mark.
+ */
+
+#ifndef UTIL_COMPILE_REPORT_H
+#define UTIL_COMPILE_REPORT_H
+
+#include "ue2common.h"
+#include "util/ue2_containers.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+namespace ue2 {
+
+/** \brief Totals for one phase path, over every time it ran. */
+struct PhaseStats {
+    std::string name; //!< full path of the phase
+    u32 depth = 0; //!< nesting depth, zero for a top-level phase
+    u32 calls = 0; //!< number of times the phase ran
+    u64a time_ns = 0; //!< total wall time
+    u64a peak_heap = 0; //!< largest heap growth seen during one run
+};
+
+/** \brief Cost of adding one expression to the compiler. */
+struct ExpressionStats {
+    u32 index; //!< index in the caller's expression array
+    u32 id; //!< the expression's match ID
+    u64a time_ns; //!< wall time spent in parse and graph analysis
+    u64a peak_heap; //!< largest heap growth seen while doing so
+};
+
+/** \brief Numbers of engines of each kind in the final bytecode. */
+struct EngineCounts {
+    u32 limex = 0;
+    u32 mcclellan = 0;
+    u32 sheng = 0;
+    u32 mcsheng = 0;
+    u32 gough = 0;
+    u32 castle = 0;
+    u32 lbr = 0;
+    u32 mpv = 0;
+    u32 other = 0;
+
+    u32 outfixes = 0; //!< engines run from offset zero (including MPV)
+    u32 suffixes = 0; //!< engines triggered by Rose roles
+    u32 leftfixes = 0; //!< prefix and infix engines
+    u32 literal_matchers = 0; //!< anchored, floating, EOD and small-block
+    bool small_write = false; //!< database has a small-write engine
+};
+
+/** \brief Results collected over one compile. All members may be read once
+ * the compile has finished. */
+class CompileReport : boost::noncopyable {
+public:
+    CompileReport();
+
+    /** \brief Notes that the phase at \a path has started, so that phases
+     * are listed in the order they first started. Thread-safe. */
+    void startPhase(const std::string &path, u32 depth);
+
+    /** \brief Adds one run of the phase at \a path. Thread-safe. */
+    void addPhase(const std::string &path, u32 depth, u64a time_ns,
+                  u64a heap_start, u64a heap_max);
+
+    /** \brief Records the cost of one expression. */
+    void addExpression(u32 index, u32 id, u64a time_ns, u64a peak_heap);
+
+    /** \brief Stamps the total time and heap peak of the compile. */
+    void finish();
+
+    /** \brief Phases in the order they first started. */
+    std::vector<PhaseStats> phases;
+
+    std::vector<ExpressionStats> expressions;
+
+    EngineCounts engines;
+
+    u64a time_ns = 0; //!< total wall time, set by finish()
+    u64a peak_heap = 0; //!< peak heap growth, set by finish()
+
+private:
+    PhaseStats &lookupPhase(const std::string &path, u32 depth);
+
+    std::mutex lock;
+    ue2::unordered_map<std::string, size_t> phase_index;
+    std::chrono::steady_clock::time_point start;
+    u64a heap_base;
+    u64a heap_high;
+};
+
+/** \brief Scoped timer for one compile phase. */
+class CompilePhase : boost::noncopyable {
+public:
+    /** \brief Starts a top-level phase that is recorded in \a report, which
+     * may be null, in which case the phase and everything nested in it are
+     * not recorded. */
+    CompilePhase(CompileReport *report, const char *name);
+
+    /** \brief Starts a phase nested in the one currently running on this
+     * thread, if there is one that is being recorded. */
+    explicit CompilePhase(const char *name);
+
+    ~CompilePhase();
+
+    /** \brief Ends the phase before it goes out of scope. */
+    void end();
+
+    /** \brief Wall time taken, once the phase has ended. */
+    u64a elapsed() const { return time_ns; }
+
+    /** \brief Peak heap growth, once the phase has ended. */
+    u64a peakHeap() const {
+        return heap_max > heap_start ? heap_max - heap_start : 0;
+    }
+
+    /** \brief The innermost phase being recorded for this thread, or nullptr.
+     */
+    static const CompilePhase *current();
+
+    /** \brief Makes phases started on the calling thread, while this object
+     * is in scope, children of \a parent, which belongs to another thread. */
+    class Inherit : boost::noncopyable {
+    public:
+        explicit Inherit(const CompilePhase *parent);
+        ~Inherit();
+    private:
+        const CompilePhase *prev;
+    };
+
+private:
+    void begin(CompileReport *r);
+
+    CompileReport *report = nullptr; //!< nullptr if not recording
+    CompilePhase *parent = nullptr; //!< enclosing phase on this thread
+    CompilePhase *prev = nullptr; //!< innermost phase before this one began
+    std::string path;
+    u32 depth = 0;
+    std::chrono::steady_clock::time_point start;
+    u64a heap_start = 0;
+    u64a heap_max = 0;
+    u64a time_ns = 0;
+};
+
+} // namespace ue2
+
+#endif // UTIL_COMPILE_REPORT_H
@@ -41,6 +41,11 @@ u64a cpuid_flags(void);
 
 u32 cpuid_tune(void);
 
+/* Individual feature checks, used by the fat runtime dispatcher. */
+int check_avx512(void);
+int check_avx2(void);
+int check_ssse3(void);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Inline functions for manipulating the logical and combination
+ * vectors used to evaluate logical combinations.
+ */
+
+#ifndef LOGICAL_H
+#define LOGICAL_H
+
+#include "rose/rose_internal.h"
+#include "util/multibit.h"
+#include "ue2common.h"
+
+/** Index meaning a given logical key is invalid. */
+#define INVALID_LKEY    (~(u32)0)
+
+/** \brief Test whether the given key (\a lkey) is set in the logical vector
+ * \a lvec. */
+static really_inline
+char getLogicalVal(const struct RoseEngine *t, const u8 *lvec, u32 lkey) {
+    assert(lkey != INVALID_LKEY);
+    assert(lkey < t->lkeyCount);
+    return mmbit_isset(lvec, t->lkeyCount, lkey);
+}
+
+/** \brief Set the given key (\a lkey) in the logical vector \a lvec to
+ * \a val. */
+static really_inline
+void setLogicalVal(const struct RoseEngine *t, u8 *lvec, u32 lkey, char val) {
+    assert(lkey != INVALID_LKEY);
+    assert(lkey < t->lkeyCount);
+    if (val) {
+        mmbit_set(lvec, t->lkeyCount, lkey);
+    } else {
+        mmbit_unset(lvec, t->lkeyCount, lkey);
+    }
+}
+
+/** \brief Evaluate every operation in the logical tree, writing each result
+ * into \a lvec. Operands always precede the operations that use them. */
+static really_inline
+void evalLogicalTree(const struct RoseEngine *t, u8 *lvec) {
+    const struct LogicalOp *op = (const struct LogicalOp *)
+        ((const char *)t + t->logicalTreeOffset);
+    for (u32 i = 0; i < t->lopCount; i++, op++) {
+        char val = getLogicalVal(t, lvec, op->lo);
+        switch (op->op) {
+        case LOGICAL_OP_NOT:
+            val = !val;
+            break;
+        case LOGICAL_OP_AND:
+            val = val && getLogicalVal(t, lvec, op->ro);
+            break;
+        case LOGICAL_OP_OR:
+            val = val || getLogicalVal(t, lvec, op->ro);
+            break;
+        default:
+            assert(0);
+        }
+        DEBUG_PRINTF("lkey %u = %d\n", op->id, (int)val);
+        setLogicalVal(t, lvec, op->id, val);
+    }
+}
+
+/** \brief Clear all keys in the logical vector. */
+static really_inline
+void clearLvec(const struct RoseEngine *t, u8 *lvec) {
+    DEBUG_PRINTF("clearing lvec %p %u\n", lvec, t->lkeyCount);
+    mmbit_clear(lvec, t->lkeyCount);
+}
+
+/** \brief Clear all keys in the combination vector. */
+static really_inline
+void clearCvec(const struct RoseEngine *t, u8 *cvec) {
+    DEBUG_PRINTF("clearing cvec %p %u\n", cvec, t->ckeyCount);
+    mmbit_clear(cvec, t->ckeyCount);
+}
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file
+ * \brief Simple fork/join helper for running independent compile-time work
+ * items on a number of threads.
+ */
+
+#ifndef UTIL_PARALLEL_H
+#define UTIL_PARALLEL_H
+
+#include "ue2common.h"
+#include "util/compile_report.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace ue2 {
+
+/**
+ * \brief Returns the number of threads to use for a requested thread count,
+ * where zero means one thread per hardware thread.
+ */
+static inline
+u32 resolveThreadCount(u32 requested) {
+    if (requested) {
+        return requested;
+    }
+    u32 hw = std::thread::hardware_concurrency();
+    return hw ? hw : 1;
+}
+
+/**
+ * \brief Calls \a func(i) for each i in [0, count) using up to \a threads
+ * threads (including the calling thread).
+ *
+ * Work items are handed out in index order. If any item throws, no further
+ * items are started and the exception from the lowest-indexed failing item is
+ * rethrown once all threads have finished, which is the exception that a
+ * serial loop would have thrown. Callers are responsible for ensuring that
+ * the work items do not share mutable state.
+ *
+ * Compile phases started by the work items are reported as children of the
+ * calling thread's current phase, whichever thread runs them.
+ */
+template<class Func>
+void parallelFor(size_t count, u32 threads, Func &&func) {
+    threads = (u32)std::min<size_t>(resolveThreadCount(threads), count);
+
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::exception_ptr> errors(count);
+
+    auto worker = [&]() {
+        // Once an item has failed we stop taking new items, but any item
+        // already taken is run, so every item below the failing one runs.
+        while (!failed) {
+            size_t i = next++;
+            if (i >= count) {
+                return;
+            }
+            try {
+                func(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    const CompilePhase *phase = CompilePhase::current();
+    auto spawned = [&]() {
+        CompilePhase::Inherit inherit(phase);
+        worker();
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (u32 t = 1; t < threads; t++) {
+        try {
+            pool.emplace_back(spawned);
+        } catch (const std::system_error &) {
+            // Unable to start any more threads; carry on with what we have.
+            break;
+        }
+    }
+
+    worker();
+
+    for (auto &th : pool) {
+        th.join();
+    }
+
+    for (const auto &e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+} // namespace ue2
+
+#endif
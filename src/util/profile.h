@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file
+ * \brief Runtime profiling counters.
+ *
+ * When the library is built with PROFILE_SUPPORT, the runtime accumulates
+ * counters describing where scan time goes into the scratch region.
+ *
+ * Leaf code (acceleration, LimEx exception handling, FDR/Teddy confirm, Rose
+ * programs, catchup) has no access to scratch, so it bumps per-thread event
+ * counters with \ref PROFILE_EVENT. The points that know which engine or
+ * literal matcher is running take a \ref ProfileMark before the call and
+ * attribute the elapsed cycles and the event deltas to it afterwards. Times
+ * are inclusive: work done in match callbacks is charged to the engine or
+ * matcher that raised the match as well as to anything it runs.
+ *
+ * Without PROFILE_SUPPORT, \ref PROFILE_EVENT compiles to nothing and none of
+ * the structures here exist.
+ */
+
+#ifndef UTIL_PROFILE_H
+#define UTIL_PROFILE_H
+
+#include "ue2common.h"
+
+#ifdef PROFILE_SUPPORT
+
+#include "util/bitutils.h"
+
+/** \brief Literal matcher tables profiled separately. These must match the
+ * HS_PROFILE_TABLE_* values in hs_runtime.h. */
+#define PROFILE_TABLE_FLOATING      0
+#define PROFILE_TABLE_ANCHORED      1
+#define PROFILE_TABLE_EOD           2
+#define PROFILE_TABLE_SMALL_BLOCK   3
+#define PROFILE_TABLE_COUNT         4
+
+/** \brief An acceleration call that skips fewer bytes than this (less than a
+ * vector's worth) is counted as a miss. */
+#define PROFILE_ACCEL_MISS_BYTES    16
+
+/** \brief Events counted by leaf code into thread-local storage. */
+struct ProfileEvents {
+    u64a accel_calls; //!< acceleration scans run
+    u64a accel_bytes; //!< bytes skipped by acceleration
+    u64a accel_misses; //!< scans that skipped < PROFILE_ACCEL_MISS_BYTES
+    u64a exceptions; //!< LimEx exception states processed
+    u64a confirms; //!< FDR/Teddy literal confirm attempts
+    u64a literal_matches; //!< literal matches delivered to Rose
+    u64a programs; //!< Rose programs run
+    u64a instructions; //!< Rose program instructions executed
+    u64a catchup_ops; //!< catchup priority queue operations
+};
+
+/** \brief Counters for the engine on one queue. */
+struct ProfileEngine {
+    u64a execs; //!< queue executions
+    u64a bytes; //!< bytes covered by those executions
+    u64a cycles; //!< timestamp counter ticks
+    struct ProfileEvents events; //!< events raised during those executions
+};
+
+/** \brief Counters for one literal matcher table. */
+struct ProfileMatcher {
+    u64a calls; //!< times the table was run
+    u64a bytes; //!< bytes scanned
+    u64a cycles; //!< timestamp counter ticks
+    struct ProfileEvents events; //!< events raised during those calls
+};
+
+/** \brief Profiling counters held in scratch. */
+struct ProfileCounters {
+    u64a scans; //!< block scans, stream writes and end of stream checks
+    u64a bytes; //!< bytes scanned
+    u64a cycles; //!< timestamp counter ticks spent scanning
+    u64a matches; //!< matches delivered to the user
+    struct ProfileEvents events; //!< all events raised while scanning
+    struct ProfileMatcher matchers[PROFILE_TABLE_COUNT];
+    struct ProfileEngine *engines; //!< one per queue
+    u64a *patterns; //!< user matches, indexed like \a ids
+    u32 engineCount; //!< number of entries in \a engines
+    u32 patternCount; //!< number of entries in \a patterns
+    const u32 *ids; //!< sorted match IDs of the database being scanned
+    u32 idCount; //!< number of entries in \a ids
+};
+
+#if defined(_WIN32)
+#define PROFILE_TLS __declspec(thread)
+#else
+#define PROFILE_TLS __thread
+#endif
+
+/** \brief Per-thread event counters, bumped by \ref PROFILE_EVENT. */
+extern PROFILE_TLS struct ProfileEvents profileEvents;
+
+/** \brief Count \a n events of kind \a field. */
+#define PROFILE_EVENT(field, n) (profileEvents.field += (n))
+
+/** \brief Snapshot taken before running an engine or matcher. */
+struct ProfileMark {
+    u64a cycles;
+    struct ProfileEvents events;
+};
+
+static really_inline
+void profileMark(struct ProfileMark *m) {
+    m->events = profileEvents;
+    m->cycles = __rdtsc();
+}
+
+/** \brief Add the events raised since mark \a m to \a out. */
+static really_inline
+void profileAddEvents(struct ProfileEvents *out, const struct ProfileMark *m) {
+    const struct ProfileEvents *now = &profileEvents;
+    const struct ProfileEvents *then = &m->events;
+    out->accel_calls += now->accel_calls - then->accel_calls;
+    out->accel_bytes += now->accel_bytes - then->accel_bytes;
+    out->accel_misses += now->accel_misses - then->accel_misses;
+    out->exceptions += now->exceptions - then->exceptions;
+    out->confirms += now->confirms - then->confirms;
+    out->literal_matches += now->literal_matches - then->literal_matches;
+    out->programs += now->programs - then->programs;
+    out->instructions += now->instructions - then->instructions;
+    out->catchup_ops += now->catchup_ops - then->catchup_ops;
+}
+
+/** \brief Charge a queue execution over [from, to) to engine \a e. */
+static really_inline
+void profileEngineDone(struct ProfileEngine *e, const struct ProfileMark *m,
+                       s64a from, s64a to) {
+    if (!e) {
+        return;
+    }
+    e->cycles += __rdtsc() - m->cycles;
+    e->execs++;
+    e->bytes += to > from ? (u64a)(to - from) : 0;
+    profileAddEvents(&e->events, m);
+}
+
+/** \brief Charge a run of literal matcher \a table over \a len bytes. */
+static really_inline
+void profileMatcherDone(struct ProfileCounters *p, u32 table,
+                        const struct ProfileMark *m, size_t len) {
+    assert(table < PROFILE_TABLE_COUNT);
+    struct ProfileMatcher *pm = &p->matchers[table];
+    pm->cycles += __rdtsc() - m->cycles;
+    pm->calls++;
+    pm->bytes += len;
+    profileAddEvents(&pm->events, m);
+}
+
+/** \brief Charge a block scan, stream write or end of stream check of \a len
+ * bytes. */
+static really_inline
+void profileScanDone(struct ProfileCounters *p, const struct ProfileMark *m,
+                     size_t len) {
+    p->cycles += __rdtsc() - m->cycles;
+    p->scans++;
+    p->bytes += len;
+    profileAddEvents(&p->events, m);
+}
+
+/** \brief Declare a \ref ProfileMark called \a m and take it now. */
+#define PROFILE_MARK(m)                                                        \
+    struct ProfileMark m;                                                      \
+    profileMark(&m)
+
+/** \brief Charge the run of literal matcher \a table over \a len bytes since
+ * mark \a m to the profile in \a scratch. */
+#define PROFILE_MATCHER(scratch, table, m, len)                                \
+    profileMatcherDone((scratch)->profile, PROFILE_TABLE_##table, &(m), (len))
+
+/** \brief Charge the scan of \a len bytes since mark \a m to the profile in
+ * \a scratch. */
+#define PROFILE_SCAN(scratch, m, len)                                          \
+    profileScanDone((scratch)->profile, &(m), (len))
+
+/** \brief Count a match for \a id delivered to the user. */
+static really_inline
+void profileUserMatch(struct ProfileCounters *p, u32 id) {
+    p->matches++;
+
+    // Binary search for the pattern's slot in the sorted ID table.
+    u32 lo = 0, hi = MIN(p->idCount, p->patternCount);
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        if (p->ids[mid] < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < MIN(p->idCount, p->patternCount) && p->ids[lo] == id) {
+        p->patterns[lo]++;
+    }
+}
+
+#else
+
+#define PROFILE_EVENT(field, n) do {} while (0)
+#define PROFILE_MARK(m) do {} while (0)
+#define PROFILE_MATCHER(scratch, table, m, len) do {} while (0)
+#define PROFILE_SCAN(scratch, m, len) do {} while (0)
+
+#endif // PROFILE_SUPPORT
+
+#endif // UTIL_PROFILE_H
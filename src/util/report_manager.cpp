@@ -113,7 +113,8 @@ u32 ReportManager::numEkeys() const {
 }
 
 bool ReportManager::patternSetCanExhaust() const {
-    return global_exhaust && !toExhaustibleKeyMap.empty();
+    // Logical combinations must be evaluated until the end of the data.
+    return global_exhaust && !toExhaustibleKeyMap.empty() && !pl.numCkeys();
 }
 
 vector<ReportID> ReportManager::getDkeyToReportTable() const {
@@ -201,6 +202,34 @@ void ReportManager::registerExtReport(ReportID id,
     }
 }
 
+bool ReportManager::hasExtReport(ReportID id) const {
+    return contains(externalIdMap, id);
+}
+
+void ReportManager::registerQuiet(ReportID id, bool quiet,
+                                  u32 expressionIndex) {
+    auto it = quietIdMap.find(id);
+    if (it == quietIdMap.end()) {
+        quietIdMap.emplace(id, make_pair(quiet, expressionIndex));
+        return;
+    }
+
+    if (it->second.first != quiet) {
+        ostringstream out;
+        out << "Expression (index " << expressionIndex << ") with match ID "
+            << id << " " << (quiet ? "specified" : "did not specify")
+            << " HS_FLAG_QUIET whereas previous expression (index "
+            << it->second.second << ") with the same match ID did"
+            << (quiet ? " not." : ".");
+        throw CompileError(expressionIndex, out.str());
+    }
+}
+
+bool ReportManager::isQuiet(ReportID id) const {
+    auto it = quietIdMap.find(id);
+    return it != quietIdMap.end() && it->second.first;
+}
+
 Report ReportManager::getBasicInternalReport(const NGWrapper &g, s32 adj) {
     /* validate that we are not violating highlander constraints, this will
      * throw a CompileError if so. */
@@ -35,6 +35,7 @@
 #define REPORT_MANAGER_H
 
 #include "ue2common.h"
+#include "parser/logical_combination.h"
 #include "util/compile_error.h"
 #include "util/report.h"
 
@@ -105,6 +106,18 @@ public:
      * thrown). */
     void registerExtReport(ReportID id, const external_report_info &ext);
 
+    /** \brief True if an external report has been registered with the given
+     * match ID. */
+    bool hasExtReport(ReportID id) const;
+
+    /** \brief Record whether matches with the given external match ID are
+     * quiet (never delivered to the user). Throws a CompileError if this
+     * conflicts with an earlier expression with the same match ID. */
+    void registerQuiet(ReportID id, bool quiet, u32 expressionIndex);
+
+    /** \brief True if matches with the given external match ID are quiet. */
+    bool isQuiet(ReportID id) const;
+
     /** \brief Fetch the ekey associated with the given expression index,
      * assigning one if necessary. */
     u32 getExhaustibleKey(u32 expressionIndex);
@@ -121,6 +134,9 @@ public:
      * set. */
     u32 getProgramOffset(ReportID id) const;
 
+    /** \brief Logical combinations of external reports. */
+    ParsedLogical pl;
+
 private:
     /** \brief Grey box ref, for checking resource limits. */
     const Grey &grey;
@@ -142,6 +158,10 @@ private:
      * id. */
     std::map<ReportID, external_report_info> externalIdMap;
 
+    /** \brief Mapping from external match ids to their quiet status and the
+     * index of the first expression that used them. */
+    std::map<ReportID, std::pair<bool, u32>> quietIdMap;
+
     /** \brief Mapping from expression index to exhaustion key. */
     std::map<s64a, u32> toExhaustibleKeyMap;
 
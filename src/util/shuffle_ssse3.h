@@ -76,4 +76,28 @@ u32 shufflePshufb128(m128 s, const m128 permute, const m128 compare) {
 }
 #endif // NO_SSSE3
 
+#if defined(__AVX2__)
+/* As shufflePshufb128, but over both lanes at once. The lanes are expected to
+ * set disjoint bits, so their results are combined into one 16-bit index. */
+static really_inline
+u32 shufflePshufb256(m256 s, const m256 permute, const m256 compare) {
+    m256 shuffled = vpshufb(s, permute);
+    m256 compared = and256(shuffled, compare);
+    u32 rv = ~movemask256(eq256(compared, shuffled));
+    return (rv | (rv >> 16)) & 0xffff;
+}
+#endif // AVX2
+
+#if defined(__AVX512BW__)
+/* As shufflePshufb256, over all four lanes of a 512-bit vector. */
+static really_inline
+u32 shufflePshufb512(m512 s, const m512 permute, const m512 compare) {
+    m512 shuffled = _mm512_shuffle_epi8(s, permute);
+    m512 compared = and512(shuffled, compare);
+    u64a rv = _mm512_cmpneq_epi8_mask(compared, shuffled);
+    rv |= rv >> 32;
+    return (u32)(rv | (rv >> 16)) & 0xffff;
+}
+#endif // AVX512BW
+
 #endif // SHUFFLE_SSSE3_H
@@ -68,9 +68,18 @@ typedef __m256i m256;
 typedef struct ALIGN_AVX_DIRECTIVE {m128 lo; m128 hi;} m256;
 #endif
 
-// these should align to 16 and 32 respectively
 typedef struct {m128 lo; m128 mid; m128 hi;} m384;
-typedef struct {m256 lo; m256 hi;} m512;
+#if defined(__AVX512BW__)
+typedef __m512i m512;
+#else
+// aligned as the native type, so that bytecode layout does not depend on
+// whether AVX-512 is available
+typedef struct ALIGN_ATTR(64) {m256 lo; m256 hi;} m512;
+#endif
+
+// wider state sets for the largest LimEx models
+typedef struct {m256 lo; m256 mid; m256 hi;} m768;
+typedef struct {m512 lo; m512 hi;} m1024;
 
 #endif /* SIMD_TYPES_H */
 
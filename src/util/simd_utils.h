@@ -980,6 +980,112 @@ char testbit384(const m384 *ptr, unsigned int n) {
  **** 512-bit Primitives
  ****/
 
+#if defined(__AVX512BW__)
+
+static really_inline m512 and512(m512 a, m512 b) {
+    return _mm512_and_si512(a, b);
+}
+
+static really_inline m512 or512(m512 a, m512 b) {
+    return _mm512_or_si512(a, b);
+}
+
+static really_inline m512 xor512(m512 a, m512 b) {
+    return _mm512_xor_si512(a, b);
+}
+
+static really_inline m512 zeroes512(void) {
+    return _mm512_setzero_si512();
+}
+
+static really_inline m512 ones512(void) {
+    return _mm512_set1_epi8(0xFF);
+}
+
+static really_inline m512 not512(m512 a) {
+    return _mm512_xor_si512(a, ones512());
+}
+
+static really_inline m512 andnot512(m512 a, m512 b) {
+    return _mm512_andnot_si512(a, b);
+}
+
+#define shift512(a, b)  _mm512_slli_epi64((a), (b))
+
+static really_inline int diff512(m512 a, m512 b) {
+    return !!_mm512_cmpneq_epi64_mask(a, b);
+}
+
+static really_inline int isnonzero512(m512 a) {
+    return !!_mm512_test_epi64_mask(a, a);
+}
+
+/**
+ * "Rich" version of diff512(). Takes two vectors a and b and returns a 16-bit
+ * mask indicating which 32-bit words contain differences.
+ */
+static really_inline u32 diffrich512(m512 a, m512 b) {
+    return _mm512_cmpneq_epi32_mask(a, b);
+}
+
+// aligned load
+static really_inline m512 load512(const void *ptr) {
+    assert(ISALIGNED_N(ptr, alignof(m512)));
+    return _mm512_load_si512(ptr);
+}
+
+// aligned store
+static really_inline void store512(void *ptr, m512 a) {
+    assert(ISALIGNED_N(ptr, alignof(m512)));
+    _mm512_store_si512(ptr, a);
+}
+
+// unaligned load
+static really_inline m512 loadu512(const void *ptr) {
+    return _mm512_loadu_si512(ptr);
+}
+
+// packed unaligned store of first N bytes
+static really_inline
+void storebytes512(void *ptr, m512 a, unsigned int n) {
+    assert(n <= sizeof(a));
+    _mm512_mask_storeu_epi8(ptr, n == 64 ? ~0ULL : (1ULL << n) - 1, a);
+}
+
+// packed unaligned load of first N bytes, pad with zero
+static really_inline
+m512 loadbytes512(const void *ptr, unsigned int n) {
+    assert(n <= sizeof(m512));
+    return _mm512_maskz_loadu_epi8(n == 64 ? ~0ULL : (1ULL << n) - 1, ptr);
+}
+
+// vector with only bit N switched on
+static really_inline
+m512 mask1bit512(unsigned int n) {
+    assert(n < sizeof(m512) * 8);
+    return _mm512_maskz_set1_epi8(1ULL << (n / 8), 1U << (n % 8));
+}
+
+// switches on bit N in the given vector.
+static really_inline
+void setbit512(m512 *ptr, unsigned int n) {
+    *ptr = or512(mask1bit512(n), *ptr);
+}
+
+// switches off bit N in the given vector.
+static really_inline
+void clearbit512(m512 *ptr, unsigned int n) {
+    *ptr = andnot512(mask1bit512(n), *ptr);
+}
+
+// tests bit N in the given vector.
+static really_inline
+char testbit512(const m512 *ptr, unsigned int n) {
+    return !!_mm512_test_epi8_mask(mask1bit512(n), *ptr);
+}
+
+#else // !AVX512BW
+
 #if defined(USE_GCC_COMPOUND_STATEMENTS)
 #define and512(a, b) ({                                                 \
     m512 rv_and512;                                                     \
@@ -1121,15 +1227,6 @@ static really_inline u32 diffrich512(m512 a, m512 b) {
 #endif
 }
 
-/**
- * "Rich" version of diffrich(), 64-bit variant. Takes two vectors a and b and
- * returns a 16-bit mask indicating which 64-bit words contain differences.
- */
-static really_inline u32 diffrich64_512(m512 a, m512 b) {
-    u32 d = diffrich512(a, b);
-    return (d | (d >> 1)) & 0x55555555;
-}
-
 // aligned load
 static really_inline m512 load512(const void *ptr) {
     assert(ISALIGNED_16(ptr));
@@ -1256,4 +1353,347 @@ char testbit512(const m512 *ptr, unsigned int n) {
 #endif
 }
 
+#endif // AVX512BW
+
+/**
+ * "Rich" version of diffrich(), 64-bit variant. Takes two vectors a and b and
+ * returns a 16-bit mask indicating which 64-bit words contain differences.
+ */
+static really_inline u32 diffrich64_512(m512 a, m512 b) {
+    u32 d = diffrich512(a, b);
+    return (d | (d >> 1)) & 0x55555555;
+}
+
+/****
+ **** 768-bit Primitives
+ ****/
+
+static really_inline m768 and768(m768 a, m768 b) {
+    m768 rv;
+    rv.lo = and256(a.lo, b.lo);
+    rv.mid = and256(a.mid, b.mid);
+    rv.hi = and256(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m768 or768(m768 a, m768 b) {
+    m768 rv;
+    rv.lo = or256(a.lo, b.lo);
+    rv.mid = or256(a.mid, b.mid);
+    rv.hi = or256(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m768 xor768(m768 a, m768 b) {
+    m768 rv;
+    rv.lo = xor256(a.lo, b.lo);
+    rv.mid = xor256(a.mid, b.mid);
+    rv.hi = xor256(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m768 not768(m768 a) {
+    m768 rv;
+    rv.lo = not256(a.lo);
+    rv.mid = not256(a.mid);
+    rv.hi = not256(a.hi);
+    return rv;
+}
+
+static really_inline m768 andnot768(m768 a, m768 b) {
+    m768 rv;
+    rv.lo = andnot256(a.lo, b.lo);
+    rv.mid = andnot256(a.mid, b.mid);
+    rv.hi = andnot256(a.hi, b.hi);
+    return rv;
+}
+
+// The shift amount is an immediate, so we define these operations as macros on
+// Intel SIMD (using a GNU C extension).
+#if defined(USE_GCC_COMPOUND_STATEMENTS)
+#define shift768(a, b)  ({                                              \
+    m768 rv_shift768;                                                   \
+    rv_shift768.lo = shift256((a).lo, b);                               \
+    rv_shift768.mid = shift256((a).mid, b);                             \
+    rv_shift768.hi = shift256((a).hi, b);                               \
+    rv_shift768;                                                        \
+})
+#else
+static really_inline m768 shift768(m768 a, unsigned b) {
+    m768 rv;
+    rv.lo = shift256(a.lo, b);
+    rv.mid = shift256(a.mid, b);
+    rv.hi = shift256(a.hi, b);
+    return rv;
+}
+#endif
+
+static really_inline m768 zeroes768(void) {
+    m768 rv = {zeroes256(), zeroes256(), zeroes256()};
+    return rv;
+}
+
+static really_inline m768 ones768(void) {
+    m768 rv = {ones256(), ones256(), ones256()};
+    return rv;
+}
+
+static really_inline int diff768(m768 a, m768 b) {
+    return diff256(a.lo, b.lo) || diff256(a.mid, b.mid) ||
+           diff256(a.hi, b.hi);
+}
+
+static really_inline int isnonzero768(m768 a) {
+    return isnonzero256(or256(or256(a.lo, a.mid), a.hi));
+}
+
+/**
+ * "Rich" version of diff768(). Takes two vectors a and b and returns a 24-bit
+ * mask indicating which 32-bit words contain differences.
+ */
+static really_inline u32 diffrich768(m768 a, m768 b) {
+    return diffrich256(a.lo, b.lo) | (diffrich256(a.mid, b.mid) << 8) |
+           (diffrich256(a.hi, b.hi) << 16);
+}
+
+/**
+ * "Rich" version of diffrich(), 64-bit variant. Takes two vectors a and b and
+ * returns a 24-bit mask indicating which 64-bit words contain differences.
+ */
+static really_inline u32 diffrich64_768(m768 a, m768 b) {
+    u32 d = diffrich768(a, b);
+    return (d | (d >> 1)) & 0x55555555;
+}
+
+// aligned load
+static really_inline m768 load768(const void *ptr) {
+    assert(ISALIGNED_N(ptr, alignof(m256)));
+    m768 rv = { load256(ptr), load256((const char *)ptr + 32),
+                load256((const char *)ptr + 64) };
+    return rv;
+}
+
+// aligned store
+static really_inline void store768(void *ptr, m768 a) {
+    assert(ISALIGNED_N(ptr, alignof(m256)));
+    store256(ptr, a.lo);
+    store256((char *)ptr + 32, a.mid);
+    store256((char *)ptr + 64, a.hi);
+}
+
+// unaligned load
+static really_inline m768 loadu768(const void *ptr) {
+    m768 rv = { loadu256(ptr), loadu256((const char *)ptr + 32),
+                loadu256((const char *)ptr + 64) };
+    return rv;
+}
+
+// packed unaligned store of first N bytes
+static really_inline
+void storebytes768(void *ptr, m768 a, unsigned int n) {
+    assert(n <= sizeof(a));
+    memcpy(ptr, &a, n);
+}
+
+// packed unaligned load of first N bytes, pad with zero
+static really_inline
+m768 loadbytes768(const void *ptr, unsigned int n) {
+    m768 a = zeroes768();
+    assert(n <= sizeof(a));
+    memcpy(&a, ptr, n);
+    return a;
+}
+
+// switches on bit N in the given vector.
+static really_inline
+void setbit768(m768 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    m256 *sub;
+    if (n < 256) {
+        sub = &ptr->lo;
+    } else if (n < 512) {
+        sub = &ptr->mid;
+    } else {
+        sub = &ptr->hi;
+    }
+    setbit256(sub, n % 256);
+}
+
+// switches off bit N in the given vector.
+static really_inline
+void clearbit768(m768 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    m256 *sub;
+    if (n < 256) {
+        sub = &ptr->lo;
+    } else if (n < 512) {
+        sub = &ptr->mid;
+    } else {
+        sub = &ptr->hi;
+    }
+    clearbit256(sub, n % 256);
+}
+
+// tests bit N in the given vector.
+static really_inline
+char testbit768(const m768 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    const m256 *sub;
+    if (n < 256) {
+        sub = &ptr->lo;
+    } else if (n < 512) {
+        sub = &ptr->mid;
+    } else {
+        sub = &ptr->hi;
+    }
+    return testbit256(sub, n % 256);
+}
+
+/****
+ **** 1024-bit Primitives
+ ****/
+
+static really_inline m1024 and1024(m1024 a, m1024 b) {
+    m1024 rv;
+    rv.lo = and512(a.lo, b.lo);
+    rv.hi = and512(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m1024 or1024(m1024 a, m1024 b) {
+    m1024 rv;
+    rv.lo = or512(a.lo, b.lo);
+    rv.hi = or512(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m1024 xor1024(m1024 a, m1024 b) {
+    m1024 rv;
+    rv.lo = xor512(a.lo, b.lo);
+    rv.hi = xor512(a.hi, b.hi);
+    return rv;
+}
+
+static really_inline m1024 not1024(m1024 a) {
+    m1024 rv;
+    rv.lo = not512(a.lo);
+    rv.hi = not512(a.hi);
+    return rv;
+}
+
+static really_inline m1024 andnot1024(m1024 a, m1024 b) {
+    m1024 rv;
+    rv.lo = andnot512(a.lo, b.lo);
+    rv.hi = andnot512(a.hi, b.hi);
+    return rv;
+}
+
+#if defined(USE_GCC_COMPOUND_STATEMENTS)
+#define shift1024(a, b)  ({                                             \
+    m1024 rv_shift1024;                                                 \
+    rv_shift1024.lo = shift512((a).lo, b);                              \
+    rv_shift1024.hi = shift512((a).hi, b);                              \
+    rv_shift1024;                                                       \
+})
+#else
+static really_inline m1024 shift1024(m1024 a, unsigned b) {
+    m1024 rv;
+    rv.lo = shift512(a.lo, b);
+    rv.hi = shift512(a.hi, b);
+    return rv;
+}
+#endif
+
+static really_inline m1024 zeroes1024(void) {
+    m1024 rv = {zeroes512(), zeroes512()};
+    return rv;
+}
+
+static really_inline m1024 ones1024(void) {
+    m1024 rv = {ones512(), ones512()};
+    return rv;
+}
+
+static really_inline int diff1024(m1024 a, m1024 b) {
+    return diff512(a.lo, b.lo) || diff512(a.hi, b.hi);
+}
+
+static really_inline int isnonzero1024(m1024 a) {
+    return isnonzero512(or512(a.lo, a.hi));
+}
+
+/**
+ * "Rich" version of diff1024(). Takes two vectors a and b and returns a 32-bit
+ * mask indicating which 32-bit words contain differences.
+ */
+static really_inline u32 diffrich1024(m1024 a, m1024 b) {
+    return diffrich512(a.lo, b.lo) | (diffrich512(a.hi, b.hi) << 16);
+}
+
+/**
+ * "Rich" version of diffrich(), 64-bit variant. Takes two vectors a and b and
+ * returns a 32-bit mask indicating which 64-bit words contain differences.
+ */
+static really_inline u32 diffrich64_1024(m1024 a, m1024 b) {
+    u32 d = diffrich1024(a, b);
+    return (d | (d >> 1)) & 0x55555555;
+}
+
+// aligned load
+static really_inline m1024 load1024(const void *ptr) {
+    assert(ISALIGNED_N(ptr, alignof(m512)));
+    m1024 rv = { load512(ptr), load512((const char *)ptr + 64) };
+    return rv;
+}
+
+// aligned store
+static really_inline void store1024(void *ptr, m1024 a) {
+    assert(ISALIGNED_N(ptr, alignof(m512)));
+    store512(ptr, a.lo);
+    store512((char *)ptr + 64, a.hi);
+}
+
+// unaligned load
+static really_inline m1024 loadu1024(const void *ptr) {
+    m1024 rv = { loadu512(ptr), loadu512((const char *)ptr + 64) };
+    return rv;
+}
+
+// packed unaligned store of first N bytes
+static really_inline
+void storebytes1024(void *ptr, m1024 a, unsigned int n) {
+    assert(n <= sizeof(a));
+    memcpy(ptr, &a, n);
+}
+
+// packed unaligned load of first N bytes, pad with zero
+static really_inline
+m1024 loadbytes1024(const void *ptr, unsigned int n) {
+    m1024 a = zeroes1024();
+    assert(n <= sizeof(a));
+    memcpy(&a, ptr, n);
+    return a;
+}
+
+// switches on bit N in the given vector.
+static really_inline
+void setbit1024(m1024 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    setbit512(n < 512 ? &ptr->lo : &ptr->hi, n % 512);
+}
+
+// switches off bit N in the given vector.
+static really_inline
+void clearbit1024(m1024 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    clearbit512(n < 512 ? &ptr->lo : &ptr->hi, n % 512);
+}
+
+// tests bit N in the given vector.
+static really_inline
+char testbit1024(const m1024 *ptr, unsigned int n) {
+    assert(n < sizeof(*ptr) * 8);
+    return testbit512(n < 512 ? &ptr->lo : &ptr->hi, n % 512);
+}
+
 #endif
@@ -546,7 +546,12 @@ m512 loadcompressed512_32bit(const void *ptr, m512 mvec) {
                   expand32(v[14], m[14]), expand32(v[15], m[15]) };
 
     m512 xvec;
-#if !defined(__AVX2__)
+#if defined(__AVX512BW__)
+    xvec = _mm512_set_epi32(x[15], x[14], x[13], x[12],
+                            x[11], x[10], x[9], x[8],
+                            x[7], x[6], x[5], x[4],
+                            x[3], x[2], x[1], x[0]);
+#elif !defined(__AVX2__)
     xvec.lo.lo = _mm_set_epi32(x[3], x[2], x[1], x[0]);
     xvec.lo.hi = _mm_set_epi32(x[7], x[6], x[5], x[4]);
     xvec.hi.lo = _mm_set_epi32(x[11], x[10], x[9], x[8]);
@@ -581,7 +586,10 @@ m512 loadcompressed512_64bit(const void *ptr, m512 mvec) {
                   expand64(v[4], m[4]), expand64(v[5], m[5]),
                   expand64(v[6], m[6]), expand64(v[7], m[7]) };
 
-#if !defined(__AVX2__)
+#if defined(__AVX512BW__)
+    m512 xvec = _mm512_set_epi64(x[7], x[6], x[5], x[4],
+                                 x[3], x[2], x[1], x[0]);
+#elif !defined(__AVX2__)
     m512 xvec = { .lo = { _mm_set_epi64x(x[1], x[0]),
                           _mm_set_epi64x(x[3], x[2]) },
                   .hi = { _mm_set_epi64x(x[5], x[4]),
@@ -602,3 +610,243 @@ void loadcompressed512(m512 *x, const void *ptr, const m512 *m,
     *x = loadcompressed512_32bit(ptr, *m);
 #endif
 }
+
+/*
+ * 768-bit store/load.
+ */
+
+#if defined(ARCH_32_BIT)
+static really_inline
+void storecompressed768_32bit(void *ptr, m768 xvec, m768 mvec) {
+    // First, decompose our vectors into 32-bit chunks.
+    u32 x[24];
+    memcpy(x, &xvec, sizeof(xvec));
+    u32 m[24];
+    memcpy(m, &mvec, sizeof(mvec));
+
+    // Count the number of bits of compressed state we're writing out per
+    // chunk, and compress each 32-bit chunk individually.
+    u32 bits[24];
+    u32 v[24];
+    for (u32 i = 0; i < 24; i++) {
+        bits[i] = popcount32(m[i]);
+        v[i] = compress32(x[i], m[i]);
+    }
+
+    // Write packed data out.
+    pack_bits_32(ptr, v, bits, 24);
+}
+#endif
+
+#if defined(ARCH_64_BIT)
+static really_inline
+void storecompressed768_64bit(void *ptr, m768 xvec, m768 mvec) {
+    // First, decompose our vectors into 64-bit chunks.
+    u64a x[12];
+    memcpy(x, &xvec, sizeof(xvec));
+    u64a m[12];
+    memcpy(m, &mvec, sizeof(mvec));
+
+    // Count the number of bits of compressed state we're writing out per
+    // chunk, and compress each 64-bit chunk individually.
+    u32 bits[12];
+    u64a v[12];
+    for (u32 i = 0; i < 12; i++) {
+        bits[i] = popcount64(m[i]);
+        v[i] = compress64(x[i], m[i]);
+    }
+
+    // Write packed data out.
+    pack_bits_64(ptr, v, bits, 12);
+}
+#endif
+
+void storecompressed768(void *ptr, const m768 *x, const m768 *m,
+                        UNUSED u32 bytes) {
+#if defined(ARCH_64_BIT)
+    storecompressed768_64bit(ptr, *x, *m);
+#else
+    storecompressed768_32bit(ptr, *x, *m);
+#endif
+}
+
+#if defined(ARCH_32_BIT)
+static really_inline
+m768 loadcompressed768_32bit(const void *ptr, m768 mvec) {
+    // First, decompose our vectors into 32-bit chunks.
+    u32 m[24];
+    memcpy(m, &mvec, sizeof(mvec));
+
+    u32 bits[24];
+    for (u32 i = 0; i < 24; i++) {
+        bits[i] = popcount32(m[i]);
+    }
+
+    u32 v[24];
+    unpack_bits_32(v, (const u8 *)ptr, bits, 24);
+
+    u32 x[24];
+    for (u32 i = 0; i < 24; i++) {
+        x[i] = expand32(v[i], m[i]);
+    }
+
+    m768 xvec;
+    memcpy(&xvec, x, sizeof(xvec));
+    return xvec;
+}
+#endif
+
+#if defined(ARCH_64_BIT)
+static really_inline
+m768 loadcompressed768_64bit(const void *ptr, m768 mvec) {
+    // First, decompose our vectors into 64-bit chunks.
+    u64a m[12];
+    memcpy(m, &mvec, sizeof(mvec));
+
+    u32 bits[12];
+    for (u32 i = 0; i < 12; i++) {
+        bits[i] = popcount64(m[i]);
+    }
+
+    u64a v[12];
+    unpack_bits_64(v, (const u8 *)ptr, bits, 12);
+
+    u64a x[12];
+    for (u32 i = 0; i < 12; i++) {
+        x[i] = expand64(v[i], m[i]);
+    }
+
+    m768 xvec;
+    memcpy(&xvec, x, sizeof(xvec));
+    return xvec;
+}
+#endif
+
+void loadcompressed768(m768 *x, const void *ptr, const m768 *m,
+                       UNUSED u32 bytes) {
+#if defined(ARCH_64_BIT)
+    *x = loadcompressed768_64bit(ptr, *m);
+#else
+    *x = loadcompressed768_32bit(ptr, *m);
+#endif
+}
+
+/*
+ * 1024-bit store/load.
+ */
+
+#if defined(ARCH_32_BIT)
+static really_inline
+void storecompressed1024_32bit(void *ptr, m1024 xvec, m1024 mvec) {
+    // First, decompose our vectors into 32-bit chunks.
+    u32 x[32];
+    memcpy(x, &xvec, sizeof(xvec));
+    u32 m[32];
+    memcpy(m, &mvec, sizeof(mvec));
+
+    // Count the number of bits of compressed state we're writing out per
+    // chunk, and compress each 32-bit chunk individually.
+    u32 bits[32];
+    u32 v[32];
+    for (u32 i = 0; i < 32; i++) {
+        bits[i] = popcount32(m[i]);
+        v[i] = compress32(x[i], m[i]);
+    }
+
+    // Write packed data out.
+    pack_bits_32(ptr, v, bits, 32);
+}
+#endif
+
+#if defined(ARCH_64_BIT)
+static really_inline
+void storecompressed1024_64bit(void *ptr, m1024 xvec, m1024 mvec) {
+    // First, decompose our vectors into 64-bit chunks.
+    u64a x[16];
+    memcpy(x, &xvec, sizeof(xvec));
+    u64a m[16];
+    memcpy(m, &mvec, sizeof(mvec));
+
+    // Count the number of bits of compressed state we're writing out per
+    // chunk, and compress each 64-bit chunk individually.
+    u32 bits[16];
+    u64a v[16];
+    for (u32 i = 0; i < 16; i++) {
+        bits[i] = popcount64(m[i]);
+        v[i] = compress64(x[i], m[i]);
+    }
+
+    // Write packed data out.
+    pack_bits_64(ptr, v, bits, 16);
+}
+#endif
+
+void storecompressed1024(void *ptr, const m1024 *x, const m1024 *m,
+                        UNUSED u32 bytes) {
+#if defined(ARCH_64_BIT)
+    storecompressed1024_64bit(ptr, *x, *m);
+#else
+    storecompressed1024_32bit(ptr, *x, *m);
+#endif
+}
+
+#if defined(ARCH_32_BIT)
+static really_inline
+m1024 loadcompressed1024_32bit(const void *ptr, m1024 mvec) {
+    // First, decompose our vectors into 32-bit chunks.
+    u32 m[32];
+    memcpy(m, &mvec, sizeof(mvec));
+
+    u32 bits[32];
+    for (u32 i = 0; i < 32; i++) {
+        bits[i] = popcount32(m[i]);
+    }
+
+    u32 v[32];
+    unpack_bits_32(v, (const u8 *)ptr, bits, 32);
+
+    u32 x[32];
+    for (u32 i = 0; i < 32; i++) {
+        x[i] = expand32(v[i], m[i]);
+    }
+
+    m1024 xvec;
+    memcpy(&xvec, x, sizeof(xvec));
+    return xvec;
+}
+#endif
+
+#if defined(ARCH_64_BIT)
+static really_inline
+m1024 loadcompressed1024_64bit(const void *ptr, m1024 mvec) {
+    // First, decompose our vectors into 64-bit chunks.
+    u64a m[16];
+    memcpy(m, &mvec, sizeof(mvec));
+
+    u32 bits[16];
+    for (u32 i = 0; i < 16; i++) {
+        bits[i] = popcount64(m[i]);
+    }
+
+    u64a v[16];
+    unpack_bits_64(v, (const u8 *)ptr, bits, 16);
+
+    u64a x[16];
+    for (u32 i = 0; i < 16; i++) {
+        x[i] = expand64(v[i], m[i]);
+    }
+
+    m1024 xvec;
+    memcpy(&xvec, x, sizeof(xvec));
+    return xvec;
+}
+#endif
+
+void loadcompressed1024(m1024 *x, const void *ptr, const m1024 *m,
+                       UNUSED u32 bytes) {
+#if defined(ARCH_64_BIT)
+    *x = loadcompressed1024_64bit(ptr, *m);
+#else
+    *x = loadcompressed1024_32bit(ptr, *m);
+#endif
+}
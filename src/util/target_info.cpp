@@ -46,16 +46,31 @@ bool target_t::can_run_on_code_built_for(const target_t &code_target) const {
         return false;
     }
 
+    if (!has_avx512() && code_target.has_avx512()) {
+        return false;
+    }
+
     return true;
 }
 
 target_t::target_t(const hs_platform_info &p)
-    : tune(p.tune), cpu_features(p.cpu_features) {}
+    : tune(p.tune), cpu_features(p.cpu_features) {
+    // Every AVX-512 capable CPU also has AVX2, and the database platform
+    // check relies on this: a platform with AVX-512 but no AVX2 is accepted
+    // by no runtime.
+    if (cpu_features & HS_CPU_FEATURES_AVX512) {
+        cpu_features |= HS_CPU_FEATURES_AVX2;
+    }
+}
 
 bool target_t::has_avx2(void) const {
     return (cpu_features & HS_CPU_FEATURES_AVX2);
 }
 
+bool target_t::has_avx512(void) const {
+    return (cpu_features & HS_CPU_FEATURES_AVX512);
+}
+
 bool target_t::is_atom_class(void) const {
     return tune == HS_TUNE_FAMILY_SLM;
 }
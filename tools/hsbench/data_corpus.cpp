@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "config.h"
+
+#include "data_corpus.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include <sqlite3.h>
+
+using namespace std;
+
+static
+void readRow(sqlite3_stmt *statement, vector<DataBlock> &blocks,
+             unordered_map<unsigned int, unsigned int> &stream_indices) {
+    unsigned int id = sqlite3_column_int(statement, 0);
+    unsigned int stream_id = sqlite3_column_int(statement, 1);
+    const char *blob = (const char *)sqlite3_column_blob(statement, 2);
+    unsigned int bytes = sqlite3_column_bytes(statement, 2);
+
+    if (!blob && bytes) {
+        throw DataCorpusError("Could not read block data for id " +
+                              to_string(id));
+    }
+
+    // Assign dense stream indices in order of first appearance.
+    auto it = stream_indices.find(stream_id);
+    unsigned int index;
+    if (it != stream_indices.end()) {
+        index = it->second;
+    } else {
+        index = stream_indices.size();
+        stream_indices.emplace(stream_id, index);
+    }
+
+    blocks.emplace_back(id, index, string(blob ? blob : "", bytes));
+}
+
+vector<DataBlock> readCorpus(const string &filename) {
+    sqlite3 *db = nullptr;
+    int status = sqlite3_open_v2(filename.c_str(), &db, SQLITE_OPEN_READONLY,
+                                 nullptr);
+    if (status != SQLITE_OK) {
+        string msg = db ? sqlite3_errmsg(db) : "out of memory";
+        sqlite3_close(db);
+        throw DataCorpusError("Unable to open corpus '" + filename + "': " +
+                              msg);
+    }
+
+    static const string query("SELECT id, stream_id, data "
+                              "FROM chunk ORDER BY id;");
+
+    sqlite3_stmt *statement = nullptr;
+    status = sqlite3_prepare_v2(db, query.c_str(), query.size(), &statement,
+                                nullptr);
+    if (status != SQLITE_OK) {
+        string msg = sqlite3_errmsg(db);
+        sqlite3_finalize(statement);
+        sqlite3_close(db);
+        throw DataCorpusError("Unable to prepare corpus query: " + msg);
+    }
+
+    vector<DataBlock> blocks;
+    unordered_map<unsigned int, unsigned int> stream_indices;
+
+    try {
+        while ((status = sqlite3_step(statement)) == SQLITE_ROW) {
+            readRow(statement, blocks, stream_indices);
+        }
+        if (status != SQLITE_DONE) {
+            throw DataCorpusError(string("Error reading corpus: ") +
+                                  sqlite3_errmsg(db));
+        }
+    } catch (...) {
+        sqlite3_finalize(statement);
+        sqlite3_close(db);
+        throw;
+    }
+
+    sqlite3_finalize(statement);
+    sqlite3_close(db);
+    return blocks;
+}
+
+unsigned int countStreams(const vector<DataBlock> &corpus) {
+    unsigned int count = 0;
+    for (const auto &b : corpus) {
+        count = max(count, b.stream_id + 1);
+    }
+    return count;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef DATACORPUS_H
+#define DATACORPUS_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** \brief One chunk of corpus data. */
+struct DataBlock {
+    DataBlock(unsigned int in_id, unsigned int in_stream, std::string in_data)
+        : id(in_id), stream_id(in_stream), payload(std::move(in_data)) {}
+
+    unsigned int id;        //!< unique identifier, from the corpus database
+    unsigned int stream_id; //!< dense stream index, 0 to (stream count - 1)
+    std::string payload;    //!< actual block data
+};
+
+class DataCorpusError : public std::runtime_error {
+public:
+    explicit DataCorpusError(const std::string &msg)
+        : std::runtime_error(msg) {}
+};
+
+/**
+ * \brief Read a corpus from the given sqlite3 database.
+ *
+ * The database must contain a table of the form:
+ *
+ *     CREATE TABLE chunk (id INTEGER PRIMARY KEY, stream_id INTEGER NOT NULL,
+ *                         data BLOB);
+ *
+ * Blocks are returned in order of id. Stream IDs are renumbered densely in
+ * order of first appearance, so that they can be used as indices.
+ *
+ * Throws DataCorpusError on failure.
+ */
+std::vector<DataBlock> readCorpus(const std::string &filename);
+
+/** \brief Number of distinct streams in a corpus returned by readCorpus(). */
+unsigned int countStreams(const std::vector<DataBlock> &corpus);
+
+#endif // DATACORPUS_H
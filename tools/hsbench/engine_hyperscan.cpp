@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "config.h"
+
+#include "engine_hyperscan.h"
+#include "ExpressionParser.h"
+#include "timer.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static
+int onMatch(unsigned int, unsigned long long, unsigned long long,
+            unsigned int, void *ctx) {
+    unsigned long long *matches = (unsigned long long *)ctx;
+    (*matches)++;
+    return 0;
+}
+
+static
+void failHs(const char *what, hs_error_t err) {
+    cerr << "Error: " << what << " failed with error " << err << "." << endl;
+    exit(1);
+}
+
+EngineContext::EngineContext(const hs_scratch_t *proto,
+                             unsigned int stream_count)
+    : streams(stream_count, nullptr) {
+    hs_error_t err = hs_clone_scratch(proto, &scratch);
+    if (err != HS_SUCCESS) {
+        failHs("hs_clone_scratch()", err);
+    }
+}
+
+EngineContext::~EngineContext() {
+    for (auto *stream : streams) {
+        if (stream) {
+            hs_close_stream(stream, nullptr, nullptr, nullptr);
+        }
+    }
+    hs_free_scratch(scratch);
+}
+
+EngineHyperscan::EngineHyperscan(hs_database_t *db_in, ScanMode mode_in)
+    : db(db_in), mode(mode_in) {
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    if (err != HS_SUCCESS) {
+        failHs("hs_alloc_scratch()", err);
+    }
+}
+
+EngineHyperscan::~EngineHyperscan() {
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+unique_ptr<EngineContext>
+EngineHyperscan::makeContext(unsigned int stream_count) const {
+    return unique_ptr<EngineContext>(new EngineContext(scratch, stream_count));
+}
+
+unsigned long long EngineHyperscan::scanBlock(const vector<DataBlock> &corpus,
+                                              EngineContext &ctx) const {
+    unsigned long long matches = 0;
+    for (const auto &b : corpus) {
+        hs_error_t err = hs_scan(db, b.payload.c_str(), b.payload.size(), 0,
+                                 ctx.scratch, onMatch, &matches);
+        if (err != HS_SUCCESS) {
+            failHs("hs_scan()", err);
+        }
+    }
+    return matches;
+}
+
+unsigned long long
+EngineHyperscan::scanStreaming(const vector<DataBlock> &corpus,
+                               EngineContext &ctx) const {
+    unsigned long long matches = 0;
+    hs_error_t err;
+    for (const auto &b : corpus) {
+        hs_stream_t *&stream = ctx.streams[b.stream_id];
+        if (!stream) {
+            err = hs_open_stream(db, 0, &stream);
+            if (err != HS_SUCCESS) {
+                failHs("hs_open_stream()", err);
+            }
+        }
+        err = hs_scan_stream(stream, b.payload.c_str(), b.payload.size(), 0,
+                             ctx.scratch, onMatch, &matches);
+        if (err != HS_SUCCESS) {
+            failHs("hs_scan_stream()", err);
+        }
+    }
+
+    for (auto &stream : ctx.streams) {
+        if (!stream) {
+            continue;
+        }
+        err = hs_close_stream(stream, ctx.scratch, onMatch, &matches);
+        if (err != HS_SUCCESS) {
+            failHs("hs_close_stream()", err);
+        }
+        stream = nullptr;
+    }
+    return matches;
+}
+
+unsigned long long
+EngineHyperscan::scanVectored(const vector<VectoredStream> &corpus,
+                              EngineContext &ctx) const {
+    unsigned long long matches = 0;
+    for (const auto &v : corpus) {
+        hs_error_t err = hs_scan_vector(db, v.data.data(), v.length.data(),
+                                        v.data.size(), 0, ctx.scratch, onMatch,
+                                        &matches);
+        if (err != HS_SUCCESS) {
+            failHs("hs_scan_vector()", err);
+        }
+    }
+    return matches;
+}
+
+size_t EngineHyperscan::bytecodeSize() const {
+    size_t size = 0;
+    hs_error_t err = hs_database_size(db, &size);
+    if (err != HS_SUCCESS) {
+        failHs("hs_database_size()", err);
+    }
+    return size;
+}
+
+size_t EngineHyperscan::streamSize() const {
+    if (mode != ScanMode::STREAMING) {
+        return 0;
+    }
+    size_t size = 0;
+    hs_error_t err = hs_stream_size(db, &size);
+    if (err != HS_SUCCESS) {
+        failHs("hs_stream_size()", err);
+    }
+    return size;
+}
+
+size_t EngineHyperscan::scratchSize() const {
+    size_t size = 0;
+    hs_error_t err = hs_scratch_size(scratch, &size);
+    if (err != HS_SUCCESS) {
+        failHs("hs_scratch_size()", err);
+    }
+    return size;
+}
+
+unique_ptr<EngineHyperscan>
+buildEngineHyperscan(const ExpressionMap &exprMap, ScanMode mode,
+                     double *compile_secs) {
+    if (exprMap.empty()) {
+        cerr << "Error: no expressions to compile." << endl;
+        exit(1);
+    }
+
+    vector<string> patterns;
+    vector<unsigned int> flags;
+    vector<unsigned int> ids;
+    vector<hs_expr_ext> ext;
+    bool som = false;
+
+    for (const auto &m : exprMap) {
+        string expr;
+        unsigned int f = 0;
+        hs_expr_ext e;
+        if (!readExpression(m.second, expr, &f, &e)) {
+            cerr << "Error: unable to parse expression " << m.first << ": "
+                 << m.second << endl;
+            exit(1);
+        }
+        som |= !!(f & HS_FLAG_SOM_LEFTMOST);
+        patterns.push_back(expr);
+        flags.push_back(f);
+        ids.push_back(m.first);
+        ext.push_back(e);
+    }
+
+    vector<const char *> patternPtrs;
+    vector<const hs_expr_ext *> extPtrs;
+    for (size_t i = 0; i < patterns.size(); i++) {
+        patternPtrs.push_back(patterns[i].c_str());
+        extPtrs.push_back(&ext[i]);
+    }
+
+    unsigned int hs_mode = HS_MODE_BLOCK;
+    switch (mode) {
+    case ScanMode::BLOCK:
+        break;
+    case ScanMode::STREAMING:
+        hs_mode = HS_MODE_STREAM;
+        break;
+    case ScanMode::VECTORED:
+        hs_mode = HS_MODE_VECTORED;
+        break;
+    }
+    if (som && mode != ScanMode::BLOCK) {
+        hs_mode |= HS_MODE_SOM_HORIZON_LARGE;
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+
+    Timer timer;
+    timer.start();
+    hs_error_t err = hs_compile_ext_multi(patternPtrs.data(), flags.data(),
+                                          ids.data(), extPtrs.data(),
+                                          patternPtrs.size(), hs_mode, nullptr,
+                                          &db, &compile_err);
+    timer.complete();
+    *compile_secs = timer.seconds();
+
+    if (err != HS_SUCCESS) {
+        if (compile_err && compile_err->expression >= 0) {
+            unsigned int id = ids[compile_err->expression];
+            cerr << "Compile failed for expression " << id << ": "
+                 << compile_err->message << endl;
+        } else {
+            cerr << "Compile failed: "
+                 << (compile_err ? compile_err->message : "unknown error")
+                 << endl;
+        }
+        hs_free_compile_error(compile_err);
+        exit(1);
+    }
+
+    return unique_ptr<EngineHyperscan>(new EngineHyperscan(db, mode));
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef ENGINEHYPERSCAN_H
+#define ENGINEHYPERSCAN_H
+
+#include "common.h"
+#include "data_corpus.h"
+#include "expressions.h"
+#include "hs.h"
+
+#include <memory>
+#include <vector>
+
+/** \brief One stream of corpus data, gathered for hs_scan_vector(). */
+struct VectoredStream {
+    std::vector<const char *> data;
+    std::vector<unsigned int> length;
+};
+
+/** \brief Per-thread scanning state: a cloned scratch and open streams. */
+class EngineContext {
+public:
+    EngineContext(const hs_scratch_t *proto, unsigned int stream_count);
+    ~EngineContext();
+
+    EngineContext(const EngineContext &) = delete;
+    EngineContext &operator=(const EngineContext &) = delete;
+
+    hs_scratch_t *scratch = nullptr;
+    std::vector<hs_stream_t *> streams;
+};
+
+/** \brief A compiled database, plus the prototype scratch for it. */
+class EngineHyperscan {
+public:
+    EngineHyperscan(hs_database_t *db, ScanMode mode);
+    ~EngineHyperscan();
+
+    EngineHyperscan(const EngineHyperscan &) = delete;
+    EngineHyperscan &operator=(const EngineHyperscan &) = delete;
+
+    /** \brief Make a context for one scanning thread. */
+    std::unique_ptr<EngineContext>
+    makeContext(unsigned int stream_count) const;
+
+    /** \brief Scan each block independently; returns the match count. */
+    unsigned long long scanBlock(const std::vector<DataBlock> &corpus,
+                                 EngineContext &ctx) const;
+
+    /** \brief Scan each stream as a sequence of writes, interleaved in
+     * corpus order; returns the match count. */
+    unsigned long long scanStreaming(const std::vector<DataBlock> &corpus,
+                                     EngineContext &ctx) const;
+
+    /** \brief Scan each stream with one vectored call; returns the match
+     * count. */
+    unsigned long long scanVectored(const std::vector<VectoredStream> &corpus,
+                                    EngineContext &ctx) const;
+
+    size_t bytecodeSize() const;
+
+    /** \brief Stream state size, or zero if this is not a streaming
+     * database. */
+    size_t streamSize() const;
+
+    size_t scratchSize() const;
+
+private:
+    hs_database_t *db;
+    hs_scratch_t *scratch = nullptr;
+    const ScanMode mode;
+};
+
+/**
+ * \brief Compile the given expressions for the given mode.
+ *
+ * Each expression is of the form /regex/flags, optionally followed by
+ * extended parameters in braces. Exits with an error message on failure.
+ * The wall-clock time taken by the compiler is returned in \a compile_secs.
+ */
+std::unique_ptr<EngineHyperscan>
+buildEngineHyperscan(const ExpressionMap &exprMap, ScanMode mode,
+                     double *compile_secs);
+
+#endif // ENGINEHYPERSCAN_H
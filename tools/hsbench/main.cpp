@@ -0,0 +1,450 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file
+ * \brief hsbench: throughput benchmark for Hyperscan.
+ *
+ * Compiles a set of expressions, loads a corpus of blocks from an sqlite3
+ * database (see data_corpus.h for the schema) and scans it repeatedly in
+ * block, streaming or vectored mode on one or more threads, each with its own
+ * cloned scratch. Reports compile time, database, stream state and scratch
+ * sizes, and scanning throughput in Mbit/s and matches/s over all repeats.
+ */
+
+#include "config.h"
+
+#include "common.h"
+#include "data_corpus.h"
+#include "engine_hyperscan.h"
+#include "expressions.h"
+#include "thread_barrier.h"
+#include "timer.h"
+#include "hs.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace /* anonymous */ {
+
+// Global configuration, set from the command line.
+string exprPath;
+string sigFile;
+string corpusFile;
+ScanMode scan_mode = ScanMode::BLOCK;
+unsigned int repeats = 20;
+unsigned int num_threads = 1;
+vector<int> cores; // empty if threads are not pinned
+bool verbose = false;
+
+/** \brief Results from one scanning thread, one entry per repeat. */
+struct ThreadResults {
+    vector<unsigned long long> matches;
+};
+
+} // namespace
+
+static
+void usage(const char *name, const char *error) {
+    cerr << "Usage: " << name << " [OPTIONS...]" << endl << endl;
+    cerr << "  -e PATH         Path to expression directory or file." << endl;
+    cerr << "  -s FILE         Signature file to use (list of expression "
+            "IDs)." << endl;
+    cerr << "  -c FILE         Corpus database to scan." << endl;
+    cerr << "  -N              Benchmark in block mode (default)." << endl;
+    cerr << "  -S              Benchmark in streaming mode." << endl;
+    cerr << "  -V              Benchmark in vectored mode." << endl;
+    cerr << "  -n REPEATS      Repeat the scan REPEATS times (default "
+         << repeats << ")." << endl;
+    cerr << "  -j THREADS      Scan on THREADS unpinned threads (default 1)."
+         << endl;
+    cerr << "  -T CPU,CPU,...  Scan on one thread per listed CPU, pinned "
+            "(ranges such as 0-3 are allowed)." << endl;
+    cerr << "  -v              Print results for every repeat." << endl;
+    cerr << "  -h              Display help and exit." << endl;
+    cerr << endl;
+
+    if (error) {
+        cerr << "Error: " << error << endl;
+    }
+}
+
+static
+bool parseUnsigned(const char *str, unsigned int *out) {
+    char *end = nullptr;
+    errno = 0;
+    unsigned long val = strtoul(str, &end, 10);
+    if (!*str || *end || errno || val > UINT_MAX) {
+        return false;
+    }
+    *out = (unsigned int)val;
+    return true;
+}
+
+// Parse a taskset-style CPU list, e.g. "0,2,4-7".
+static
+bool parseCpuList(const string &list, vector<int> &out) {
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        string item = list.substr(pos, comma - pos);
+        size_t dash = item.find('-');
+        unsigned int lo, hi;
+        if (dash == string::npos) {
+            if (!parseUnsigned(item.c_str(), &lo)) {
+                return false;
+            }
+            hi = lo;
+        } else if (!parseUnsigned(item.substr(0, dash).c_str(), &lo) ||
+                   !parseUnsigned(item.substr(dash + 1).c_str(), &hi) ||
+                   hi < lo) {
+            return false;
+        }
+        for (unsigned int c = lo; c <= hi; c++) {
+            out.push_back((int)c);
+        }
+        if (comma == string::npos) {
+            break;
+        }
+        pos = comma + 1;
+    }
+    return !out.empty();
+}
+
+static
+void processArgs(int argc, char *argv[]) {
+    const char options[] = "e:s:c:NSVn:j:T:vh";
+    bool threadsGiven = false;
+    int in;
+    while ((in = getopt(argc, argv, options)) != -1) {
+        switch (in) {
+        case 'e':
+            exprPath.assign(optarg);
+            break;
+        case 's':
+            sigFile.assign(optarg);
+            break;
+        case 'c':
+            corpusFile.assign(optarg);
+            break;
+        case 'N':
+            scan_mode = ScanMode::BLOCK;
+            break;
+        case 'S':
+            scan_mode = ScanMode::STREAMING;
+            break;
+        case 'V':
+            scan_mode = ScanMode::VECTORED;
+            break;
+        case 'n':
+            if (!parseUnsigned(optarg, &repeats) || repeats == 0) {
+                usage(argv[0], "Couldn't parse argument to -n flag.");
+                exit(1);
+            }
+            break;
+        case 'j':
+            if (!parseUnsigned(optarg, &num_threads) || num_threads == 0) {
+                usage(argv[0], "Couldn't parse argument to -j flag.");
+                exit(1);
+            }
+            threadsGiven = true;
+            break;
+        case 'T':
+            if (!parseCpuList(optarg, cores)) {
+                usage(argv[0], "Couldn't parse argument to -T flag.");
+                exit(1);
+            }
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        case 'h':
+            usage(argv[0], nullptr);
+            exit(0);
+        default:
+            usage(argv[0], "Unrecognised command line argument.");
+            exit(1);
+        }
+    }
+
+    if (optind < argc) {
+        usage(argv[0], "Unrecognised argument.");
+        exit(1);
+    }
+    if (exprPath.empty()) {
+        usage(argv[0], "Must specify an expression path with -e.");
+        exit(1);
+    }
+    if (corpusFile.empty()) {
+        usage(argv[0], "Must specify a corpus file with -c.");
+        exit(1);
+    }
+    if (!cores.empty()) {
+        if (threadsGiven && num_threads != cores.size()) {
+            usage(argv[0], "The -j and -T flags disagree on thread count.");
+            exit(1);
+        }
+        num_threads = cores.size();
+    }
+#if !defined(__linux__)
+    if (!cores.empty()) {
+        cerr << "Warning: thread pinning is not supported on this platform."
+             << endl;
+        cores.clear();
+    }
+#endif
+}
+
+static
+void pinThread(int cpu) {
+#if defined(__linux__)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    int rv = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (rv) {
+        cerr << "Error: unable to pin thread to CPU " << cpu << "." << endl;
+        exit(1);
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+static
+vector<VectoredStream> gatherStreams(const vector<DataBlock> &corpus,
+                                     unsigned int stream_count) {
+    vector<VectoredStream> streams(stream_count);
+    for (const auto &b : corpus) {
+        VectoredStream &v = streams[b.stream_id];
+        v.data.push_back(b.payload.c_str());
+        v.length.push_back(b.payload.size());
+    }
+    return streams;
+}
+
+static
+const char *modeName(ScanMode mode) {
+    switch (mode) {
+    case ScanMode::BLOCK:
+        return "block";
+    case ScanMode::STREAMING:
+        return "streaming";
+    case ScanMode::VECTORED:
+        return "vectored";
+    }
+    return "unknown";
+}
+
+static
+void printStats(const vector<double> &vals, const char *label) {
+    double sum = 0;
+    for (double v : vals) {
+        sum += v;
+    }
+    double mean = sum / vals.size();
+    double var = 0;
+    for (double v : vals) {
+        var += (v - mean) * (v - mean);
+    }
+    double stddev = vals.size() > 1 ? sqrt(var / (vals.size() - 1)) : 0;
+
+    auto mm = minmax_element(vals.begin(), vals.end());
+    cout << setw(24) << left << label << right << fixed << setprecision(2)
+         << "mean " << setw(12) << mean << "  stddev " << setw(10) << stddev
+         << " (" << setprecision(1) << (mean ? 100 * stddev / mean : 0)
+         << "%)" << setprecision(2) << "  min " << setw(12) << *mm.first
+         << "  max " << setw(12) << *mm.second << endl;
+}
+
+int main(int argc, char *argv[]) {
+    processArgs(argc, argv);
+
+    ExpressionMap exprMap;
+    loadExpressions(exprPath, exprMap);
+    if (!sigFile.empty()) {
+        SignatureSet sigs;
+        loadSignatureList(sigFile, sigs);
+        limitBySignature(exprMap, sigs);
+    }
+
+    vector<DataBlock> corpus;
+    try {
+        corpus = readCorpus(corpusFile);
+    } catch (const DataCorpusError &e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    if (corpus.empty()) {
+        cerr << "Error: corpus '" << corpusFile << "' is empty." << endl;
+        return 1;
+    }
+
+    const unsigned int stream_count = countStreams(corpus);
+    unsigned long long corpus_bytes = 0;
+    for (const auto &b : corpus) {
+        corpus_bytes += b.payload.size();
+    }
+
+    double compile_secs = 0;
+    auto engine = buildEngineHyperscan(exprMap, scan_mode, &compile_secs);
+
+    vector<VectoredStream> vectored;
+    if (scan_mode == ScanMode::VECTORED) {
+        vectored = gatherStreams(corpus, stream_count);
+    }
+
+    cout << "Signatures:        " << exprMap.size() << endl;
+    cout << "Hyperscan info:    " << hs_version() << endl;
+    cout << "Mode:              " << modeName(scan_mode) << endl;
+    cout << "Compile time:      " << fixed << setprecision(3) << compile_secs
+         << " seconds" << endl;
+    cout << "Bytecode size:     " << engine->bytecodeSize() << " bytes"
+         << endl;
+    if (scan_mode == ScanMode::STREAMING) {
+        cout << "Stream state size: " << engine->streamSize() << " bytes"
+             << endl;
+    }
+    cout << "Scratch size:      " << engine->scratchSize() << " bytes"
+         << endl;
+    cout << "Corpus:            " << corpus.size() << " blocks in "
+         << stream_count << " streams, " << corpus_bytes << " bytes" << endl;
+    cout << "Threads:           " << num_threads;
+    if (!cores.empty()) {
+        cout << " (pinned to CPUs";
+        for (int c : cores) {
+            cout << " " << c;
+        }
+        cout << ")";
+    }
+    cout << endl;
+    cout << "Repeats:           " << repeats << endl << endl;
+
+    vector<ThreadResults> results(num_threads);
+    vector<double> run_secs(repeats);
+    thread_barrier barrier(num_threads);
+
+    auto worker = [&](unsigned int tid) {
+        if (!cores.empty()) {
+            pinThread(cores[tid]);
+        }
+        auto ctx = engine->makeContext(stream_count);
+        ThreadResults &res = results[tid];
+        res.matches.resize(repeats);
+        Timer timer;
+
+        for (unsigned int r = 0; r < repeats; r++) {
+            barrier.wait();
+            if (tid == 0) {
+                timer.start();
+            }
+
+            switch (scan_mode) {
+            case ScanMode::BLOCK:
+                res.matches[r] = engine->scanBlock(corpus, *ctx);
+                break;
+            case ScanMode::STREAMING:
+                res.matches[r] = engine->scanStreaming(corpus, *ctx);
+                break;
+            case ScanMode::VECTORED:
+                res.matches[r] = engine->scanVectored(vectored, *ctx);
+                break;
+            }
+
+            barrier.wait();
+            if (tid == 0) {
+                timer.complete();
+                run_secs[r] = timer.seconds();
+            }
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned int i = 0; i < num_threads; i++) {
+        threads.emplace_back(worker, i);
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    // Aggregate over all threads for each repeat.
+    vector<double> mbits(repeats);
+    vector<double> match_rate(repeats);
+    double total_secs = 0;
+    const unsigned long long matches_per_scan = results[0].matches[0];
+    bool consistent = true;
+    for (unsigned int r = 0; r < repeats; r++) {
+        unsigned long long matches = 0;
+        for (const auto &res : results) {
+            matches += res.matches[r];
+            consistent &= res.matches[r] == matches_per_scan;
+        }
+        double secs = max(run_secs[r], 1e-9);
+        double bits = 8.0 * corpus_bytes * num_threads;
+        mbits[r] = bits / secs / 1000000.0;
+        match_rate[r] = matches / secs;
+        total_secs += run_secs[r];
+
+        if (verbose) {
+            cout << "Run " << setw(4) << r + 1 << ": " << fixed
+                 << setprecision(6) << run_secs[r] << " s, "
+                 << setprecision(2) << mbits[r] << " Mbit/s, " << match_rate[r]
+                 << " matches/s" << endl;
+        }
+    }
+    if (verbose) {
+        cout << endl;
+    }
+    if (!consistent) {
+        cerr << "Warning: match counts differ between scans." << endl;
+    }
+
+    cout << "Time spent scanning:  " << fixed << setprecision(3) << total_secs
+         << " seconds" << endl;
+    cout << "Matches per scan:     " << matches_per_scan << endl;
+    printStats(mbits, "Throughput (Mbit/s):");
+    printStats(match_rate, "Matches/s:");
+
+    return 0;
+}
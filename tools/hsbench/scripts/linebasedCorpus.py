@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+
+'''
+Simple script to take a file full of lines of text and push them into a
+Hyperscan benchmarking corpus database, one block per line.
+'''
+
+import sys
+import getopt
+from CorpusBuilder import CorpusBuilder
+
+def lineCorpus(inFN, outFN, linesPerStream):
+    '''
+    Read lines from file name @inFN and write them as blocks to a new db with
+    name @outFN. Every @linesPerStream lines make up one stream.
+    '''
+    if linesPerStream < 1:
+        raise ValueError("lines per stream must be at least one")
+
+    builder = CorpusBuilder(outFN)
+    with open(inFN, 'rb') as f:
+        lineNum = 0
+        for line in f:
+            builder.add_chunk(lineNum // linesPerStream, line)
+            lineNum += 1
+    builder.finish()
+
+def usage(exeName):
+    errmsg = "Usage: %s -i <input file> -o <output file> [-s <lines per stream>]"
+    errmsg = errmsg % exeName
+    print(errmsg, file=sys.stderr)
+    sys.exit(-1)
+
+if __name__ == '__main__':
+    opts, args = getopt.getopt(sys.argv[1:], 'i:o:s:')
+    opts = dict(opts)
+
+    requiredKeys = ['-i', '-o']
+    for k in requiredKeys:
+        if k not in opts:
+            usage(sys.argv[0])
+
+    linesPerStream = int(opts.get('-s', 1))
+    lineCorpus(opts['-i'], opts['-o'], linesPerStream)
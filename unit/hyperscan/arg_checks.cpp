@@ -327,6 +327,50 @@ TEST(HyperscanArgChecks, MultiCompileStreamingNoDatabase) {
     hs_free_compile_error(compile_err);
 }
 
+// hs_alloc_compile_cache: Allocate to a NULL cache ptr
+TEST(HyperscanArgChecks, AllocCompileCacheNull) {
+    hs_error_t err = hs_alloc_compile_cache(nullptr);
+    EXPECT_EQ(HS_INVALID, err);
+}
+
+// hs_free_compile_cache: Free a NULL cache
+TEST(HyperscanArgChecks, FreeCompileCacheNull) {
+    hs_error_t err = hs_free_compile_cache(nullptr);
+    EXPECT_EQ(HS_SUCCESS, err);
+}
+
+// hs_compile_ext_multi_cached: Compile with a NULL cache
+TEST(HyperscanArgChecks, CachedCompileNoCache) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    const char *expr[] = {"foobar"};
+    hs_error_t err = hs_compile_ext_multi_cached(expr, nullptr, nullptr,
+                                                 nullptr, 1, HS_MODE_NOSTREAM,
+                                                 nullptr, nullptr, &db,
+                                                 &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_TRUE(db == nullptr);
+    EXPECT_TRUE(compile_err != nullptr);
+    hs_free_compile_error(compile_err);
+}
+
+// hs_compile_ext_multi_cached: Compile a pattern to a NULL database ptr
+TEST(HyperscanArgChecks, CachedCompileNoDatabase) {
+    hs_compile_cache_t *cache = nullptr;
+    hs_error_t err = hs_alloc_compile_cache(&cache);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_compile_error_t *compile_err = nullptr;
+    const char *expr[] = {"foobar"};
+    err = hs_compile_ext_multi_cached(expr, nullptr, nullptr, nullptr, 1,
+                                      HS_MODE_NOSTREAM, nullptr, cache, nullptr,
+                                      &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_TRUE(compile_err != nullptr);
+    hs_free_compile_error(compile_err);
+    hs_free_compile_cache(cache);
+}
+
 // hs_open_stream: Open a stream with a NULL database ptr
 TEST(HyperscanArgChecks, OpenStreamNoDatabase) {
     hs_stream_t *stream = nullptr;
@@ -863,6 +907,119 @@ TEST(HyperscanArgChecks, ResetAndCopyStreamDiffDb) {
     hs_free_database(db2);
 }
 
+// hs_compress_stream: Call with no stream
+TEST(HyperscanArgChecks, CompressStreamNoStream) {
+    char buf[100];
+    size_t used = 0;
+    hs_error_t err = hs_compress_stream(nullptr, buf, sizeof(buf), &used);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+// hs_compress_stream: Call with no used_space pointer
+TEST(HyperscanArgChecks, CompressStreamNoUsedSpace) {
+    hs_stream_t *stream = nullptr;
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char buf[100];
+    err = hs_compress_stream(stream, buf, sizeof(buf), nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // A null buffer is only acceptable with zero space.
+    size_t used = 0;
+    err = hs_compress_stream(stream, nullptr, sizeof(buf), &used);
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_close_stream(stream, nullptr, nullptr, nullptr);
+    hs_free_database(db);
+}
+
+// hs_expand_stream: Call with no database
+TEST(HyperscanArgChecks, ExpandStreamNoDatabase) {
+    char buf[100] = {0};
+    hs_stream_t *stream = nullptr;
+    hs_error_t err = hs_expand_stream(nullptr, &stream, buf, sizeof(buf));
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_TRUE(stream == nullptr);
+}
+
+// hs_expand_stream: Call with no stream pointer or buffer
+TEST(HyperscanArgChecks, ExpandStreamNoStreamOrBuf) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char buf[100] = {0};
+    err = hs_expand_stream(db, nullptr, buf, sizeof(buf));
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_expand_stream(db, &stream, nullptr, sizeof(buf));
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_TRUE(stream == nullptr);
+
+    hs_free_database(db);
+}
+
+// hs_expand_stream: Call with a block-mode database
+TEST(HyperscanArgChecks, ExpandStreamBlockMode) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char buf[100] = {0};
+    hs_stream_t *stream = nullptr;
+    err = hs_expand_stream(db, &stream, buf, sizeof(buf));
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+    ASSERT_TRUE(stream == nullptr);
+
+    hs_free_database(db);
+}
+
+// hs_reset_and_expand_stream: Call with no stream
+TEST(HyperscanArgChecks, ResetAndExpandStreamNoStream) {
+    char buf[100] = {0};
+    hs_error_t err = hs_reset_and_expand_stream(nullptr, buf, sizeof(buf),
+                                                nullptr, nullptr, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+// hs_reset_and_expand_stream: If you specify a callback, you must provide
+// scratch.
+TEST(HyperscanArgChecks, ResetAndExpandStreamNoScratch) {
+    hs_stream_t *stream = nullptr;
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char buf[100];
+    size_t used = 0;
+    err = hs_compress_stream(stream, buf, sizeof(buf), &used);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_reset_and_expand_stream(stream, buf, used, nullptr, dummy_cb,
+                                     nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    hs_close_stream(stream, nullptr, nullptr, nullptr);
+    hs_free_database(db);
+}
+
 // hs_scan: Call with no database
 TEST(HyperscanArgChecks, ScanBlockNoDatabase) {
     hs_database_t *db = nullptr;
@@ -1329,6 +1486,226 @@ TEST(HyperscanArgChecks, ScanVectorNoHandler) {
     hs_free_database(db);
 }
 
+// hs_scan_batch: Call with no database
+TEST(HyperscanArgChecks, ScanBatchNoDatabase) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    const char *data[] = {"data", "data"};
+    unsigned int len[] = {4, 4};
+    err = hs_scan_batch(nullptr, data, len, 2, 0, scratch, dummy_cb, nullptr);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with a database built for streaming mode
+TEST(HyperscanArgChecks, ScanBatchStreamingDatabase) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    const char *data[] = {"data", "data"};
+    unsigned int len[] = {4, 4};
+    err = hs_scan_batch(db, data, len, 2, 0, scratch, dummy_cb, nullptr);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with null data array, buffer or length array
+TEST(HyperscanArgChecks, ScanBatchNoData) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    const char *data[] = {"data", nullptr};
+    unsigned int len[] = {4, 4};
+    err = hs_scan_batch(db, nullptr, len, 2, 0, scratch, dummy_cb, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_scan_batch(db, data, len, 2, 0, scratch, dummy_cb, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_scan_batch(db, data, nullptr, 1, 0, scratch, dummy_cb, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with no scratch
+TEST(HyperscanArgChecks, ScanBatchNoScratch) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    const char *data[] = {"data", "data"};
+    unsigned int len[] = {4, 4};
+    err = hs_scan_batch(db, data, len, 2, 0, nullptr, dummy_cb, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    hs_free_database(db);
+}
+
+// hs_scan_batch: Call with no event handler or contexts
+TEST(HyperscanArgChecks, ScanBatchNoHandler) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+    const char *data[] = {"foobar", "foobar"};
+    unsigned int len[] = {6, 6};
+    err = hs_scan_batch(db, data, len, 2, 0, scratch, nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_scan_bitmap: Call with no database
+TEST(HyperscanArgChecks, ScanBitmapNoDatabase) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    unsigned char bitmap[1] = {0};
+    err = hs_scan_bitmap(nullptr, "data", 4, 0, scratch, bitmap, 8);
+    ASSERT_NE(HS_SUCCESS, err);
+    EXPECT_NE(HS_SCAN_TERMINATED, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_scan_bitmap: Call with a database built for streaming mode
+TEST(HyperscanArgChecks, ScanBitmapStreamingDatabase) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_STREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    unsigned char bitmap[1] = {0};
+    err = hs_scan_bitmap(db, "data", 4, 0, scratch, bitmap, 8);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_scan_bitmap: Call with no data, scratch or bitmap
+TEST(HyperscanArgChecks, ScanBitmapNullArgs) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    unsigned char bitmap[1] = {0};
+    err = hs_scan_bitmap(db, nullptr, 4, 0, scratch, bitmap, 8);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_scan_bitmap(db, "data", 4, 0, nullptr, bitmap, 8);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_scan_bitmap(db, "data", 4, 0, scratch, nullptr, 8);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// hs_scan_count: Call with no data, scratch or counts
+TEST(HyperscanArgChecks, ScanCountNullArgs) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_BLOCK, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(scratch != nullptr);
+
+    unsigned long long counts[1] = {0};
+    err = hs_scan_count(nullptr, "data", 4, 0, scratch, counts, 1);
+    ASSERT_NE(HS_SUCCESS, err);
+    err = hs_scan_count(db, nullptr, 4, 0, scratch, counts, 1);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_scan_count(db, "data", 4, 0, nullptr, counts, 1);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_scan_count(db, "data", 4, 0, scratch, nullptr, 1);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
 // hs_alloc_scratch: Call with no database
 TEST(HyperscanArgChecks, AllocScratchNoDatabase) {
     hs_scratch_t *scratch = nullptr;
@@ -1488,6 +1865,105 @@ TEST(HyperscanArgChecks, CloneScratchNoSource) {
     EXPECT_TRUE(scratch2 == nullptr);
 }
 
+// hs_alloc_scratch_pool: Call with no database
+TEST(HyperscanArgChecks, AllocScratchPoolNoDatabase) {
+    hs_scratch_pool_t *pool = nullptr;
+    hs_error_t err = hs_alloc_scratch_pool(nullptr, 4, &pool);
+    EXPECT_EQ(HS_INVALID, err);
+    EXPECT_TRUE(pool == nullptr);
+}
+
+// hs_alloc_scratch_pool: Call with no pool ptr or a zero size
+TEST(HyperscanArgChecks, AllocScratchPoolBadArgs) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_NOSTREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+
+    err = hs_alloc_scratch_pool(db, 4, nullptr);
+    EXPECT_EQ(HS_INVALID, err);
+
+    hs_scratch_pool_t *pool = nullptr;
+    err = hs_alloc_scratch_pool(db, 0, &pool);
+    EXPECT_EQ(HS_INVALID, err);
+    EXPECT_TRUE(pool == nullptr);
+
+    // teardown
+    hs_free_database(db);
+}
+
+// hs_scratch_pool_*: Call with no pool
+TEST(HyperscanArgChecks, ScratchPoolNoPool) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_NOSTREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_scratch_pool_acquire(nullptr, &scratch);
+    EXPECT_EQ(HS_INVALID, err);
+    EXPECT_TRUE(scratch == nullptr);
+
+    err = hs_scratch_pool_add_database(nullptr, db);
+    EXPECT_EQ(HS_INVALID, err);
+
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scratch_pool_release(nullptr, scratch);
+    EXPECT_EQ(HS_INVALID, err);
+
+    // teardown
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// hs_scratch_pool_release: Call with scratch from elsewhere
+TEST(HyperscanArgChecks, ScratchPoolReleaseForeignScratch) {
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile("foobar", 0, HS_MODE_NOSTREAM, nullptr, &db,
+                                &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_pool_t *pool = nullptr;
+    err = hs_alloc_scratch_pool(db, 2, &pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_scratch_pool_release(pool, scratch);
+    EXPECT_EQ(HS_INVALID, err);
+    err = hs_scratch_pool_release(pool, nullptr);
+    EXPECT_EQ(HS_INVALID, err);
+
+    // a clone of pooled scratch is the caller's own
+    hs_scratch_t *pooled = nullptr;
+    err = hs_scratch_pool_acquire(pool, &pooled);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_scratch_t *clone = nullptr;
+    err = hs_clone_scratch(pooled, &clone);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scratch_pool_release(pool, clone);
+    EXPECT_EQ(HS_INVALID, err);
+    err = hs_alloc_scratch(db, &pooled);
+    EXPECT_EQ(HS_INVALID, err);
+    err = hs_scratch_pool_release(pool, pooled);
+    EXPECT_EQ(HS_SUCCESS, err);
+
+    // teardown
+    hs_free_scratch(clone);
+    hs_free_scratch(scratch);
+    hs_free_scratch_pool(pool);
+    hs_free_database(db);
+}
+
 // hs_serialize_database: Call with no database
 TEST(HyperscanArgChecks, SerializeNoDatabase) {
     char *bytes = nullptr;
@@ -1986,6 +2462,241 @@ TEST(HyperscanArgChecks, DeserializeDatabaseAtBadBytes2) {
     free(db);
 }
 
+// Returns the first 64-byte aligned address at or after p.
+static
+char *alignToCacheline(char *p) {
+    return p + ((64 - ((size_t)p & 63)) & 63);
+}
+
+static
+void makeDatabaseImage(char **bytes, size_t *length) {
+    hs_database_t *db = buildDB("(foo.*bar){3,}", 0, 0, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    hs_error_t err = hs_serialize_database_image(db, bytes, length);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(HyperscanArgChecks, SerializeImageNoDatabase) {
+    char *bytes = nullptr;
+    size_t length = 0;
+    hs_error_t err = hs_serialize_database_image(nullptr, &bytes, &length);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+TEST(HyperscanArgChecks, SerializeImageNoBuffer) {
+    hs_database_t *db = buildDB("foobar", 0, 0, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    size_t length = 0;
+    hs_error_t err = hs_serialize_database_image(db, nullptr, &length);
+    ASSERT_EQ(HS_INVALID, err);
+    hs_free_database(db);
+}
+
+TEST(HyperscanArgChecks, SerializeImageNoLength) {
+    hs_database_t *db = buildDB("foobar", 0, 0, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    char *bytes = nullptr;
+    hs_error_t err = hs_serialize_database_image(db, &bytes, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    hs_free_database(db);
+}
+
+TEST(HyperscanArgChecks, LoadImageNoBytes) {
+    const hs_database_t *db = nullptr;
+    hs_error_t err = hs_load_database_image(nullptr, 2048, &db);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+TEST(HyperscanArgChecks, LoadImageNoDb) {
+    char *bytes = nullptr;
+    size_t length = 0;
+    makeDatabaseImage(&bytes, &length);
+    hs_error_t err = hs_load_database_image(bytes, length, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    free(bytes);
+}
+
+TEST(HyperscanArgChecks, LoadImageBadAlign) {
+    char *bytes = nullptr;
+    size_t length = 0;
+    makeDatabaseImage(&bytes, &length);
+    char *mem = new char[length + 128];
+    char *copy = alignToCacheline(mem) + 8;
+    memcpy(copy, bytes, length);
+    const hs_database_t *db = nullptr;
+    hs_error_t err = hs_load_database_image(copy, length, &db);
+    ASSERT_EQ(HS_BAD_ALIGN, err);
+    ASSERT_EQ(nullptr, db);
+    free(bytes);
+    delete[] mem;
+}
+
+TEST(HyperscanArgChecks, LoadImageBadLen) {
+    char *bytes = nullptr;
+    size_t length = 0;
+    makeDatabaseImage(&bytes, &length);
+    char *mem = new char[length + 64];
+    char *copy = alignToCacheline(mem);
+    memcpy(copy, bytes, length);
+    const hs_database_t *db = nullptr;
+    hs_error_t err = hs_load_database_image(copy, length - 1, &db);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_load_database_image(copy, length + 1, &db);
+    ASSERT_EQ(HS_INVALID, err);
+    free(bytes);
+    delete[] mem;
+}
+
+TEST(HyperscanArgChecks, LoadImageBadBytes) {
+    char *bytes = nullptr;
+    size_t length = 0;
+    makeDatabaseImage(&bytes, &length);
+    char *mem = new char[length + 64];
+    char *copy = alignToCacheline(mem);
+    memcpy(copy, bytes, length);
+    copy[length - 1] ^= 0xff; // scribble on the bytecode
+    const hs_database_t *db = nullptr;
+    hs_error_t err = hs_load_database_image(copy, length, &db);
+    ASSERT_EQ(HS_INVALID, err);
+    free(bytes);
+    delete[] mem;
+}
+
+TEST(HyperscanArgChecks, LoadImageSerialized) {
+    // A regular serialized database is not an image.
+    char *bytes = nullptr;
+    size_t length = 0;
+    makeSerializedDatabase(&bytes, &length);
+    char *mem = new char[length + 64];
+    char *copy = alignToCacheline(mem);
+    memcpy(copy, bytes, length);
+    const hs_database_t *db = nullptr;
+    hs_error_t err = hs_load_database_image(copy, length, &db);
+    ASSERT_EQ(HS_INVALID, err);
+    free(bytes);
+    delete[] mem;
+}
+
+TEST(HyperscanArgChecks, CompileShardedNoDbs) {
+    const char *expr = "foobar";
+    unsigned shards = 0;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_sharded(&expr, nullptr, nullptr,
+                                                  nullptr, 1, HS_MODE_BLOCK,
+                                                  nullptr, 4, nullptr, &shards,
+                                                  &compile_err);
+    ASSERT_EQ(HS_COMPILER_ERROR, err);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+}
+
+TEST(HyperscanArgChecks, CompileShardedZeroShards) {
+    const char *expr = "foobar";
+    hs_database_t *db = nullptr;
+    unsigned shards = 0;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_sharded(&expr, nullptr, nullptr,
+                                                  nullptr, 1, HS_MODE_BLOCK,
+                                                  nullptr, 0, &db, &shards,
+                                                  &compile_err);
+    ASSERT_EQ(HS_COMPILER_ERROR, err);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+}
+
+TEST(HyperscanArgChecks, CompileShardedNoShardCount) {
+    const char *expr = "foobar";
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_sharded(&expr, nullptr, nullptr,
+                                                  nullptr, 1, HS_MODE_BLOCK,
+                                                  nullptr, 1, &db, nullptr,
+                                                  &compile_err);
+    ASSERT_EQ(HS_COMPILER_ERROR, err);
+    ASSERT_EQ(nullptr, db);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+}
+
+TEST(HyperscanArgChecks, CompileReportNoReport) {
+    const char *expr = "foobar";
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_report(&expr, nullptr, nullptr,
+                                                 nullptr, 1, HS_MODE_BLOCK,
+                                                 nullptr, &db, &compile_err,
+                                                 nullptr);
+    ASSERT_EQ(HS_COMPILER_ERROR, err);
+    ASSERT_EQ(nullptr, db);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+}
+
+TEST(HyperscanArgChecks, CompileReportNoDb) {
+    const char *expr = "foobar";
+    hs_compile_error_t *compile_err = nullptr;
+    hs_compile_report_t *report = nullptr;
+    hs_error_t err = hs_compile_ext_multi_report(&expr, nullptr, nullptr,
+                                                 nullptr, 1, HS_MODE_BLOCK,
+                                                 nullptr, nullptr,
+                                                 &compile_err, &report);
+    ASSERT_EQ(HS_COMPILER_ERROR, err);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+    hs_free_compile_report(report);
+}
+
+TEST(HyperscanArgChecks, hs_free_compile_report_null) {
+    hs_error_t err = hs_free_compile_report(nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+}
+
+TEST(HyperscanArgChecks, AllocShardScannerNoDbs) {
+    hs_shard_scanner_t *scanner = nullptr;
+    hs_error_t err = hs_alloc_shard_scanner(nullptr, 1, &scanner);
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_EQ(nullptr, scanner);
+}
+
+TEST(HyperscanArgChecks, AllocShardScannerNoScanner) {
+    hs_database_t *db = buildDB("foobar", 0, 0, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    hs_error_t err = hs_alloc_shard_scanner(&db, 1, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_alloc_shard_scanner(&db, 0, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    hs_free_database(db);
+}
+
+TEST(HyperscanArgChecks, ScanShardedNoScanner) {
+    hs_error_t err = hs_scan_sharded(nullptr, "data", 4, 0, dummy_cb, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+TEST(HyperscanArgChecks, ScanShardedStreamingDatabase) {
+    hs_database_t *db = buildDB("foobar", 0, 0, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+    hs_shard_scanner_t *scanner = nullptr;
+    hs_error_t err = hs_alloc_shard_scanner(&db, 1, &scanner);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan_sharded(scanner, "data", 4, 0, dummy_cb, nullptr);
+    ASSERT_EQ(HS_DB_MODE_ERROR, err);
+    hs_free_shard_scanner(scanner);
+    hs_free_database(db);
+}
+
+TEST(HyperscanArgChecks, OpenStreamShardedNoScanner) {
+    hs_shard_stream_t *stream = nullptr;
+    hs_error_t err = hs_open_stream_sharded(nullptr, 0, &stream);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
+TEST(HyperscanArgChecks, CloseStreamShardedNoStream) {
+    hs_error_t err = hs_close_stream_sharded(nullptr, dummy_cb, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
 TEST(HyperscanArgChecks, ScratchSizeNoSize) {
     hs_error_t err;
 
@@ -2254,6 +2965,16 @@ TEST(HyperscanArgChecks, hs_free_scratch_garbage) {
     ASSERT_EQ(HS_INVALID, err);
 }
 
+TEST(HyperscanArgChecks, hs_free_scratch_pool_null) {
+    hs_error_t err = hs_free_scratch_pool(nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+}
+
+TEST(HyperscanArgChecks, hs_free_scratch_pool_garbage) {
+    hs_error_t err = hs_free_scratch_pool((hs_scratch_pool_t *)garbage);
+    ASSERT_EQ(HS_INVALID, err);
+}
+
 TEST(HyperscanArgChecks, hs_free_compile_error_null) {
     hs_error_t err = hs_free_compile_error(nullptr);
     ASSERT_EQ(HS_SUCCESS, err);
@@ -2312,6 +3033,12 @@ TEST(HyperscanArgChecks, hs_populate_platform_null) {
     ASSERT_EQ(HS_INVALID, err);
 }
 
+// hs_valid_platform: we are running our tests, so this platform must be okay.
+TEST(HyperscanArgChecks, hs_valid_platform) {
+    hs_error_t err = hs_valid_platform();
+    ASSERT_EQ(HS_SUCCESS, err);
+}
+
 class BadModeTest : public testing::TestWithParam<unsigned> {};
 
 // hs_compile: Compile a pattern with bogus mode flags set.
@@ -2347,6 +3074,9 @@ static const unsigned badModeValues[] = {
     HS_MODE_STREAM | HS_MODE_SOM_HORIZON_LARGE | HS_MODE_SOM_HORIZON_SMALL,
     HS_MODE_STREAM | HS_MODE_SOM_HORIZON_LARGE | HS_MODE_SOM_HORIZON_MEDIUM,
     HS_MODE_STREAM | HS_MODE_SOM_HORIZON_MEDIUM | HS_MODE_SOM_HORIZON_SMALL,
+    // Unordered is a modifier, not a mode of its own.
+    HS_MODE_UNORDERED,
+    HS_MODE_UNORDERED | HS_MODE_SOM_HORIZON_LARGE,
 };
 
 INSTANTIATE_TEST_CASE_P(HyperscanArgChecks, BadModeTest,
@@ -1172,6 +1172,290 @@ TEST(HyperscanTestBehaviour, Vectored7) {
     hs_free_database(db);
 }
 
+// Many short blocks, some spanning the runtime's internal gather buffer, must
+// produce exactly the same matches as the same data in a single block.
+TEST(HyperscanTestBehaviour, VectoredManyBlocks) {
+    hs_error_t err;
+
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo.*bar", 0, 1));
+    patterns.push_back(pattern("abc[^x]{5,10}def", 0, 2));
+    patterns.push_back(pattern("q[0-9]{3,}z", 0, 3));
+    patterns.push_back(pattern("^xx", 0, 4));
+    patterns.push_back(pattern("teakettle$", 0, 5));
+    hs_database_t *db = buildDB(patterns, HS_MODE_VECTORED);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    string corpus = "xx";
+    for (size_t i = 0; corpus.size() < 20000; i++) {
+        corpus += "foo abc12345def q" + to_string(i * 7919) + "z bar ";
+        if (i % 50 == 0) {
+            corpus += string(3000, '-');
+        }
+    }
+    corpus += "teakettle";
+
+    CallBackContext whole;
+    const char *one[] = { corpus.c_str() };
+    unsigned int one_len[] = { (unsigned int)corpus.size() };
+    err = hs_scan_vector(db, one, one_len, 1, 0, scratch, record_cb,
+                         (void *)&whole);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_FALSE(whole.matches.empty());
+
+    vector<const char *> data;
+    vector<unsigned int> len;
+    for (size_t i = 0, step = 0; i < corpus.size(); step++) {
+        size_t n = step % 5 == 4 ? 0 : step % 41 + 1;
+        if (step % 97 == 0) {
+            n = 2500;
+        }
+        n = min(n, corpus.size() - i);
+        data.push_back(corpus.c_str() + i);
+        len.push_back(n);
+        i += n;
+    }
+
+    CallBackContext split;
+    err = hs_scan_vector(db, &data[0], &len[0], data.size(), 0, scratch,
+                         record_cb, (void *)&split);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(whole.matches, split.matches);
+
+    // Terminating from the callback must stop the scan at that match.
+    CallBackContext halted;
+    halted.halt = true;
+    err = hs_scan_vector(db, &data[0], &len[0], data.size(), 0, scratch,
+                         record_cb, (void *)&halted);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    ASSERT_EQ(1U, halted.matches.size());
+    ASSERT_EQ(whole.matches[0], halted.matches[0]);
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// A batch scan must produce the same matches as scanning each buffer with
+// hs_scan, delivered to each buffer's own context.
+TEST(HyperscanTestBehaviour, ScanBatch) {
+    hs_error_t err;
+
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo.*bar", 0, 1));
+    patterns.push_back(pattern("^abc", 0, 2));
+    patterns.push_back(pattern("[0-9]{4}$", 0, 3));
+    patterns.push_back(pattern("x{20,}", 0, 4));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // Mostly short buffers, with runs of buffers that cannot match at all.
+    vector<string> corpora;
+    for (size_t i = 0; i < 400; i++) {
+        string s;
+        if (i % 3 == 0) {
+            s += "abc";
+        }
+        if (i % 100 < 60 && i % 7) {
+            s += "nothing to see here " + to_string(i) + " ";
+        } else {
+            s += "foo" + string(i % 17, ' ') + "bar " + to_string(i * 1013);
+        }
+        s += string(i % 31, 'x');
+        if (i % 50 == 0) {
+            s += string(300, '-');
+        }
+        corpora.push_back(s);
+    }
+    corpora.push_back("");
+
+    vector<const char *> data;
+    vector<unsigned int> len;
+    vector<CallBackContext> expected(corpora.size());
+    for (size_t i = 0; i < corpora.size(); i++) {
+        data.push_back(corpora[i].c_str());
+        len.push_back(corpora[i].size());
+        err = hs_scan(db, data[i], len[i], 0, scratch, record_cb,
+                      (void *)&expected[i]);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+
+    vector<CallBackContext> actual(corpora.size());
+    vector<void *> ctx;
+    for (auto &c : actual) {
+        ctx.push_back(&c);
+    }
+    err = hs_scan_batch(db, &data[0], &len[0], data.size(), 0, scratch,
+                        record_cb, &ctx[0]);
+    ASSERT_EQ(HS_SUCCESS, err);
+    for (size_t i = 0; i < corpora.size(); i++) {
+        ASSERT_EQ(expected[i].matches, actual[i].matches) << "buffer " << i;
+    }
+
+    // Terminating stops only the buffer being scanned.
+    for (auto &c : actual) {
+        c.clear();
+        c.halt = true;
+    }
+    err = hs_scan_batch(db, &data[0], &len[0], data.size(), 0, scratch,
+                        record_cb, &ctx[0]);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    for (size_t i = 0; i < corpora.size(); i++) {
+        if (expected[i].matches.empty()) {
+            ASSERT_TRUE(actual[i].matches.empty());
+        } else {
+            ASSERT_EQ(1U, actual[i].matches.size());
+            ASSERT_EQ(expected[i].matches[0], actual[i].matches[0]);
+        }
+    }
+
+    // teardown
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// The callback-free scan modes must agree with the matches delivered to a
+// callback by hs_scan.
+TEST(HyperscanTestBehaviour, ScanBitmapAndCount) {
+    hs_error_t err;
+
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo.*bar", 0, 1));
+    patterns.push_back(pattern("^abc", 0, 2));
+    patterns.push_back(pattern("[0-9]{4}$", 0, 3));
+    patterns.push_back(pattern("x{3,}", 0, 9));
+    patterns.push_back(pattern("y+z", HS_FLAG_SOM_LEFTMOST, 12));
+    patterns.push_back(pattern("q", HS_FLAG_SINGLEMATCH, 13));
+    patterns.push_back(pattern("unused", 0, 70));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    const vector<string> corpora = {
+        "", "abc", "foo bar 1234", "abcxxxxxyyyz foobar q q",
+        "q foo xxxx bar yz 99999", "nothing here",
+    };
+
+    for (const auto &corpus : corpora) {
+        SCOPED_TRACE(corpus);
+        CallBackContext c;
+        err = hs_scan(db, corpus.c_str(), corpus.size(), 0, scratch,
+                      record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        // IDs of 64 and above are not covered by the result arrays.
+        vector<unsigned long long> expected_counts(64, 0);
+        for (const auto &m : c.matches) {
+            if (m.id < 64) {
+                expected_counts[m.id]++;
+            }
+        }
+
+        vector<unsigned long long> counts(64, 0);
+        err = hs_scan_count(db, corpus.c_str(), corpus.size(), 0, scratch,
+                            &counts[0], counts.size());
+        ASSERT_EQ(HS_SUCCESS, err);
+        EXPECT_EQ(expected_counts, counts);
+
+        vector<unsigned char> bitmap(8, 0);
+        err = hs_scan_bitmap(db, corpus.c_str(), corpus.size(), 0, scratch,
+                             &bitmap[0], 64);
+        ASSERT_EQ(HS_SUCCESS, err);
+        for (unsigned id = 0; id < 64; id++) {
+            bool set = bitmap[id / 8] & (1U << (id % 8));
+            EXPECT_EQ(expected_counts[id] != 0, set) << "id " << id;
+        }
+    }
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// Once every pattern has matched, a bitmap scan stops early; the result must
+// still be complete, and the tail of the data must not be scanned.
+TEST(HyperscanTestBehaviour, ScanBitmapAllMatched) {
+    hs_error_t err;
+
+    vector<pattern> patterns;
+    patterns.push_back(pattern("abc", 0, 0));
+    patterns.push_back(pattern("d[ef]+g", 0, 1));
+    patterns.push_back(pattern("hij", HS_FLAG_SOM_LEFTMOST, 2));
+    patterns.push_back(pattern("0 | !2", HS_FLAG_COMBINATION, 3));
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // Every ID has matched by the end of the first "abc"; the long tail would
+    // match each pattern again many times over.
+    string tail;
+    for (unsigned i = 0; i < 1000; i++) {
+        tail += " abc defg hij";
+    }
+    string corpus = "hij defeg abc" + tail;
+
+#ifdef PROFILE_SUPPORT
+    CallBackContext c;
+    err = hs_scan(db, corpus.c_str(), corpus.size(), 0, scratch, record_cb,
+                  (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_profile_t full;
+    ASSERT_EQ(HS_SUCCESS, hs_scratch_profile(db, scratch, &full));
+    EXPECT_EQ(c.matches.size(), full.matches);
+    ASSERT_EQ(HS_SUCCESS, hs_reset_scratch_profile(scratch));
+#endif
+
+    unsigned char bitmap = 0;
+    err = hs_scan_bitmap(db, corpus.c_str(), corpus.size(), 0, scratch,
+                         &bitmap, 8);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(0xf, bitmap);
+
+#ifdef PROFILE_SUPPORT
+    // The scan stopped at the first "abc": each ID was delivered once, and
+    // none of the literal matches or programs in the tail were run.
+    hs_profile_t early;
+    ASSERT_EQ(HS_SUCCESS, hs_scratch_profile(db, scratch, &early));
+    EXPECT_EQ(4ULL, early.matches);
+    EXPECT_LT(early.matches * 100, full.matches);
+    EXPECT_LT(early.programs * 100, full.programs);
+    unsigned long long early_lits = 0;
+    unsigned long long full_lits = 0;
+    for (unsigned i = 0; i < HS_PROFILE_TABLE_COUNT; i++) {
+        early_lits += early.matchers[i].matches;
+        full_lits += full.matchers[i].matches;
+    }
+    EXPECT_LT(early_lits * 100, full_lits);
+    ASSERT_EQ(HS_SUCCESS, hs_reset_scratch_profile(scratch));
+#endif
+
+    // Only the combination holds, and only at the end of the data.
+    corpus = "nothing";
+    bitmap = 0;
+    err = hs_scan_bitmap(db, corpus.c_str(), corpus.size(), 0, scratch,
+                         &bitmap, 8);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(0x8, bitmap);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
 TEST(regression, UE_1005) {
     hs_error_t err;
     vector<pattern> patterns;
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "config.h"
+
+#include "gtest/gtest.h"
+#include "test_util.h"
+#include "hs.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+static const char *const reportExprs[] = {
+    "foobar",
+    "hatstand.*teakettle",
+    "^abc[0-9]{2,4}def",
+    "badger[^\\n]{20,}mushroom",
+    "(a|b)c{100,200}d",
+    "x[yz]+w$",
+};
+
+static const unsigned numReportExprs =
+    sizeof(reportExprs) / sizeof(reportExprs[0]);
+
+// Compiles the test pattern set with a report, checking that the compile
+// worked.
+hs_database_t *compileWithReport(unsigned mode, hs_compile_report_t **report) {
+    vector<unsigned> flags(numReportExprs, HS_FLAG_DOTALL);
+    vector<unsigned> ids(numReportExprs);
+    for (unsigned i = 0; i < numReportExprs; i++) {
+        ids[i] = i + 10;
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_report(
+        reportExprs, flags.data(), ids.data(), nullptr, numReportExprs, mode,
+        nullptr, &db, &compile_err, report);
+    EXPECT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+    EXPECT_TRUE(*report != nullptr);
+    return db;
+}
+
+const hs_compile_phase_t *findPhase(const hs_compile_report_t *report,
+                                    const string &name) {
+    for (unsigned i = 0; i < report->phase_count; i++) {
+        if (name == report->phases[i].name) {
+            return &report->phases[i];
+        }
+    }
+    return nullptr;
+}
+
+// Every nested phase must be listed after its parent, at the next depth.
+void checkPhaseTree(const hs_compile_report_t *report) {
+    for (unsigned i = 0; i < report->phase_count; i++) {
+        const hs_compile_phase_t &p = report->phases[i];
+        SCOPED_TRACE(p.name);
+        string name(p.name);
+        EXPECT_LT(0U, p.calls);
+
+        size_t slash = name.rfind('/');
+        if (slash == string::npos) {
+            EXPECT_EQ(0U, p.depth);
+            continue;
+        }
+
+        string parent_name = name.substr(0, slash);
+        bool found = false;
+        for (unsigned j = 0; j < i; j++) {
+            if (parent_name == report->phases[j].name) {
+                EXPECT_EQ(report->phases[j].depth + 1, p.depth);
+                found = true;
+                break;
+            }
+        }
+        EXPECT_TRUE(found);
+    }
+}
+
+class CompileReportp : public testing::TestWithParam<unsigned> {};
+
+} // namespace
+
+TEST_P(CompileReportp, Basic) {
+    const unsigned mode = GetParam();
+    hs_compile_report_t *report = nullptr;
+    hs_database_t *db = compileWithReport(mode, &report);
+    ASSERT_TRUE(db != nullptr);
+    ASSERT_TRUE(report != nullptr);
+
+    EXPECT_LT(0ULL, report->time_ns);
+    ASSERT_LT(0U, report->phase_count);
+    ASSERT_TRUE(report->phases != nullptr);
+    checkPhaseTree(report);
+
+    // The top-level phases are one per expression, then the build.
+    const hs_compile_phase_t *expr = findPhase(report, "expression");
+    ASSERT_TRUE(expr != nullptr);
+    EXPECT_EQ(numReportExprs, expr->calls);
+    const hs_compile_phase_t *build = findPhase(report, "build");
+    ASSERT_TRUE(build != nullptr);
+    EXPECT_EQ(1U, build->calls);
+    EXPECT_LE(build->time_ns, report->time_ns);
+    EXPECT_TRUE(findPhase(report, "build/rose") != nullptr);
+    EXPECT_TRUE(findPhase(report, "build/rose/bytecode") != nullptr);
+    EXPECT_TRUE(findPhase(report, "expression/parse") != nullptr);
+
+    ASSERT_EQ(numReportExprs, report->expression_count);
+    for (unsigned i = 0; i < report->expression_count; i++) {
+        const hs_compile_expr_stats_t &e = report->expressions[i];
+        EXPECT_EQ(i, e.index);
+        EXPECT_EQ(i + 10, e.id);
+        EXPECT_LT(0ULL, e.time_ns);
+        EXPECT_GE(report->time_ns, e.time_ns);
+    }
+
+    // Engines by type and by role should agree.
+    unsigned by_type = report->limex_count + report->mcclellan_count +
+                       report->sheng_count + report->mcsheng_count +
+                       report->gough_count + report->castle_count +
+                       report->lbr_count + report->mpv_count +
+                       report->other_count;
+    unsigned by_role = report->outfix_count + report->suffix_count +
+                       report->leftfix_count;
+    EXPECT_LT(0U, by_type);
+    EXPECT_EQ(by_type, by_role);
+    EXPECT_LT(0U, report->literal_matcher_count);
+    EXPECT_GE(4U, report->literal_matcher_count);
+
+    hs_free_compile_report(report);
+    hs_free_database(db);
+}
+
+// The database must be the same as that from hs_compile_ext_multi().
+TEST_P(CompileReportp, Identical) {
+    const unsigned mode = GetParam();
+    hs_compile_report_t *report = nullptr;
+    hs_database_t *db = compileWithReport(mode, &report);
+    ASSERT_TRUE(db != nullptr);
+    hs_free_compile_report(report);
+
+    vector<unsigned> flags(numReportExprs, HS_FLAG_DOTALL);
+    vector<unsigned> ids(numReportExprs);
+    for (unsigned i = 0; i < numReportExprs; i++) {
+        ids[i] = i + 10;
+    }
+    hs_database_t *db2 = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi(reportExprs, flags.data(),
+                                          ids.data(), nullptr, numReportExprs,
+                                          mode, nullptr, &db2, &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(db2 != nullptr);
+
+    char *bytes1 = nullptr;
+    char *bytes2 = nullptr;
+    size_t len1 = 0;
+    size_t len2 = 0;
+    ASSERT_EQ(HS_SUCCESS, hs_serialize_database(db, &bytes1, &len1));
+    ASSERT_EQ(HS_SUCCESS, hs_serialize_database(db2, &bytes2, &len2));
+    ASSERT_EQ(len1, len2);
+    EXPECT_EQ(0, memcmp(bytes1, bytes2, len1));
+
+    free(bytes1);
+    free(bytes2);
+    hs_free_database(db);
+    hs_free_database(db2);
+}
+
+// Phases run on compile worker threads are still nested under the phase that
+// started them.
+TEST_P(CompileReportp, Threaded) {
+    const unsigned mode = GetParam();
+    hs_set_compile_threads(4);
+    hs_compile_report_t *report = nullptr;
+    hs_database_t *db = compileWithReport(mode, &report);
+    hs_set_compile_threads(1);
+    ASSERT_TRUE(db != nullptr);
+    ASSERT_TRUE(report != nullptr);
+
+    checkPhaseTree(report);
+    for (unsigned i = 0; i < report->phase_count; i++) {
+        string name(report->phases[i].name);
+        EXPECT_TRUE(name.compare(0, 10, "expression") == 0 ||
+                    name.compare(0, 5, "build") == 0) << name;
+    }
+
+    hs_free_compile_report(report);
+    hs_free_database(db);
+}
+
+static const unsigned reportModes[] = {
+    HS_MODE_BLOCK,
+    HS_MODE_STREAM,
+    HS_MODE_VECTORED,
+};
+
+INSTANTIATE_TEST_CASE_P(CompileReport, CompileReportp,
+                        testing::ValuesIn(reportModes));
+
+// A failed compile still returns a report, covering the expressions added
+// before the failure.
+TEST(CompileReport, Failure) {
+    const char *exprs[] = {"foobar", "foo(bar)\\1", "baz"};
+    const unsigned ids[] = {1, 2, 3};
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_compile_report_t *report = nullptr;
+    hs_error_t err = hs_compile_ext_multi_report(exprs, nullptr, ids, nullptr,
+                                                 3, HS_MODE_BLOCK, nullptr,
+                                                 &db, &compile_err, &report);
+    ASSERT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    ASSERT_TRUE(compile_err != nullptr);
+    EXPECT_EQ(1, compile_err->expression);
+    hs_free_compile_error(compile_err);
+
+    ASSERT_TRUE(report != nullptr);
+    ASSERT_EQ(1U, report->expression_count);
+    EXPECT_EQ(0U, report->expressions[0].index);
+    EXPECT_EQ(1U, report->expressions[0].id);
+    const hs_compile_phase_t *expr = findPhase(report, "expression");
+    ASSERT_TRUE(expr != nullptr);
+    EXPECT_EQ(2U, expr->calls);
+    EXPECT_EQ(nullptr, findPhase(report, "build"));
+    EXPECT_EQ(0U, report->outfix_count + report->suffix_count +
+                  report->leftfix_count);
+    EXPECT_EQ(0U, report->literal_matcher_count);
+
+    hs_free_compile_report(report);
+}
+
+TEST(CompileReport, BadArgs) {
+    const char *expr = "foobar";
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_report(&expr, nullptr, nullptr,
+                                                 nullptr, 1, HS_MODE_BLOCK,
+                                                 nullptr, &db, &compile_err,
+                                                 nullptr);
+    ASSERT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    ASSERT_TRUE(compile_err != nullptr);
+    hs_free_compile_error(compile_err);
+
+    EXPECT_EQ(HS_SUCCESS, hs_free_compile_report(nullptr));
+}
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "config.h"
+
+#include "gtest/gtest.h"
+#include "test_util.h"
+#include "hs.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct SomMatch {
+    SomMatch(unsigned i, unsigned long long f, unsigned long long t)
+        : id(i), from(f), to(t) {}
+    bool operator==(const SomMatch &o) const {
+        return id == o.id && from == o.from && to == o.to;
+    }
+    unsigned id;
+    unsigned long long from;
+    unsigned long long to;
+};
+
+int somRecord(unsigned id, unsigned long long from, unsigned long long to,
+              unsigned, void *ctxt) {
+    auto *out = static_cast<vector<SomMatch> *>(ctxt);
+    out->emplace_back(id, from, to);
+    return 0;
+}
+
+// Escape every byte so that the regex compiler treats the literal exactly.
+string escapeLiteral(const string &lit) {
+    string out;
+    for (unsigned char c : lit) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\x%02x", c);
+        out += buf;
+    }
+    return out;
+}
+
+hs_database_t *buildLitDB(const vector<string> &lits,
+                          const vector<unsigned> &flags, unsigned mode) {
+    vector<const char *> ptrs;
+    vector<size_t> lens;
+    vector<unsigned> ids;
+    for (size_t i = 0; i < lits.size(); i++) {
+        ptrs.push_back(lits[i].data());
+        lens.push_back(lits[i].size());
+        ids.push_back(i);
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_lit_multi(ptrs.data(), flags.data(),
+                                          ids.data(), lens.data(),
+                                          lits.size(), mode, nullptr, &db,
+                                          &compile_err);
+    if (err != HS_SUCCESS) {
+        hs_free_compile_error(compile_err);
+        return nullptr;
+    }
+    return db;
+}
+
+hs_database_t *buildEscapedDB(const vector<string> &lits,
+                              const vector<unsigned> &flags, unsigned mode) {
+    vector<pattern> patterns;
+    for (size_t i = 0; i < lits.size(); i++) {
+        patterns.push_back(pattern(escapeLiteral(lits[i]), flags[i], i));
+    }
+    return buildDB(patterns, mode);
+}
+
+vector<SomMatch> scanBlock(const hs_database_t *db, const string &data) {
+    vector<SomMatch> matches;
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    EXPECT_EQ(HS_SUCCESS, err);
+    err = hs_scan(db, data.data(), data.size(), 0, scratch, somRecord,
+                  &matches);
+    EXPECT_EQ(HS_SUCCESS, err);
+    hs_free_scratch(scratch);
+    return matches;
+}
+
+vector<SomMatch> scanStream(const hs_database_t *db, const string &data,
+                            size_t chunk) {
+    vector<SomMatch> matches;
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    EXPECT_EQ(HS_SUCCESS, err);
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    EXPECT_EQ(HS_SUCCESS, err);
+    for (size_t i = 0; i < data.size(); i += chunk) {
+        size_t len = min(chunk, data.size() - i);
+        err = hs_scan_stream(stream, data.data() + i, len, 0, scratch,
+                             somRecord, &matches);
+        EXPECT_EQ(HS_SUCCESS, err);
+    }
+    err = hs_close_stream(stream, scratch, somRecord, &matches);
+    EXPECT_EQ(HS_SUCCESS, err);
+    hs_free_scratch(scratch);
+    return matches;
+}
+
+// A small literal set exercising NUL bytes, high bytes, caseless matching,
+// single-match and SOM reporting.
+struct LiteralSet {
+    vector<string> lits;
+    vector<unsigned> flags;
+
+    LiteralSet() {
+        add(string("foo\0bar", 7), 0);
+        add(string("\0\0", 2), 0);
+        add("ABCdef", HS_FLAG_CASELESS);
+        add("a\xff\x80z", HS_FLAG_CASELESS);
+        add("needle", HS_FLAG_SINGLEMATCH);
+        add("x", HS_FLAG_SINGLEMATCH);
+        add("hay", HS_FLAG_SOM_LEFTMOST);
+        add(string("q\0", 2), HS_FLAG_SOM_LEFTMOST | HS_FLAG_CASELESS);
+        add(".*", 0); // not a regex: matched byte-for-byte
+    }
+
+    void add(const string &s, unsigned f) {
+        lits.push_back(s);
+        flags.push_back(f);
+    }
+};
+
+string makeCorpus(const LiteralSet &ls, size_t len) {
+    mt19937 prng(17);
+    string corpus;
+    while (corpus.size() < len) {
+        switch (prng() % 4) {
+        case 0: {
+            string lit = ls.lits[prng() % ls.lits.size()];
+            for (auto &c : lit) {
+                if (prng() % 2) {
+                    c = toupper((unsigned char)c);
+                }
+            }
+            corpus += lit;
+            break;
+        }
+        case 1:
+            corpus.push_back('\0');
+            break;
+        default:
+            corpus.push_back("abcdefhnoqxyz.*"[prng() % 15]);
+            break;
+        }
+    }
+    return corpus;
+}
+
+} // namespace
+
+TEST(LiteralCompile, Single) {
+    const string lit("ab\0cd", 5);
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_lit(lit.data(), 0, lit.size(), HS_MODE_BLOCK,
+                                    nullptr, &db, &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_NE(nullptr, db);
+
+    const string data("xxab\0cdab\0cab\0cd", 16);
+    vector<SomMatch> matches = scanBlock(db, data);
+    ASSERT_EQ(2U, matches.size());
+    EXPECT_EQ(7U, matches[0].to);
+    EXPECT_EQ(16U, matches[1].to);
+
+    hs_free_database(db);
+}
+
+TEST(LiteralCompile, MatchesEscapedBlock) {
+    LiteralSet ls;
+    string corpus = makeCorpus(ls, 4000);
+
+    hs_database_t *lit_db = buildLitDB(ls.lits, ls.flags, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, lit_db);
+    hs_database_t *re_db = buildEscapedDB(ls.lits, ls.flags, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, re_db);
+
+    vector<SomMatch> lit_matches = scanBlock(lit_db, corpus);
+    vector<SomMatch> re_matches = scanBlock(re_db, corpus);
+    EXPECT_FALSE(lit_matches.empty());
+    EXPECT_TRUE(lit_matches == re_matches);
+
+    hs_free_database(lit_db);
+    hs_free_database(re_db);
+}
+
+TEST(LiteralCompile, MatchesEscapedStream) {
+    LiteralSet ls;
+    string corpus = makeCorpus(ls, 4000);
+    const unsigned mode = HS_MODE_STREAM | HS_MODE_SOM_HORIZON_LARGE;
+
+    hs_database_t *lit_db = buildLitDB(ls.lits, ls.flags, mode);
+    ASSERT_NE(nullptr, lit_db);
+    hs_database_t *re_db = buildEscapedDB(ls.lits, ls.flags, mode);
+    ASSERT_NE(nullptr, re_db);
+
+    for (size_t chunk : {1, 3, 64, 4000}) {
+        SCOPED_TRACE(chunk);
+        vector<SomMatch> lit_matches = scanStream(lit_db, corpus, chunk);
+        vector<SomMatch> re_matches = scanStream(re_db, corpus, chunk);
+        EXPECT_FALSE(lit_matches.empty());
+        EXPECT_TRUE(lit_matches == re_matches);
+    }
+
+    hs_free_database(lit_db);
+    hs_free_database(re_db);
+}
+
+TEST(LiteralCompile, SomAndSingleMatch) {
+    vector<string> lits = {"hay", "needle", "x"};
+    vector<unsigned> flags = {HS_FLAG_SOM_LEFTMOST, HS_FLAG_SINGLEMATCH,
+                              HS_FLAG_SINGLEMATCH};
+    hs_database_t *db = buildLitDB(lits, flags, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    vector<SomMatch> matches = scanBlock(db, "haystack needle hay needle xx");
+    const vector<SomMatch> expected = {
+        {0, 0, 3}, {1, 0, 15}, {0, 16, 19}, {2, 0, 28}};
+    EXPECT_TRUE(expected == matches);
+
+    hs_free_database(db);
+}
+
+TEST(LiteralCompile, BadArgs) {
+    const char *lit = "abc";
+    const size_t len = 3;
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+
+    // null error
+    hs_error_t err = hs_compile_lit(lit, 0, len, HS_MODE_BLOCK, nullptr, &db,
+                                    nullptr);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+
+    // null db
+    err = hs_compile_lit(lit, 0, len, HS_MODE_BLOCK, nullptr, nullptr,
+                         &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+
+    // null expression
+    err = hs_compile_lit(nullptr, 0, len, HS_MODE_BLOCK, nullptr, &db,
+                         &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+
+    // empty literal
+    err = hs_compile_lit(lit, 0, 0, HS_MODE_BLOCK, nullptr, &db,
+                         &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    ASSERT_NE(nullptr, compile_err);
+    EXPECT_EQ(0, compile_err->expression);
+    hs_free_compile_error(compile_err);
+
+    // flags that make no sense for a literal
+    for (unsigned flag : {HS_FLAG_DOTALL, HS_FLAG_MULTILINE, HS_FLAG_UTF8,
+                          HS_FLAG_UCP, HS_FLAG_PREFILTER,
+                          HS_FLAG_ALLOWEMPTY}) {
+        err = hs_compile_lit(lit, flag, len, HS_MODE_BLOCK, nullptr, &db,
+                             &compile_err);
+        EXPECT_EQ(HS_COMPILER_ERROR, err);
+        EXPECT_EQ(nullptr, db);
+        ASSERT_NE(nullptr, compile_err);
+        hs_free_compile_error(compile_err);
+    }
+
+    // single match with SOM
+    err = hs_compile_lit(lit, HS_FLAG_SINGLEMATCH | HS_FLAG_SOM_LEFTMOST, len,
+                         HS_MODE_BLOCK, nullptr, &db, &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+
+    // SOM in streaming mode without a horizon
+    err = hs_compile_lit(lit, HS_FLAG_SOM_LEFTMOST, len, HS_MODE_STREAM,
+                         nullptr, &db, &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+}
+
+TEST(LiteralCompile, BadArgsMulti) {
+    const char *lits[] = {"abc", "def"};
+    const size_t lens[] = {3, 3};
+    const unsigned ids[] = {1, 2};
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+
+    // null expressions
+    hs_error_t err = hs_compile_lit_multi(nullptr, nullptr, ids, lens, 2,
+                                          HS_MODE_BLOCK, nullptr, &db,
+                                          &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+
+    // null lens
+    err = hs_compile_lit_multi(lits, nullptr, ids, nullptr, 2, HS_MODE_BLOCK,
+                               nullptr, &db, &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+
+    // zero elements
+    err = hs_compile_lit_multi(lits, nullptr, ids, lens, 0, HS_MODE_BLOCK,
+                               nullptr, &db, &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+
+    // bad mode
+    err = hs_compile_lit_multi(lits, nullptr, ids, lens, 2, 0, nullptr, &db,
+                               &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    ASSERT_NE(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+
+    // null element: error should carry its index
+    const char *bad_lits[] = {"abc", nullptr};
+    err = hs_compile_lit_multi(bad_lits, nullptr, ids, lens, 2, HS_MODE_BLOCK,
+                               nullptr, &db, &compile_err);
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    ASSERT_NE(nullptr, compile_err);
+    EXPECT_EQ(1, compile_err->expression);
+    hs_free_compile_error(compile_err);
+}
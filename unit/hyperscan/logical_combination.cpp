@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include "gtest/gtest.h"
+#include "test_util.h"
+#include "hs.h"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct Match {
+    Match(unsigned i, unsigned long long f, unsigned long long t)
+        : id(i), from(f), to(t) {}
+    bool operator==(const Match &o) const {
+        return id == o.id && from == o.from && to == o.to;
+    }
+    bool operator<(const Match &o) const {
+        return tie(to, id, from) < tie(o.to, o.id, o.from);
+    }
+    unsigned id;
+    unsigned long long from;
+    unsigned long long to;
+};
+
+ostream &operator<<(ostream &o, const Match &m) {
+    return o << "(" << m.id << ", " << m.from << ", " << m.to << ")";
+}
+
+int recordMatch(unsigned id, unsigned long long from, unsigned long long to,
+                unsigned, void *ctxt) {
+    auto *out = static_cast<vector<Match> *>(ctxt);
+    out->emplace_back(id, from, to);
+    return 0;
+}
+
+int haltOnMatch(unsigned id, unsigned long long from, unsigned long long to,
+                unsigned, void *ctxt) {
+    recordMatch(id, from, to, 0, ctxt);
+    return 1;
+}
+
+// Only the end offsets of matches from sub-expressions are of interest here,
+// so their start offsets are zeroed before comparison.
+vector<Match> normalise(vector<Match> matches) {
+    for (auto &m : matches) {
+        m.from = 0;
+    }
+    sort(matches.begin(), matches.end());
+    return matches;
+}
+
+vector<Match> scanBlock(const hs_database_t *db, const string &data) {
+    vector<Match> matches;
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    EXPECT_EQ(HS_SUCCESS, err);
+    err = hs_scan(db, data.data(), data.size(), 0, scratch, recordMatch,
+                  &matches);
+    EXPECT_EQ(HS_SUCCESS, err);
+    hs_free_scratch(scratch);
+    return normalise(matches);
+}
+
+vector<Match> scanStream(const hs_database_t *db, const string &data,
+                         size_t chunk) {
+    vector<Match> matches;
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    EXPECT_EQ(HS_SUCCESS, err);
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    EXPECT_EQ(HS_SUCCESS, err);
+    for (size_t i = 0; i < data.size(); i += chunk) {
+        size_t len = min(chunk, data.size() - i);
+        err = hs_scan_stream(stream, data.data() + i, len, 0, scratch,
+                             recordMatch, &matches);
+        EXPECT_EQ(HS_SUCCESS, err);
+    }
+    err = hs_close_stream(stream, scratch, recordMatch, &matches);
+    EXPECT_EQ(HS_SUCCESS, err);
+    hs_free_scratch(scratch);
+    return normalise(matches);
+}
+
+// Returns the compile error message, or the empty string on success.
+string compileError(const vector<pattern> &patterns) {
+    vector<const char *> exprs;
+    vector<unsigned> flags;
+    vector<unsigned> ids;
+    for (const auto &p : patterns) {
+        exprs.push_back(p.expression.c_str());
+        flags.push_back(p.flags);
+        ids.push_back(p.id);
+    }
+
+    hs_database_t *db = nullptr;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_multi(exprs.data(), flags.data(), ids.data(),
+                                      exprs.size(), HS_MODE_BLOCK, nullptr,
+                                      &db, &compile_err);
+    if (err == HS_SUCCESS) {
+        hs_free_database(db);
+        return "";
+    }
+    EXPECT_EQ(HS_COMPILER_ERROR, err);
+    EXPECT_EQ(nullptr, db);
+    string msg = compile_err->message;
+    hs_free_compile_error(compile_err);
+    return msg;
+}
+
+} // namespace
+
+TEST(LogicalCombination, And) {
+    vector<pattern> patterns = {
+        pattern("abc", 0, 101),
+        pattern("def", 0, 102),
+        pattern("101 & 102", HS_FLAG_COMBINATION, 1000),
+    };
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    vector<Match> expected = {{101, 0, 5}, {102, 0, 10}, {1000, 0, 10}};
+    EXPECT_EQ(expected, scanBlock(db, "xxabcxxdefxx"));
+
+    expected = {{101, 0, 5}};
+    EXPECT_EQ(expected, scanBlock(db, "xxabcxxxxxxx"));
+
+    hs_free_database(db);
+}
+
+TEST(LogicalCombination, OrReportsEveryTime) {
+    vector<pattern> patterns = {
+        pattern("abc", 0, 101),
+        pattern("def", 0, 102),
+        pattern("101 | 102", HS_FLAG_COMBINATION, 1000),
+    };
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    vector<Match> expected = {{101, 0, 5},   {1000, 0, 5}, {102, 0, 10},
+                              {1000, 0, 10}, {101, 0, 13}, {1000, 0, 13}};
+    EXPECT_EQ(expected, scanBlock(db, "xxabcxxdefabc"));
+
+    hs_free_database(db);
+}
+
+TEST(LogicalCombination, SingleMatch) {
+    vector<pattern> patterns = {
+        pattern("abc", 0, 101),
+        pattern("def", 0, 102),
+        pattern("101 | 102", HS_FLAG_COMBINATION | HS_FLAG_SINGLEMATCH, 1000),
+    };
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    vector<Match> expected = {{101, 0, 5}, {1000, 0, 5}, {102, 0, 10},
+                              {101, 0, 13}};
+    EXPECT_EQ(expected, scanBlock(db, "xxabcxxdefabc"));
+
+    hs_free_database(db);
+}
+
+TEST(LogicalCombination, Quiet) {
+    vector<pattern> patterns = {
+        pattern("abc", HS_FLAG_QUIET, 101),
+        pattern("de+f", HS_FLAG_QUIET | HS_FLAG_SINGLEMATCH, 102),
+        pattern("101 & 102", HS_FLAG_COMBINATION, 1000),
+    };
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    vector<Match> expected = {{1000, 0, 11}, {1000, 0, 16}};
+    EXPECT_EQ(expected, scanBlock(db, "xxabcxxdeefxxabcdef"));
+
+    expected = {};
+    EXPECT_EQ(expected, scanBlock(db, "deef"));
+
+    hs_free_database(db);
+}
+
+TEST(LogicalCombination, QuietWithoutCombination) {
+    vector<pattern> patterns = {
+        pattern("abc", HS_FLAG_QUIET, 101),
+        pattern("def", 0, 102),
+    };
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    vector<Match> expected = {{102, 0, 10}};
+    EXPECT_EQ(expected, scanBlock(db, "xxabcxxdefxx"));
+
+    hs_free_database(db);
+}
+
+// A quiet pattern that feeds no combination has no report program at all;
+// its matches from engines as well as from literals must be dropped quietly.
+TEST(LogicalCombination, QuietWithoutCombinationEngine) {
+    vector<pattern> patterns = {
+        pattern("abc", HS_FLAG_QUIET, 101),
+        pattern("a[^x]{4,}b", HS_FLAG_QUIET, 102),
+        pattern("x.*y\\d+z", HS_FLAG_QUIET, 103),
+        pattern("def", 0, 104),
+    };
+    const string data = "abcxxa____bxxdefxxy12zxxabcddddb";
+    vector<Match> expected = {{104, 0, 16}};
+
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    EXPECT_EQ(expected, scanBlock(db, data));
+    hs_free_database(db);
+
+    db = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+    EXPECT_EQ(expected, scanStream(db, data, 5));
+    hs_free_database(db);
+}
+
+TEST(LogicalCombination, Negation) {
+    vector<pattern> patterns = {
+        pattern("abc", HS_FLAG_QUIET, 101),
+        pattern("def", HS_FLAG_QUIET, 102),
+        pattern("101 & !102", HS_FLAG_COMBINATION, 1000),
+    };
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    vector<Match> expected = {{1000, 0, 5}};
+    EXPECT_EQ(expected, scanBlock(db, "xxabcxxdefabc"));
+
+    expected = {};
+    EXPECT_EQ(expected, scanBlock(db, "xxdefxxabc"));
+
+    hs_free_database(db);
+}
+
+TEST(LogicalCombination, PurelyNegativeAtEnd) {
+    vector<pattern> patterns = {
+        pattern("abc", HS_FLAG_QUIET, 101),
+        pattern("!101", HS_FLAG_COMBINATION, 1000),
+    };
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    vector<Match> expected = {{1000, 0, 6}};
+    EXPECT_EQ(expected, scanBlock(db, "xxxxxx"));
+
+    expected = {{1000, 0, 0}};
+    EXPECT_EQ(expected, scanBlock(db, ""));
+
+    expected = {};
+    EXPECT_EQ(expected, scanBlock(db, "xxabcx"));
+
+    hs_free_database(db);
+}
+
+TEST(LogicalCombination, Precedence) {
+    vector<pattern> patterns = {
+        pattern("a", HS_FLAG_QUIET, 1),
+        pattern("b", HS_FLAG_QUIET, 2),
+        pattern("c", HS_FLAG_QUIET, 3),
+        // Parsed as 1 | (2 & !3).
+        pattern("1 | 2 & !3", HS_FLAG_COMBINATION | HS_FLAG_SINGLEMATCH, 10),
+        // Parsed as (1 | 2) & !3.
+        pattern("(1 | 2) & !3", HS_FLAG_COMBINATION | HS_FLAG_SINGLEMATCH, 11),
+    };
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    vector<Match> expected = {{10, 0, 5}};
+    EXPECT_EQ(expected, scanBlock(db, "xcxxax"));
+
+    expected = {{10, 0, 2}, {11, 0, 2}};
+    EXPECT_EQ(expected, scanBlock(db, "xbxxcx"));
+
+    hs_free_database(db);
+}
+
+TEST(LogicalCombination, StreamingMatchesBlock) {
+    vector<pattern> patterns = {
+        pattern("abc", HS_FLAG_QUIET, 101),
+        pattern("d.f", 0, 102),
+        pattern("xyz", HS_FLAG_QUIET, 103),
+        pattern("101 & 102", HS_FLAG_COMBINATION, 1000),
+        pattern("(101 | 103) & !102", HS_FLAG_COMBINATION, 1001),
+        pattern("!103", HS_FLAG_COMBINATION, 1002),
+        pattern("102 | !101", HS_FLAG_COMBINATION | HS_FLAG_SINGLEMATCH, 1003),
+    };
+    hs_database_t *bdb = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, bdb);
+    hs_database_t *sdb = buildDB(patterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, sdb);
+
+    const vector<string> corpora = {
+        "", "abc", "def", "xyz", "xxabcxdefxxabcxxdofx", "xyzabcdxfabc",
+        "dufxxxxxxxxxxxxxxxxxxabcxxxxxxxxxxxxxxxxxxxxxxxxxxxxdef",
+    };
+
+    for (const auto &corpus : corpora) {
+        SCOPED_TRACE(corpus);
+        vector<Match> expected = scanBlock(bdb, corpus);
+        for (size_t chunk : {1, 2, 3, 7, 64}) {
+            SCOPED_TRACE(chunk);
+            EXPECT_EQ(expected, scanStream(sdb, corpus, chunk));
+        }
+    }
+
+    // Spot-check one corpus exactly.
+    vector<Match> expected = {{1001, 0, 5},  {1002, 0, 5},  {102, 0, 9},
+                              {1000, 0, 9},  {1002, 0, 9},  {1003, 0, 9},
+                              {1000, 0, 14}, {1002, 0, 14}, {102, 0, 19},
+                              {1000, 0, 19}, {1002, 0, 19}};
+    EXPECT_EQ(expected, scanBlock(bdb, "xxabcxdefxxabcxxdofx"));
+
+    hs_free_database(bdb);
+    hs_free_database(sdb);
+}
+
+TEST(LogicalCombination, HaltInCombination) {
+    vector<pattern> patterns = {
+        pattern("abc", HS_FLAG_QUIET, 101),
+        pattern("101", HS_FLAG_COMBINATION, 1000),
+    };
+    hs_database_t *db = buildDB(patterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    vector<Match> matches;
+    const string data("abcabcabc");
+    err = hs_scan(db, data.data(), data.size(), 0, scratch, haltOnMatch,
+                  &matches);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    vector<Match> expected = {{1000, 0, 3}};
+    EXPECT_EQ(expected, matches);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(LogicalCombination, BadSyntax) {
+    const vector<string> bad = {
+        "", "101 &", "& 101", "(101", "101)", "101 102", "101 && 102",
+        "101 & ()", "abc", "101 | !", "99999999999",
+    };
+
+    for (const auto &expr : bad) {
+        SCOPED_TRACE(expr);
+        vector<pattern> patterns = {
+            pattern("abc", 0, 101),
+            pattern("def", 0, 102),
+            pattern(expr, HS_FLAG_COMBINATION, 1000),
+        };
+        string msg = compileError(patterns);
+        EXPECT_EQ(0U, msg.find("Invalid logical combination")) << msg;
+    }
+}
+
+TEST(LogicalCombination, UnknownId) {
+    vector<pattern> patterns = {
+        pattern("abc", 0, 101),
+        pattern("101 & 102", HS_FLAG_COMBINATION, 1000),
+    };
+    EXPECT_EQ("Logical combination refers to match ID 102, which is not used "
+              "by any other expression.", compileError(patterns));
+}
+
+TEST(LogicalCombination, BadFlags) {
+    vector<pattern> patterns = {
+        pattern("abc", 0, 101),
+        pattern("101", HS_FLAG_COMBINATION | HS_FLAG_CASELESS, 1000),
+    };
+    EXPECT_EQ("Only HS_FLAG_SINGLEMATCH may be used in combination with "
+              "HS_FLAG_COMBINATION.", compileError(patterns));
+}
+
+TEST(LogicalCombination, InconsistentQuiet) {
+    vector<pattern> patterns = {
+        pattern("abc", HS_FLAG_QUIET, 101),
+        pattern("def", 0, 101),
+    };
+    EXPECT_EQ("Expression (index 1) with match ID 101 did not specify "
+              "HS_FLAG_QUIET whereas previous expression (index 0) with the "
+              "same match ID did.", compileError(patterns));
+}
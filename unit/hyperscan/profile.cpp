@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "config.h"
+
+#include "gtest/gtest.h"
+#include "test_util.h"
+#include "hs.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+static
+hs_database_t *buildProfileDB(unsigned int mode) {
+    vector<pattern> patterns;
+    patterns.emplace_back("foobar", 0, 10);
+    patterns.emplace_back("foo.*bar", 0, 20);
+    patterns.emplace_back("abc[0-9]{2,4}def", 0, 30);
+    patterns.emplace_back("x[^y]{20}z", 0, 40);
+    return buildDB(patterns, mode);
+}
+
+static const string profileData =
+    "xxfoobarxxabc123defxx" "x0123456789abcdefghijz" "foo....bar";
+
+} // namespace
+
+#ifdef PROFILE_SUPPORT
+
+TEST(Profile, BlockTotals) {
+    hs_database_t *db = buildProfileDB(HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db, &scratch));
+
+    CallBackContext c;
+    hs_error_t err = hs_scan(db, profileData.c_str(), profileData.size(), 0,
+                             scratch, record_cb, &c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_FALSE(c.matches.empty());
+
+    hs_profile_t p;
+    ASSERT_EQ(HS_SUCCESS, hs_scratch_profile(db, scratch, &p));
+    EXPECT_EQ(1ULL, p.scans);
+    EXPECT_EQ(profileData.size(), p.bytes);
+    EXPECT_LT(0ULL, p.cycles);
+    EXPECT_EQ(c.matches.size(), p.matches);
+    EXPECT_LE(p.programs, p.instructions);
+    EXPECT_LE(1U, p.engine_count);
+    EXPECT_LT(0ULL, p.engine_execs);
+
+    // Every literal matcher that exists was run at most once for one block.
+    unsigned long long lit_matches = 0;
+    for (const auto &m : p.matchers) {
+        if (m.kind == HS_PROFILE_MATCHER_NONE) {
+            EXPECT_EQ(0ULL, m.calls);
+        }
+        EXPECT_GE(1ULL, m.calls);
+        lit_matches += m.matches;
+    }
+    EXPECT_LT(0ULL, lit_matches);
+
+    // Per-pattern counters, sorted by ID, add up to the total.
+    ASSERT_EQ(4U, p.pattern_count);
+    unsigned long long total = 0;
+    vector<unsigned> ids;
+    for (unsigned i = 0; i < p.pattern_count; i++) {
+        hs_profile_pattern_t pp;
+        ASSERT_EQ(HS_SUCCESS, hs_scratch_profile_pattern(db, scratch, i, &pp));
+        ids.push_back(pp.id);
+        auto expected = count_if(c.matches.begin(), c.matches.end(),
+                                 [&](const MatchRecord &m) {
+                                     return m.id == (int)pp.id;
+                                 });
+        EXPECT_EQ((unsigned long long)expected, pp.matches);
+        total += pp.matches;
+    }
+    EXPECT_EQ(vector<unsigned>({10, 20, 30, 40}), ids);
+    EXPECT_EQ(p.matches, total);
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(Profile, EngineAttribution) {
+    hs_database_t *db = buildProfileDB(HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db, &scratch));
+
+    ASSERT_EQ(HS_SUCCESS, hs_scan(db, profileData.c_str(), profileData.size(),
+                                  0, scratch, dummy_cb, nullptr));
+
+    hs_profile_t p;
+    ASSERT_EQ(HS_SUCCESS, hs_scratch_profile(db, scratch, &p));
+
+    unsigned long long execs = 0;
+    bool found_40 = false;
+    for (unsigned i = 0; i < p.engine_count; i++) {
+        hs_profile_engine_t e;
+        ASSERT_EQ(HS_SUCCESS, hs_scratch_profile_engine(db, scratch, i, &e));
+        ASSERT_NE(nullptr, e.kind);
+        EXPECT_LE(e.accel_misses, e.accel_calls);
+        execs += e.execs;
+        ASSERT_TRUE(e.pattern_count == 0 || e.patterns != nullptr);
+        EXPECT_TRUE(is_sorted(e.patterns, e.patterns + e.pattern_count));
+        if (e.execs && find(e.patterns, e.patterns + e.pattern_count, 40) !=
+                           e.patterns + e.pattern_count) {
+            found_40 = true;
+        }
+    }
+    EXPECT_EQ(p.engine_execs, execs);
+    EXPECT_TRUE(found_40);
+
+    hs_profile_engine_t e;
+    EXPECT_EQ(HS_INVALID,
+              hs_scratch_profile_engine(db, scratch, p.engine_count, &e));
+    hs_profile_pattern_t pp;
+    EXPECT_EQ(HS_INVALID,
+              hs_scratch_profile_pattern(db, scratch, p.pattern_count, &pp));
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(Profile, StreamAccumulateAndReset) {
+    hs_database_t *db = buildProfileDB(HS_MODE_STREAM);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db, &scratch));
+
+    hs_stream_t *stream = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_open_stream(db, 0, &stream));
+    CallBackContext c;
+    for (size_t i = 0; i < profileData.size(); i += 7) {
+        size_t len = min<size_t>(7, profileData.size() - i);
+        ASSERT_EQ(HS_SUCCESS, hs_scan_stream(stream, profileData.c_str() + i,
+                                             len, 0, scratch, record_cb, &c));
+    }
+    ASSERT_EQ(HS_SUCCESS, hs_close_stream(stream, scratch, record_cb, &c));
+
+    hs_profile_t p;
+    ASSERT_EQ(HS_SUCCESS, hs_scratch_profile(db, scratch, &p));
+    EXPECT_EQ((profileData.size() + 6) / 7 + 1, p.scans);
+    EXPECT_EQ(profileData.size(), p.bytes);
+    EXPECT_EQ(c.matches.size(), p.matches);
+
+    ASSERT_EQ(HS_SUCCESS, hs_reset_scratch_profile(scratch));
+    ASSERT_EQ(HS_SUCCESS, hs_scratch_profile(db, scratch, &p));
+    EXPECT_EQ(0ULL, p.scans);
+    EXPECT_EQ(0ULL, p.bytes);
+    EXPECT_EQ(0ULL, p.cycles);
+    EXPECT_EQ(0ULL, p.matches);
+    EXPECT_EQ(0ULL, p.engine_execs);
+    for (unsigned i = 0; i < p.pattern_count; i++) {
+        hs_profile_pattern_t pp;
+        ASSERT_EQ(HS_SUCCESS, hs_scratch_profile_pattern(db, scratch, i, &pp));
+        EXPECT_EQ(0ULL, pp.matches);
+    }
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+TEST(Profile, BadArgs) {
+    hs_database_t *db = buildProfileDB(HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db, &scratch));
+
+    hs_profile_t p;
+    hs_profile_engine_t e;
+    hs_profile_pattern_t pp;
+    EXPECT_EQ(HS_INVALID, hs_scratch_profile(nullptr, scratch, &p));
+    EXPECT_EQ(HS_INVALID, hs_scratch_profile(db, nullptr, &p));
+    EXPECT_EQ(HS_INVALID, hs_scratch_profile(db, scratch, nullptr));
+    EXPECT_EQ(HS_INVALID, hs_scratch_profile_engine(db, scratch, 0, nullptr));
+    EXPECT_EQ(HS_INVALID, hs_scratch_profile_engine(nullptr, scratch, 0, &e));
+    EXPECT_EQ(HS_INVALID,
+              hs_scratch_profile_pattern(db, scratch, 0, nullptr));
+    EXPECT_EQ(HS_INVALID, hs_scratch_profile_pattern(db, nullptr, 0, &pp));
+    EXPECT_EQ(HS_INVALID, hs_reset_scratch_profile(nullptr));
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+#else // PROFILE_SUPPORT
+
+TEST(Profile, NotSupported) {
+    hs_database_t *db = buildProfileDB(HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, db);
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(db, &scratch));
+
+    hs_profile_t p;
+    hs_profile_engine_t e;
+    hs_profile_pattern_t pp;
+    EXPECT_EQ(HS_INVALID, hs_scratch_profile(db, scratch, &p));
+    EXPECT_EQ(HS_INVALID, hs_scratch_profile_engine(db, scratch, 0, &e));
+    EXPECT_EQ(HS_INVALID, hs_scratch_profile_pattern(db, scratch, 0, &pp));
+    EXPECT_EQ(HS_INVALID, hs_reset_scratch_profile(scratch));
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+#endif // PROFILE_SUPPORT
@@ -30,6 +30,7 @@
 
 #include <stdlib.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -291,4 +292,178 @@ TEST(scratch, damagedScratch) {
     hs_free_database(db);
 }
 
+TEST(scratch, poolReusesScratch) {
+    hs_database_t *db = buildDB("foobar", 0, 0, HS_MODE_BLOCK, nullptr);
+    ASSERT_NE(nullptr, db);
+
+    hs_scratch_pool_t *pool = nullptr;
+    hs_error_t err = hs_alloc_scratch_pool(db, 4, &pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_NE(nullptr, pool);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_scratch_pool_acquire(pool, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_NE(nullptr, scratch);
+
+    CallBackContext c;
+    err = hs_scan(db, "xfoobarx", 8, 0, scratch, record_cb, &c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+
+    // Pooled scratch belongs to the pool.
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_INVALID, err);
+    err = hs_free_scratch_pool(pool);
+    ASSERT_EQ(HS_SCRATCH_IN_USE, err);
+
+    err = hs_scratch_pool_release(pool, scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scratch_pool_release(pool, scratch);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // The same thread gets the same scratch back.
+    hs_scratch_t *scratch2 = nullptr;
+    err = hs_scratch_pool_acquire(pool, &scratch2);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(scratch, scratch2);
+    err = hs_scratch_pool_release(pool, scratch2);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_free_scratch_pool(pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(scratch, poolExhausted) {
+    hs_database_t *db = buildDB("foobar", 0, 0, HS_MODE_BLOCK, nullptr);
+    ASSERT_NE(nullptr, db);
+
+    allocated_count = 0;
+    hs_error_t err = hs_set_scratch_allocator(count_malloc, count_free);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_scratch_pool_t *pool = nullptr;
+    err = hs_alloc_scratch_pool(db, 1, &pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_scratch_t *s1 = nullptr;
+    hs_scratch_t *s2 = nullptr;
+    err = hs_scratch_pool_acquire(pool, &s1);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scratch_pool_acquire(pool, &s2);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_NE(s1, s2);
+
+    err = hs_scan(db, "foobar", 6, 0, s2, dummy_cb, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_scratch_pool_release(pool, s2);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scratch_pool_release(pool, s1);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    err = hs_free_scratch_pool(pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(0, allocated_count);
+
+    hs_set_scratch_allocator(nullptr, nullptr);
+    hs_free_database(db);
+}
+
+TEST(scratch, poolGrows) {
+    hs_database_t *db1 = buildDB("foobar", 0, 0, HS_MODE_BLOCK, nullptr);
+    ASSERT_NE(nullptr, db1);
+    hs_database_t *db2 =
+        buildDB("(a.?b.?c.?d.?e.?f.?g)|(hatstand(..)+teakettle)", 0, 0,
+                HS_MODE_BLOCK, nullptr);
+    ASSERT_NE(nullptr, db2);
+
+    hs_scratch_pool_t *pool = nullptr;
+    hs_error_t err = hs_alloc_scratch_pool(db1, 2, &pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_scratch_t *held = nullptr;
+    err = hs_scratch_pool_acquire(pool, &held);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan(db2, "somedata", 8, 0, held, dummy_cb, nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+
+    // Growing the pool leaves scratch already handed out alone.
+    err = hs_scratch_pool_add_database(pool, db2);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan(db1, "foobar", 6, 0, held, dummy_cb, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scratch_pool_release(pool, held);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // Adding a database that fits is a no-op.
+    err = hs_scratch_pool_add_database(pool, db1);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    for (int i = 0; i < 3; i++) {
+        hs_scratch_t *scratch = nullptr;
+        err = hs_scratch_pool_acquire(pool, &scratch);
+        ASSERT_EQ(HS_SUCCESS, err);
+        err = hs_scan(db1, "foobar", 6, 0, scratch, dummy_cb, nullptr);
+        ASSERT_EQ(HS_SUCCESS, err);
+        err = hs_scan(db2, "somedata", 8, 0, scratch, dummy_cb, nullptr);
+        ASSERT_EQ(HS_SUCCESS, err);
+        err = hs_scratch_pool_release(pool, scratch);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+
+    err = hs_free_scratch_pool(pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db1);
+    hs_free_database(db2);
+}
+
+TEST(scratch, poolThreads) {
+    hs_database_t *db1 = buildDB("foo.*bar", 0, 0, HS_MODE_BLOCK, nullptr);
+    ASSERT_NE(nullptr, db1);
+    hs_database_t *db2 =
+        buildDB("(a.?b.?c.?d.?e.?f.?g)|(hatstand(..)+teakettle)", 0, 0,
+                HS_MODE_BLOCK, nullptr);
+    ASSERT_NE(nullptr, db2);
+
+    hs_scratch_pool_t *pool = nullptr;
+    hs_error_t err = hs_alloc_scratch_pool(db1, 2, &pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    const unsigned int num_threads = 4;
+    const unsigned int num_scans = 200;
+    vector<unsigned int> failures(num_threads, 0);
+    vector<thread> threads;
+    for (unsigned int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+            for (unsigned int i = 0; i < num_scans; i++) {
+                hs_scratch_t *scratch = nullptr;
+                if (hs_scratch_pool_acquire(pool, &scratch) != HS_SUCCESS ||
+                    hs_scan(db1, "foo bar", 7, 0, scratch, dummy_cb,
+                            nullptr) != HS_SUCCESS ||
+                    hs_scratch_pool_release(pool, scratch) != HS_SUCCESS) {
+                    failures[t]++;
+                }
+            }
+        });
+    }
+
+    // Grow the pool while the threads are scanning.
+    err = hs_scratch_pool_add_database(pool, db2);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    for (auto &th : threads) {
+        th.join();
+    }
+    for (unsigned int t = 0; t < num_threads; t++) {
+        EXPECT_EQ(0U, failures[t]);
+    }
+
+    err = hs_free_scratch_pool(pool);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db1);
+    hs_free_database(db2);
+}
+
 } // namespace
@@ -35,6 +35,10 @@
 #include <string>
 #include <vector>
 
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
 #include "gtest/gtest.h"
 #include "hs.h"
 #include "hs_internal.h"
@@ -217,6 +221,230 @@ TEST_P(Serializep, DeserializeAtFromAnyAlignment) {
     delete[] mem;
 }
 
+static
+string compileAndSerialize(const vector<pattern> &patterns, unsigned mode,
+                           hs_compile_cache_t *cache = nullptr) {
+    hs_database_t *db = nullptr;
+    if (cache) {
+        vector<const char *> exprs;
+        vector<unsigned> flags, ids;
+        for (const auto &p : patterns) {
+            exprs.push_back(p.expression.c_str());
+            flags.push_back(p.flags);
+            ids.push_back(p.id);
+        }
+        hs_compile_error_t *compile_err = nullptr;
+        hs_error_t err = hs_compile_ext_multi_cached(
+            exprs.data(), flags.data(), ids.data(), nullptr, patterns.size(),
+            mode, nullptr, cache, &db, &compile_err);
+        if (err != HS_SUCCESS) {
+            hs_free_compile_error(compile_err);
+            return string();
+        }
+    } else {
+        db = buildDB(patterns, mode);
+    }
+    if (!db) {
+        return string();
+    }
+
+    char *bytes = nullptr;
+    size_t bytes_len = 0;
+    hs_error_t err = hs_serialize_database(db, &bytes, &bytes_len);
+    hs_free_database(db);
+    if (err != HS_SUCCESS) {
+        return string();
+    }
+
+    string rv(bytes, bytes_len);
+    free(bytes);
+    return rv;
+}
+
+// A mixture of patterns that produce outfixes, prefixes, infixes, suffixes and
+// anchored DFAs.
+static
+vector<pattern> makeEngineMix(unsigned count) {
+    vector<pattern> patterns;
+    for (unsigned i = 0; i < count; i++) {
+        string n = to_string(i);
+        patterns.emplace_back("lit" + n + "[a-z]{" + to_string(i + 3) + "," +
+                                  to_string(i + 10) + "}end" + n,
+                              0, 4 * i);
+        patterns.emplace_back("^start" + n + ".*x[0-9]{" + to_string(i + 1) +
+                                  "}y",
+                              0, 4 * i + 1);
+        patterns.emplace_back("[a-c]{" + to_string(i + 2) + "}mid" + n +
+                                  ".*tail",
+                              0, 4 * i + 2);
+        patterns.emplace_back("q[^r]*r" + n + "s+t", 0, 4 * i + 3);
+    }
+    return patterns;
+}
+
+// Check that a multi-threaded compile produces the same bytecode as a serial
+// one.
+TEST_P(Serializep, CompileThreadsIdentical) {
+    const unsigned mode = GetParam();
+    SCOPED_TRACE(mode);
+
+    const vector<pattern> patterns = makeEngineMix(20);
+
+    hs_set_compile_threads(1);
+    const string serial = compileAndSerialize(patterns, mode);
+    ASSERT_FALSE(serial.empty());
+
+    hs_set_compile_threads(4);
+    const string parallel = compileAndSerialize(patterns, mode);
+
+    hs_set_compile_threads(0);
+    const string automatic = compileAndSerialize(patterns, mode);
+
+    hs_set_compile_threads(1);
+
+    ASSERT_FALSE(parallel.empty());
+    ASSERT_FALSE(automatic.empty());
+    EXPECT_TRUE(serial == parallel);
+    EXPECT_TRUE(serial == automatic);
+}
+
+// Check that compiles using a compile cache produce the same bytecode as
+// uncached compiles as the pattern set changes.
+TEST_P(Serializep, CompileCacheIdentical) {
+    const unsigned mode = GetParam();
+    SCOPED_TRACE(mode);
+
+    hs_compile_cache_t *cache = nullptr;
+    hs_error_t err = hs_alloc_compile_cache(&cache);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(cache != nullptr);
+
+    vector<pattern> patterns = makeEngineMix(10);
+
+    // First compile populates the cache, the second is served from it.
+    for (unsigned i = 0; i < 2; i++) {
+        SCOPED_TRACE(i);
+        const string expected = compileAndSerialize(patterns, mode);
+        ASSERT_FALSE(expected.empty());
+        EXPECT_TRUE(expected == compileAndSerialize(patterns, mode, cache));
+    }
+
+    // Add patterns.
+    vector<pattern> more = makeEngineMix(12);
+    const string expected_more = compileAndSerialize(more, mode);
+    ASSERT_FALSE(expected_more.empty());
+    EXPECT_TRUE(expected_more == compileAndSerialize(more, mode, cache));
+
+    // Remove some from the front, which shifts the IDs of everything else.
+    more.erase(more.begin(), more.begin() + 3);
+    const string expected_fewer = compileAndSerialize(more, mode);
+    ASSERT_FALSE(expected_fewer.empty());
+    EXPECT_TRUE(expected_fewer == compileAndSerialize(more, mode, cache));
+
+    // And back to the original set.
+    const string expected = compileAndSerialize(patterns, mode);
+    EXPECT_TRUE(expected == compileAndSerialize(patterns, mode, cache));
+
+    hs_free_compile_cache(cache);
+}
+
+#if !defined(_WIN32)
+// Check that a database image can be loaded and scanned in place from a
+// read-only page-aligned mapping, and that it serializes back to the original.
+TEST_P(Serializep, LoadImageInPlace) {
+    const unsigned mode = GetParam();
+    SCOPED_TRACE(mode);
+
+    hs_error_t err;
+    hs_database_t *db = buildDB("hatstand.*teakettle.*badgerbrush",
+                                HS_FLAG_CASELESS, 1000, mode);
+    ASSERT_TRUE(db != nullptr) << "database build failed.";
+
+    char *original_info = nullptr;
+    err = hs_database_info(db, &original_info);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char *original_bytes = nullptr;
+    size_t original_length = 0;
+    err = hs_serialize_database(db, &original_bytes, &original_length);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char *bytes = nullptr;
+    size_t length = 0;
+    err = hs_serialize_database_image(db, &bytes, &length);
+    ASSERT_EQ(HS_SUCCESS, err) << "image serialize failed.";
+    ASSERT_NE(nullptr, bytes);
+    ASSERT_LT(0U, length);
+
+    hs_free_database(db);
+
+    // Copy the image into a fresh mapping and make it read-only.
+    void *map = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(MAP_FAILED, map);
+    memcpy(map, bytes, length);
+    free(bytes);
+    ASSERT_EQ(0, mprotect(map, length, PROT_READ));
+
+    const hs_database_t *image = nullptr;
+    err = hs_load_database_image((const char *)map, length, &image);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(map, (const void *)image);
+
+    char *info = nullptr;
+    err = hs_database_info(image, &info);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_STREQ(original_info, info);
+    free(info);
+    free(original_info);
+
+    size_t image_size = 0;
+    err = hs_database_size(image, &image_size);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(length, image_size);
+
+    // The image is not ours to free.
+    err = hs_free_database(const_cast<hs_database_t *>(image));
+    EXPECT_EQ(HS_INVALID, err);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(image, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    const string data("hatstand teakettle badgerbrush");
+    CallBackContext c;
+    if (mode == HS_MODE_STREAM) {
+        hs_stream_t *stream = nullptr;
+        err = hs_open_stream(image, 0, &stream);
+        ASSERT_EQ(HS_SUCCESS, err);
+        err = hs_scan_stream(stream, data.c_str(), data.size(), 0, scratch,
+                             record_cb, &c);
+        ASSERT_EQ(HS_SUCCESS, err);
+        err = hs_close_stream(stream, scratch, record_cb, &c);
+        ASSERT_EQ(HS_SUCCESS, err);
+    } else {
+        err = hs_scan(image, data.c_str(), data.size(), 0, scratch, record_cb,
+                      &c);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+    ASSERT_EQ(1U, c.matches.size());
+    EXPECT_EQ(MatchRecord(data.size(), 1000), c.matches[0]);
+    hs_free_scratch(scratch);
+
+    // Serializing the loaded image gives back the original serialization.
+    char *round_bytes = nullptr;
+    size_t round_length = 0;
+    err = hs_serialize_database(image, &round_bytes, &round_length);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(original_length, round_length);
+    EXPECT_EQ(0, memcmp(original_bytes, round_bytes, round_length));
+    free(round_bytes);
+    free(original_bytes);
+
+    munmap(map, length);
+}
+#endif
+
 INSTANTIATE_TEST_CASE_P(Serialize, Serializep,
                         ValuesIn(validModes));
 
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include "gtest/gtest.h"
+#include "test_util.h"
+#include "hs.h"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+static const char *const shardExprs[] = {
+    "foobar",
+    "foo.*bar",
+    "hatstand",
+    "teakettle",
+    "badger[a-z]+",
+    "abc[0-9]{2,4}def",
+    "xyz",
+    "quux.{3}zip",
+    "zebra",
+    "mongoose",
+    "[0-9]{5}",
+    "ferret.*weasel",
+};
+
+static const unsigned numShardExprs =
+    sizeof(shardExprs) / sizeof(shardExprs[0]);
+
+static const string shardCorpus =
+    "foobar hatstand badgerbrush abc123def xyz quux123zip 98765 zebra "
+    "ferret and weasel teakettle foo then bar mongoose xyzzy abc1234def";
+
+bool byEnd(const MatchRecord &a, const MatchRecord &b) {
+    return tie(a.to, a.id) < tie(b.to, b.id);
+}
+
+// Builds the test pattern set as shards, checking that the compile worked.
+vector<hs_database_t *> buildShards(unsigned mode, unsigned max_shards) {
+    vector<unsigned> flags(numShardExprs, 0);
+    vector<unsigned> ids(numShardExprs);
+    for (unsigned i = 0; i < numShardExprs; i++) {
+        ids[i] = i + 1;
+    }
+
+    vector<hs_database_t *> dbs(max_shards, nullptr);
+    unsigned shards = 0;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_sharded(
+        shardExprs, flags.data(), ids.data(), nullptr, numShardExprs, mode,
+        nullptr, max_shards, dbs.data(), &shards, &compile_err);
+    EXPECT_EQ(HS_SUCCESS, err);
+    EXPECT_EQ(nullptr, compile_err);
+    hs_free_compile_error(compile_err);
+    EXPECT_LE(1U, shards);
+    EXPECT_GE(max_shards, shards);
+    for (unsigned i = shards; i < max_shards; i++) {
+        EXPECT_EQ(nullptr, dbs[i]);
+    }
+    dbs.resize(shards);
+    return dbs;
+}
+
+hs_database_t *buildWhole(unsigned mode) {
+    vector<pattern> patterns;
+    for (unsigned i = 0; i < numShardExprs; i++) {
+        patterns.emplace_back(shardExprs[i], 0, i + 1);
+    }
+    return buildDB(patterns, mode);
+}
+
+void freeShards(vector<hs_database_t *> &dbs) {
+    for (auto *db : dbs) {
+        hs_free_database(db);
+    }
+    dbs.clear();
+}
+
+int haltOnFirst(unsigned id, unsigned long long from, unsigned long long to,
+                unsigned flags, void *ctxt) {
+    record_cb(id, from, to, flags, ctxt);
+    return 1;
+}
+
+class ShardScan : public testing::TestWithParam<unsigned> {};
+
+} // namespace
+
+// Sharded block scans find the same matches as a single database, in end
+// offset order.
+TEST_P(ShardScan, BlockMatchesWhole) {
+    const unsigned max_shards = GetParam();
+
+    hs_database_t *whole = buildWhole(HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, whole);
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(whole, &scratch));
+    CallBackContext expected;
+    hs_error_t err = hs_scan(whole, shardCorpus.c_str(), shardCorpus.size(),
+                             0, scratch, record_cb, &expected);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_scratch(scratch);
+    hs_free_database(whole);
+    ASSERT_FALSE(expected.matches.empty());
+
+    vector<hs_database_t *> dbs = buildShards(HS_MODE_BLOCK, max_shards);
+    ASSERT_FALSE(dbs.empty());
+
+    hs_shard_scanner_t *scanner = nullptr;
+    err = hs_alloc_shard_scanner(dbs.data(), dbs.size(), &scanner);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_NE(nullptr, scanner);
+
+    // Run a few times to exercise reuse of the worker threads.
+    for (unsigned i = 0; i < 3; i++) {
+        CallBackContext c;
+        err = hs_scan_sharded(scanner, shardCorpus.c_str(), shardCorpus.size(),
+                              0, record_cb, &c);
+        ASSERT_EQ(HS_SUCCESS, err);
+        ASSERT_TRUE(is_sorted(c.matches.begin(), c.matches.end(),
+                              [](const MatchRecord &a, const MatchRecord &b) {
+                                  return a.to < b.to;
+                              }));
+
+        vector<MatchRecord> got = c.matches;
+        vector<MatchRecord> want = expected.matches;
+        sort(got.begin(), got.end(), byEnd);
+        sort(want.begin(), want.end(), byEnd);
+        ASSERT_EQ(want, got);
+    }
+
+    // A null callback scans without reporting anything.
+    err = hs_scan_sharded(scanner, shardCorpus.c_str(), shardCorpus.size(), 0,
+                          nullptr, nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    hs_free_shard_scanner(scanner);
+    freeShards(dbs);
+}
+
+// Sharded streams find the same matches as a single database across writes.
+TEST_P(ShardScan, StreamMatchesWhole) {
+    const unsigned max_shards = GetParam();
+
+    hs_database_t *whole = buildWhole(HS_MODE_STREAM);
+    ASSERT_NE(nullptr, whole);
+    hs_scratch_t *scratch = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_scratch(whole, &scratch));
+
+    vector<hs_database_t *> dbs = buildShards(HS_MODE_STREAM, max_shards);
+    ASSERT_FALSE(dbs.empty());
+    hs_shard_scanner_t *scanner = nullptr;
+    ASSERT_EQ(HS_SUCCESS,
+              hs_alloc_shard_scanner(dbs.data(), dbs.size(), &scanner));
+
+    hs_stream_t *stream = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_open_stream(whole, 0, &stream));
+    hs_shard_stream_t *sstream = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_open_stream_sharded(scanner, 0, &sstream));
+    ASSERT_NE(nullptr, sstream);
+
+    CallBackContext expected;
+    CallBackContext c;
+    const size_t block = 7;
+    for (size_t i = 0; i < shardCorpus.size(); i += block) {
+        const size_t len = min(block, shardCorpus.size() - i);
+        hs_error_t err = hs_scan_stream(stream, shardCorpus.c_str() + i, len,
+                                        0, scratch, record_cb, &expected);
+        ASSERT_EQ(HS_SUCCESS, err);
+        err = hs_scan_stream_sharded(sstream, shardCorpus.c_str() + i, len, 0,
+                                     record_cb, &c);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+    ASSERT_EQ(HS_SUCCESS, hs_close_stream(stream, scratch, record_cb,
+                                          &expected));
+    ASSERT_EQ(HS_SUCCESS, hs_close_stream_sharded(sstream, record_cb, &c));
+
+    ASSERT_FALSE(expected.matches.empty());
+    vector<MatchRecord> got = c.matches;
+    vector<MatchRecord> want = expected.matches;
+    sort(got.begin(), got.end(), byEnd);
+    sort(want.begin(), want.end(), byEnd);
+    ASSERT_EQ(want, got);
+
+    hs_free_shard_scanner(scanner);
+    freeShards(dbs);
+    hs_free_scratch(scratch);
+    hs_free_database(whole);
+}
+
+// Termination by the callback stops delivery, and ends a sharded stream.
+TEST_P(ShardScan, Terminate) {
+    const unsigned max_shards = GetParam();
+
+    vector<hs_database_t *> dbs = buildShards(HS_MODE_STREAM, max_shards);
+    ASSERT_FALSE(dbs.empty());
+    hs_shard_scanner_t *scanner = nullptr;
+    ASSERT_EQ(HS_SUCCESS,
+              hs_alloc_shard_scanner(dbs.data(), dbs.size(), &scanner));
+
+    hs_shard_stream_t *sstream = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_open_stream_sharded(scanner, 0, &sstream));
+
+    CallBackContext c;
+    hs_error_t err = hs_scan_stream_sharded(sstream, shardCorpus.c_str(),
+                                            shardCorpus.size(), 0, haltOnFirst,
+                                            &c);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    ASSERT_EQ(1U, c.matches.size());
+    EXPECT_EQ(6U, c.matches[0].to); // "foobar" ends first
+
+    err = hs_scan_stream_sharded(sstream, shardCorpus.c_str(),
+                                 shardCorpus.size(), 0, record_cb, &c);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    ASSERT_EQ(1U, c.matches.size());
+
+    ASSERT_EQ(HS_SUCCESS, hs_close_stream_sharded(sstream, record_cb, &c));
+    ASSERT_EQ(1U, c.matches.size());
+
+    hs_free_shard_scanner(scanner);
+    freeShards(dbs);
+}
+
+INSTANTIATE_TEST_CASE_P(Shard, ShardScan, testing::Values(1, 2, 3, 8));
+
+// A logical combination is always compiled with its sub-expressions.
+TEST(Shard, CombinationKeptTogether) {
+    const char *exprs[] = {"alpha", "beta", "gamma", "delta", "epsilon",
+                           "zeta", "101 & 104", "102 | 105"};
+    unsigned flags[] = {0, 0, 0, 0, 0, 0, HS_FLAG_COMBINATION,
+                        HS_FLAG_COMBINATION};
+    unsigned ids[] = {101, 102, 103, 104, 105, 106, 1, 2};
+    const unsigned count = sizeof(exprs) / sizeof(exprs[0]);
+
+    const unsigned max_shards = 4;
+    hs_database_t *dbs[max_shards];
+    unsigned shards = 0;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_sharded(
+        exprs, flags, ids, nullptr, count, HS_MODE_BLOCK, nullptr, max_shards,
+        dbs, &shards, &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_LE(2U, shards); // gamma and zeta stand alone
+
+    hs_shard_scanner_t *scanner = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_shard_scanner(dbs, shards, &scanner));
+
+    const string data = "alpha delta epsilon";
+    CallBackContext c;
+    err = hs_scan_sharded(scanner, data.c_str(), data.size(), 0, record_cb,
+                          &c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    EXPECT_NE(c.matches.end(),
+              find(c.matches.begin(), c.matches.end(), MatchRecord(11, 1)));
+    EXPECT_NE(c.matches.end(),
+              find(c.matches.begin(), c.matches.end(), MatchRecord(19, 2)));
+
+    hs_free_shard_scanner(scanner);
+    for (unsigned i = 0; i < shards; i++) {
+        hs_free_database(dbs[i]);
+    }
+}
+
+// Expressions sharing an ID are compiled together, so HS_FLAG_SINGLEMATCH
+// still reports that ID only once, even when there are enough shards to split
+// them up.
+TEST(Shard, SingleMatchSharedId) {
+    const char *exprs[] = {"foo", "bar"};
+    unsigned flags[] = {HS_FLAG_SINGLEMATCH, HS_FLAG_SINGLEMATCH};
+    unsigned ids[] = {7, 7};
+    const unsigned count = sizeof(exprs) / sizeof(exprs[0]);
+
+    const unsigned max_shards = 2;
+    hs_database_t *dbs[max_shards];
+    unsigned shards = 0;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_sharded(
+        exprs, flags, ids, nullptr, count, HS_MODE_BLOCK, nullptr, max_shards,
+        dbs, &shards, &compile_err);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, shards);
+
+    hs_shard_scanner_t *scanner = nullptr;
+    ASSERT_EQ(HS_SUCCESS, hs_alloc_shard_scanner(dbs, shards, &scanner));
+
+    const string data = "foo bar foo bar";
+    CallBackContext c;
+    err = hs_scan_sharded(scanner, data.c_str(), data.size(), 0, record_cb,
+                          &c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    EXPECT_EQ(7U, c.matches[0].id);
+
+    hs_free_shard_scanner(scanner);
+    for (unsigned i = 0; i < shards; i++) {
+        hs_free_database(dbs[i]);
+    }
+}
+
+// A NULL expression is reported as a compile error, not dereferenced.
+TEST(Shard, NullExpression) {
+    const char *exprs[] = {"alpha", nullptr, "gamma"};
+    unsigned ids[] = {1, 2, 3};
+    const unsigned count = sizeof(exprs) / sizeof(exprs[0]);
+
+    const unsigned max_shards = 2;
+    hs_database_t *dbs[max_shards];
+    unsigned shards = 0;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_sharded(
+        exprs, nullptr, ids, nullptr, count, HS_MODE_BLOCK, nullptr,
+        max_shards, dbs, &shards, &compile_err);
+    ASSERT_EQ(HS_COMPILER_ERROR, err);
+    ASSERT_NE(nullptr, compile_err);
+    EXPECT_EQ(1, compile_err->expression);
+    for (unsigned i = 0; i < max_shards; i++) {
+        EXPECT_EQ(nullptr, dbs[i]);
+    }
+    hs_free_compile_error(compile_err);
+}
+
+// Compile errors identify the expression in the caller's array.
+TEST(Shard, CompileErrorIndex) {
+    const char *exprs[] = {"alpha", "beta", "gamma", "delta", "a*", "zeta"};
+    const unsigned count = sizeof(exprs) / sizeof(exprs[0]);
+
+    const unsigned max_shards = 3;
+    hs_database_t *dbs[max_shards];
+    unsigned shards = 0;
+    hs_compile_error_t *compile_err = nullptr;
+    hs_error_t err = hs_compile_ext_multi_sharded(
+        exprs, nullptr, nullptr, nullptr, count, HS_MODE_BLOCK, nullptr,
+        max_shards, dbs, &shards, &compile_err);
+    ASSERT_EQ(HS_COMPILER_ERROR, err);
+    ASSERT_NE(nullptr, compile_err);
+    EXPECT_EQ(4, compile_err->expression);
+    for (unsigned i = 0; i < max_shards; i++) {
+        EXPECT_EQ(nullptr, dbs[i]);
+    }
+    hs_free_compile_error(compile_err);
+}
@@ -364,6 +364,7 @@ static const unsigned validModes[] = {
 static const unsigned long long featureMask[] = {
     ~0ULL, /* native */
     ~HS_CPU_FEATURES_AVX2, /* no avx2 */
+    ~HS_CPU_FEATURES_AVX512, /* no avx512 */
 };
 
 INSTANTIATE_TEST_CASE_P(Single,
@@ -434,6 +435,7 @@ TEST_P(HyperscanTestCrossCompile, Build) {
 static const TestPlatform validPlatforms[] = {
     TestPlatform(0),
     TestPlatform(HS_CPU_FEATURES_AVX2),
+    TestPlatform(HS_CPU_FEATURES_AVX512),
 };
 
 INSTANTIATE_TEST_CASE_P(Single,
@@ -534,6 +534,241 @@ TEST(StreamUtil, copy_reset_matches) {
     hs_free_database(db);
 }
 
+TEST(StreamUtil, compress_expand1) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    hs_stream_t *stream2 = nullptr;
+
+    CallBackContext c;
+
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream != nullptr);
+
+    err = hs_scan_stream(stream, data1, sizeof(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(9, 0), c.matches[0]);
+
+    c.matches.clear();
+
+    // Query the required space first.
+    size_t used = 0;
+    err = hs_compress_stream(stream, nullptr, 0, &used);
+    ASSERT_EQ(HS_INSUFFICIENT_SPACE, err);
+    ASSERT_LT(0U, used);
+
+    size_t stream_size;
+    err = hs_stream_size(db, &stream_size);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_GT(stream_size, used);
+
+    vector<char> buf(used);
+    size_t used2 = 0;
+    err = hs_compress_stream(stream, buf.data(), buf.size() - 1, &used2);
+    ASSERT_EQ(HS_INSUFFICIENT_SPACE, err);
+    ASSERT_EQ(used, used2);
+
+    err = hs_compress_stream(stream, buf.data(), buf.size(), &used2);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(used, used2);
+
+    err = hs_expand_stream(db, &stream2, buf.data(), buf.size());
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_TRUE(stream2 != nullptr);
+
+    err = hs_scan_stream(stream, data1, sizeof(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(2U, c.matches.size());
+    ASSERT_EQ(MatchRecord(13, 0), c.matches[0]);
+    ASSERT_EQ(MatchRecord(19, 0), c.matches[1]);
+
+    c.matches.clear();
+
+    err = hs_scan_stream(stream2, data1, sizeof(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(2U, c.matches.size());
+    ASSERT_EQ(MatchRecord(13, 0), c.matches[0]);
+    ASSERT_EQ(MatchRecord(19, 0), c.matches[1]);
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    hs_close_stream(stream2, scratch, nullptr, nullptr);
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+// Compress a stream part-way through a scan, expand it and check that the
+// expanded stream carries on exactly as the original does.
+TEST(StreamUtil, compress_expand2) {
+    hs_error_t err;
+    vector<pattern> patterns;
+    patterns.push_back(pattern("foo.*bar", 0, 1));
+    patterns.push_back(pattern("abc[^x]{5,10}def", 0, 2));
+    patterns.push_back(pattern("(abc|xyz)+ghi", 0, 3));
+    patterns.push_back(pattern("q[0-9]{3,}z", 0, 4));
+    patterns.push_back(pattern("hatstand.*teakettle$", 0, 5));
+    patterns.push_back(pattern("f.o.o.b.a.r", HS_FLAG_SOM_LEFTMOST, 6));
+    patterns.push_back(pattern("^abc", HS_FLAG_SINGLEMATCH, 7));
+    hs_database_t *db = buildDB(patterns,
+                                HS_MODE_STREAM | HS_MODE_SOM_HORIZON_LARGE);
+    ASSERT_TRUE(db != nullptr);
+
+    hs_scratch_t *scratch = nullptr;
+    err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    const string data = "abcfoo abc12345defxyzabcxyzghi q0123456789z "
+                        "f_o_o_b_a_r hatstand barbarbar teakettle";
+
+    for (size_t split = 0; split <= data.size(); split++) {
+        hs_stream_t *stream = nullptr;
+        hs_stream_t *stream2 = nullptr;
+        CallBackContext c, c2;
+
+        err = hs_open_stream(db, 0, &stream);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        err = hs_scan_stream(stream, data.c_str(), split, 0, scratch,
+                             record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        size_t used = 0;
+        err = hs_compress_stream(stream, nullptr, 0, &used);
+        ASSERT_EQ(HS_INSUFFICIENT_SPACE, err);
+        vector<char> buf(used);
+        err = hs_compress_stream(stream, buf.data(), buf.size(), &used);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        err = hs_expand_stream(db, &stream2, buf.data(), buf.size());
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        c2.matches = c.matches;
+        err = hs_scan_stream(stream, data.c_str() + split, data.size() - split,
+                             0, scratch, record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+        err = hs_close_stream(stream, scratch, record_cb, (void *)&c);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        err = hs_scan_stream(stream2, data.c_str() + split,
+                             data.size() - split, 0, scratch, record_cb,
+                             (void *)&c2);
+        ASSERT_EQ(HS_SUCCESS, err);
+        err = hs_close_stream(stream2, scratch, record_cb, (void *)&c2);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        ASSERT_EQ(9U, c.matches.size());
+        ASSERT_EQ(c.matches, c2.matches) << "split at " << split;
+    }
+
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, reset_and_expand) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar$", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    hs_stream_t *stream2 = nullptr;
+
+    CallBackContext c;
+
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_open_stream(db, 0, &stream2);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // "foo" seen on the first stream only.
+    err = hs_scan_stream(stream, "xfoo", 4, 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // The second stream would match at EOD.
+    err = hs_scan_stream(stream2, data1, strlen(data1), 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(0U, c.matches.size());
+
+    char buf[1024];
+    size_t used = 0;
+    err = hs_compress_stream(stream, buf, sizeof(buf), &used);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // Expanding on top of the second stream reports its EOD match.
+    err = hs_reset_and_expand_stream(stream2, buf, used, scratch, record_cb,
+                                     (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(9, 0), c.matches[0]);
+
+    c.matches.clear();
+    err = hs_scan_stream(stream2, "bar", 3, 0, scratch, record_cb,
+                         (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_close_stream(stream2, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(1U, c.matches.size());
+    ASSERT_EQ(MatchRecord(7, 0), c.matches[0]);
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
+TEST(StreamUtil, expand_bad_buffer) {
+    hs_error_t err;
+    hs_scratch_t *scratch = nullptr;
+    hs_database_t *db = buildDBAndScratch("foo.*bar", 0, 0, HS_MODE_STREAM,
+                                          &scratch);
+
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan_stream(stream, data1, strlen(data1), 0, scratch, dummy_cb,
+                         nullptr);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    char buf[1024];
+    size_t used = 0;
+    err = hs_compress_stream(stream, buf, sizeof(buf), &used);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    // Truncated and over-long buffers are both rejected.
+    hs_stream_t *stream2 = nullptr;
+    err = hs_expand_stream(db, &stream2, buf, used - 1);
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_TRUE(stream2 == nullptr);
+    err = hs_expand_stream(db, &stream2, buf, used + 1);
+    ASSERT_EQ(HS_INVALID, err);
+    ASSERT_TRUE(stream2 == nullptr);
+
+    // A failed reset-and-expand leaves a freshly opened stream.
+    err = hs_reset_and_expand_stream(stream, buf, used - 1, nullptr, nullptr,
+                                     nullptr);
+    ASSERT_EQ(HS_INVALID, err);
+    CallBackContext c;
+    err = hs_scan_stream(stream, "bar", 3, 0, scratch, record_cb, (void *)&c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    ASSERT_EQ(0U, c.matches.size());
+
+    hs_close_stream(stream, scratch, nullptr, nullptr);
+    err = hs_free_scratch(scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_database(db);
+}
+
 static size_t last_alloc;
 
 static
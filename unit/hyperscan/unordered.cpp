@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "config.h"
+
+#include "gtest/gtest.h"
+#include "test_util.h"
+#include "hs.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// A mix of pure literals, literals with suffix engines and outfixes, so that
+// matches come from the literal matcher and from engines running behind it.
+static const vector<pattern> unorderedPatterns = {
+    pattern("foobar", 0, 1),
+    pattern("foo[^X]*bar", HS_FLAG_DOTALL, 2),
+    pattern("abc[0-9]{2,10}def", 0, 3),
+    pattern("[a-f]{3}[0-9]+x", 0, 4),
+    pattern("(ab|cd)e*f.{3,30}bar", HS_FLAG_DOTALL, 5),
+    pattern("^[^\\n]*baz", 0, 6),
+    pattern("x[yz]{4}", 0, 7),
+};
+
+static const string unorderedCorpus =
+    "xxfoobar abc1234def foo..bar abcdeff012x cdeeeef-----bar xyzyzq "
+    "baz abc12def foofoobarbar xzzzzz aaa9x";
+
+typedef set<pair<unsigned long long, unsigned>> MatchSet;
+
+MatchSet toSet(const CallBackContext &c) {
+    MatchSet rv;
+    for (const auto &m : c.matches) {
+        rv.emplace(m.to, m.id);
+    }
+    return rv;
+}
+
+void scanBlock(hs_database_t *db, const string &data, CallBackContext &c) {
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    err = hs_scan(db, data.c_str(), data.size(), 0, scratch, record_cb, &c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_scratch(scratch);
+}
+
+void scanStream(hs_database_t *db, const string &data, size_t chunk,
+                CallBackContext &c) {
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_stream_t *stream = nullptr;
+    err = hs_open_stream(db, 0, &stream);
+    ASSERT_EQ(HS_SUCCESS, err);
+    for (size_t i = 0; i < data.size(); i += chunk) {
+        size_t len = min(chunk, data.size() - i);
+        err = hs_scan_stream(stream, data.c_str() + i, len, 0, scratch,
+                             record_cb, &c);
+        ASSERT_EQ(HS_SUCCESS, err);
+    }
+    err = hs_close_stream(stream, scratch, record_cb, &c);
+    ASSERT_EQ(HS_SUCCESS, err);
+    hs_free_scratch(scratch);
+}
+
+} // namespace
+
+TEST(Unordered, BlockSameMatches) {
+    hs_database_t *ordered = buildDB(unorderedPatterns, HS_MODE_BLOCK);
+    ASSERT_NE(nullptr, ordered);
+    hs_database_t *unordered =
+        buildDB(unorderedPatterns, HS_MODE_BLOCK | HS_MODE_UNORDERED);
+    ASSERT_NE(nullptr, unordered);
+
+    CallBackContext c1, c2;
+    scanBlock(ordered, unorderedCorpus, c1);
+    scanBlock(unordered, unorderedCorpus, c2);
+    ASSERT_FALSE(c1.matches.empty());
+
+    // Order and duplicates may differ, but the set of matches must not.
+    EXPECT_EQ(toSet(c1), toSet(c2));
+
+    hs_free_database(ordered);
+    hs_free_database(unordered);
+}
+
+TEST(Unordered, StreamSameMatches) {
+    hs_database_t *ordered = buildDB(unorderedPatterns, HS_MODE_STREAM);
+    ASSERT_NE(nullptr, ordered);
+    hs_database_t *unordered =
+        buildDB(unorderedPatterns, HS_MODE_STREAM | HS_MODE_UNORDERED);
+    ASSERT_NE(nullptr, unordered);
+
+    CallBackContext c1;
+    scanStream(ordered, unorderedCorpus, unorderedCorpus.size(), c1);
+    ASSERT_FALSE(c1.matches.empty());
+    const MatchSet expected = toSet(c1);
+
+    for (size_t chunk : {1, 3, 7, 16, 1000}) {
+        SCOPED_TRACE(chunk);
+        CallBackContext c2;
+        scanStream(unordered, unorderedCorpus, chunk, c2);
+        EXPECT_EQ(expected, toSet(c2));
+    }
+
+    hs_free_database(ordered);
+    hs_free_database(unordered);
+}
+
+TEST(Unordered, Halt) {
+    hs_database_t *db =
+        buildDB(unorderedPatterns, HS_MODE_BLOCK | HS_MODE_UNORDERED);
+    ASSERT_NE(nullptr, db);
+
+    hs_scratch_t *scratch = nullptr;
+    hs_error_t err = hs_alloc_scratch(db, &scratch);
+    ASSERT_EQ(HS_SUCCESS, err);
+
+    CallBackContext c;
+    c.halt = true;
+    err = hs_scan(db, unorderedCorpus.c_str(), unorderedCorpus.size(), 0,
+                  scratch, record_cb, &c);
+    ASSERT_EQ(HS_SCAN_TERMINATED, err);
+    ASSERT_EQ(1U, c.matches.size());
+
+    hs_free_scratch(scratch);
+    hs_free_database(db);
+}
+
+// Databases that need ordered delivery are still built, with ordering intact.
+TEST(Unordered, SomStillOrdered) {
+    vector<pattern> patterns = unorderedPatterns;
+    patterns.push_back(pattern("bar.{0,20}baz", HS_FLAG_SOM_LEFTMOST, 8));
+
+    hs_database_t *db = buildDB(patterns, HS_MODE_STREAM | HS_MODE_UNORDERED |
+                                              HS_MODE_SOM_HORIZON_LARGE);
+    ASSERT_NE(nullptr, db);
+
+    CallBackContext c;
+    scanStream(db, unorderedCorpus, 5, c);
+    ASSERT_FALSE(c.matches.empty());
+    for (size_t i = 1; i < c.matches.size(); i++) {
+        EXPECT_LE(c.matches[i - 1].to, c.matches[i].to);
+    }
+
+    hs_free_database(db);
+}
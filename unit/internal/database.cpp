@@ -51,10 +51,30 @@ TEST(DB, flagsToPlatform) {
     p.cpu_features |= HS_CPU_FEATURES_AVX2;
 #endif
 
+#if defined(__AVX512BW__)
+    p.cpu_features |= HS_CPU_FEATURES_AVX512;
+#endif
+
     platform_t pp = target_to_platform(target_t(p));
     ASSERT_EQ(pp, hs_current_platform);
 }
 
+// AVX-512 implies AVX2, so a target that asks for AVX-512 alone must not
+// produce a platform that has the no-AVX2 bit set.
+TEST(DB, avx512ImpliesAvx2) {
+    hs_platform_info p;
+    memset(&p, 0, sizeof(p));
+    p.cpu_features = HS_CPU_FEATURES_AVX512;
+
+    target_t t(p);
+    EXPECT_TRUE(t.has_avx2());
+    EXPECT_TRUE(t.has_avx512());
+
+    platform_t pp = target_to_platform(t);
+    EXPECT_EQ(0U, pp & HS_PLATFORM_NOAVX2);
+    EXPECT_EQ(0U, pp & HS_PLATFORM_NOAVX512);
+}
+
 TEST(CRC, alignments) {
     std::array<u8, 4096> a;
     a.fill('a');
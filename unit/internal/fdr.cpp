@@ -330,6 +330,58 @@ TEST_P(FDRp, NoRepeat3) {
     EXPECT_EQ(match(31, 32, 0), matches[0]);
 }
 
+TEST_P(FDRp, ManyLiterals) {
+    const u32 hint = GetParam();
+    SCOPED_TRACE(hint);
+
+    // Many short literals over a small alphabet, so that there are matches
+    // (and confirm candidates) at every offset in each iteration.
+    const string alpha = "abcd";
+    boost::random::mt19937 prng(hint);
+    boost::random::uniform_int_distribution<size_t> char_dist(0, 3);
+    boost::random::uniform_int_distribution<size_t> len_dist(3, 6);
+
+    vector<hwlmLiteral> lits;
+    for (u32 i = 0; i < 200; i++) {
+        string s;
+        for (size_t j = len_dist(prng); j; j--) {
+            s.push_back(alpha[char_dist(prng)]);
+        }
+        lits.push_back(hwlmLiteral(s, false, i));
+    }
+
+    string data;
+    for (u32 i = 0; i < 1000; i++) {
+        data.push_back(alpha[char_dist(prng)]);
+    }
+
+    auto fdr = fdrBuildTableHinted(lits, false, hint, get_current_target(), Grey());
+    CHECK_WITH_TEDDY_OK_TO_FAIL(fdr, hint);
+
+    // FDR only guarantees the end offset of each match.
+    vector<pair<size_t, u32>> expected;
+    for (const auto &lit : lits) {
+        for (size_t pos = data.find(lit.s); pos != string::npos;
+             pos = data.find(lit.s, pos + 1)) {
+            expected.push_back(make_pair(pos + lit.s.size() - 1, lit.id));
+        }
+    }
+
+    vector<match> matches;
+    fdrExec(fdr.get(), (const u8 *)data.c_str(), data.size(), 0,
+            decentCallback, &matches, HWLM_ALL_GROUPS);
+
+    vector<pair<size_t, u32>> found;
+    for (const auto &m : matches) {
+        found.push_back(make_pair(m.end, m.id));
+    }
+
+    sort(expected.begin(), expected.end());
+    sort(found.begin(), found.end());
+    ASSERT_EQ(expected.size(), found.size());
+    EXPECT_TRUE(expected == found);
+}
+
 /**
  * \brief Helper function wrapping the FDR streaming call that ensures it is
  * always safe to read 16 bytes before the end of the history buffer.
@@ -839,3 +891,122 @@ TEST(FDR, ManyLengths) {
 
     ASSERT_EQ(768U, matches.size());
 }
+
+/** \brief Distinct six-byte literals with no flood-prone tails. */
+static
+vector<hwlmLiteral> makeTeddyLiterals(u32 count) {
+    vector<hwlmLiteral> lits;
+    for (u32 i = 0; i < count; i++) {
+        string s = "t";
+        s.push_back('a' + i % 26);
+        s.push_back('A' + i / 26);
+        s += "xyz";
+        lits.push_back(hwlmLiteral(s, false, i));
+    }
+    return lits;
+}
+
+TEST(Teddy, EngineSelection) {
+    const auto ssse3 = targetByArchFeatures(0);
+    const auto avx2 = targetByArchFeatures(HS_CPU_FEATURES_AVX2);
+    const auto avx512 = targetByArchFeatures(HS_CPU_FEATURES_AVX2 |
+                                             HS_CPU_FEATURES_AVX512);
+
+    // On AVX-512 targets, up to 32 literals get a bucket each and 33-64
+    // literals are packed into the 16-bucket model.
+    for (u32 count : {20, 32, 33, 64}) {
+        SCOPED_TRACE(count);
+        const auto lits = makeTeddyLiterals(count);
+        auto des = chooseTeddyEngine(avx512, lits);
+        ASSERT_TRUE(des != nullptr);
+        EXPECT_EQ(count <= 32 ? 32U : 16U, des->getNumBuckets());
+        EXPECT_EQ(count > 32, des->packed);
+        EXPECT_FALSE(des->isValidOnTarget(avx2));
+    }
+
+    // Targets without AVX-512 keep the engines they were given before the
+    // AVX-512 models were added.
+    const auto lits20 = makeTeddyLiterals(20);
+    const auto lits40 = makeTeddyLiterals(40);
+    const auto lits64 = makeTeddyLiterals(64);
+
+    auto des = chooseTeddyEngine(ssse3, lits20);
+    ASSERT_TRUE(des != nullptr);
+    EXPECT_EQ(16U, des->getID());
+    des = chooseTeddyEngine(ssse3, lits40);
+    ASSERT_TRUE(des != nullptr);
+    EXPECT_EQ(18U, des->getID());
+    EXPECT_TRUE(chooseTeddyEngine(ssse3, lits64) == nullptr);
+
+    des = chooseTeddyEngine(avx2, lits20);
+    ASSERT_TRUE(des != nullptr);
+    EXPECT_EQ(16U, des->getID());
+    des = chooseTeddyEngine(avx2, lits40);
+    ASSERT_TRUE(des != nullptr);
+    EXPECT_EQ(8U, des->getID());
+    des = chooseTeddyEngine(avx2, lits64);
+    ASSERT_TRUE(des != nullptr);
+    EXPECT_EQ(8U, des->getID());
+}
+
+TEST(Teddy, Avx512Matches) {
+    const auto target = get_current_target();
+    if (!target.has_avx512()) {
+        return; // AVX-512 Teddy models cannot run on this host
+    }
+
+    boost::random::mt19937 prng(42);
+    boost::random::uniform_int_distribution<size_t> pos_dist(0, 4000);
+    const string alpha = "taAbBcCxyz";
+    boost::random::uniform_int_distribution<size_t> char_dist(
+        0, alpha.size() - 1);
+
+    for (u32 count : {20, 32, 40, 64}) {
+        SCOPED_TRACE(count);
+        const auto lits = makeTeddyLiterals(count);
+        auto des = chooseTeddyEngine(target, lits);
+        ASSERT_TRUE(des != nullptr);
+        ASSERT_LE(19U, des->getID()); // an AVX-512 model
+
+        auto fdr = fdrBuildTableHinted(lits, false, des->getID(), target,
+                                       Grey());
+        ASSERT_TRUE(fdr != nullptr);
+
+        // Random data over the literals' alphabet, with every literal
+        // planted a few times, including at the very start and end.
+        string data;
+        for (u32 i = 0; i < 4096; i++) {
+            data.push_back(alpha[char_dist(prng)]);
+        }
+        for (const auto &lit : lits) {
+            for (u32 i = 0; i < 3; i++) {
+                data.replace(pos_dist(prng), lit.s.size(), lit.s);
+            }
+        }
+        data.replace(0, lits.front().s.size(), lits.front().s);
+        data.replace(data.size() - lits.back().s.size(), lits.back().s.size(),
+                     lits.back().s);
+
+        vector<pair<size_t, u32>> expected;
+        for (const auto &lit : lits) {
+            for (size_t pos = data.find(lit.s); pos != string::npos;
+                 pos = data.find(lit.s, pos + 1)) {
+                expected.push_back(make_pair(pos + lit.s.size() - 1, lit.id));
+            }
+        }
+
+        vector<match> matches;
+        fdrExec(fdr.get(), (const u8 *)data.c_str(), data.size(), 0,
+                decentCallback, &matches, HWLM_ALL_GROUPS);
+
+        vector<pair<size_t, u32>> found;
+        for (const auto &m : matches) {
+            found.push_back(make_pair(m.end, m.id));
+        }
+
+        sort(expected.begin(), expected.end());
+        sort(found.begin(), found.end());
+        ASSERT_EQ(expected.size(), found.size());
+        EXPECT_TRUE(expected == found);
+    }
+}
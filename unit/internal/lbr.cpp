@@ -126,6 +126,9 @@ protected:
         q.cb = onMatch;
         q.som_cb = nullptr; // only used by Haig
         q.context = &matches;
+#ifdef PROFILE_SUPPORT
+        q.profile = nullptr;
+#endif
     }
 
     virtual string matchingCorpus(size_t len) const {
@@ -40,8 +40,13 @@
 #include "nfa/nfa_api_util.h"
 #include "nfa/nfa_internal.h"
 #include "util/alloc.h"
+#include "util/bitutils.h"
 #include "util/target_info.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 using namespace std;
 using namespace testing;
 using namespace ue2;
@@ -106,6 +111,9 @@ protected:
         q.cb = onMatch;
         q.som_cb = nullptr; // only used by Haig
         q.context = &matches;
+#ifdef PROFILE_SUPPORT
+        q.profile = nullptr;
+#endif
     }
 
     // NFA type (enum NFAEngineType)
@@ -129,7 +137,7 @@ protected:
 
 INSTANTIATE_TEST_CASE_P(
     LimEx, LimExModelTest,
-    Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_512_7));
+    Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_1024_7));
 
 TEST_P(LimExModelTest, StateSize) {
     ASSERT_TRUE(nfa != nullptr);
@@ -336,7 +344,7 @@ protected:
 };
 
 INSTANTIATE_TEST_CASE_P(LimExReverse, LimExReverseTest,
-                        Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_512_7));
+                        Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_1024_7));
 
 TEST_P(LimExReverseTest, BlockExecReverse) {
     ASSERT_TRUE(nfa != nullptr);
@@ -400,6 +408,9 @@ protected:
         q.cb = onMatch;
         q.som_cb = nullptr; // only used by Haig
         q.context = &matches;
+#ifdef PROFILE_SUPPORT
+        q.profile = nullptr;
+#endif
     }
 
     // NFA type (enum NFAEngineType)
@@ -422,7 +433,7 @@ protected:
 };
 
 INSTANTIATE_TEST_CASE_P(LimExZombie, LimExZombieTest,
-                        Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_512_7));
+                        Range((int)LIMEX_NFA_32_1, (int)LIMEX_NFA_1024_7));
 
 TEST_P(LimExZombieTest, GetZombieStatus) {
     ASSERT_TRUE(nfa != nullptr);
@@ -446,3 +457,141 @@ TEST_P(LimExZombieTest, GetZombieStatus) {
     // The .* at the end of the pattern should have turned us into a zombie...
     ASSERT_EQ(NFA_ZOMBIE_ALWAYS_YES, nfaGetZombieStatus(nfa.get(), &q, end));
 }
+
+static
+aligned_unique_ptr<NFA> buildForTarget(const string &expr,
+                                       unsigned long long features,
+                                       const Grey &grey = Grey()) {
+    hs_platform_info plat;
+    hs_error_t err = hs_populate_platform(&plat);
+    if (err != HS_SUCCESS) {
+        return nullptr;
+    }
+    plat.cpu_features = features;
+
+    target_t target(plat);
+    CompileContext cc(false, false, target, grey);
+    ReportManager rm(cc.grey);
+    ParsedExpression parsed(0, expr.c_str(), 0, 0);
+    unique_ptr<NGWrapper> g = buildWrapper(rm, cc, parsed);
+    if (!g) {
+        return nullptr;
+    }
+    rm.setProgramOffset(0, MATCH_REPORT);
+
+    const map<u32, u32> fixed_depth_tops;
+    const map<u32, vector<vector<CharReach>>> triggers;
+    return constructNFA(*g, &rm, fixed_depth_tops, triggers, false, cc);
+}
+
+// NFAs with 257-384 states use the 384-bit model, unless the target has
+// AVX-512, in which case the single-register 512-bit model is preferred.
+TEST(LimExModelSelection, WideTarget) {
+    string expr;
+    for (u32 i = 0; i < 300; i++) {
+        expr += i % 2 ? "[cd]" : "[ab]";
+    }
+
+    auto nfa = buildForTarget(expr, 0);
+    ASSERT_TRUE(nfa != nullptr);
+    EXPECT_LT(256U, nfa->nPositions);
+    EXPECT_GE((int)LIMEX_NFA_384_7, (int)nfa->type);
+    EXPECT_LE((int)LIMEX_NFA_384_1, (int)nfa->type);
+
+    nfa = buildForTarget(expr, HS_CPU_FEATURES_AVX2);
+    ASSERT_TRUE(nfa != nullptr);
+    EXPECT_GE((int)LIMEX_NFA_384_7, (int)nfa->type);
+    EXPECT_LE((int)LIMEX_NFA_384_1, (int)nfa->type);
+
+    nfa = buildForTarget(expr, HS_CPU_FEATURES_AVX2 | HS_CPU_FEATURES_AVX512);
+    ASSERT_TRUE(nfa != nullptr);
+    EXPECT_GE((int)LIMEX_NFA_512_7, (int)nfa->type);
+    EXPECT_LE((int)LIMEX_NFA_512_1, (int)nfa->type);
+}
+
+// NFAs with 513-768 states use the 768-bit model, or the 1024-bit model on
+// AVX-512 targets.
+TEST(LimExModelSelection, VeryWideTarget) {
+    string expr;
+    for (u32 i = 0; i < 600; i++) {
+        expr += i % 2 ? "[cd]" : "[ab]";
+    }
+
+    auto nfa = buildForTarget(expr, 0);
+    ASSERT_TRUE(nfa != nullptr);
+    EXPECT_LT(512U, nfa->nPositions);
+    EXPECT_GE((int)LIMEX_NFA_768_7, (int)nfa->type);
+    EXPECT_LE((int)LIMEX_NFA_768_1, (int)nfa->type);
+
+    nfa = buildForTarget(expr, HS_CPU_FEATURES_AVX2 | HS_CPU_FEATURES_AVX512);
+    ASSERT_TRUE(nfa != nullptr);
+    EXPECT_GE((int)LIMEX_NFA_1024_7, (int)nfa->type);
+    EXPECT_LE((int)LIMEX_NFA_1024_1, (int)nfa->type);
+}
+
+static
+int onMatchRecord(u64a offset, ReportID id, void *ctx) {
+    auto *matches = (vector<pair<u64a, ReportID>> *)ctx;
+    matches->push_back(make_pair(offset, id));
+    return MO_CONTINUE_MATCHING;
+}
+
+static
+vector<pair<u64a, ReportID>> scanBlock(const NFA *nfa, const string &data) {
+    auto full_state = aligned_zmalloc_unique<char>(nfa->scratchStateSize);
+    auto stream_state = aligned_zmalloc_unique<char>(nfa->streamStateSize);
+    vector<pair<u64a, ReportID>> matches;
+
+    struct mq q;
+    memset(&q, 0, sizeof(q));
+    q.nfa = nfa;
+    q.state = full_state.get();
+    q.streamState = stream_state.get();
+    q.buffer = (const u8 *)data.c_str();
+    q.length = data.size();
+    q.cb = onMatchRecord;
+    q.context = &matches;
+    nfaQueueInitState(nfa, &q);
+
+    u64a end = data.size();
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, end);
+    nfaQueueExec(nfa, &q, end);
+
+    sort(matches.begin(), matches.end());
+    return matches;
+}
+
+// With its original numbering, the fan-out from 'a' to five branches that
+// rejoin at 'l' spreads over more states than a shift can reach, so some
+// transitions need the exception path. Reordering the states must reduce
+// the number of exceptional states without changing what the NFA matches.
+TEST(LimExReorder, FewerExceptions) {
+    const string expr = "a(bc|de|fg|hi|jk)l";
+    const string data = "abcl_adel_afgl_ahil_ajkl_abl_akjl_abcdel_aabcll";
+
+    Grey grey;
+    grey.nfaForceSize = 32;
+    grey.nfaForceShifts = 7;
+
+    grey.reorderNFAStates = false;
+    auto nfa_orig = buildForTarget(expr, 0, grey);
+    ASSERT_TRUE(nfa_orig != nullptr);
+    ASSERT_EQ(LIMEX_NFA_32_7, nfa_orig->type);
+
+    grey.reorderNFAStates = true;
+    auto nfa = buildForTarget(expr, 0, grey);
+    ASSERT_TRUE(nfa != nullptr);
+    ASSERT_EQ(LIMEX_NFA_32_7, nfa->type);
+
+    const LimExNFA32 *limex_orig =
+        (const LimExNFA32 *)getImplNfa(nfa_orig.get());
+    const LimExNFA32 *limex = (const LimExNFA32 *)getImplNfa(nfa.get());
+    EXPECT_LT(popcount32(limex->exceptionMask),
+              popcount32(limex_orig->exceptionMask));
+
+    auto matches = scanBlock(nfa.get(), data);
+    EXPECT_EQ(6U, matches.size());
+    EXPECT_EQ(scanBlock(nfa_orig.get(), data), matches);
+}
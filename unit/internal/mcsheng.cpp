@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "gtest/gtest.h"
+
+#include "grey.h"
+#include "compiler/compiler.h"
+#include "nfagraph/ng.h"
+#include "nfagraph/ng_mcclellan.h"
+#include "nfa/mcclellancompile.h"
+#include "nfa/mcshengcompile.h"
+#include "nfa/nfa_api.h"
+#include "nfa/nfa_api_util.h"
+#include "nfa/nfa_internal.h"
+#include "nfa/rdfa.h"
+#include "util/alloc.h"
+#include "util/target_info.h"
+
+using namespace std;
+using namespace testing;
+using namespace ue2;
+
+static const u32 MATCH_REPORT = 1024;
+
+static
+int onMatch(u64a, ReportID, void *ctx) {
+    unsigned *matches = (unsigned *)ctx;
+    (*matches)++;
+    return MO_CONTINUE_MATCHING;
+}
+
+static
+unique_ptr<raw_dfa> buildRawDfa(const string &expr, ReportManager &rm,
+                                const CompileContext &cc) {
+    ParsedExpression parsed(0, expr.c_str(), 0, 0);
+    unique_ptr<NGWrapper> g = buildWrapper(rm, cc, parsed);
+    if (!g) {
+        return nullptr;
+    }
+    rm.setProgramOffset(0, MATCH_REPORT);
+    return buildMcClellan(*g, &rm, cc.grey);
+}
+
+static
+string makeData(void) {
+    string data;
+    for (u32 i = 0; i < 8192; i++) {
+        data.push_back("abcxyz_\n"[(i * 6 + i / 3) % 8]);
+    }
+    return data;
+}
+
+static
+unsigned scan(const NFA *n, const string &data, size_t split) {
+    auto state = aligned_zmalloc_unique<char>(n->scratchStateSize);
+    auto sstate = aligned_zmalloc_unique<char>(n->streamStateSize);
+    unsigned matches = 0;
+
+    struct mq q;
+    memset(&q, 0, sizeof(q));
+    q.nfa = n;
+    q.state = state.get();
+    q.streamState = sstate.get();
+    q.buffer = (const u8 *)data.c_str();
+    q.length = split;
+    q.cb = onMatch;
+    q.context = &matches;
+
+    nfaQueueInitState(n, &q);
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, split);
+    nfaQueueExec(n, &q, split);
+
+    if (split == data.size()) {
+        return matches;
+    }
+
+    // Resume in a second write, compressing and expanding the state in
+    // between as the streaming runtime does.
+    nfaQueueCompressState(n, &q, split);
+    memset(state.get(), 0xff, n->scratchStateSize);
+
+    q.cur = 0;
+    q.end = 0;
+    q.offset = split;
+    q.buffer = (const u8 *)data.c_str() + split;
+    q.length = data.size() - split;
+    nfaExpandState(n, q.state, q.streamState, q.offset,
+                   (u8)data[split - 1]);
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_END, q.length);
+    nfaQueueExec(n, &q, q.length);
+
+    return matches;
+}
+
+class McShengTest : public Test {
+protected:
+    virtual void SetUp() {
+        hs_platform_info plat;
+        hs_error_t err = hs_populate_platform(&plat);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        target_t target(plat);
+        CompileContext cc(true, false, target, Grey());
+        ReportManager rm(cc.grey);
+
+        // Large enough to need a 16-bit McClellan.
+        auto rdfa = buildRawDfa("a.{8}b", rm, cc);
+        ASSERT_TRUE(rdfa != nullptr);
+        ASSERT_LT(256U, rdfa->states.size());
+        raw_dfa rdfa_copy(*rdfa);
+
+        nfa = mcshengCompile(*rdfa, cc, rm);
+        ASSERT_TRUE(nfa != nullptr);
+        mcc_nfa = mcclellanCompile(rdfa_copy, cc, rm);
+        ASSERT_TRUE(mcc_nfa != nullptr);
+    }
+
+    // Compiled engines.
+    aligned_unique_ptr<NFA> nfa;
+    aligned_unique_ptr<NFA> mcc_nfa;
+};
+
+TEST_F(McShengTest, IsMcSheng) {
+    ASSERT_TRUE(nfa != nullptr);
+    EXPECT_EQ(MCSHENG_NFA_16, nfa->type);
+    EXPECT_TRUE(isDfaType(nfa->type));
+    EXPECT_EQ(2U, nfa->scratchStateSize);
+    EXPECT_EQ(2U, nfa->streamStateSize);
+}
+
+// McSheng and McClellan built from the same DFA must agree.
+TEST_F(McShengTest, AgreesWithMcClellan) {
+    const string data = makeData();
+    unsigned expected = scan(mcc_nfa.get(), data, data.size());
+    EXPECT_LT(0U, expected);
+    EXPECT_EQ(expected, scan(nfa.get(), data, data.size()));
+}
+
+TEST_F(McShengTest, StreamSplit) {
+    const string data = makeData();
+    unsigned expected = scan(mcc_nfa.get(), data, data.size());
+    for (size_t split = 1; split < 64; split++) {
+        SCOPED_TRACE(split);
+        ASSERT_EQ(expected, scan(nfa.get(), data, split));
+    }
+}
+
+TEST(McSheng, SmallDfaStaysMcClellan8) {
+    hs_platform_info plat;
+    hs_error_t err = hs_populate_platform(&plat);
+    ASSERT_EQ(HS_SUCCESS, err);
+    target_t target(plat);
+
+    CompileContext cc(false, false, target, Grey());
+    ReportManager rm(cc.grey);
+    auto rdfa = buildRawDfa("abcdefghijklmnopqrstuvwxyz", rm, cc);
+    ASSERT_TRUE(rdfa != nullptr);
+    ASSERT_GE(256U, rdfa->states.size());
+
+    EXPECT_TRUE(mcshengCompile(*rdfa, cc, rm) == nullptr);
+}
+
+TEST(McSheng, Disabled) {
+    hs_platform_info plat;
+    hs_error_t err = hs_populate_platform(&plat);
+    ASSERT_EQ(HS_SUCCESS, err);
+    target_t target(plat);
+
+    Grey grey;
+    grey.allowMcSheng = false;
+    CompileContext cc(false, false, target, grey);
+    ReportManager rm(cc.grey);
+    auto rdfa = buildRawDfa("a.{8}b", rm, cc);
+    ASSERT_TRUE(rdfa != nullptr);
+
+    EXPECT_TRUE(mcshengCompile(*rdfa, cc, rm) == nullptr);
+}
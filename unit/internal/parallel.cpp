@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include "util/parallel.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace ue2;
+
+TEST(Parallel, Empty) {
+    u32 calls = 0;
+    parallelFor(0, 4, [&](size_t) { calls++; });
+    ASSERT_EQ(0U, calls);
+}
+
+TEST(Parallel, AllItemsOnce) {
+    for (u32 threads : {0U, 1U, 2U, 4U, 16U}) {
+        SCOPED_TRACE(threads);
+        const size_t count = 1000;
+        vector<atomic<u32>> seen(count);
+        for (auto &s : seen) {
+            s = 0;
+        }
+        parallelFor(count, threads, [&](size_t i) { seen[i]++; });
+        for (size_t i = 0; i < count; i++) {
+            ASSERT_EQ(1U, seen[i]) << "item " << i;
+        }
+    }
+}
+
+TEST(Parallel, LowestExceptionWins) {
+    for (u32 threads : {1U, 4U}) {
+        SCOPED_TRACE(threads);
+        try {
+            parallelFor(100, threads, [](size_t i) {
+                if (i % 10 == 7) {
+                    throw runtime_error(to_string(i));
+                }
+            });
+            FAIL() << "no exception thrown";
+        } catch (const runtime_error &e) {
+            ASSERT_EQ(string("7"), e.what());
+        }
+    }
+}
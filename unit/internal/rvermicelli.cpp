@@ -218,3 +218,64 @@ TEST(RDoubleVermicelli, Exec5) {
         }
     }
 }
+
+// Long enough for the wide aligned loops on AVX2 and AVX-512 builds, with
+// matches at every alignment relative to a 64-byte boundary.
+TEST(RVermicelli, ExecLong) {
+    ALIGN_CL_DIRECTIVE u8 t1[512];
+
+    for (size_t i = 0; i < 64; i++) {
+        for (size_t j = 0; j < 64; j += 9) {
+            const u8 *begin = t1 + j;
+            const u8 *end = t1 + sizeof(t1) - i;
+            for (const u8 *match = end - 1; match >= begin; match -= 11) {
+                memset(t1, 'b', sizeof(t1));
+                t1[match - t1] = 'a';
+
+                const u8 *rv = rvermicelliExec('a', 0, begin, end);
+                ASSERT_EQ(match, rv);
+
+                rv = rvermicelliExec('A', 1, begin, end);
+                ASSERT_EQ(match, rv);
+
+                rv = rnvermicelliExec('b', 0, begin, end);
+                ASSERT_EQ(match, rv);
+
+                rv = rnvermicelliExec('B', 1, begin, end);
+                ASSERT_EQ(match, rv);
+            }
+        }
+    }
+}
+
+TEST(RDoubleVermicelli, ExecLong) {
+    ALIGN_CL_DIRECTIVE u8 t1[512];
+
+    for (size_t i = 0; i < 64; i++) {
+        for (size_t j = 0; j < 64; j += 9) {
+            const u8 *begin = t1 + j;
+            const u8 *end = t1 + sizeof(t1) - i;
+            for (const u8 *match = end - 1; match > begin; match -= 11) {
+                memset(t1, 'b', sizeof(t1));
+                t1[match - t1 - 1] = 'a';
+                t1[match - t1] = 'c';
+
+                // a match in the first block may only be reported as a
+                // possible match at the block boundary
+                const u8 *rv = rvermicelliDoubleExec('a', 'c', 0, begin, end);
+                if (match - begin >= 16) {
+                    ASSERT_EQ(match, rv);
+                } else {
+                    ASSERT_LE(match, rv);
+                }
+
+                rv = rvermicelliDoubleExec('A', 'C', 1, begin, end);
+                if (match - begin >= 16) {
+                    ASSERT_EQ(match, rv);
+                } else {
+                    ASSERT_LE(match, rv);
+                }
+            }
+        }
+    }
+}
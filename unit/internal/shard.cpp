@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include "compiler/shard.h"
+#include "gtest/gtest.h"
+
+#include <vector>
+
+using namespace std;
+using namespace ue2;
+
+static
+ShardItem makeItem(u32 member, u64a cost, vector<u32> keys = {}) {
+    ShardItem item;
+    item.members.push_back(member);
+    item.cost = cost;
+    item.keys = keys;
+    return item;
+}
+
+TEST(Shard, OneShard) {
+    vector<ShardItem> items;
+    for (u32 i = 0; i < 10; i++) {
+        items.push_back(makeItem(i, i + 1));
+    }
+    auto shards = assignShards(items, 1);
+    ASSERT_EQ(1U, shards.size());
+    ASSERT_EQ(10U, shards[0].size());
+    for (u32 i = 0; i < 10; i++) {
+        ASSERT_EQ(i, shards[0][i]);
+    }
+}
+
+TEST(Shard, FewerItemsThanShards) {
+    vector<ShardItem> items = {makeItem(0, 5), makeItem(1, 5)};
+    auto shards = assignShards(items, 4);
+    ASSERT_EQ(2U, shards.size());
+    EXPECT_EQ(vector<u32>({0}), shards[0]);
+    EXPECT_EQ(vector<u32>({1}), shards[1]);
+}
+
+TEST(Shard, Balanced) {
+    // Costs 1..16 sum to 136; greedy placement gets each of 4 shards to 34.
+    vector<ShardItem> items;
+    for (u32 i = 0; i < 16; i++) {
+        items.push_back(makeItem(i, i + 1));
+    }
+    auto shards = assignShards(items, 4);
+    ASSERT_EQ(4U, shards.size());
+
+    vector<bool> seen(16, false);
+    for (const auto &shard : shards) {
+        u64a cost = 0;
+        for (u32 m : shard) {
+            ASSERT_FALSE(seen[m]);
+            seen[m] = true;
+            cost += m + 1;
+        }
+        EXPECT_EQ(34U, cost);
+    }
+}
+
+TEST(Shard, SharedKeysGrouped) {
+    // Items sharing keys are placed together when the balance allows it.
+    vector<ShardItem> items = {
+        makeItem(0, 10, {1, 2}), makeItem(1, 10, {3, 4}),
+        makeItem(2, 1, {1}),     makeItem(3, 1, {3}),
+        makeItem(4, 1, {2}),     makeItem(5, 1, {4}),
+    };
+    auto shards = assignShards(items, 2);
+    ASSERT_EQ(2U, shards.size());
+    EXPECT_EQ(vector<u32>({0, 2, 4}), shards[0]);
+    EXPECT_EQ(vector<u32>({1, 3, 5}), shards[1]);
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "gtest/gtest.h"
+
+#include "grey.h"
+#include "compiler/compiler.h"
+#include "nfagraph/ng.h"
+#include "nfagraph/ng_mcclellan.h"
+#include "nfa/mcclellancompile.h"
+#include "nfa/nfa_api.h"
+#include "nfa/nfa_api_util.h"
+#include "nfa/nfa_internal.h"
+#include "nfa/rdfa.h"
+#include "nfa/shengcompile.h"
+#include "util/alloc.h"
+#include "util/target_info.h"
+
+using namespace std;
+using namespace testing;
+using namespace ue2;
+
+static const string SCAN_DATA = "___foo______\n___foofoo_foo_^^^^^^^^^^^^^^^^^^"
+                                "^^^^__bar_bar______0_______z_____bar";
+static const u32 MATCH_REPORT = 1024;
+
+static
+int onMatch(u64a, ReportID, void *ctx) {
+    unsigned *matches = (unsigned *)ctx;
+    (*matches)++;
+    return MO_CONTINUE_MATCHING;
+}
+
+static
+unique_ptr<raw_dfa> buildRawDfa(const string &expr, ReportManager &rm,
+                                const CompileContext &cc) {
+    ParsedExpression parsed(0, expr.c_str(), 0, 0);
+    unique_ptr<NGWrapper> g = buildWrapper(rm, cc, parsed);
+    if (!g) {
+        return nullptr;
+    }
+    rm.setProgramOffset(0, MATCH_REPORT);
+    return buildMcClellan(*g, &rm, cc.grey);
+}
+
+class ShengTest : public Test {
+protected:
+    virtual void SetUp() {
+        hs_platform_info plat;
+        hs_error_t err = hs_populate_platform(&plat);
+        ASSERT_EQ(HS_SUCCESS, err);
+
+        target_t target(plat);
+        matches = 0;
+
+        CompileContext cc(false, false, target, Grey());
+        ReportManager rm(cc.grey);
+        auto rdfa = buildRawDfa("foo.*bar", rm, cc);
+        ASSERT_TRUE(rdfa != nullptr);
+
+        nfa = shengCompile(*rdfa, cc, rm);
+        ASSERT_TRUE(nfa != nullptr);
+
+        full_state = aligned_zmalloc_unique<char>(nfa->scratchStateSize);
+        stream_state = aligned_zmalloc_unique<char>(nfa->streamStateSize);
+    }
+
+    virtual void initQueue(const string &data) {
+        q.nfa = nfa.get();
+        q.cur = 0;
+        q.end = 0;
+        q.state = full_state.get();
+        q.streamState = stream_state.get();
+        q.offset = 0;
+        q.buffer = (const u8 *)data.c_str();
+        q.length = data.size();
+        q.history = nullptr;
+        q.hlength = 0;
+        q.report_current = 0;
+        q.cb = onMatch;
+        q.som_cb = nullptr; // only used by Haig
+        q.context = &matches;
+#ifdef PROFILE_SUPPORT
+        q.profile = nullptr;
+#endif
+    }
+
+    // Match count
+    unsigned matches;
+
+    // Compiled engine.
+    aligned_unique_ptr<NFA> nfa;
+
+    // Space for full state.
+    aligned_unique_ptr<char> full_state;
+
+    // Space for stream state.
+    aligned_unique_ptr<char> stream_state;
+
+    // Queue structure.
+    struct mq q;
+};
+
+TEST_F(ShengTest, IsSheng) {
+    ASSERT_TRUE(nfa != nullptr);
+    EXPECT_EQ(SHENG_NFA_0, nfa->type);
+    EXPECT_TRUE(isDfaType(nfa->type));
+    EXPECT_EQ(1U, nfa->scratchStateSize);
+    EXPECT_EQ(1U, nfa->streamStateSize);
+}
+
+TEST_F(ShengTest, QueueExec) {
+    initQueue(SCAN_DATA);
+    nfaQueueInitState(nfa.get(), &q);
+
+    u64a end = SCAN_DATA.size();
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, end);
+
+    nfaQueueExec(nfa.get(), &q, end);
+
+    ASSERT_EQ(3, matches);
+}
+
+TEST_F(ShengTest, QueueExecToMatch) {
+    initQueue(SCAN_DATA);
+    nfaQueueInitState(nfa.get(), &q);
+
+    u64a end = SCAN_DATA.size();
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, end);
+
+    for (unsigned i = 0; i < 3; i++) {
+        char rv = nfaQueueExecToMatch(nfa.get(), &q, end);
+        ASSERT_EQ(MO_MATCHES_PENDING, rv);
+        ASSERT_EQ(i, matches);
+        ASSERT_NE(0, nfaInAcceptState(nfa.get(), MATCH_REPORT, &q));
+        nfaReportCurrentMatches(nfa.get(), &q);
+        ASSERT_EQ(i + 1, matches);
+    }
+
+    // No more.
+    char rv = nfaQueueExecToMatch(nfa.get(), &q, end);
+    ASSERT_EQ(MO_ALIVE, rv);
+    ASSERT_EQ(3, matches);
+}
+
+TEST_F(ShengTest, QueueExecRose) {
+    initQueue(SCAN_DATA);
+
+    // For rose, there's no callback or context.
+    q.cb = nullptr;
+    q.context = nullptr;
+
+    nfaQueueInitState(nfa.get(), &q);
+
+    u64a end = SCAN_DATA.size();
+    pushQueue(&q, MQE_START, 0);
+    pushQueue(&q, MQE_TOP, 0);
+    pushQueue(&q, MQE_END, end);
+
+    char rv = nfaQueueExecRose(nfa.get(), &q, MATCH_REPORT);
+    ASSERT_EQ(MO_MATCHES_PENDING, rv);
+    pushQueue(&q, MQE_START, end);
+    ASSERT_NE(0, nfaInAcceptState(nfa.get(), MATCH_REPORT, &q));
+}
+
+// Scan the data in two writes, compressing and expanding the state in
+// between as the streaming runtime does.
+TEST_F(ShengTest, StreamSplit) {
+    for (size_t split = 1; split < SCAN_DATA.size(); split++) {
+        SCOPED_TRACE(split);
+        matches = 0;
+
+        const string first = SCAN_DATA.substr(0, split);
+        const string second = SCAN_DATA.substr(split);
+
+        initQueue(first);
+        nfaQueueInitState(nfa.get(), &q);
+        pushQueue(&q, MQE_START, 0);
+        pushQueue(&q, MQE_TOP, 0);
+        pushQueue(&q, MQE_END, split);
+        nfaQueueExec(nfa.get(), &q, split);
+        nfaQueueCompressState(nfa.get(), &q, split);
+
+        memset(full_state.get(), 0xff, nfa->scratchStateSize);
+
+        initQueue(second);
+        q.offset = split;
+        nfaExpandState(nfa.get(), q.state, q.streamState, q.offset,
+                       queue_prev_byte(&q, 0));
+        pushQueue(&q, MQE_START, 0);
+        pushQueue(&q, MQE_END, second.size());
+        nfaQueueExec(nfa.get(), &q, second.size());
+
+        ASSERT_EQ(3, matches);
+    }
+}
+
+// Sheng and McClellan built from the same DFA must agree, including over
+// inputs long enough to use the unrolled inner loop and acceleration.
+TEST(Sheng, AgreesWithMcClellan) {
+    hs_platform_info plat;
+    hs_error_t err = hs_populate_platform(&plat);
+    ASSERT_EQ(HS_SUCCESS, err);
+    target_t target(plat);
+
+    const string exprs[] = { "foo.*bar", "a.b", "(ab|cd)ef", "x[0-9]+y" };
+
+    string data;
+    for (u32 i = 0; i < 4096; i++) {
+        data.push_back("abcdefxy0123_\n"[(i * 7 + i / 13) % 14]);
+    }
+    data += "foo__bar abczzd axb cdef x123y";
+
+    for (const auto &expr : exprs) {
+        SCOPED_TRACE(expr);
+        CompileContext cc(false, false, target, Grey());
+        ReportManager rm(cc.grey);
+        auto rdfa = buildRawDfa(expr, rm, cc);
+        ASSERT_TRUE(rdfa != nullptr);
+        raw_dfa rdfa_copy(*rdfa);
+
+        auto sheng_nfa = shengCompile(*rdfa, cc, rm);
+        ASSERT_TRUE(sheng_nfa != nullptr);
+        ASSERT_EQ(SHENG_NFA_0, sheng_nfa->type);
+        auto mcc_nfa = mcclellanCompile(rdfa_copy, cc, rm);
+        ASSERT_TRUE(mcc_nfa != nullptr);
+
+        unsigned counts[2];
+        const NFA *engines[2] = { sheng_nfa.get(), mcc_nfa.get() };
+        for (u32 i = 0; i < 2; i++) {
+            const NFA *n = engines[i];
+            auto state = aligned_zmalloc_unique<char>(n->scratchStateSize);
+            auto sstate = aligned_zmalloc_unique<char>(n->streamStateSize);
+            counts[i] = 0;
+
+            struct mq q;
+            memset(&q, 0, sizeof(q));
+            q.nfa = n;
+            q.state = state.get();
+            q.streamState = sstate.get();
+            q.buffer = (const u8 *)data.c_str();
+            q.length = data.size();
+            q.cb = onMatch;
+            q.context = &counts[i];
+
+            nfaQueueInitState(n, &q);
+            pushQueue(&q, MQE_START, 0);
+            pushQueue(&q, MQE_TOP, 0);
+            pushQueue(&q, MQE_END, data.size());
+            nfaQueueExec(n, &q, data.size());
+        }
+
+        EXPECT_LT(0U, counts[1]);
+        EXPECT_EQ(counts[1], counts[0]);
+    }
+}
+
+TEST(Sheng, TooManyStates) {
+    hs_platform_info plat;
+    hs_error_t err = hs_populate_platform(&plat);
+    ASSERT_EQ(HS_SUCCESS, err);
+    target_t target(plat);
+
+    CompileContext cc(false, false, target, Grey());
+    ReportManager rm(cc.grey);
+    auto rdfa = buildRawDfa("abcdefghijklmnopqrstuvwxyz", rm, cc);
+    ASSERT_TRUE(rdfa != nullptr);
+    ASSERT_LT(16U, rdfa->states.size());
+
+    EXPECT_TRUE(shengCompile(*rdfa, cc, rm) == nullptr);
+}
@@ -518,3 +518,62 @@ TEST(DoubleVermicelliMasked, Exec4) {
     }
 }
 
+
+// Long enough for the wide aligned loops on AVX2 and AVX-512 builds, with
+// matches at every alignment relative to a 64-byte boundary.
+TEST(Vermicelli, ExecLong) {
+    ALIGN_CL_DIRECTIVE u8 t1[512];
+
+    for (size_t i = 0; i < 64; i++) {
+        for (size_t j = 0; j < 64; j += 9) {
+            const u8 *begin = t1 + i;
+            const u8 *end = t1 + sizeof(t1) - j;
+            for (const u8 *match = begin; match < end; match += 11) {
+                memset(t1, 'b', sizeof(t1));
+                t1[match - t1] = 'a';
+
+                const u8 *rv = vermicelliExec('a', 0, begin, end);
+                ASSERT_EQ(match, rv);
+
+                rv = vermicelliExec('A', 1, begin, end);
+                ASSERT_EQ(match, rv);
+
+                rv = nvermicelliExec('b', 0, begin, end);
+                ASSERT_EQ(match, rv);
+
+                rv = nvermicelliExec('B', 1, begin, end);
+                ASSERT_EQ(match, rv);
+            }
+        }
+    }
+}
+
+TEST(DoubleVermicelli, ExecLong) {
+    ALIGN_CL_DIRECTIVE u8 t1[512];
+
+    for (size_t i = 0; i < 64; i++) {
+        for (size_t j = 0; j < 64; j += 9) {
+            const u8 *begin = t1 + i;
+            const u8 *end = t1 + sizeof(t1) - j;
+            for (const u8 *match = begin; match + 1 < end; match += 11) {
+                memset(t1, 'b', sizeof(t1));
+                t1[match - t1] = 'a';
+                t1[match - t1 + 1] = 'c';
+
+                const u8 *rv = vermicelliDoubleExec('a', 'c', 0, begin, end);
+                ASSERT_EQ(match, rv);
+
+                rv = vermicelliDoubleExec('A', 'C', 1, begin, end);
+                ASSERT_EQ(match, rv);
+
+                rv = vermicelliDoubleMaskedExec('a', 'c', 0xff, 0xff, begin,
+                                                end);
+                ASSERT_EQ(match, rv);
+
+                rv = vermicelliDoubleMaskedExec('A', 'C', CASE_CLEAR,
+                                                CASE_CLEAR, begin, end);
+                ASSERT_EQ(match, rv);
+            }
+        }
+    }
+}